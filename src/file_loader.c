@@ -0,0 +1,529 @@
+/* A simple front end debugger.
+   Copyright (C) 2012 Kenneth Olsson
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file file_loader.c
+ *
+ * @brief The implementation of the background file loader.
+ *
+ * One thread loads the files, one at the time. Only the last requested file
+ * is of interest, so a request replaces the one that is waiting, and a file
+ * that was requested again while it was loaded is thrown away. A loaded file
+ * is kept until it is taken, and a byte is written to a pipe so the main
+ * loop wakes up.
+ *
+ * Files that are likely to be shown next are prefetched when there is no
+ * request. They are kept in a small cache, together with the modification
+ * time and size the file had, until they are requested.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "file_loader.h"
+#include "debug.h"
+
+#define FILE_LOADER_PREFETCH 16 /**< Max number of files waiting to be
+                                 * prefetched.
+                                 */
+#define FILE_LOADER_CACHE 16 /**< Max number of prefetched files kept. */
+
+/*******************************************************************************
+ * Internal structures and enums
+ ******************************************************************************/
+/** A prefetched file. */
+typedef struct cached_file_t
+{
+  char *file_name;	/**< The file, NULL if the entry is not used. */
+  text *text;		/**< The text of the file. */
+  struct timespec mtime; /**< The modification time when it was read. */
+  off_t size;		/**< The size when it was read. */
+  unsigned int age;	/**< When it was stored, for replacing the oldest. */
+} cached_file;
+
+/** The loader. */
+struct file_loader_t
+{
+  pthread_t thread;	/**< The thread loading the files. */
+  pthread_mutex_t lock;	/**< Protects the fields below. */
+  pthread_cond_t cond;	/**< Signaled on a new request or when quitting. */
+  int pipe[2];		/**< Written to when a file is loaded. */
+  char *request;	/**< The file to load next, NULL if none. */
+  char *file_name;	/**< The loaded file, NULL if none. */
+  text *text;		/**< The text of @a file_name, NULL if it failed. */
+  int quit;		/**< 1 when the thread should stop. */
+
+  char *prefetch[FILE_LOADER_PREFETCH]; /**< The files to prefetch. */
+  int nr_prefetch;	/**< Number of files in @a prefetch. */
+  cached_file cache[FILE_LOADER_CACHE]; /**< The prefetched files. */
+  unsigned int age;	/**< Stamped on the next stored file. */
+};
+
+/*******************************************************************************
+ * Internal functions
+ ******************************************************************************/
+/**
+ * @brief Find a prefetched file.
+ *
+ * @param loader The loader, locked.
+ * @param file_name The file.
+ *
+ * @return The entry of the file, NULL if it is not prefetched.
+ */
+static cached_file *
+file_loader_find (file_loader * loader, const char *file_name)
+{
+  int i;
+
+  for (i = 0; i < FILE_LOADER_CACHE; i++)
+    {
+      if (loader->cache[i].file_name != NULL
+	  && strcmp (loader->cache[i].file_name, file_name) == 0)
+	{
+	  return &loader->cache[i];
+	}
+    }
+
+  return NULL;
+}
+
+/**
+ * @brief Take a prefetched file out of the cache.
+ *
+ * @param loader The loader, locked.
+ * @param file_name The file.
+ * @param file Set to the entry of the file.
+ *
+ * @return 1 if the file was prefetched, otherwise 0.
+ */
+static int
+file_loader_remove (file_loader * loader, const char *file_name,
+		    cached_file * file)
+{
+  cached_file *entry;
+
+  entry = file_loader_find (loader, file_name);
+  if (entry == NULL)
+    {
+      return 0;
+    }
+  *file = *entry;
+  entry->file_name = NULL;
+  entry->text = NULL;
+
+  return 1;
+}
+
+/**
+ * @brief Check that a prefetched file has not changed since it was read.
+ *
+ * @param file The entry of the file, freed.
+ *
+ * @return The text of the file, NULL if it has changed.
+ */
+static text *
+file_loader_check (cached_file * file)
+{
+  struct stat st;
+  text *text = NULL;
+
+  if (stat (file->file_name, &st) == 0 && st.st_size == file->size
+      && st.st_mtim.tv_sec == file->mtime.tv_sec
+      && st.st_mtim.tv_nsec == file->mtime.tv_nsec)
+    {
+      text = file->text;
+    }
+  else
+    {
+      DINFO (3, "'%s' has changed", file->file_name);
+      text_free (file->text);
+    }
+  free (file->file_name);
+
+  return text;
+}
+
+/**
+ * @brief Prefetch a file.
+ *
+ * Load a file and keep it in the cache, replacing the oldest file if the
+ * cache is full.
+ *
+ * @param loader The loader, locked. Unlocked while the file is read.
+ * @param file_name The file. Taken over by the loader.
+ */
+static void
+file_loader_prefetch_file (file_loader * loader, char *file_name)
+{
+  cached_file *entry;
+  struct stat st;
+  text *text = NULL;
+  int i;
+
+  pthread_mutex_unlock (&loader->lock);
+  if (stat (file_name, &st) == 0)
+    {
+      text = text_load_file (file_name);
+    }
+  pthread_mutex_lock (&loader->lock);
+
+  if (text == NULL || file_loader_find (loader, file_name) != NULL)
+    {
+      free (file_name);
+      if (text != NULL)
+	{
+	  text_free (text);
+	}
+      return;
+    }
+  entry = &loader->cache[0];
+  for (i = 0; i < FILE_LOADER_CACHE && entry->file_name != NULL; i++)
+    {
+      if (loader->cache[i].file_name == NULL
+	  || loader->cache[i].age < entry->age)
+	{
+	  entry = &loader->cache[i];
+	}
+    }
+  if (entry->file_name != NULL)
+    {
+      DINFO (3, "Dropped prefetched '%s'", entry->file_name);
+      free (entry->file_name);
+      text_free (entry->text);
+    }
+  entry->file_name = file_name;
+  entry->text = text;
+  entry->mtime = st.st_mtim;
+  entry->size = st.st_size;
+  entry->age = loader->age++;
+  DINFO (3, "Prefetched '%s'", file_name);
+}
+
+/**
+ * @brief Load the requested files.
+ *
+ * The requests go before the files to prefetch.
+ *
+ * @param data The loader.
+ *
+ * @return NULL.
+ */
+static void *
+file_loader_run (void *data)
+{
+  file_loader *loader = (file_loader *) data;
+  cached_file file;
+  char *file_name;
+  text *text;
+  int cached;
+
+  pthread_mutex_lock (&loader->lock);
+  while (1)
+    {
+      while (!loader->quit && loader->request == NULL
+	     && loader->nr_prefetch == 0)
+	{
+	  pthread_cond_wait (&loader->cond, &loader->lock);
+	}
+      if (loader->quit)
+	{
+	  break;
+	}
+      if (loader->request == NULL)
+	{
+	  file_name = loader->prefetch[0];
+	  loader->nr_prefetch--;
+	  memmove (loader->prefetch, loader->prefetch + 1,
+		   loader->nr_prefetch * sizeof (*loader->prefetch));
+	  file_loader_prefetch_file (loader, file_name);
+	  continue;
+	}
+      file_name = loader->request;
+      loader->request = NULL;
+      cached = file_loader_remove (loader, file_name, &file);
+      pthread_mutex_unlock (&loader->lock);
+      text = cached ? file_loader_check (&file) : NULL;
+      if (text == NULL)
+	{
+	  text = text_load_file (file_name);
+	}
+      pthread_mutex_lock (&loader->lock);
+
+      if (loader->request != NULL || loader->quit)
+	{
+	  /* Another file is wanted. */
+	  DINFO (3, "Dropped '%s'", file_name);
+	  free (file_name);
+	  if (text != NULL)
+	    {
+	      text_free (text);
+	    }
+	  continue;
+	}
+      free (loader->file_name);
+      if (loader->text != NULL)
+	{
+	  text_free (loader->text);
+	}
+      loader->file_name = file_name;
+      loader->text = text;
+      if (write (loader->pipe[1], "", 1) < 0 && errno != EAGAIN)
+	{
+	  LOG_ERR ("Could not wake up the main loop: %m");
+	}
+    }
+  pthread_mutex_unlock (&loader->lock);
+
+  return NULL;
+}
+
+/*******************************************************************************
+ * Public functions
+ ******************************************************************************/
+/**
+ * @brief Create a loader.
+ *
+ * Create a loader and start its thread.
+ *
+ * @return The loader, or NULL if the thread could not be started.
+ */
+file_loader *
+file_loader_create (void)
+{
+  file_loader *loader;
+  int i;
+
+  loader = (file_loader *) malloc (sizeof (*loader));
+  LOG_ERR_IF_FATAL (loader == NULL, ERR_MSG_CREATE ("file loader"));
+  memset (loader, 0, sizeof (*loader));
+
+  if (pipe (loader->pipe) < 0)
+    {
+      LOG_ERR ("Could not create pipe: %m");
+      free (loader);
+      return NULL;
+    }
+  for (i = 0; i < 2; i++)
+    {
+      fcntl (loader->pipe[i], F_SETFL,
+	     fcntl (loader->pipe[i], F_GETFL) | O_NONBLOCK);
+      fcntl (loader->pipe[i], F_SETFD, FD_CLOEXEC);
+    }
+  pthread_mutex_init (&loader->lock, NULL);
+  pthread_cond_init (&loader->cond, NULL);
+
+  if (pthread_create (&loader->thread, NULL, file_loader_run, loader) != 0)
+    {
+      LOG_ERR ("Could not start the file loader");
+      pthread_cond_destroy (&loader->cond);
+      pthread_mutex_destroy (&loader->lock);
+      close (loader->pipe[0]);
+      close (loader->pipe[1]);
+      free (loader);
+      return NULL;
+    }
+
+  return loader;
+}
+
+/**
+ * @brief Free a loader.
+ *
+ * Stop the thread, after the file it is loading, and free the loader.
+ *
+ * @param loader The loader, may be NULL.
+ */
+void
+file_loader_free (file_loader * loader)
+{
+  int i;
+
+  if (loader == NULL)
+    {
+      return;
+    }
+
+  pthread_mutex_lock (&loader->lock);
+  loader->quit = 1;
+  pthread_cond_signal (&loader->cond);
+  pthread_mutex_unlock (&loader->lock);
+  pthread_join (loader->thread, NULL);
+
+  pthread_cond_destroy (&loader->cond);
+  pthread_mutex_destroy (&loader->lock);
+  close (loader->pipe[0]);
+  close (loader->pipe[1]);
+  free (loader->request);
+  free (loader->file_name);
+  if (loader->text != NULL)
+    {
+      text_free (loader->text);
+    }
+  for (i = 0; i < loader->nr_prefetch; i++)
+    {
+      free (loader->prefetch[i]);
+    }
+  for (i = 0; i < FILE_LOADER_CACHE; i++)
+    {
+      if (loader->cache[i].file_name != NULL)
+	{
+	  free (loader->cache[i].file_name);
+	  text_free (loader->cache[i].text);
+	}
+    }
+  free (loader);
+}
+
+/**
+ * @brief Get the file descriptor to wait on.
+ *
+ * @param loader The loader.
+ *
+ * @return A descriptor that is readable when file_loader_take() has a file.
+ */
+int
+file_loader_fd (file_loader * loader)
+{
+  assert (loader);
+
+  return loader->pipe[0];
+}
+
+/**
+ * @brief Load a file.
+ *
+ * Load a file in the background. Replaces the file waiting to be loaded, if
+ * any.
+ *
+ * @param loader The loader.
+ * @param file_name The file.
+ *
+ * @return 0 upon success, otherwise -1.
+ */
+int
+file_loader_request (file_loader * loader, const char *file_name)
+{
+  char *copy;
+
+  assert (loader);
+  assert (file_name);
+
+  copy = strdup (file_name);
+  LOG_ERR_IF_RETURN (copy == NULL, -1, ERR_MSG_CREATE ("file name"));
+
+  pthread_mutex_lock (&loader->lock);
+  free (loader->request);
+  loader->request = copy;
+  pthread_cond_signal (&loader->cond);
+  pthread_mutex_unlock (&loader->lock);
+
+  return 0;
+}
+
+/**
+ * @brief Take a loaded file.
+ *
+ * @param loader The loader.
+ * @param file_name Set to the name of the file. Should be freed by the
+ *        caller.
+ * @param text Set to the text of the file, NULL if it could not be read.
+ *        Should be freed by the caller.
+ *
+ * @return 1 if a file was taken, 0 if no file has been loaded.
+ */
+int
+file_loader_take (file_loader * loader, char **file_name, text ** text)
+{
+  char buf[64];
+  int ret = 0;
+
+  assert (loader);
+  assert (file_name);
+  assert (text);
+
+  pthread_mutex_lock (&loader->lock);
+  while (read (loader->pipe[0], buf, sizeof (buf)) > 0)
+    {
+    }
+  if (loader->file_name != NULL)
+    {
+      *file_name = loader->file_name;
+      *text = loader->text;
+      loader->file_name = NULL;
+      loader->text = NULL;
+      ret = 1;
+    }
+  pthread_mutex_unlock (&loader->lock);
+
+  return ret;
+}
+
+/**
+ * @brief Prefetch a file.
+ *
+ * Load a file in the background when there is no request, and keep it until
+ * it is requested. Files that are already prefetched or waiting are not
+ * added again.
+ *
+ * @param loader The loader.
+ * @param file_name The file.
+ *
+ * @return 0 upon success, 1 if the file is already prefetched, -1 if too
+ *         many files are waiting.
+ */
+int
+file_loader_prefetch (file_loader * loader, const char *file_name)
+{
+  int ret = 0;
+  int i;
+
+  assert (loader);
+  assert (file_name);
+
+  pthread_mutex_lock (&loader->lock);
+  if (file_loader_find (loader, file_name) != NULL)
+    {
+      ret = 1;
+      goto out;
+    }
+  for (i = 0; i < loader->nr_prefetch; i++)
+    {
+      if (strcmp (loader->prefetch[i], file_name) == 0)
+	{
+	  goto out;
+	}
+    }
+  if (loader->nr_prefetch == FILE_LOADER_PREFETCH)
+    {
+      ret = -1;
+      goto out;
+    }
+  loader->prefetch[loader->nr_prefetch] = strdup (file_name);
+  LOG_ERR_IF_FATAL (loader->prefetch[loader->nr_prefetch] == NULL,
+		    ERR_MSG_CREATE ("file name"));
+  loader->nr_prefetch++;
+  pthread_cond_signal (&loader->cond);
+
+out:
+  pthread_mutex_unlock (&loader->lock);
+  return ret;
+}
@@ -0,0 +1,47 @@
+/* A simple front end debugger.
+   Copyright (C) 2012 Kenneth Olsson
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file file_loader.h
+ *
+ * @brief Interface for loading text files in the background.
+ *
+ * The files are read by a thread of their own, so a slow file system does
+ * not stop the user interface or the debugger records. A file descriptor
+ * becomes readable when a file has been loaded. Files that may be shown
+ * next can be prefetched.
+ */
+#ifndef FILE_LOADER_H
+#define FILE_LOADER_H
+
+#include "text.h"
+
+/*******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+typedef struct file_loader_t file_loader;
+
+/*******************************************************************************
+ * Public functions
+ ******************************************************************************/
+file_loader *file_loader_create (void);
+void file_loader_free (file_loader * loader);
+int file_loader_fd (file_loader * loader);
+int file_loader_request (file_loader * loader, const char *file_name);
+int file_loader_take (file_loader * loader, char **file_name, text ** text);
+int file_loader_prefetch (file_loader * loader, const char *file_name);
+#endif
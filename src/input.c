@@ -52,6 +52,10 @@ struct input_t
   view *view;	       /**< The view. For commands that alter the view. */
   configuration *conf; /**< The configuration. */
   int fd;	       /**< The fd to the debugger. */
+  int target_fd;       /**< The terminal of the program, -1 if none. */
+  char *search;	       /**< The last searched pattern, NULL if none. */
+  int search_dir;      /**< 1 if searching forward, -1 if backward. */
+  int search_typed;    /**< 1 if the pattern has been edited. */
 };
 
 /*******************************************************************************
@@ -59,15 +63,46 @@ struct input_t
  ******************************************************************************/
 void input_change_mode (input * input);
 void input_load_file (input * input);
+void input_browse_file (input * input);
+void input_go_to_function (input * input);
 int inputParseEnter (input * input);
+int input_fetch_frames (input * input);
+int input_fetch_memory (input * input);
+void input_search_update (void *data, const char *pattern);
+void input_search (input * input, int dir);
+
+/**
+ * @brief Copy the output of a file descriptor to stdout.
+ *
+ * @param fd The file descriptor, non blocking.
+ */
+static void
+input_copy_output (int fd)
+{
+  char line[LINE_SIZE];
+  int ret;
+
+  do
+    {
+      ret = read (fd, line, LINE_SIZE - 1);
+      if (ret > 0)
+	{
+	  line[ret] = '\0';
+	  fprintf (stdout, "%s\r\n", line);
+	}
+      fflush (stdout);
+    }
+  while (ret > 0);
+}
 
 /**
  * @brief Put view in non ncurse mode.
  *
  * Put view in non ncurse mode and send command or user input direct to gdb.
+ * If the program has a terminal of its own the input is sent to the program
+ * instead, <C-t> switches between the program and the debugger.
  *
  * NOTE: lvdbg do not parser the debugger output.
- * NOTE: To stop the mode press Ctrl-q
  *
  * @todo This function should not be in input. Mainloop?
  *
@@ -81,14 +116,20 @@ input_change_mode (input * input)
   struct termios attr;
   struct termios org;
   FILE *f;
-  char line[LINE_SIZE];
   fd_set rfds;
   int retval;
+  int to_target;
+  int nfds;
 
   assert (input);
 
   view_toggle_view_mode (input->view);
   fprintf (stdout, _("Press <C-q> to go back to lvdbg\r\n"));
+  if (input->target_fd >= 0)
+    {
+      fprintf (stdout, _("Press <C-t> to switch between the program and "
+			 "the debugger\r\n"));
+    }
   fflush (stdout);
 
   f = fdopen (input->fd, "r+");
@@ -100,13 +141,19 @@ input_change_mode (input * input)
   cfmakeraw (&attr);
   tcsetattr (0, TCSANOW, &attr);
 
+  to_target = input->target_fd >= 0;
+  nfds = (input->fd > input->target_fd ? input->fd : input->target_fd) + 1;
   do
     {
       FD_ZERO (&rfds);
       FD_SET (0, &rfds);
       FD_SET (input->fd, &rfds);
+      if (input->target_fd >= 0)
+	{
+	  FD_SET (input->target_fd, &rfds);
+	}
 
-      retval = select (input->fd + 1, &rfds, NULL, NULL, NULL);
+      retval = select (nfds, &rfds, NULL, NULL, NULL);
       if (retval == -1)
 	{
 	  LOG_ERR ("Select error");
@@ -122,22 +169,31 @@ input_change_mode (input * input)
 		  break;
 		}
 	      ch = 0xff & ret;
-	      fprintf (f, "%c", ch);
-	      fflush (f);
-	    }
-	  if (FD_ISSET (input->fd, &rfds))
-	    {
-	      do
+	      if (ret == 0x14 && input->target_fd >= 0)
 		{
-		  ret = read (input->fd, line, LINE_SIZE - 1);
-		  if (ret > 0)
-		    {
-		      line[ret] = '\0';
-		      fprintf (stdout, "%s\r\n", line);
-		    }
+		  to_target = !to_target;
+		  fprintf (stdout, "%s\r\n", to_target ? _("To the program")
+			   : _("To the debugger"));
 		  fflush (stdout);
 		}
-	      while (ret > 0);
+	      else if (to_target)
+		{
+		  LOG_ERR_IF (write (input->target_fd, &ch, 1) != 1,
+			      "Could not write to the program: %m");
+		}
+	      else
+		{
+		  fprintf (f, "%c", ch);
+		  fflush (f);
+		}
+	    }
+	  if (FD_ISSET (input->fd, &rfds))
+	    {
+	      input_copy_output (input->fd);
+	    }
+	  if (input->target_fd >= 0 && FD_ISSET (input->target_fd, &rfds))
+	    {
+	      input_copy_output (input->target_fd);
 	    }
 	}
     }
@@ -148,7 +204,49 @@ input_change_mode (input * input)
 }
 
 /**
- * @brief Set up a form for loading a file.
+ * @brief Set up a form for loading a source file.
+ *
+ * Let the user search the source files of the program and load the selected
+ * file to Main window. The source files are requested from the debugger
+ * the first time.
+ *
+ * @param input The input.
+ */
+void
+input_load_file (input * input)
+{
+  int ret;
+
+  ret = mi2_do_action (input->mi2, ACTION_FILE_LIST_EXEC_SORCES, 0);
+  if (ret < 0)
+    {
+      VLOG_ERR (input->view, _("Could not list source files"));
+    }
+}
+
+/**
+ * @brief Set up a form for going to a function.
+ *
+ * Let the user search the functions of the program and show the selected
+ * function in Main window. The functions are requested from the debugger
+ * the first time.
+ *
+ * @param input The input.
+ */
+void
+input_go_to_function (input * input)
+{
+  int ret;
+
+  ret = mi2_do_action (input->mi2, ACTION_SYMBOL_INFO_FUNCTIONS, 0);
+  if (ret < 0)
+    {
+      VLOG_ERR (input->view, _("Could not list functions"));
+    }
+}
+
+/**
+ * @brief Set up a form for browsing for a file.
  *
  * Set up a form for selecting and loading a file to Main window.
  *
@@ -157,7 +255,7 @@ input_change_mode (input * input)
  * @param input The input.
  */
 void
-input_load_file (input * input)
+input_browse_file (input * input)
 {
   char *file = NULL;
   char *full = NULL;
@@ -253,10 +351,17 @@ inputParseEnter (input * input)
     case WIN_CONSOLE:
     case WIN_TARGET:
     case WIN_LOG:
-    case WIN_RESPONSES:
     case WIN_BREAKPOINTS:
     case WIN_LIBRARIES:
+      break;
+    case WIN_RESPONSES:
+      ret = view_toggle_record (input->view);
+      break;
     case WIN_FRAME:
+      if (tag >= 0)
+	{
+	  ret = mi2_do_action (input->mi2, ACTION_VAR_TOGGLE, tag);
+	}
       break;
     case WIN_STACK:
       ret = mi2_do_action (input->mi2, ACTION_STACK_LIST_VARIABLES, tag);
@@ -276,6 +381,125 @@ inputParseEnter (input * input)
   return ret;
 }
 
+/**
+ * @brief Fetch more frames when moving in the stack window.
+ *
+ * Deep stacks are fetched page by page. If the stack window has focus, let
+ * the mi2 interface request more frames when the cursor gets near the last
+ * fetched frame.
+ *
+ * @param input The input object.
+ *
+ * @return 0 if no frames were needed or the request was sent, otherwise -1.
+ */
+int
+input_fetch_frames (input * input)
+{
+  int win_type = -1;
+  int line_nr;
+  const char *file_name;
+  int tag;
+
+  assert (input);
+
+  view_get_cursor (input->view, &win_type, &line_nr, &file_name);
+  if (win_type != WIN_STACK)
+    {
+      return 0;
+    }
+
+  tag = view_get_tag (input->view, &win_type);
+  if (tag < 0)
+    {
+      return 0;
+    }
+
+  return mi2_do_action (input->mi2, ACTION_STACK_LIST_MORE_FRAMES, tag);
+}
+
+/**
+ * @brief Read memory when moving in the memory window.
+ *
+ * If the memory window has focus, let the mi2 interface read the pages that
+ * were scrolled into view and are not cached.
+ *
+ * @param input The input object.
+ *
+ * @return 0 if no pages were needed or the requests were sent, otherwise -1.
+ */
+int
+input_fetch_memory (input * input)
+{
+  int win_type = -1;
+  int line_nr;
+  const char *file_name;
+
+  assert (input);
+
+  view_get_cursor (input->view, &win_type, &line_nr, &file_name);
+  if (win_type != WIN_MEMORY)
+    {
+      return 0;
+    }
+
+  return mi2_do_action (input->mi2, ACTION_DATA_READ_MEMORY, 0);
+}
+
+/**
+ * @brief Search as the pattern is typed.
+ *
+ * Called by the search form each time the pattern is edited.
+ *
+ * @param data The input.
+ * @param pattern The pattern typed so far.
+ */
+void
+input_search_update (void *data, const char *pattern)
+{
+  input *input = (struct input_t *) data;
+
+  input->search_typed = 1;
+  view_search (input->view, pattern, input->search_dir, 0);
+}
+
+/**
+ * @brief Search the current window.
+ *
+ * Let the user type a pattern and search the current window as it is typed.
+ * Accepting the last pattern unchanged goes to the next match. Canceling
+ * removes the search.
+ *
+ * @param input The input.
+ * @param dir 1 to search forward, -1 to search backward.
+ */
+void
+input_search (input * input, int dir)
+{
+  char *pattern;
+  int ret;
+
+  input->search_dir = dir;
+  input->search_typed = 0;
+  pattern = form_input (input->search, dir > 0 ? "/" : "?",
+			input_search_update, input);
+  if (pattern == NULL)
+    {
+      view_search (input->view, NULL, dir, 0);
+      return;
+    }
+
+  ret = view_search (input->view, pattern, dir, !input->search_typed);
+  if (ret < 0)
+    {
+      VLOG_INFO (input->view, _("Pattern not found: %s"), pattern);
+    }
+  if (input->search != NULL)
+    {
+      free (input->search);
+    }
+  input->search = pattern;
+}
+
 /*******************************************************************************
  * Public Functions
  ******************************************************************************/
@@ -306,10 +530,30 @@ input_create (view * view, mi2_interface * mi2, configuration * conf, int fd)
   new_input->mi2 = mi2;
   new_input->conf = conf;
   new_input->fd = fd;
+  new_input->target_fd = -1;
+  new_input->search = NULL;
+  new_input->search_dir = 1;
+  new_input->search_typed = 0;
 
   return new_input;
 }
 
+/**
+ * @brief Set the terminal of the program that is debugged.
+ *
+ * In non ncurse mode the user input is sent to the program.
+ *
+ * @param input The input object.
+ * @param fd The master of the terminal of the program, -1 if none.
+ */
+void
+input_set_target (input * input, int fd)
+{
+  assert (input);
+
+  input->target_fd = fd;
+}
+
 /**
  * @brief Free the input object.
  *
@@ -322,6 +566,10 @@ input_free (input * input)
 {
   assert (input);
 
+  if (input->search != NULL)
+    {
+      free (input->search);
+    }
   free (input);
 }
 
@@ -332,7 +580,8 @@ input_free (input * input)
  * a view object.
  *
  * The calling function has a select, so there should be at least one key to
- * read.
+ * read. It is also called when the select was interrupted, e.g. by a
+ * resize, and then there may be no key at all.
  *
  * @param input The input obejct to handle the user input.
  *
@@ -345,6 +594,8 @@ input_get_input (input * input)
   int ret = 0;
   int n;
   int i;
+  int j;
+  int resize = 0;
   int quit = 0;
   int cright[] = { 0x1b, 0x5b, 0x31, 0x3b, 0x35, 0x44 };
   int cleft[] = { 0x1b, 0x5b, 0x31, 0x3b, 0x35, 0x43 };
@@ -360,15 +611,51 @@ input_get_input (input * input)
   while (key[n - 1] != ERR);
   n--;
 
+  /* Lay out the windows once for all the resize events. */
+  for (i = 0, j = 0; i < n; i++)
+    {
+      if (key[i] == KEY_RESIZE)
+	{
+	  resize = 1;
+	}
+      else
+	{
+	  key[j++] = key[i];
+	}
+    }
+  n = j;
+  if (resize)
+    {
+      view_resize (input->view);
+    }
+
   if (n == 1)
     {
       switch (key[0])
 	{
 	case KEY_DOWN:
 	  view_scroll_up (input->view);
+	  ret = input_fetch_frames (input);
+	  if (ret == 0)
+	    {
+	      ret = input_fetch_memory (input);
+	    }
 	  break;
 	case KEY_UP:
 	  view_scroll_down (input->view);
+	  ret = input_fetch_memory (input);
+	  break;
+	case KEY_NPAGE:
+	  view_scroll_page (input->view, 1);
+	  ret = input_fetch_frames (input);
+	  if (ret == 0)
+	    {
+	      ret = input_fetch_memory (input);
+	    }
+	  break;
+	case KEY_PPAGE:
+	  view_scroll_page (input->view, -1);
+	  ret = input_fetch_memory (input);
 	  break;
 	case KEY_RIGHT:
 	  view_next_window (input->view, 1, 0);
@@ -440,7 +727,10 @@ input_get_input (input * input)
 	  input_load_file (input);
 	  break;
 	case KEY_F (5):
-	  ret = mi2_do_action (input->mi2, ACTION_FILE_LIST_EXEC_SORCES, 0);
+	  input_browse_file (input);
+	  break;
+	case 'g':
+	  input_go_to_function (input);
 	  break;
 	case 'd':
 	  mi2_toggle_disassemble (input->mi2);
@@ -449,6 +739,24 @@ input_get_input (input * input)
 	case 'm':
 	  input_change_mode (input);
 	  break;
+	case '/':
+	  input_search (input, 1);
+	  break;
+	case '?':
+	  input_search (input, -1);
+	  break;
+	case 'x':
+	  ret = mi2_do_action (input->mi2, ACTION_DATA_MEMORY, 0);
+	  break;
+	case 'W':
+	  view_toggle_wrap (input->view);
+	  break;
+	case '<':
+	  view_scroll_columns (input->view, -1);
+	  break;
+	case '>':
+	  view_scroll_columns (input->view, 1);
+	  break;
 	case 'q':
 	  /* Quit the program. */
 	  quit = -1;
@@ -457,7 +765,7 @@ input_get_input (input * input)
 	  DINFO (3, "Unhandled input: %d - %c", key[0], key[0]);
 	}
     }
-  else
+  else if (n > 1)
     {
       if (memcmp (cright, key, sizeof (cright)) == 0)
 	{
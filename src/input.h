@@ -43,5 +43,6 @@ typedef struct input_t input;
 input *input_create (view * view, mi2_interface * mi2, configuration * conf,
 		     int fd);
 void input_free (input * input);
+void input_set_target (input * input, int fd);
 int input_get_input (input * input);
 #endif
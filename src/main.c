@@ -27,6 +27,7 @@
 #include <sys/select.h>
 #include <string.h>
 #include <fcntl.h>
+#include <errno.h>
 
 #include "lvdbg.h"
 #include "view.h"
@@ -41,13 +42,17 @@
 
 #define LINE_LEN 8192
 #define GDB_DBG "gdb --fullname --interpreter=mi2"
+#define TARGET_LEN 65536    /**< Size of the buffer for the program output. */
+#define TARGET_MAX_READS 16 /**< Max reads of program output per wake up. */
 
 /*******************************************************************************
  * Internal Functions
  ******************************************************************************/
 static error_t parseOpt (int key, char *arg, struct argp_state *state);
-static int mainLoop (int fd, view * view, input * input, mi2_interface * mi2,
-		     configuration * conf);
+static int read_target (int fd, view * view, char *buf, int *len);
+static void parse_line (char *line, view * view, mi2_interface * mi2);
+static int mainLoop (int fd, int target_fd, view * view, input * input,
+		     mi2_interface * mi2, configuration * conf);
 static int setupconf (configuration * conf);
 
 /*******************************************************************************
@@ -64,6 +69,16 @@ struct arguments
   char *conf_file;
 };
 
+/** A line from the debugger longer than the line buffer. */
+struct long_line_t
+{
+  char *buf;	/**< The line read so far, NULL if streamed. */
+  int len;	/**< The length of @a buf. */
+  int size;	/**< The size of @a buf. */
+  int mi;	/**< 1 if the line is a mi2 record. */
+  int streamed;	/**< 1 if the record is parsed as it arrives. */
+};
+
 /*******************************************************************************
  * Global variables
  ******************************************************************************/
@@ -112,15 +127,229 @@ FILE *OUT_FILE = NULL;
 /*******************************************************************************
  * Internal Functions
  ******************************************************************************/
+/**
+ * @brief Read the output of the program that is debugged.
+ *
+ * The output is read in large chunks until there is no more, or for at most
+ * #TARGET_MAX_READS reads so the user input is not starved, and added to
+ * the Target window in one batch.
+ *
+ * @param fd The master of the terminal of the program, non blocking.
+ * @param view The view.
+ * @param buf The buffer, #TARGET_LEN bytes.
+ * @param len The number of bytes in @a buf.
+ *
+ * @return The number of bytes read.
+ */
+static int
+read_target (int fd, view * view, char *buf, int *len)
+{
+  int total = 0;
+  char *p;
+  int ret = 0;
+  int n;
+  int i;
+
+  for (i = 0; i < TARGET_MAX_READS; i++)
+    {
+      ret = read (fd, buf + *len, TARGET_LEN - 1 - *len);
+      if (ret <= 0)
+	{
+	  break;
+	}
+      /* A nul would end the text. */
+      for (p = buf + *len; p < buf + *len + ret; p++)
+	{
+	  if (*p == '\0')
+	    {
+	      *p = '?';
+	    }
+	}
+      *len += ret;
+      total += ret;
+
+      /* Add the complete lines, or all of them if the buffer is full. */
+      for (n = *len; n > 0 && buf[n - 1] != '\n'; n--)
+	{
+	}
+      if (n > 0)
+	{
+	  buf[n - 1] = '\0';
+	  view_add_lines (view, WIN_TARGET, buf);
+	  memmove (buf, buf + n, *len - n);
+	  *len -= n;
+	}
+      else if (*len == TARGET_LEN - 1)
+	{
+	  buf[*len] = '\0';
+	  view_add_lines (view, WIN_TARGET, buf);
+	  *len = 0;
+	}
+    }
+
+  /* Do not hold back a prompt. */
+  if (ret < 0 && *len > 0)
+    {
+      buf[*len] = '\0';
+      view_add_lines (view, WIN_TARGET, buf);
+      *len = 0;
+    }
+
+  return total;
+}
+
+/**
+ * @brief Parse a line from the debugger.
+ *
+ * The line is shown in the window of its stream, the records are also given
+ * to the mi2 parser.
+ *
+ * @param line The line, without the '\\n'. The line will be altered.
+ * @param view The view.
+ * @param mi2 The mi2 interface.
+ */
+static void
+parse_line (char *line, view * view, mi2_interface * mi2)
+{
+  int ret;
+
+  switch (*line)
+    {
+    case '~':
+      ret = unescape (line + 1, "\r\n\v");
+      if (ret == 0)
+	{
+	  view_add_line (view, WIN_CONSOLE, line + 1, -1);
+	}
+      break;
+    case '@':
+      ret = unescape (line + 1, "\r\n\v");
+      if (ret == 0)
+	{
+	  view_add_line (view, WIN_TARGET, line + 1, -1);
+	}
+      break;
+    case '&':
+      ret = unescape (line + 1, "\r\n\v");
+      if (ret == 0)
+	{
+	  view_add_line (view, WIN_LOG, line + 1, -1);
+	}
+      break;
+    case '^':			/* MI */
+    case '*':			/* Async records. */
+    case '=':			/* Asyc records. */
+      ret = unescape (line + 1, "\r\n\v");
+      if (ret == 0)
+	{
+	  view_add_record (view, line);
+	  mi2_parse (mi2, line);
+	}
+      break;
+    case '(':
+      if (strncmp (line, "(gdb)", 5) == 0)
+	{
+	  break;
+	}
+      /* Fall through */
+    default:
+      view_add_line (view, WIN_TARGET, line, -1);
+      DINFO (3, "Unknown stream record: '%s'", line);
+    }
+}
+
+/**
+ * @brief Read a part of a line that did not fit in the line buffer.
+ *
+ * The parts of the records are given to the mi2 parser as they arrive. If
+ * the record is parsed as it arrives, only its first part is kept and shown
+ * in the Responses window. Otherwise the parts are kept until the line has
+ * ended and it is parsed by parse_line().
+ *
+ * @param record The line read so far.
+ * @param part The part.
+ * @param len The length of @a part.
+ * @param end 1 if the line ends with @a part.
+ * @param view The view.
+ * @param mi2 The mi2 interface.
+ */
+static void
+read_long_line (struct long_line_t *record, const char *part, int len,
+		int end, view * view, mi2_interface * mi2)
+{
+  char *p;
+  int streamed = 0;
+
+  if (record->len == 0 && !record->streamed)
+    {
+      record->mi = *part == '^' || *part == '*' || *part == '=';
+    }
+  if (record->mi)
+    {
+      streamed = mi2_feed (mi2, part, len);
+      if (end)
+	{
+	  streamed = mi2_feed (mi2, "\n", 1);
+	}
+    }
+
+  if (!record->streamed)
+    {
+      if (record->len + len + 1 > record->size)
+	{
+	  record->size = 2 * (record->len + len + 1);
+	  p = (char *) realloc (record->buf, record->size);
+	  LOG_ERR_IF_FATAL (p == NULL, ERR_MSG_CREATE ("line"));
+	  record->buf = p;
+	}
+      memcpy (record->buf + record->len, part, len);
+      record->len += len;
+      record->buf[record->len] = '\0';
+    }
+  if (!record->streamed && streamed)
+    {
+      DINFO (3, "Streaming '%.40s'", record->buf);
+      view_add_record (view, record->buf);
+      free (record->buf);
+      record->buf = NULL;
+      record->len = 0;
+      record->size = 0;
+      record->streamed = 1;
+    }
+
+  if (end)
+    {
+      if (!record->streamed)
+	{
+	  parse_line (record->buf, view, mi2);
+	}
+      free (record->buf);
+      record->buf = NULL;
+      record->len = 0;
+      record->size = 0;
+      record->streamed = 0;
+    }
+}
+
 static int
-mainLoop (int fd, view * view, input * input, mi2_interface * mi2,
-	  configuration * conf)
+mainLoop (int fd, int target_fd, view * view, input * input,
+	  mi2_interface * mi2, configuration * conf)
 {
   fd_set rfds;
+  struct timeval no_wait;
+  long wait;
+  int idle = 0;
   int retval;
+  int load_fd;
+  int max_fd;
   char line[LINE_LEN];
+  char target[TARGET_LEN];
+  int target_len = 0;
+  struct long_line_t long_line = { NULL, 0, 0, 0, 0 };
   FILE *dbg_file = NULL;
   char *p;
+  int len;
+  int end;
   int flags;
   int ret;
 
@@ -140,19 +369,52 @@ mainLoop (int fd, view * view, input * input, mi2_interface * mi2,
       ret = -1;
       goto error;
     }
+  load_fd = view_loader_fd (view);
+  max_fd = fd > target_fd ? fd : target_fd;
+  max_fd = max_fd > load_fd ? max_fd : load_fd;
   while (1)
     {
       FD_ZERO (&rfds);
       FD_SET (0, &rfds);
       FD_SET (fd, &rfds);
+      if (target_fd >= 0)
+	{
+	  FD_SET (target_fd, &rfds);
+	}
+      if (load_fd >= 0)
+	{
+	  FD_SET (load_fd, &rfds);
+	}
 
-      retval = select (fd + 1, &rfds, NULL, NULL, NULL);
+      /*
+       * Do not wait while there is idle work to do, or longer than until
+       * the screen update that was put off.
+       */
+      wait = idle ? 0 : view_refresh_time (view);
+      no_wait.tv_sec = wait > 0 ? wait / 1000000 : 0;
+      no_wait.tv_usec = wait > 0 ? wait % 1000000 : 0;
+      retval = select (max_fd + 1, &rfds, NULL, NULL,
+		       wait >= 0 ? &no_wait : NULL);
       if (retval == -1)
 	{
-	  perror ("select()");
+	  if (errno != EINTR)
+	    {
+	      LOG_ERR ("Could not wait for input: %m");
+	    }
+	  /* A resize interrupts select, its KEY_RESIZE is waiting. */
+	  else if (input_get_input (input) == -1)
+	    {
+	      ret = 0;
+	      goto error;
+	    }
 	}
-      else if (retval)
+      else if (retval == 0)
 	{
+	  idle = view_idle (view);
+	}
+      else
+	{
+	  idle = 1;
 	  if (FD_ISSET (0, &rfds))
 	    {
 	      ret = input_get_input (input);
@@ -171,60 +433,37 @@ mainLoop (int fd, view * view, input * input, mi2_interface * mi2,
 		    {
 		      break;
 		    }
-		  if (line[strlen (line) - 1] == '\n')
+		  len = strlen (line);
+		  end = len > 0 && line[len - 1] == '\n';
+		  if (end)
 		    {
-		      line[strlen (line) - 1] = '\0';
+		      line[--len] = '\0';
 		    }
-		  switch (*line)
+		  if (end && long_line.len == 0 && !long_line.streamed)
 		    {
-		    case '~':
-		      ret = unescape (line + 1, "\r\n\v");
-		      if (ret == 0)
-			{
-			  view_add_line (view, WIN_CONSOLE, line + 1, -1);
-			}
-		      break;
-		    case '@':
-		      ret = unescape (line + 1, "\r\n\v");
-		      if (ret == 0)
-			{
-			  view_add_line (view, WIN_TARGET, line + 1, -1);
-			}
-		      break;
-		    case '&':
-		      ret = unescape (line + 1, "\r\n\v");
-		      if (ret == 0)
-			{
-			  view_add_line (view, WIN_LOG, line + 1, -1);
-			}
-		      break;
-		    case '^':	/* MI */
-		    case '*':	/* Async records. */
-		    case '=':	/* Asyc records. */
-		      ret = unescape (line + 1, "\r\n\v");
-		      if (ret == 0)
-			{
-			  view_add_line (view, WIN_RESPONSES, line, -1);
-			  mi2_parse (mi2, line);
-			}
-		      break;
-		    case '(':
-		      if (strncmp (line, "(gdb)", 5) == 0)
-			{
-			  continue;
-			}
-		      /* Fall through */
-		    default:
-		      view_add_line (view, WIN_TARGET, line, -1);
-		      LOG_ERR ("Unknown stream record: '%s'", line);
+		      parse_line (line, view, mi2);
+		    }
+		  else
+		    {
+		      read_long_line (&long_line, line, len, end, view, mi2);
 		    }
 		}
 	      while (1);
+	      mi2_flush (mi2);
+	    }
+	  if (target_fd >= 0 && FD_ISSET (target_fd, &rfds))
+	    {
+	      read_target (target_fd, view, target, &target_len);
+	    }
+	  if (load_fd >= 0 && FD_ISSET (load_fd, &rfds))
+	    {
+	      view_file_loaded (view);
 	    }
 	}
     }
   return 0;
 error:
+  free (long_line.buf);
   if (dbg_file != NULL)
     {
       fclose (dbg_file);
@@ -310,6 +549,9 @@ main (int argc, char *argv[])
   input *input;
   char *home;
   char *local_conf;
+  char target_name[64];
+  int target_fd = -1;
+  int target_slave = -1;
 
   arguments.quiet = 0;
   arguments.verbose = 0;
@@ -411,8 +653,32 @@ main (int argc, char *argv[])
       exit (EXIT_FAILURE);
     }
 
-  ret = mainLoop (fd, view, input, mi2, conf);
+  /* The program gets a terminal of its own, its output is not MI. */
+  if (open_pty (&target_fd, &target_slave, target_name,
+		sizeof (target_name)) == 0
+      && mi2_set_inferior_tty (mi2, target_name) == 0)
+    {
+      DINFO (1, "Program terminal: %s", target_name);
+      input_set_target (input, target_fd);
+    }
+  else
+    {
+      LOG_ERR ("Could not set up a terminal for the program.");
+      if (target_fd >= 0)
+	{
+	  close (target_fd);
+	  close (target_slave);
+	  target_fd = -1;
+	}
+    }
+
+  ret = mainLoop (fd, target_fd, view, input, mi2, conf);
   DINFO (1, "Program exits with %d", ret);
+  if (target_fd >= 0)
+    {
+      close (target_fd);
+      close (target_slave);
+    }
   view_cleanup (view);
   mi2_free (mi2);
   input_free (input);
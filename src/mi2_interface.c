@@ -78,11 +78,26 @@
  * Stack action commands.
  */
 /*@{*/
-#define CMD_STACK_LIST_FRAMES    "-stack-list-frames --thread %d\n"
+#define CMD_STACK_INFO_DEPTH     "-stack-info-depth --thread %d\n"
+#define CMD_STACK_LIST_FRAMES    "-stack-list-frames --thread %d %d %d\n"
 #define CMD_STACK_LIST_VARIABLES "-stack-list-variables --thread %d " \
                                  "--frame %d %s\n"
 /*@}*/
 
+/**
+ * @name Variable object commands.
+ *
+ * Commands for variable objects. The variables in the frame window are backed
+ * by variable objects, which are updated once per stop and expanded into
+ * their children.
+ */
+/*@{*/
+#define CMD_VAR_CREATE        "-var-create --thread %d --frame %d %s * %s\n"
+#define CMD_VAR_LIST_CHILDREN "-var-list-children --simple-values %s\n"
+#define CMD_VAR_DELETE        "-var-delete %s\n"
+#define CMD_VAR_UPDATE        "-var-update --all-values *\n"
+/*@}*/
+
 /**
  * @name Thread commands.
  *
@@ -101,6 +116,16 @@
  */
 /*@{*/
 #define CMD_FILE_LIST_EXEC_SOURCE_FILES "-file-list-exec-source-files\n"
+#define CMD_SYMBOL_INFO_FUNCTIONS "-symbol-info-functions\n"
+/*@}*/
+
+/**
+ * @name Inferior commands.
+ *
+ * Commands for setting up the program that is debugged.
+ */
+/*@{*/
+#define CMD_INFERIOR_TTY_SET "-inferior-tty-set %s\n"
 /*@}*/
 
 /**
@@ -115,6 +140,30 @@
 #define CMD_DATA_LIST_CHANGED_REGISTERS "-data-list-changed-registers\n"
 #define CMD_DATA_LIST_REGISTERS_VALUES "-data-list-register-values x %s\n"
 #define CMD_DATA_PC "-data-evaluate-expression $pc\n"
+#define CMD_DATA_READ_MEMORY "-data-read-memory \"%s\" x 1 1 1\n"
+#define CMD_DATA_READ_MEMORY_BYTES "-data-read-memory-bytes 0x%" PRIx64 " %d\n"
+/*@}*/
+
+/**
+ * @name Memory paging.
+ *
+ * The memory window is read a page at the time, see #MEM_PAGE_SIZE.
+ */
+/*@{*/
+#define MEM_DEFAULT_LENGTH 65536 /**< Default length of a memory region. */
+#define MEM_MAX_REQUEST 64 /**< Max number of pages requested at once. */
+/*@}*/
+
+/**
+ * @name Stack paging.
+ *
+ * Deep stacks are fetched a page at the time. A new page is requested when
+ * the cursor in the stack window comes within the prefetch margin of the
+ * last requested frame.
+ */
+/*@{*/
+#define STACK_PAGE     32 /**< Number of frames fetched per request. */
+#define STACK_PREFETCH 8  /**< Margin to the last requested frame. */
 /*@}*/
 
 /*******************************************************************************
@@ -130,6 +179,7 @@ struct mi2_interface_t
   mi2_parser *parser;  /**< The parser object. */
 
   int disassemble; /**< 1 if we should see disassembly. */
+  int stack_requested; /**< Number of frames requested of current stack. */
 };
 
 /*******************************************************************************
@@ -138,6 +188,9 @@ struct mi2_interface_t
 static void mi2_do_data_list_register_val (mi2_interface * mi2,
 					   const char *regs);
 static void mi2_do_data_disassembly (mi2_interface * mi2);
+static char *mi2_escape (const char *text);
+static int mi2_do_data_memory (mi2_interface * mi2);
+static int mi2_do_data_read_memory (mi2_interface * mi2);
 static int mi2_do_break_delete (mi2_interface * mi2, int nr);
 static int mi2_do_break_insert (mi2_interface * mi2, const char *flags,
 				const char *location);
@@ -153,7 +206,11 @@ static int mi2_do_exec_stepi_nexti (mi2_interface * mi2, int step,
 				    int reverse);
 static int mi2_do_exec_jump (mi2_interface * mi2);
 static int mi2_do_stack_frames (mi2_interface * mi2);
+static int mi2_do_stack_more_frames (mi2_interface * mi2, int level);
 static int mi2_do_stack_variables (mi2_interface * mi2, int frame);
+static int mi2_do_var_toggle (mi2_interface * mi2, int id);
+static void mi2_do_var_requests (mi2_interface * mi2);
+static int mi2_parsed (mi2_interface * mi2, int ret, int update, char *regs);
 static int mi2_do_simple (mi2_interface * mi2, const char *message);
 
 /**
@@ -184,6 +241,140 @@ mi2_do_data_list_register_val (mi2_interface * mi2, const char *regs)
     }
 }
 
+/**
+ * @brief Escapes a string for a quoted mi2 parameter.
+ *
+ * Puts a backslash before each double quote and backslash in @a text.
+ *
+ * @param text The text to escape.
+ *
+ * @return The escaped text, which must be freed.
+ */
+static char *
+mi2_escape (const char *text)
+{
+  char *escaped;
+  char *p;
+
+  escaped = malloc (2 * strlen (text) + 1);
+  LOG_ERR_IF_FATAL (escaped == NULL, ERR_MSG_CREATE ("escaped string"));
+
+  for (p = escaped; *text != '\0'; text++)
+    {
+      if (*text == '"' || *text == '\\')
+	{
+	  *p++ = '\\';
+	}
+      *p++ = *text;
+    }
+  *p = '\0';
+
+  return escaped;
+}
+
+/**
+ * @brief Show a memory region.
+ *
+ * Ask the user for the address and length of the region. The address may
+ * be any expression, it is evaluated by the debugger with
+ * -data-read-memory.
+ *
+ * @param mi2 The mi2 interface.
+ *
+ * @return 0 if the command was sent or the user canceled the form. -1 if
+ *         the command could not be sent or no address was set.
+ */
+static int
+mi2_do_data_memory (mi2_interface * mi2)
+{
+  input_field fields[] = {
+    {_("*Address"), NULL, INPUT_TYPE_STRING, {.string_value = NULL}, 0, 0,
+     NULL},
+    {_("Length"), NULL, INPUT_TYPE_INT, {.int_value = MEM_DEFAULT_LENGTH}, 0,
+     0, NULL},
+    {NULL},
+  };
+  int ret;
+  int size = 64;
+  char buf[64];
+  char *p = buf;
+  char *address = NULL;
+
+  ret = form_run (fields, _("Show memory"));
+  if (ret < 0)
+    {
+      /* Cancel. */
+      ret = 0;
+      goto error;
+    }
+
+  if (fields[0].string_value == NULL || strlen (fields[0].string_value) == 0
+      || fields[1].int_value <= 0)
+    {
+      VLOG_ERR (mi2->view, _("Memory must have an address and a length"));
+      ret = -1;
+      goto error;
+    }
+
+  address = mi2_escape (fields[0].string_value);
+  LPRINT (p, p != buf, size, CMD_DATA_READ_MEMORY, address);
+  mi2_parser_memory_locate (mi2->parser, fields[1].int_value);
+
+  ret = safe_write (mi2->debugger_fd, p);
+  VLOG_WARN_IF (ret < 0, mi2->view, SEND_ERROR, p);
+  /* Fall through. */
+
+error:
+  free (fields[0].string_value);
+  free (address);
+  if (p != buf)
+    {
+      free (p);
+    }
+
+  return ret;
+}
+
+/**
+ * @brief Read the memory in the memory window.
+ *
+ * Send -data-read-memory-bytes for each shown or prefetched page that is
+ * not cached.
+ *
+ * @param mi2 The mi2 interface.
+ *
+ * @return 0 if the commands were sent or no pages were needed, otherwise -1.
+ */
+static int
+mi2_do_data_read_memory (mi2_interface * mi2)
+{
+  uint64_t address;
+  uint64_t length;
+  uint64_t pages[MEM_MAX_REQUEST];
+  char buf[64];
+  int nr;
+  int i;
+  int ret;
+
+  ret = view_get_memory_view (mi2->view, &address, &length);
+  if (ret < 0)
+    {
+      return 0;
+    }
+
+  nr = mi2_parser_memory_pages (mi2->parser, address, length, pages,
+				MEM_MAX_REQUEST);
+  for (i = 0; i < nr; i++)
+    {
+      snprintf (buf, sizeof (buf), CMD_DATA_READ_MEMORY_BYTES, pages[i],
+		MEM_PAGE_SIZE);
+      ret = safe_write (mi2->debugger_fd, buf);
+      LOG_ERR_IF_RETURN (ret < 0, -1, SEND_ERROR, buf);
+    }
+
+  return 0;
+}
+
 /**
  * @brief Send disassembly command.
  *
@@ -981,7 +1172,8 @@ error:
 /**
  * @brief Send list frame command.
  *
- * Send -stack-list-frame command.
+ * Send -stack-info-depth to get the depth of the new stack, followed by
+ * -stack-list-frame for the first page of frames.
  *
  * @param mi2 The mi2.
  *
@@ -1000,10 +1192,67 @@ mi2_do_stack_frames (mi2_interface * mi2)
 
   thread = mi2_parser_get_thread (mi2->parser);
 
-  /* Get all types. */
-  LPRINT (p, p != buf, size, CMD_STACK_LIST_FRAMES, thread);
+  LPRINT (p, p != buf, size, CMD_STACK_INFO_DEPTH, thread);
+  ret = safe_write (mi2->debugger_fd, p);
+  VLOG_WARN_IF_RETURN (ret < 0, -1, mi2->view, SEND_ERROR, p);
+
+  LPRINT (p, p != buf, size, CMD_STACK_LIST_FRAMES, thread, 0,
+	  STACK_PAGE - 1);
+  ret = safe_write (mi2->debugger_fd, p);
+  VLOG_WARN_IF_RETURN (ret < 0, -1, mi2->view, SEND_ERROR, p);
+  mi2->stack_requested = STACK_PAGE;
+
+  if (p != buf)
+    {
+      free (p);
+    }
+  return ret;
+}
+
+/**
+ * @brief Fetch more frames of the stack.
+ *
+ * Request the next page of frames if @a level is within the prefetch margin
+ * of the last requested frame, and the stack has more frames.
+ *
+ * @param mi2 The mi2.
+ * @param level The level of the frame under the cursor.
+ *
+ * @return 0 upon success.
+ */
+static int
+mi2_do_stack_more_frames (mi2_interface * mi2, int level)
+{
+  char buf[64];
+  char *p = buf;
+  int size = 64;
+  int thread;
+  int total;
+  int high;
+  int ret;
+
+  assert (mi2);
+
+  mi2_parser_get_stack_depth (mi2->parser, &total);
+  if (mi2->stack_requested <= 0
+      || level + STACK_PREFETCH < mi2->stack_requested
+      || (total >= 0 && mi2->stack_requested >= total))
+    {
+      return 0;
+    }
+
+  high = mi2->stack_requested + STACK_PAGE - 1;
+  if (total >= 0 && high >= total)
+    {
+      high = total - 1;
+    }
+  thread = mi2_parser_get_thread (mi2->parser);
+
+  LPRINT (p, p != buf, size, CMD_STACK_LIST_FRAMES, thread,
+	  mi2->stack_requested, high);
   ret = safe_write (mi2->debugger_fd, p);
   VLOG_WARN_IF_RETURN (ret < 0, -1, mi2->view, SEND_ERROR, p);
+  mi2->stack_requested = high + 1;
 
   if (p != buf)
     {
@@ -1015,9 +1264,10 @@ mi2_do_stack_frames (mi2_interface * mi2)
 /**
  * @brief Send the -stack-list-variables.
  *
- * Sends the -stack-list-variables to the debugger two times. First with the
- * option --simple-values, to retrieve name and type. The second time with
- * the option --all-values to get all values (but not the types).
+ * Sends the -stack-list-variables to the debugger with the option
+ * --no-values, to retrieve the names of the variables. The values are kept
+ * by variable objects, which the parser requests for new variables and
+ * which are updated by -var-update.
  *
  * The commands must be sent with the current thread id.
  *
@@ -1039,17 +1289,49 @@ mi2_do_stack_variables (mi2_interface * mi2, int frame)
 
   thread = mi2_parser_get_thread (mi2->parser);
 
-  /* Get all types. */
   LPRINT (p, p != buf, size, CMD_STACK_LIST_VARIABLES, thread, frame,
-	  "--simple-values");
+	  "--no-values");
   ret = safe_write (mi2->debugger_fd, p);
   VLOG_WARN_IF (ret < 0, mi2->view, SEND_ERROR, p);
 
-  /* Get all values. */
-  LPRINT (p, p != buf, size, CMD_STACK_LIST_VARIABLES, thread, frame,
-	  "--all-values");
+  if (p != buf)
+    {
+      free (p);
+    }
+  return 0;
+}
+
+/**
+ * @brief Expand or collapse a variable.
+ *
+ * Toggle the variable in the frame window. The children of the variable are
+ * listed if they have not been fetched before.
+ *
+ * @param mi2 The mi2 interface.
+ * @param id The id of the variable.
+ *
+ * @return 0 upon success, otherwise -1.
+ */
+static int
+mi2_do_var_toggle (mi2_interface * mi2, int id)
+{
+  char buf[128];
+  char *p = buf;
+  int size = 128;
+  const char *var_name;
+  int ret;
+
+  assert (mi2);
+
+  ret = mi2_parser_var_toggle (mi2->parser, id, &var_name);
+  if (ret <= VAR_ACTION_NONE)
+    {
+      return ret;
+    }
+
+  LPRINT (p, p != buf, size, CMD_VAR_LIST_CHILDREN, var_name);
   ret = safe_write (mi2->debugger_fd, p);
-  VLOG_WARN_IF (ret < 0, mi2->view, SEND_ERROR, p);
+  VLOG_WARN_IF_RETURN (ret < 0, -1, mi2->view, SEND_ERROR, p);
 
   if (p != buf)
     {
@@ -1058,6 +1340,54 @@ mi2_do_stack_variables (mi2_interface * mi2, int frame)
   return 0;
 }
 
+/**
+ * @brief Send the variable object requests.
+ *
+ * Send -var-create and -var-delete for the variable objects the parser has
+ * requested, e.g. for variables new to a frame or for frames that are gone.
+ *
+ * @param mi2 The mi2 interface.
+ */
+static void
+mi2_do_var_requests (mi2_interface * mi2)
+{
+  char buf[128];
+  char *p = buf;
+  int size = 128;
+  int action;
+  int thread;
+  int frame;
+  char *var_name;
+  char *exp;
+  int ret;
+
+  assert (mi2);
+
+  while ((action = mi2_parser_next_var_request (mi2->parser, &thread, &frame,
+						&var_name, &exp))
+	 != VAR_ACTION_NONE)
+    {
+      if (action == VAR_ACTION_CREATE)
+	{
+	  LPRINT (p, p != buf, size, CMD_VAR_CREATE, thread, frame, var_name,
+		  exp);
+	}
+      else
+	{
+	  LPRINT (p, p != buf, size, CMD_VAR_DELETE, var_name);
+	}
+      ret = safe_write (mi2->debugger_fd, p);
+      VLOG_WARN_IF (ret < 0, mi2->view, SEND_ERROR, p);
+      free (var_name);
+      free (exp);
+    }
+
+  if (p != buf)
+    {
+      free (p);
+    }
+}
+
 /**
  * @brief Send a simple command to the debugger.
  *
@@ -1082,6 +1412,73 @@ mi2_do_simple (mi2_interface * mi2, const char *command)
   return ret;
 }
 
+/**
+ * @brief Send the commands requested by a parsed record.
+ *
+ * Done after each record, whether it was parsed as a whole or as it
+ * arrived.
+ *
+ * @param mi2 The mi2 interface object.
+ * @param ret The result of the parsing.
+ * @param update 1 if the debugger stopped and the views must be updated.
+ * @param regs The registers whose values must be requested, or NULL.
+ *
+ * @return @a ret if the commands were sent. -1 if a command could not be
+ *         sent.
+ */
+static int
+mi2_parsed (mi2_interface * mi2, int ret, int update, char *regs)
+{
+  mi2_do_var_requests (mi2);
+  if (mi2_parser_disassembly_request (mi2->parser))
+    {
+      mi2_do_data_disassembly (mi2);
+    }
+  if (mi2_parser_memory_refresh (mi2->parser))
+    {
+      mi2_do_data_read_memory (mi2);
+    }
+  if (ret == 0 && regs != NULL)
+    {
+      mi2_do_data_list_register_val (mi2, regs);
+    }
+  if (ret == 0 && update)
+    {
+      /* One update of all variable objects, only the changes are sent. */
+      ret = mi2_do_simple (mi2, CMD_VAR_UPDATE);
+      if (ret < 0)
+	{
+	  return ret;
+	}
+      ret = mi2_do_action (mi2, ACTION_STACK_LIST_FRAMES, 0);
+      if (ret < 0)
+	{
+	  return ret;
+	}
+      ret = mi2_do_action (mi2, ACTION_THREAD_INFO, 0);
+      if (ret < 0)
+	{
+	  return ret;
+	}
+      ret = mi2_do_action (mi2, ACTION_STACK_LIST_VARIABLES, 0);
+      if (ret < 0)
+	{
+	  return ret;
+	}
+      if (mi2->disassemble > 0)
+	{
+	  ret = mi2_do_simple (mi2, CMD_DATA_LIST_CHANGED_REGISTERS);
+	  LOG_ERR_IF_RETURN (ret < 0, ret, SEND_ERROR,
+			     CMD_DATA_LIST_REGISTERS_VALUES);
+	  /* The function is only disassembled if the pc is not cached. */
+	  ret = mi2_do_simple (mi2, CMD_DATA_PC);
+	  LOG_ERR_IF_RETURN (ret < 0, ret, SEND_ERROR, CMD_DATA_PC);
+	}
+    }
+
+  return ret;
+}
+
 /*******************************************************************************
  * Public Functions
  ******************************************************************************/
@@ -1111,6 +1508,7 @@ mi2_create (int fd, pid_t pid, view * view, configuration * conf)
   LOG_ERR_IF_FATAL (mi2 == NULL, ERR_MSG_CREATE ("mi2 interface"));
 
   mi2->disassemble = -1;
+  mi2->stack_requested = 0;
   mi2->debugger_fd = fd;
   mi2->debugger_pid = pid;
   mi2->view = view;
@@ -1166,36 +1564,56 @@ mi2_parse (mi2_interface * mi2, char *line)
 
   DINFO (3, "Parsing '%s'", line);
   ret = mi2_parser_parse (mi2->parser, line, &update, &regs);
-  if (ret == 0 && regs != NULL)
-    {
-      mi2_do_data_list_register_val (mi2, regs);
-    }
-  if (ret == 0 && update)
+
+  return mi2_parsed (mi2, ret, update, regs);
+}
+
+/**
+ * @brief Parse a part of a record sent by the debugger.
+ *
+ * Used for records too long to be read as one line, see mi2_parser_feed().
+ *
+ * @param mi2 The mi2 interface object.
+ * @param buf The bytes of the record.
+ * @param len The number of bytes.
+ *
+ * @return 1 if the record is parsed as it arrives. 0 if the record must be
+ *         given to mi2_parse() when it has ended. -1 if the record was
+ *         parsed as it arrived but was broken.
+ */
+int
+mi2_feed (mi2_interface * mi2, const char *buf, int len)
+{
+  int ret;
+
+  assert (mi2);
+
+  ret = mi2_parser_feed (mi2->parser, buf, len);
+  if (ret != 0 && memchr (buf, '\n', len) != NULL)
     {
-      ret = mi2_do_action (mi2, ACTION_STACK_LIST_FRAMES, 0);
-      if (ret < 0)
-	{
-	  return ret;
-	}
-      ret = mi2_do_action (mi2, ACTION_THREAD_INFO, 0);
-      if (ret < 0)
-	{
-	  return ret;
-	}
-      if (mi2->disassemble > 0)
-	{
-	  ret = mi2_do_simple (mi2, CMD_DATA_LIST_CHANGED_REGISTERS);
-	  LOG_ERR_IF_RETURN (ret < 0, ret, SEND_ERROR,
-			     CMD_DATA_LIST_REGISTERS_VALUES);
-	  ret = mi2_do_simple (mi2, CMD_DATA_PC);
-	  LOG_ERR_IF_RETURN (ret < 0, ret, SEND_ERROR, CMD_DATA_PC);
-	  mi2_do_data_disassembly (mi2);
-	}
+      /* The record has ended. */
+      mi2_parsed (mi2, ret < 0 ? -1 : 0, 0, NULL);
     }
 
   return ret;
 }
 
+/**
+ * @brief Flush pending view updates.
+ *
+ * Called when all available lines from the debugger have been parsed, to
+ * let the parser redraw the views changed by the parsed records.
+ *
+ * @param mi2 The mi2 interface object.
+ */
+void
+mi2_flush (mi2_interface * mi2)
+{
+  assert (mi2);
+
+  mi2_parser_flush (mi2->parser);
+}
+
 /**
  * @brief Do mi2 actions.
  *
@@ -1280,6 +1698,12 @@ mi2_do_action (mi2_interface * mi2, int action, int param)
       mi2_parser_set_frame (mi2->parser, param);
       ret = mi2_do_stack_variables (mi2, param);
       break;
+    case ACTION_STACK_LIST_MORE_FRAMES:
+      ret = mi2_do_stack_more_frames (mi2, param);
+      break;
+    case ACTION_VAR_TOGGLE:
+      ret = mi2_do_var_toggle (mi2, param);
+      break;
     case ACTION_BP_SIMPLE:
       ret = mi2_do_break_simple (mi2);
       break;
@@ -1296,11 +1720,28 @@ mi2_do_action (mi2_interface * mi2, int action, int param)
       ret = mi2_do_simple (mi2, CMD_THREAD_INFO);
       break;
     case ACTION_FILE_LIST_EXEC_SORCES:
-      ret = mi2_do_simple (mi2, CMD_FILE_LIST_EXEC_SOURCE_FILES);
+      /* The source files are only requested once per symbol load. */
+      if (mi2_parser_find_file (mi2->parser) < 0)
+	{
+	  ret = mi2_do_simple (mi2, CMD_FILE_LIST_EXEC_SOURCE_FILES);
+	}
+      break;
+    case ACTION_SYMBOL_INFO_FUNCTIONS:
+      /* The functions are only requested once per symbol load. */
+      if (mi2_parser_find_symbol (mi2->parser) < 0)
+	{
+	  ret = mi2_do_simple (mi2, CMD_SYMBOL_INFO_FUNCTIONS);
+	}
       break;
     case ACTION_DATA_DISASSEMBLE:
       mi2_do_data_disassembly (mi2);
       break;
+    case ACTION_DATA_MEMORY:
+      ret = mi2_do_data_memory (mi2);
+      break;
+    case ACTION_DATA_READ_MEMORY:
+      ret = mi2_do_data_read_memory (mi2);
+      break;
     default:
       LOG_ERR ("Unknown action type");
       ret = -1;
@@ -1339,7 +1780,27 @@ mi2_toggle_disassemble (mi2_interface * mi2)
   mi2_parser_toggle_disassemble (mi2->parser);
   if (mi2->disassemble != 0)
     {
-      /* Fetch disassemble data. */
-      mi2_do_data_disassembly (mi2);
+      /* Fetch the pc, the function is disassembled if not cached. */
+      mi2_do_simple (mi2, CMD_DATA_PC);
     }
 }
+
+/**
+ * @brief Set the terminal of the program that is debugged.
+ *
+ * @param mi2 The mi2 interface.
+ * @param tty The name of the terminal.
+ *
+ * @return 0 if the command was sent. -1 on failure.
+ */
+int
+mi2_set_inferior_tty (mi2_interface * mi2, const char *tty)
+{
+  char buf[256];
+
+  assert (mi2);
+  assert (tty);
+
+  snprintf (buf, sizeof (buf), CMD_INFERIOR_TTY_SET, tty);
+  return mi2_do_simple (mi2, buf);
+}
@@ -82,6 +82,16 @@ enum mi2_actions
   /*@{ */
   ACTION_STACK_LIST_FRAMES,    /**< List frames in stack. */
   ACTION_STACK_LIST_VARIABLES, /**< List variables in the current frame. */
+  ACTION_STACK_LIST_MORE_FRAMES, /**< Fetch the frames below the cursor. */
+  /*@} */
+
+  /**
+   * @name Variable actions.
+   *
+   * The -var- family commands.
+   */
+  /*@{ */
+  ACTION_VAR_TOGGLE, /**< Expand or collapse a variable. */
   /*@} */
 
   /**
@@ -114,6 +124,15 @@ enum mi2_actions
   ACTION_FILE_LIST_EXEC_SORCES,	/**< List source files. */
   /*@} */
 
+  /**
+   * @name Symbol actions.
+   *
+   * The -symbol- family commands.
+   */
+  /*@{ */
+  ACTION_SYMBOL_INFO_FUNCTIONS,	/**< List functions. */
+  /*@} */
+
   /**
    * @name Data actions.
    *
@@ -121,6 +140,8 @@ enum mi2_actions
    */
   /*@{ */
   ACTION_DATA_DISASSEMBLE, /**< Ask for disassemble information. */
+  ACTION_DATA_MEMORY,	   /**< Show a memory region. */
+  ACTION_DATA_READ_MEMORY, /**< Read the pages in the memory window. */
   /*@} */
 };
 
@@ -136,6 +157,9 @@ mi2_interface *mi2_create (int fd, pid_t pid, view * view,
 			   configuration * conf);
 void mi2_free (mi2_interface * mi2);
 int mi2_parse (mi2_interface * mi2, char *line);
+int mi2_feed (mi2_interface * mi2, const char *buf, int len);
+void mi2_flush (mi2_interface * mi2);
 int mi2_do_action (mi2_interface * mi2, int action, int param);
 void mi2_toggle_disassemble (mi2_interface * mi2);
+int mi2_set_inferior_tty (mi2_interface * mi2, const char *tty);
 #endif
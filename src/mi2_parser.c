@@ -39,6 +39,7 @@
 #include "objects.h"
 #include "view.h"
 #include "misc.h"
+#include "mi2_stream.h"
 #include "debug.h"
 #include "win_form.h"
 
@@ -134,16 +135,57 @@
  */
 /*@{*/
 #define DONE_STACK      "stack"
+#define DONE_DEPTH      "depth"
 #define DONE_VARIABLES  "variables"
 #define DONE_THREADS    "threads"
 #define DONE_FILES      "files"
+#define DONE_SYMBOLS    "symbols"
 #define DONE_ASM_INSNS  "asm_insns"
 #define DONE_REGISTER_NAMES "register-names"
 #define DONE_CHANGED_REGISTERS "changed-registers"
 #define DONE_REGISTER_VALUES "register-values"
 #define DONE_VALUE "value"
+#define DONE_CHANGELIST "changelist"
 /*@}*/
 
+/**
+ * @name Symbol fields.
+ *
+ * The fields of -symbol-info-functions.
+ */
+/*@{*/
+#define SYMBOLS_DEBUG    "debug"
+#define SYMBOLS_FILENAME "filename"
+#define SYMBOLS_FULLNAME "fullname"
+#define SYMBOL_NAME      "name"
+#define SYMBOL_LINE      "line"
+/*@}*/
+
+#define SYMBOL_ITEM_LEN 512 /**< Max length of a symbol in the search form. */
+
+/**
+ * @name Memory fields.
+ *
+ * The fields of -data-read-memory-bytes, -data-read-memory and
+ * =memory-changed.
+ */
+/*@{*/
+#define DONE_MEMORY     "memory"
+#define MEMORY_BEGIN    "begin"
+#define MEMORY_OFFSET   "offset"
+#define MEMORY_END      "end"
+#define MEMORY_CONTENTS "contents"
+#define MEMORY_ADDR     "addr"
+#define MEMORY_LEN      "len"
+#define MEMORY_CHANGED  "=memory-changed"
+/*@}*/
+
+#define MEM_PREFETCH 4 /**< Pages read on each side of the memory view. */
+#define SOURCE_PREFETCH 8 /**< Top frames whose source files are prefetched. */
+
+#define REG_REPEATS "<repeats " /**< Repeated lanes in a vector register. */
+#define REG_MAX_LANES 64 /**< Max number of lanes in a vector register. */
+
 /**
  * @name Frame fields.
  *
@@ -164,6 +206,26 @@
 #define ARGS_VALUE        "value"
 /*@}*/
 
+/**
+ * @name Variable object fields.
+ *
+ * The fields from the responses of -var-create, -var-list-children and
+ * -var-update.
+ */
+/*@{*/
+#define VAR_NAME     "name"
+#define VAR_NUMCHILD "numchild"
+#define VAR_VALUE    "value"
+#define VAR_TYPE     "type"
+#define VAR_EXP      "exp"
+#define VAR_CHILDREN "children"
+#define VAR_CHILD    "child"
+#define VAR_IN_SCOPE         "in_scope"
+#define VAR_TYPE_CHANGED     "type_changed"
+#define VAR_NEW_TYPE         "new_type"
+#define VAR_NEW_NUM_CHILDREN "new_num_children"
+/*@}*/
+
 /**
  * @name Threads fields.
  *
@@ -179,6 +241,33 @@
 /*******************************************************************************
  * Internal structures and enums
  ******************************************************************************/
+/** A variable object command the mi2 interface has to send. */
+typedef struct var_request_t
+{
+  int action;	  /**< #VAR_ACTION_CREATE or #VAR_ACTION_DELETE. */
+  int thread_id;  /**< The thread of the frame. */
+  int frame;	  /**< The level of the frame. */
+  char *var_name; /**< The name of the variable object. */
+  char *exp;	  /**< The expression, NULL when deleting. */
+
+  struct var_request_t *next; /**< Next request. */
+} var_request;
+
+/** The state of a streamed result, e.g. '^done,files'. */
+typedef struct stream_result_t
+{
+  int level;	     /**< Number of open tuples and lists. */
+  int line_nr;	     /**< The source line of the instructions. */
+  char *file;	     /**< The file of the source line or file entry. */
+  char *fullname;    /**< The full name of the file entry. */
+  uint64_t address;  /**< The address of the instruction. */
+  int offset;	     /**< The offset of the instruction in the function. */
+  char *func_name;   /**< The function of the instruction. */
+  char *inst;	     /**< The instruction. */
+  int nr_insts;	     /**< Number of instructions of the source line. */
+  asm_function *func; /**< The disassembled function. */
+} stream_result;
+
 /** The mi2 parser structure. */
 struct mi2_parser_t
 {
@@ -192,10 +281,15 @@ struct mi2_parser_t
   int is_exit;	    /**< Set to 1 when debugger exits. */
 
   breakpoint_table *breakpoint_table; /**< Table of all breakpoints. */
-  library *libraries;		      /**< List of loaded libraries. */
+  library_table *libraries;	      /**< Table of loaded libraries. */
+  int libraries_changed;	      /**< 1 if the library view is stale. */
   thread_group *thread_groups;	      /**< List of thread groups and threads. */
   stack *stack;			      /**< The stack of the current thread. */
   int frame;			      /**< The current frame. */
+  int frame_changed;		      /**< 1 if the frame view is stale. */
+  scope *scopes;		      /**< Variables of the listed frames. */
+  var_request *requests;	      /**< Pending variable objects commands. */
+  var_request **last_request;	      /**< Where to add the next request. */
   int thread_id;   /**< The current thread id. */
 
   int auto_frames;  /**<
@@ -204,14 +298,34 @@ struct mi2_parser_t
                      * in the frame parameter will be shown.
                      */
   int disassemble;  /**< 1 if we should request disassembler information. */
-  assembler *ass_lines;	/**< A set of assembler lines. */
+  assembler *ass_lines;	/**< The cache of disassembled functions. */
+  asm_function *ass_shown; /**< The function in the disassemble window. */
+  int ass_request; /**< 1 if the function at pc must be disassembled. */
 
   data_registers *registers; /**< The registers. */
-  int changed_regs; /**< Set to 1 if the registers has changed. */
-  char *regs;	    /**< Holds which register that has changed. */
+  int changed_regs; /**< Set to 1 if register values must be requested. */
+  char *regs;	    /**< The register numbers to request. */
   int size_regs;    /**< Size of regs. */
 
-  int pc;
+  uint64_t pc; /**< The pc, marked in the disassemble window. */
+
+  mem_cache *memory; /**< The pages of the memory window. */
+  uint64_t mem_locate; /**<
+			* Length of the region whose address is requested, 0
+			* if none.
+			*/
+  int mem_refresh; /**< 1 if the pages in the memory window must be read. */
+
+  file_index *files; /**< The source files of the program. */
+  int files_loaded;  /**< 0 if the source files must be requested. */
+
+  symbol_index *symbols; /**< The functions of the program. */
+  int symbols_loaded;	 /**< 0 if the functions must be requested. */
+  char symbol_item[SYMBOL_ITEM_LEN]; /**< A symbol shown in the form. */
+
+  mi2_stream *stream;	  /**< Parses the results that may be huge. */
+  stream_result streamed; /**< The state of the streamed result. */
+  int stream_error;	  /**< 1 if the last streamed record was broken. */
 };
 
 /*******************************************************************************
@@ -220,15 +334,36 @@ struct mi2_parser_t
 static void mi2_parser_exit (mi2_parser * parser);
 static void mi2_parser_parse_changed_registers (mi2_parser * parser,
 						char *regs);
+static int mi2_parser_parse_register_value (mi2_parser * parser, int nr,
+					    char *value);
 static void mi2_parser_parse_register_values (mi2_parser * parser,
 					      char *values);
+static void mi2_parser_request_registers (mi2_parser * parser);
 static void mi2_parser_parse_register_names (mi2_parser * parser,
 					     char *names);
-static void mi2_parser_parse_asm (mi2_parser * parser, char *asm_value);
-static void mi2_parser_parse_files (mi2_parser * parser, char *files);
+static void mi2_parser_stream_copy (char **dst, const char *value);
+static void mi2_parser_stream_reset (mi2_parser * parser);
+static int mi2_parser_asm_start (void *data, const char *name, int type);
+static int mi2_parser_asm_value (void *data, const char *name,
+				 const char *value);
+static int mi2_parser_asm_end (void *data, int type);
+static void mi2_parser_asm_done (void *data, int error);
+static void mi2_parser_show_pc (mi2_parser * parser, uint64_t pc);
+static int mi2_parser_parse_memory (mi2_parser * parser, char *memory);
+static int mi2_parser_parse_memory_locate (mi2_parser * parser, char *line);
+static int mi2_parser_parse_memory_changed (mi2_parser * parser, char *line);
+static int mi2_parser_files_start (void *data, const char *name, int type);
+static int mi2_parser_files_value (void *data, const char *name,
+				   const char *value);
+static int mi2_parser_files_end (void *data, int type);
+static void mi2_parser_files_done (void *data, int error);
+static void mi2_parser_parse_symbols (mi2_parser * parser, char *symbols);
+static int mi2_parser_match_file (void *data, const char *pattern);
+static const char *mi2_parser_get_file (void *data, int nr);
 static int mi2_parser_parse_threads (mi2_parser * parser, char *threads);
 static int mi2_parser_parse_variables (mi2_parser * parser, char *vars);
 static int mi2_parser_parsestack (mi2_parser * parser, char *stack);
+static void mi2_parser_prefetch_sources (mi2_parser * parser);
 static int mi2_parser_parse_args (frame * frame, char *args_value,
 				  int variable);
 static int mi2_parser_parse_frame (mi2_parser * parser, char *frame_val,
@@ -242,6 +377,37 @@ static int mi2_parser_parse_running (mi2_parser * parser, char *line);
 static int mi2_parser_parse_stopped (mi2_parser * parser, char *line);
 static int mi2_parser_parse_thread (mi2_parser * parser, char *line);
 static int mi2_parser_parse_library (mi2_parser * parser, char *line);
+static frame *mi2_parser_current_frame (mi2_parser * parser);
+static variable *mi2_parser_find_object (mi2_parser * parser,
+					 const char *var_name, int parent,
+					 scope ** owner);
+static void mi2_parser_add_var_request (mi2_parser * parser, int action,
+					int frame, const char *var_name,
+					const char *exp);
+static void mi2_parser_drop_scope (mi2_parser * parser, scope * s);
+static int mi2_parser_parse_var_create (mi2_parser * parser, char *line);
+static int mi2_parser_parse_var_children (mi2_parser * parser, char *line);
+static int mi2_parser_parse_var_update (mi2_parser * parser,
+					char *changelist);
+
+/*******************************************************************************
+ * Global variables
+ ******************************************************************************/
+/** The events of '^done,asm_insns'. */
+static const mi2_stream_handler asm_handler = {
+  mi2_parser_asm_start,
+  mi2_parser_asm_end,
+  mi2_parser_asm_value,
+  mi2_parser_asm_done
+};
+
+/** The events of '^done,files'. */
+static const mi2_stream_handler files_handler = {
+  mi2_parser_files_start,
+  mi2_parser_files_end,
+  mi2_parser_files_value,
+  mi2_parser_files_done
+};
 
 /**
  * @brief Do cleanup adter program exit.
@@ -258,8 +424,185 @@ mi2_parser_exit (mi2_parser * parser)
   DINFO (1, "Exiting program");
 
   stack_clean_frame (parser->stack, -1);
+  while (parser->scopes != NULL)
+    {
+      mi2_parser_drop_scope (parser, parser->scopes);
+    }
   view_update_stack (parser->view, parser->stack);
   view_update_frame (parser->view, parser->stack, -1);
+
+  /* The addresses may differ in the next run. */
+  ass_reset (parser->ass_lines);
+  parser->ass_shown = NULL;
+}
+
+/**
+ * @brief Parse read memory.
+ *
+ * Parse the memory of -data-read-memory-bytes, which has the form:
+ *
+ * @code
+ * memory=[{begin="0x..",offset="0x..",end="0x..",contents="00ff.."},...]
+ * @endcode
+ *
+ * Only the readable blocks are listed. The bytes are stored in the pages
+ * of the memory cache and the memory view is redrawn.
+ *
+ * @param parser The parser.
+ * @param memory The list of blocks.
+ *
+ * @return 0 upon success, otherwise -1.
+ */
+static int
+mi2_parser_parse_memory (mi2_parser * parser, char *memory)
+{
+  char *next;
+  char *name;
+  char *value;
+  char *inext;
+  char *iname;
+  char *ivalue;
+  char *endptr;
+  char *contents;
+  uint64_t begin;
+  uint64_t offset;
+  int ret;
+
+  next = memory;
+  while (next != NULL && *next != '\0')
+    {
+      ret = get_next_param (next, &name, &value, &next);
+      LOG_ERR_IF_RETURN (ret != '{' || value == NULL, -1, PARSE_ERROR,
+			 memory);
+      begin = 0;
+      offset = 0;
+      contents = NULL;
+      inext = value;
+      while (inext != NULL && *inext != '\0')
+	{
+	  ret = get_next_param (inext, &iname, &ivalue, &inext);
+	  LOG_ERR_IF_RETURN (ret < 0 || iname == NULL || ivalue == NULL, -1,
+			     PARSE_ERROR, value);
+	  if (strcmp (iname, MEMORY_BEGIN) == 0)
+	    {
+	      begin = strtoull (ivalue, &endptr, 0);
+	      LOG_ERR_IF_RETURN (endptr == ivalue, -1, NOT_A_NUMBER, ivalue);
+	    }
+	  else if (strcmp (iname, MEMORY_OFFSET) == 0)
+	    {
+	      offset = strtoull (ivalue, &endptr, 0);
+	      LOG_ERR_IF_RETURN (endptr == ivalue, -1, NOT_A_NUMBER, ivalue);
+	    }
+	  else if (strcmp (iname, MEMORY_CONTENTS) == 0)
+	    {
+	      contents = ivalue;
+	    }
+	}
+      LOG_ERR_IF_RETURN (contents == NULL, -1, PARSE_ERROR, value);
+      ret = mem_cache_set_bytes (parser->memory, begin + offset, contents);
+      LOG_ERR_IF_RETURN (ret < 0, -1, PARSE_ERROR, contents);
+    }
+  view_update_memory (parser->view, parser->memory);
+
+  return 0;
+}
+
+/**
+ * @brief Parse the address of a new memory region.
+ *
+ * The address of the region is found with -data-read-memory, which answers
+ * with:
+ *
+ * @code
+ * addr="0x..",nr-bytes="1",total-bytes="1",next-row=..,memory=[...]
+ * @endcode
+ *
+ * Only the address is used, the pages are read with
+ * -data-read-memory-bytes.
+ *
+ * @param parser The parser.
+ * @param line The response.
+ *
+ * @return 0 upon success, otherwise -1.
+ */
+static int
+mi2_parser_parse_memory_locate (mi2_parser * parser, char *line)
+{
+  char *next;
+  char *name;
+  char *value;
+  char *endptr;
+  uint64_t address;
+  int ret;
+
+  ret = get_next_param (line, &name, &value, &next);
+  LOG_ERR_IF_RETURN (ret < 0 || name == NULL || value == NULL
+		     || strcmp (name, MEMORY_ADDR) != 0, -1, PARSE_ERROR,
+		     line);
+  address = strtoull (value, &endptr, 0);
+  LOG_ERR_IF_RETURN (endptr == value, -1, NOT_A_NUMBER, value);
+  if (parser->mem_locate == 0)
+    {
+      return 0;
+    }
+
+  mem_cache_set_region (parser->memory, address, parser->mem_locate);
+  parser->mem_locate = 0;
+  parser->mem_refresh = 1;
+  view_update_memory (parser->view, parser->memory);
+
+  return 0;
+}
+
+/**
+ * @brief Parse changed memory.
+ *
+ * Parse the asynchronous =memory-changed, which has the form:
+ *
+ * @code
+ * =memory-changed,thread-group="i1",addr="0x..",len="0x.."[,type="code"]
+ * @endcode
+ *
+ * The cached pages of the changed memory are read again.
+ *
+ * @param parser The parser.
+ * @param line The parameters of the record.
+ *
+ * @return 0 upon success, otherwise -1.
+ */
+static int
+mi2_parser_parse_memory_changed (mi2_parser * parser, char *line)
+{
+  char *next;
+  char *name;
+  char *value;
+  char *endptr;
+  uint64_t address = 0;
+  uint64_t length = 0;
+  int ret;
+
+  next = line;
+  while (next != NULL && *next != '\0')
+    {
+      ret = get_next_param (next, &name, &value, &next);
+      LOG_ERR_IF_RETURN (ret < 0 || name == NULL || value == NULL, -1,
+			 PARSE_ERROR, line);
+      if (strcmp (name, MEMORY_ADDR) == 0)
+	{
+	  address = strtoull (value, &endptr, 0);
+	  LOG_ERR_IF_RETURN (endptr == value, -1, NOT_A_NUMBER, value);
+	}
+      else if (strcmp (name, MEMORY_LEN) == 0)
+	{
+	  length = strtoull (value, &endptr, 0);
+	  LOG_ERR_IF_RETURN (endptr == value, -1, NOT_A_NUMBER, value);
+	}
+    }
+
+  mem_cache_invalidate (parser->memory, address, length);
+  parser->mem_refresh = parser->memory->length > 0;
+
+  return 0;
 }
 
 /**
@@ -279,17 +622,11 @@ mi2_parser_parse_changed_registers (mi2_parser * parser, char *regs)
 {
   char *s;
   char *e;
-  int nr;
-  char buf[512];
-  char *p = buf;
   char *t;
-  int size = 512;
-  int len;
+  int nr;
 
-  len = 0;
-  nr = 0;
   s = regs;
-  p[0] = '\0';
+  data_registers_clear_changed (parser->registers);
   while (*s != '\0')
     {
       while (*s && *s != '\"')
@@ -311,30 +648,137 @@ mi2_parser_parse_changed_registers (mi2_parser * parser, char *regs)
 	  break;
 	}
       *e = '\0';
-      if (len + strlen (s) + 2 >= size)
+      nr = strtol (s, &t, 0);
+      if (t != s)
 	{
-	  size = len + strlen (s) + 64;
-	  t = (char *) realloc (p, size);
-	  LOG_ERR_IF_FATAL (t == NULL, ERR_MSG_CREATE ("regs"));
-	  p = t;
+	  data_registers_set_changed (parser->registers, nr);
 	}
-      strcat (p, " ");
-      strcat (p, s);
       s = e + 1;
     }
-  if (strlen (p) != 0)
+  mi2_parser_request_registers (parser);
+}
+
+/**
+ * @brief Build the register value request.
+ *
+ * Build the list of register numbers for one -data-list-register-values
+ * request. Only registers that have a name, i.e. are shown in the
+ * registers view, are requested, and only if they changed at the last stop
+ * or have not been fetched yet.
+ *
+ * @param parser The parser.
+ */
+static void
+mi2_parser_request_registers (mi2_parser * parser)
+{
+  data_registers *registers = parser->registers;
+  data_reg *reg;
+  char *t;
+  int len = 0;
+  int size;
+  int i;
+
+  for (i = 0; i < registers->len; i++)
     {
-      LPRINT (parser->regs, -1, parser->size_regs, "%s", p);
-      parser->changed_regs = 1;
+      reg = registers->registers + i;
+      if (reg->name_len == 0 || (reg->type != DATA_REG_NONE
+				 && !data_registers_is_changed (registers, i)))
+	{
+	  continue;
+	}
+      /* Room for " %d" and the terminating null. */
+      if (len + 16 > parser->size_regs)
+	{
+	  size = parser->size_regs > 0 ? 2 * parser->size_regs : 256;
+	  t = (char *) realloc (parser->regs, size);
+	  LOG_ERR_IF_FATAL (t == NULL, ERR_MSG_CREATE ("regs"));
+	  parser->regs = t;
+	  parser->size_regs = size;
+	}
+      len += sprintf (parser->regs + len, " %d", i);
     }
-  else
+  parser->changed_regs = len > 0;
+}
+
+/**
+ * @brief Parse the value of a register.
+ *
+ * Parse a register value into binary form. A vector value is stored as the
+ * lanes of its first member, e.g. the four lanes of v4_float in:
+ *
+ * @code
+ * {v4_float = {0x0, 0x1, 0x0, 0x0}, v16_int8 = {0x0 <repeats 16 times>}}
+ * @endcode
+ *
+ * Values that are not numbers are stored as strings.
+ *
+ * @param parser The parser.
+ * @param nr The register number.
+ * @param value The value.
+ *
+ * @return 0 upon success, -1 if the value could not be stored.
+ */
+static int
+mi2_parser_parse_register_value (mi2_parser * parser, int nr, char *value)
+{
+  uint64_t lanes[REG_MAX_LANES];
+  int nr_lanes = 0;
+  uint64_t v;
+  long repeat;
+  char *p;
+  char *q;
+  char *endptr;
+
+  if (value[0] != '{')
     {
-      parser->changed_regs = 0;
+      v = strtoull (value, &endptr, 0);
+      if (endptr != value && *endptr == '\0')
+	{
+	  return data_registers_set_value (parser->registers, nr, v);
+	}
+      return data_registers_set_str_value (parser->registers, nr, value);
     }
-  if (p != buf)
+
+  p = strchr (value + 1, '{');
+  LOG_ERR_IF_RETURN (p == NULL, -1, PARSE_ERROR, value);
+  q = strchr (p, '}');
+  LOG_ERR_IF_RETURN (q == NULL, -1, PARSE_ERROR, value);
+  *q = '\0';
+  p++;
+  value = p;
+  while (*p != '\0')
     {
-      free (p);
+      v = strtoull (p, &endptr, 0);
+      if (endptr == p)
+	{
+	  /* Not a number, keep the lanes as text. */
+	  return data_registers_set_str_value (parser->registers, nr, value);
+	}
+      p = endptr;
+      while (*p == ' ')
+	{
+	  p++;
+	}
+      repeat = 1;
+      if (strncmp (p, REG_REPEATS, strlen (REG_REPEATS)) == 0)
+	{
+	  repeat = strtol (p + strlen (REG_REPEATS), &p, 10);
+	  p = strchr (p, '>');
+	  LOG_ERR_IF_RETURN (p == NULL, -1, PARSE_ERROR, value);
+	  p++;
+	}
+      while (repeat > 0 && nr_lanes < REG_MAX_LANES)
+	{
+	  lanes[nr_lanes++] = v;
+	  repeat--;
+	}
+      while (*p == ',' || *p == ' ')
+	{
+	  p++;
+	}
     }
+
+  return data_registers_set_lanes (parser->registers, nr, lanes, nr_lanes);
 }
 
 /**
@@ -363,8 +807,6 @@ mi2_parser_parse_register_values (mi2_parser * parser, char *values)
   char *endptr;
   int nr = -1;
   int ret;
-  char *p;
-  char *q;
 
   next = values;
   while (next && *next != '\0')
@@ -389,28 +831,7 @@ mi2_parser_parse_register_values (mi2_parser * parser, char *values)
 	    }
 	  else if (strcmp (iname, "value") == 0)
 	    {
-	      if (ivalue[0] == '{')
-		{
-		  p = ivalue + 1;
-		  while (*p && *p != '{')
-		    {
-		      p++;
-		    }
-		  LOG_ERR_IF_RETURN (*p == '\0',, PARSE_ERROR, ivalue);
-		  p++;
-		  q = p;
-		  while (*q && *q != '}')
-		    {
-		      q++;
-		    }
-		  LOG_ERR_IF_RETURN (*q == '\0',, PARSE_ERROR, ivalue);
-		  *q = '\0';
-		}
-	      else
-		{
-		  p = ivalue;
-		}
-	      ret = data_registers_set_str_value (parser->registers, nr, p);
+	      ret = mi2_parser_parse_register_value (parser, nr, ivalue);
 	      LOG_ERR_IF_RETURN (ret < 0,, PARSE_ERROR, ivalue);
 	    }
 	  else
@@ -420,79 +841,503 @@ mi2_parser_parse_register_values (mi2_parser * parser, char *values)
 	    }
 	}
     }
-  parser->changed_regs = 0;
-  view_update_registers (parser->view, parser->registers);
+  view_update_registers (parser->view, parser->registers);
+}
+
+/**
+ * @brief Parse register names.
+ *
+ * Parse the ^done,register-names which has the form:
+ *
+ * @code
+ * register-names=["Name 1","Name 2",...]
+ * @endcode
+ *
+ * @param parser The parser.
+ * @param names The names.
+ */
+static void
+mi2_parser_parse_register_names (mi2_parser * parser, char *names)
+{
+  char *s;
+  char *e;
+  int nr;
+
+  nr = 0;
+  s = names;
+  while (*s != '\0')
+    {
+      while (*s && *s != '\"')
+	{
+	  s++;
+	}
+      if (*s == '\0')
+	{
+	  break;
+	}
+      s++;
+      /* Unused register numbers have empty names. */
+      e = s;
+      while (*e && *e != '\"')
+	{
+	  e++;
+	}
+      if (*e == '\0')
+	{
+	  LOG_ERR (PARSE_ERROR, s);
+	  break;
+	}
+      *e = '\0';
+      DINFO (3, "Added reg %d '%s'", nr, s);
+      data_registers_add (parser->registers, nr, s);
+      nr++;
+      s = e + 1;
+    }
+}
+
+/**
+ * @brief Keep a copy of a streamed string.
+ *
+ * @param dst The copy, the old copy is freed.
+ * @param value The string.
+ */
+static void
+mi2_parser_stream_copy (char **dst, const char *value)
+{
+  free (*dst);
+  *dst = strdup (value);
+  LOG_ERR_IF_FATAL (*dst == NULL, ERR_MSG_CREATE ("string"));
+}
+
+/**
+ * @brief Reset the state of a streamed result.
+ *
+ * @param parser The parser.
+ */
+static void
+mi2_parser_stream_reset (mi2_parser * parser)
+{
+  stream_result *r = &parser->streamed;
+
+  free (r->file);
+  free (r->fullname);
+  free (r->func_name);
+  free (r->inst);
+  memset (r, 0, sizeof (*r));
+}
+
+/**
+ * @brief A tuple or list of '^done,asm_insns' starts.
+ *
+ * The result has the form:
+ *
+ * @code
+ * asm_insns=[src_and_asm_line={line="NR",file="NAME",
+ * line_asm_insn=[{address="ADDR",func-name="NAME",offset="NR", inst="INST"},
+ * {addr...}]},src_and_asm_line=...]
+ * @endcode
+ *
+ * @param data The parser.
+ * @param name The name of the tuple or list.
+ * @param type '{' or '['.
+ *
+ * @return 0 on success, -1 on parse error.
+ */
+static int
+mi2_parser_asm_start (void *data, const char *name, int type)
+{
+  mi2_parser *parser = (mi2_parser *) data;
+  stream_result *r = &parser->streamed;
+
+  r->level++;
+  switch (r->level)
+    {
+    case 1:
+      break;
+    case 2:
+      LOG_ERR_IF_RETURN (type != '{' || name == NULL
+			 || strcmp (name, "src_and_asm_line") != 0, -1,
+			 PARSE_ERROR, name ? name : "{");
+      r->line_nr = -1;
+      free (r->file);
+      r->file = NULL;
+      break;
+    case 3:
+      LOG_ERR_IF_RETURN (name == NULL || strcmp (name, "line_asm_insn") != 0,
+			 -1, PARSE_ERROR, name ? name : "[");
+      LOG_ERR_IF_RETURN (r->file == NULL || r->line_nr < 0, -1, PARSE_ERROR,
+			 name);
+      if (r->func == NULL)
+	{
+	  r->func = asm_function_create (r->file);
+	}
+      r->nr_insts = 0;
+      free (r->func_name);
+      r->func_name = NULL;
+      free (r->inst);
+      r->inst = NULL;
+      break;
+    case 4:
+      LOG_ERR_IF_RETURN (type != '{' || name != NULL, -1, PARSE_ERROR,
+			 name ? name : "[");
+      r->address = ASM_NO_ADDRESS;
+      r->offset = -1;
+      break;
+    default:
+      LOG_ERR (PARSE_ERROR, name ? name : "");
+      return -1;
+    }
+
+  return 0;
+}
+
+/**
+ * @brief A value of '^done,asm_insns'.
+ *
+ * @param data The parser.
+ * @param name The name of the value.
+ * @param value The value.
+ *
+ * @return 0 on success, -1 on parse error.
+ */
+static int
+mi2_parser_asm_value (void *data, const char *name, const char *value)
+{
+  mi2_parser *parser = (mi2_parser *) data;
+  stream_result *r = &parser->streamed;
+  char *endptr;
+
+  LOG_ERR_IF_RETURN (name == NULL, -1, PARSE_ERROR, value);
+
+  if (r->level == 2 && strcmp (name, "line") == 0)
+    {
+      r->line_nr = strtol (value, &endptr, 0);
+      LOG_ERR_IF_RETURN (endptr == value, -1, NOT_A_NUMBER, value);
+    }
+  else if (r->level == 2 && strcmp (name, "file") == 0)
+    {
+      mi2_parser_stream_copy (&r->file, value);
+    }
+  else if (r->level == 2 && strcmp (name, "fullname") == 0)
+    {
+      /* The file is used as the name of the function's file. */
+    }
+  else if (r->level == 4 && strcmp (name, "address") == 0)
+    {
+      r->address = strtoull (value, &endptr, 0);
+      LOG_ERR_IF_RETURN (endptr == value, -1, NOT_A_NUMBER, value);
+    }
+  else if (r->level == 4 && strcmp (name, "offset") == 0)
+    {
+      r->offset = strtol (value, &endptr, 0);
+      LOG_ERR_IF_RETURN (endptr == value, -1, NOT_A_NUMBER, value);
+    }
+  else if (r->level == 4 && strcmp (name, "func-name") == 0)
+    {
+      mi2_parser_stream_copy (&r->func_name, value);
+    }
+  else if (r->level == 4 && strcmp (name, "inst") == 0)
+    {
+      mi2_parser_stream_copy (&r->inst, value);
+    }
+  else
+    {
+      LOG_ERR (PARSE_ERROR, name);
+      return -1;
+    }
+
+  return 0;
+}
+
+/**
+ * @brief A tuple or list of '^done,asm_insns' ends.
+ *
+ * Each instruction is added when its tuple ends. A source line without
+ * instructions is added as an empty line.
+ *
+ * @param data The parser.
+ * @param type '{' or '['.
+ *
+ * @return 0 on success, -1 on parse error.
+ */
+static int
+mi2_parser_asm_end (void *data, int type)
+{
+  mi2_parser *parser = (mi2_parser *) data;
+  stream_result *r = &parser->streamed;
+  int ret = 0;
+
+  if (r->level == 4)
+    {
+      LOG_ERR_IF_RETURN (r->address == ASM_NO_ADDRESS || r->offset < 0, -1,
+			 PARSE_ERROR, r->inst ? r->inst : "");
+      ret = asm_function_add_line (r->func, r->func_name, r->line_nr,
+				   r->address, r->offset, r->inst);
+      r->nr_insts++;
+    }
+  else if (r->level == 3 && r->nr_insts == 0)
+    {
+      ret = asm_function_add_line (r->func, NULL, r->line_nr,
+				   ASM_NO_ADDRESS, -1, NULL);
+    }
+  r->level--;
+  LOG_ERR_IF_RETURN (ret < 0, -1, PARSE_ERROR, r->file ? r->file : "");
+
+  return 0;
+}
+
+/**
+ * @brief The '^done,asm_insns' record ends.
+ *
+ * The disassembled function is shown and cached.
+ *
+ * @param data The parser.
+ * @param error 1 if the record could not be parsed.
+ */
+static void
+mi2_parser_asm_done (void *data, int error)
+{
+  mi2_parser *parser = (mi2_parser *) data;
+  asm_function *func = parser->streamed.func;
+
+  parser->streamed.func = NULL;
+  mi2_parser_stream_reset (parser);
+  parser->stream_error = error;
+  if (error)
+    {
+      asm_function_free (func);
+      return;
+    }
+  if (func == NULL)
+    {
+      return;
+    }
+
+  asm_function_done (func);
+  view_update_ass (parser->view, func, parser->pc);
+  if (func->nr_lines > 0)
+    {
+      parser->ass_shown = ass_insert (parser->ass_lines, func);
+    }
+  else
+    {
+      /* Nothing to cache. */
+      asm_function_free (func);
+      parser->ass_shown = NULL;
+    }
+}
+
+/**
+ * @brief Show the pc in the disassemble window.
+ *
+ * If the function at @a pc is cached it is shown, only moving the pc marker
+ * if it is already in the window. Otherwise a disassembly of the function is
+ * requested, see mi2_parser_disassembly_request().
+ *
+ * @param parser The parser.
+ * @param pc The new pc.
+ */
+static void
+mi2_parser_show_pc (mi2_parser * parser, uint64_t pc)
+{
+  asm_function *func;
+  uint64_t old_pc;
+
+  old_pc = parser->pc;
+  parser->pc = pc;
+  if (!parser->disassemble)
+    {
+      return;
+    }
+
+  func = ass_find (parser->ass_lines, pc);
+  if (func == NULL)
+    {
+      DINFO (3, "0x%" PRIX64 " not cached", pc);
+      parser->ass_request = 1;
+    }
+  else if (func == parser->ass_shown)
+    {
+      view_move_ass_pc (parser->view, func, old_pc, pc);
+    }
+  else
+    {
+      view_update_ass (parser->view, func, pc);
+      parser->ass_shown = func;
+    }
+}
+
+/**
+ * @brief A tuple or list of '^done,files' starts.
+ *
+ * The result has the form:
+ *
+ * @code
+ * files=[{file='FILENAME'[,fullname='FULLNAME']},{file=...}]
+ * @endcode
+ *
+ * @param data The parser.
+ * @param name The name of the tuple or list.
+ * @param type '{' or '['.
+ *
+ * @return 0 on success, -1 on parse error.
+ */
+static int
+mi2_parser_files_start (void *data, const char *name, int type)
+{
+  mi2_parser *parser = (mi2_parser *) data;
+
+  parser->streamed.level++;
+  if (parser->streamed.level == 1)
+    {
+      file_index_reset (parser->files);
+      parser->files_loaded = 0;
+      return 0;
+    }
+  LOG_ERR_IF_RETURN (parser->streamed.level != 2 || type != '{', -1,
+		     PARSE_ERROR, name ? name : "[");
+
+  return 0;
+}
+
+/**
+ * @brief A value of '^done,files'.
+ *
+ * @param data The parser.
+ * @param name The name of the value.
+ * @param value The value.
+ *
+ * @return 0 on success, -1 on parse error.
+ */
+static int
+mi2_parser_files_value (void *data, const char *name, const char *value)
+{
+  mi2_parser *parser = (mi2_parser *) data;
+  stream_result *r = &parser->streamed;
+
+  LOG_ERR_IF_RETURN (r->level != 2 || name == NULL, -1, PARSE_ERROR, value);
+
+  if (strcmp (name, "fullname") == 0)
+    {
+      mi2_parser_stream_copy (&r->fullname, value);
+    }
+  else if (strcmp (name, "file") == 0)
+    {
+      mi2_parser_stream_copy (&r->file, value);
+    }
+  else
+    {
+      LOG_ERR (PARSE_ERROR, name);
+      return -1;
+    }
+
+  return 0;
+}
+
+/**
+ * @brief A tuple or list of '^done,files' ends.
+ *
+ * The file is stored in the file index when its tuple ends.
+ *
+ * @param data The parser.
+ * @param type '{' or '['.
+ *
+ * @return 0.
+ */
+static int
+mi2_parser_files_end (void *data, int type)
+{
+  mi2_parser *parser = (mi2_parser *) data;
+  stream_result *r = &parser->streamed;
+
+  if (r->level == 2 && (r->fullname != NULL || r->file != NULL))
+    {
+      file_index_add (parser->files,
+		      r->fullname != NULL ? r->fullname : r->file);
+    }
+  free (r->file);
+  r->file = NULL;
+  free (r->fullname);
+  r->fullname = NULL;
+  r->level--;
+
+  return 0;
 }
 
 /**
- * @brief Parse register names.
- *
- * Parse the ^done,register-names which has the form:
+ * @brief The '^done,files' record ends.
  *
- * @code
- * register-names=["Name 1","Name 2",...]
- * @endcode
+ * The files are stored in the file index, which is kept until new symbols
+ * are loaded, and the user is asked to select a file.
  *
- * @param parser The parser.
- * @param names The names.
+ * @param data The parser.
+ * @param error 1 if the record could not be parsed.
  */
 static void
-mi2_parser_parse_register_names (mi2_parser * parser, char *names)
+mi2_parser_files_done (void *data, int error)
 {
-  char *s;
-  char *e;
-  int nr;
+  mi2_parser *parser = (mi2_parser *) data;
 
-  nr = 0;
-  s = names;
-  while (*s != '\0')
+  mi2_parser_stream_reset (parser);
+  parser->stream_error = error;
+  if (error)
     {
-      while (*s && *s != '\"')
-	{
-	  s++;
-	}
-      if (*s == '\0')
-	{
-	  break;
-	}
-      s++;
-      e = s + 1;
-      while (*e && *e != '\"')
-	{
-	  e++;
-	}
-      if (*e == '\0')
-	{
-	  LOG_ERR (PARSE_ERROR, s);
-	  break;
-	}
-      *e = '\0';
-      DINFO (3, "Added reg %d '%s'", nr, s);
-      data_registers_add (parser->registers, nr, s);
-      nr++;
-      s = e + 1;
+      file_index_reset (parser->files);
+      return;
     }
+  file_index_sort (parser->files);
+  parser->files_loaded = 1;
+  DINFO (1, "%d source files", parser->files->nr_names);
+
+  mi2_parser_find_file (parser);
+}
+
+/**
+ * @brief Match the source files, used by the search form.
+ *
+ * @param data The file index.
+ * @param pattern The pattern.
+ *
+ * @return The number of matching files.
+ */
+static int
+mi2_parser_match_file (void *data, const char *pattern)
+{
+  return file_index_match ((file_index *) data, pattern);
+}
+
+/**
+ * @brief Get a matching source file, used by the search form.
+ *
+ * @param data The file index.
+ * @param nr The number of the match.
+ *
+ * @return The file or NULL.
+ */
+static const char *
+mi2_parser_get_file (void *data, int nr)
+{
+  return file_index_get_match ((file_index *) data, nr);
 }
 
 /**
- * @brief Parse asm line.
+ * @brief Parse the functions of a source file.
  *
- * Parse asm line which has the form:
+ * Parse the symbols of one file in the 'debug' list of -symbol-info-functions.
+ * The file has the form:
  *
  * @code
- * [{address="ADDR",func-name="NAME",offset="NR", inst="INST"},{addr...}]
+ * filename="FILE",fullname="FULLNAME",symbols=[{line="LINE",name="NAME",
+ * type="TYPE",description="DESCRIPTION"},...]
  * @endcode
  *
  * @param parser The parser.
- * @param file The file belonging to asm line.
- * @param line_nr The line number.
- * @param line The asm line.
+ * @param file The file.
  *
- * @return 1 if the line belongs to a new function.
+ * @return 0 upon success, otherwise -1.
  */
 static int
-mi2_parser_parse_asm_line (mi2_parser * parser, const char *file, int line_nr,
-			   char *line)
+mi2_parser_parse_symbol_file (mi2_parser * parser, char *file)
 {
   char *next;
   char *name;
@@ -500,269 +1345,180 @@ mi2_parser_parse_asm_line (mi2_parser * parser, const char *file, int line_nr,
   char *inext;
   char *iname;
   char *ivalue;
-  int address = -1;
-  int offset = -1;
-  char *func = NULL;
-  char *inst = NULL;
+  char *filename = NULL;
+  char *fullname = NULL;
+  char *symbols = NULL;
+  char *symbol;
   char *endptr;
+  int line;
   int ret;
-  int new_func = 0;
 
-
-  if (line == NULL || strlen (line) == 0)
+  next = file;
+  while (next && *next)
     {
-      ret = ass_add_line (parser->ass_lines, file, NULL, line_nr, -1,
-			  -1, NULL);
-      return ret;
+      ret = get_next_param (next, &name, &value, &next);
+      LOG_ERR_IF_RETURN (ret < 0 || name == NULL || value == NULL, -1,
+			 PARSE_ERROR, next);
+      if (strcmp (name, SYMBOLS_FILENAME) == 0)
+	{
+	  filename = value;
+	}
+      else if (strcmp (name, SYMBOLS_FULLNAME) == 0)
+	{
+	  fullname = value;
+	}
+      else if (strcmp (name, DONE_SYMBOLS) == 0)
+	{
+	  symbols = value;
+	}
     }
-  next = line;
-  while (next != NULL && *next != '\0')
+  LOG_ERR_IF_RETURN (filename == NULL && fullname == NULL, -1,
+		     "No file name");
+
+  next = symbols;
+  while (next && *next)
     {
       ret = get_next_param (next, &name, &value, &next);
-      LOG_ERR_IF_RETURN (ret != '{' || name != NULL || value == NULL,
-			 -1, PARSE_ERROR, next);
-      address = -1;
-      offset = -1;
+      LOG_ERR_IF_RETURN (ret != '{' || value == NULL, -1, PARSE_ERROR, next);
+      symbol = NULL;
+      line = 0;
       inext = value;
       while (inext && *inext)
 	{
 	  ret = get_next_param (inext, &iname, &ivalue, &inext);
-	  LOG_ERR_IF_RETURN (ret < 0 || iname == NULL || ivalue == NULL,
-			     -1, PARSE_ERROR, inext);
-
-	  if (strcmp (iname, "address") == 0)
-	    {
-	      address = strtol (ivalue, &endptr, 0);
-	      LOG_ERR_IF_RETURN (endptr == ivalue, -1, NOT_A_NUMBER, ivalue);
-	    }
-	  else if (strcmp (iname, "offset") == 0)
-	    {
-	      offset = strtol (ivalue, &endptr, 0);
-	      LOG_ERR_IF_RETURN (endptr == ivalue, -1, NOT_A_NUMBER, ivalue);
-	    }
-	  else if (strcmp (iname, "func-name") == 0)
-	    {
-	      func = ivalue;
-	    }
-	  else if (strcmp (iname, "inst") == 0)
+	  LOG_ERR_IF_RETURN (ret < 0 || iname == NULL || ivalue == NULL, -1,
+			     PARSE_ERROR, inext);
+	  if (strcmp (iname, SYMBOL_NAME) == 0)
 	    {
-	      inst = ivalue;
+	      symbol = ivalue;
 	    }
-	  else
+	  else if (strcmp (iname, SYMBOL_LINE) == 0)
 	    {
-	      LOG_ERR (PARSE_ERROR, iname);
-	      return -1;
+	      line = strtol (ivalue, &endptr, 0);
+	      LOG_ERR_IF_RETURN (ivalue == endptr, -1, NOT_A_NUMBER, ivalue);
 	    }
 	}
-      LOG_ERR_IF_RETURN (address < 0 || offset < 0, -1, PARSE_ERROR, line);
-      ret = ass_add_line (parser->ass_lines, file, func, line_nr, address,
-			  offset, inst);
-      if (ret == 1)
+      if (symbol != NULL)
 	{
-	  new_func = 1;
+	  symbol_index_add (parser->symbols, symbol,
+			    fullname != NULL ? fullname : filename, line);
 	}
     }
 
-  return new_func;
+  return 0;
 }
 
 /**
- * @brief Parse '^done,asm_insns' field.
+ * @brief Parse done symbols field.
  *
- * Parse the '^done,asm_insns' field which has the form:
+ * Parse the '^done,symbols' field of -symbol-info-functions. The field has
+ * the form:
  *
  * @code
- * asm_insns=[src_and_asm_line={line="NR",file="NAME",
- * line_asm_insn=[{address="ADDR",func-name="NAME",offset="NR", inst="INST"},
- * {addr...}]},src_and_asm_line=...]
+ * symbols={debug=[{filename="FILE",fullname="FULLNAME",symbols=[...]},...],
+ * nondebugging=[{address="ADDRESS",name="NAME"},...]}
  * @endcode
  *
+ * Only the functions with debug information are kept, the others have no
+ * source to show. The functions are kept until new symbols are loaded and
+ * the user is asked to select a function.
+ *
  * @param parser The parser.
- * @param asm_value The instructions and source lines.
+ * @param symbols The field containing the symbols.
  */
 static void
-mi2_parser_parse_asm (mi2_parser * parser, char *asm_value)
+mi2_parser_parse_symbols (mi2_parser * parser, char *symbols)
 {
   char *next;
   char *name;
   char *value;
-  char *endptr;
   char *inext;
   char *iname;
   char *ivalue;
-  int address;
-  int offset;
-  char *func_name;
-  char *inst;
-  char *file;
-  int line_nr;
   int ret;
-  int new_function = 0;
 
-  /* Reset the assemble lines */
-  ass_reset (parser->ass_lines);
+  symbol_index_reset (parser->symbols);
+  parser->symbols_loaded = 0;
 
-  next = asm_value;
+  next = symbols;
   while (next && *next)
     {
       ret = get_next_param (next, &name, &value, &next);
-      if (ret != '{' || value == NULL || name == NULL
-	  || strcmp (name, "src_and_asm_line") != 0)
+      if (ret < 0 || name == NULL)
 	{
 	  LOG_ERR (PARSE_ERROR, next);
 	  goto error;
 	}
-      address = -1;
-      offset = -1;
-      line_nr = -1;
-      file = NULL;
-      func_name = NULL;
-      inst = NULL;
+      if (strcmp (name, SYMBOLS_DEBUG) != 0)
+	{
+	  continue;
+	}
       inext = value;
       while (inext && *inext)
 	{
 	  ret = get_next_param (inext, &iname, &ivalue, &inext);
-	  if (ret < 0 || iname == NULL || ivalue == NULL)
+	  if (ret != '{' || ivalue == NULL
+	      || mi2_parser_parse_symbol_file (parser, ivalue) < 0)
 	    {
 	      LOG_ERR (PARSE_ERROR, inext);
 	      goto error;
 	    }
-	  if (strcmp (iname, "line") == 0)
-	    {
-	      line_nr = strtol (ivalue, &endptr, 0);
-	      LOG_ERR_IF_RETURN (endptr == ivalue,, NOT_A_NUMBER, ivalue);
-	    }
-	  else if (strcmp (iname, "file") == 0)
-	    {
-	      file = ivalue;
-	    }
-	  else if (strcmp (iname, "line_asm_insn") == 0)
-	    {
-	      LOG_ERR_IF_RETURN (file == NULL || line_nr < 0,,
-				 PARSE_ERROR, value);
-	      ret = mi2_parser_parse_asm_line (parser, file, line_nr, ivalue);
-	      LOG_ERR_IF_RETURN (ret < 0,, PARSE_ERROR, ivalue);
-	      if (ret == 1)
-		{
-		  new_function = 1;
-		}
-	    }
-	  else
-	    {
-	      LOG_ERR (PARSE_ERROR, iname);
-	      goto error;
-	    }
 	}
     }
-  view_update_ass (parser->view, parser->ass_lines, parser->pc);
+  symbol_index_sort (parser->symbols);
+  parser->symbols_loaded = 1;
+  DINFO (1, "%d functions", parser->symbols->nr_symbols);
+
+  mi2_parser_find_symbol (parser);
+  return;
+
 error:
-  ;
+  symbol_index_reset (parser->symbols);
 }
 
 /**
- * @brief Parse done files field.
- *
- * Parse the '^done,files' field. The field has the form:
+ * @brief Match the functions, used by the search form.
  *
- * @code
- * files=[{file='FILENAME'[,fullname='FULLNAME']},{file=...}]
- * @endcode
+ * @param data The parser.
+ * @param pattern The pattern.
  *
- * @param parser The parser.
- * @param files The field containing the files.
+ * @return The number of matching functions.
  */
-static void
-mi2_parser_parse_files (mi2_parser * parser, char *files)
+static int
+mi2_parser_match_symbol (void *data, const char *pattern)
 {
-  char *next;
-  char *name;
-  char *value;
-  char *inext;
-  char *iname;
-  char *ivalue;
-  char *buf[64];
-  char **items = buf;
-  int size = 64;
-  int len = 0;
-  int ret;
-  int i;
-
-  next = files;
-  while (next && *next)
-    {
-      ret = get_next_param (next, &name, &value, &next);
-      if (ret != '{' || value == NULL)
-	{
-	  LOG_ERR (PARSE_ERROR, next);
-	  goto error;
-	}
-      inext = value;
-      while (inext && *inext)
-	{
-	  ret = get_next_param (inext, &iname, &ivalue, &inext);
-	  if (ret < 0 || iname == NULL || ivalue == NULL)
-	    {
-	      LOG_ERR (PARSE_ERROR, inext);
-	      goto error;
-	    }
-	  if (strcmp (iname, "fullname") == 0)
-	    {
-	      items[len] = ivalue;
-	      len++;
-	      if (len >= size - 1)
-		{
-		  if (items == buf)
-		    {
-		      items = (char **) malloc ((len + 10) * sizeof (char *));
-		      LOG_ERR_IF_FATAL (items == NULL, "Memory");
-		      for (i = 0; i < size; i++)
-			{
-			  items[i] = buf[i];
-			}
-		      memset (&items[size], 0,
-			      (len + 10 - size) * sizeof (char *));
-		      size = len + 10;
-		    }
-		  else
-		    {
-		      items = (char **) realloc (items,
-						 (len +
-						  10) * sizeof (char *));
-		      LOG_ERR_IF_FATAL (items == NULL, "Memory");
-		      memset (&items[size], 0,
-			      (len + 10 - size) * sizeof (char *));
-		      size = len + 10;
-		    }
-		}
+  return symbol_index_match (((mi2_parser *) data)->symbols, pattern);
+}
 
-	    }
-	  else if (strcmp (iname, "file") != 0)
-	    {
-	      LOG_ERR (PARSE_ERROR, iname);
-	      goto error;
-	    }
-	}
-    }
-  if (len == 0)
-    {
-      return;
-    }
-  items[len] = NULL;
-  ret = form_selection (items, _("Select a file"));
-  if (ret == -2)
-    {
-      VLOG_ERR (parser->view, _("Could not retrieve file"));
-    }
-  else if (ret >= 0)
+/**
+ * @brief Get a matching function, used by the search form.
+ *
+ * The function is shown with the file name, without directories, and line.
+ *
+ * @param data The parser.
+ * @param nr The number of the match.
+ *
+ * @return The function or NULL.
+ */
+static const char *
+mi2_parser_get_symbol (void *data, int nr)
+{
+  mi2_parser *parser = (mi2_parser *) data;
+  const char *name;
+  const char *file;
+  const char *base;
+  int line;
+
+  name = symbol_index_get_match (parser->symbols, nr, &file, &line);
+  if (name == NULL)
     {
-      view_show_file (parser->view, items[ret], 0, 1);
+      return NULL;
     }
+  base = strrchr (file, '/');
+  snprintf (parser->symbol_item, SYMBOL_ITEM_LEN, "%s  %s:%d", name,
+	    base != NULL ? base + 1 : file, line);
 
-error:
-  if (items != buf)
-    {
-      free (items);
-    }
+  return parser->symbol_item;
 }
 
 /**
@@ -904,7 +1660,13 @@ mi2_parser_parse_threads (mi2_parser * parser, char *threads)
  *
  * For arguments to the function of the frame, there is the field 'arg="1"',
  * which indicates the variable is an argument. For local variables, 'arg' is
- * absent.
+ * absent. The type and value are absent when only the names are listed.
+ *
+ * The variables are merged into the scope of the frame. Variables new to the
+ * scope get a variable object, which is requested to be created, and the
+ * variable objects of variables no longer listed are requested to be
+ * deleted. The values of the variables already in the scope are kept, they
+ * are updated by -var-update.
  *
  * @param parser The mi2 parser.
  * @param vars The variables value.
@@ -925,10 +1687,21 @@ mi2_parser_parse_variables (mi2_parser * parser, char *vars)
   char *vtype = NULL;
   char *vval = NULL;
   int arg;
+  frame fresh;
+  frame *f;
+  scope *s;
+  variable *removed = NULL;
+  variable *lists[2];
+  variable *v;
+  int height;
+  int i;
+  char buf[32];
 
   assert (parser);
   assert (parser->frame >= 0);
 
+  memset (&fresh, 0, sizeof (fresh));
+
   next = vars;
   while (next != NULL && *next != '\0')
     {
@@ -972,16 +1745,72 @@ mi2_parser_parse_variables (mi2_parser * parser, char *vars)
 	  else
 	    {
 	      LOG_ERR (PARSE_ERROR, inner_name);
-	      return -1;
+	      goto error;
+	    }
+	}
+      if (vname == NULL)
+	{
+	  LOG_ERR (PARSE_ERROR, value);
+	  goto error;
+	}
+      ret = frame_insert_variable (&fresh, vname, vtype, vval, !arg, 0);
+      if (ret < 0)
+	{
+	  LOG_ERR ("Could not insert variable");
+	  goto error;
+	}
+    }
+
+  f = stack_get_frame (parser->stack, parser->frame);
+  height = parser->stack->total_depth - 1 - parser->frame;
+  s = scope_get (&parser->scopes, parser->thread_id, height, f->func);
+  variable_merge_list (&s->args, fresh.args, &removed);
+  variable_merge_list (&s->variables, fresh.variables, &removed);
+
+  for (v = removed; v != NULL; v = v->next)
+    {
+      if (v->var_name != NULL)
+	{
+	  mi2_parser_add_var_request (parser, VAR_ACTION_DELETE, -1,
+				      v->var_name, NULL);
+	}
+    }
+  variable_delete_list (removed);
+
+  /* Create variable objects for the new variables. */
+  lists[0] = s->args;
+  lists[1] = s->variables;
+  for (i = 0; i < 2; i++)
+    {
+      for (v = lists[i]; v != NULL; v = v->next)
+	{
+	  if (v->var_name != NULL)
+	    {
+	      continue;
 	    }
+	  snprintf (buf, sizeof (buf), "lv%d", v->id);
+	  v->var_name = strdup (buf);
+	  LOG_ERR_IF_FATAL (v->var_name == NULL, ERR_MSG_CREATE ("string"));
+	  mi2_parser_add_var_request (parser, VAR_ACTION_CREATE, parser->frame,
+				      v->var_name, v->name);
 	}
-      ret =
-	frame_insert_variable (stack_get_frame (parser->stack, parser->frame),
-			       vname, vtype, vval, !arg, 0);
-      LOG_ERR_IF_RETURN (ret < 0, -1, "Could not insert variable");
     }
 
+  if (f->scope == NULL)
+    {
+      variable_delete_list (f->args);
+      variable_delete_list (f->variables);
+    }
+  f->args = s->args;
+  f->variables = s->variables;
+  f->scope = s;
+
   return 0;
+
+error:
+  variable_delete_list (fresh.args);
+  variable_delete_list (fresh.variables);
+  return -1;
 }
 
 /**
@@ -994,6 +1823,10 @@ mi2_parser_parse_variables (mi2_parser * parser, char *vars)
  * func="main",file="example_1.c",fullname="/h/examples/example_1.c",line="27"}
  * @endcode
  *
+ * The frames are fetched a page at the time, so the frames are stored by
+ * their level without clearing the rest of the stack. The stack is cleared
+ * when the depth of a new stack is received.
+ *
  * @param parser The mi2 parser.
  * @param stack The stack value.
  *
@@ -1010,12 +1843,8 @@ mi2_parser_parsestack (mi2_parser * parser, char *stack)
   assert (parser);
   assert (stack);
 
-  /* Delete to old stack. */
-  if (parser->stack != NULL)
-    {
-      stack_clean_frame (parser->stack, -1);
-    }
-  parser->stack->depth = -1;
+  /* Frames of a new stack start at an empty stack. */
+  parser->stack->appended = parser->stack->depth > 0;
 
   next = stack;
   while (next != NULL && *next != '\0')
@@ -1027,10 +1856,70 @@ mi2_parser_parsestack (mi2_parser * parser, char *stack)
       ret = mi2_parser_parse_frame (parser, value, NULL);
       LOG_ERR_IF_RETURN (ret < 0, -1, PARSE_ERROR, value);
     }
-
-  view_update_stack (parser->view, parser->stack);
-
-  return 0;
+
+  view_update_stack (parser->view, parser->stack);
+  mi2_parser_prefetch_sources (parser);
+
+  return 0;
+}
+
+/**
+ * @brief Prefetch the source files the user may go to next.
+ *
+ * The files of the top frames of the stack, and of the current frames of the
+ * threads before and after the current thread, are read in the background.
+ * Selecting one of those frames then shows the file at once.
+ *
+ * @param parser The mi2 parser.
+ */
+static void
+mi2_parser_prefetch_sources (mi2_parser * parser)
+{
+  thread_group *pg;
+  thread *pt;
+  thread *prev = NULL;
+  thread *next = NULL;
+  int found = 0;
+  int i;
+
+  for (i = 0; i < parser->stack->depth && i < SOURCE_PREFETCH; i++)
+    {
+      if (parser->stack->stack[i].fullname != NULL)
+	{
+	  view_prefetch_file (parser->view, parser->stack->stack[i].fullname);
+	}
+    }
+
+  for (pg = parser->thread_groups; pg != NULL && next == NULL; pg = pg->next)
+    {
+      for (pt = pg->first; pt != NULL && next == NULL; pt = pt->next)
+	{
+	  if (found)
+	    {
+	      next = pt;
+	    }
+	  else if (pt->id == parser->thread_id)
+	    {
+	      found = 1;
+	    }
+	  else
+	    {
+	      prev = pt;
+	    }
+	}
+    }
+  if (!found)
+    {
+      return;
+    }
+  if (prev != NULL && !prev->running && prev->frame.fullname != NULL)
+    {
+      view_prefetch_file (parser->view, prev->frame.fullname);
+    }
+  if (next != NULL && !next->running && next->frame.fullname != NULL)
+    {
+      view_prefetch_file (parser->view, next->frame.fullname);
+    }
 }
 
 /**
@@ -1180,7 +2069,7 @@ mi2_parser_parse_frame (mi2_parser * parser, char *frame_value,
       if (strcmp (name, FRAME_ADDR) == 0)
 	{
 	  LOG_ERR_IF_RETURN (pframe == NULL, -1, "No level yet");
-	  pframe->addr = strtol (value, &endptr, 0);
+	  pframe->addr = strtoull (value, &endptr, 0);
 	  if (value == endptr)
 	    {
 	      LOG_ERR (NOT_A_NUMBER, value);
@@ -1251,6 +2140,8 @@ mi2_parser_parse_frame (mi2_parser * parser, char *frame_value,
 	       * update.
 	       */
 	      pframe = stack_get_frame (parser->stack, level);
+	      /* The frame might be fetched again, drop the old values. */
+	      stack_clean_frame (parser->stack, level);
 	    }
 	  LOG_ERR_IF_RETURN (pframe == NULL, -1, "Could not get frame of "
 			     " level %d", level);
@@ -1497,7 +2388,7 @@ mi2_parser_parse_bkpt (mi2_parser * parser, char *line)
 	}
       else if (strcmp (name, BKPT_ADDR) == 0)
 	{
-	  bp->addr = strtol (value, &endptr, 0);
+	  bp->addr = strtoull (value, &endptr, 0);
 	  if (endptr == value)
 	    {
 	      LOG_ERR (NOT_A_NUMBER, value);
@@ -1614,12 +2505,28 @@ mi2_parser_parse_done (mi2_parser * parser, char *line)
   char *name;
   char *value;
   char *next;
+  char *endptr;
 
   if (*line == '\0')
     {
       return 0;
     }
 
+  /* Variable objects responses are parsed as a whole. */
+  if (strncmp (line, "," VAR_NAME "=", strlen ("," VAR_NAME "=")) == 0)
+    {
+      return mi2_parser_parse_var_create (parser, line + 1);
+    }
+  if (strncmp (line, "," VAR_NUMCHILD "=",
+	       strlen ("," VAR_NUMCHILD "=")) == 0)
+    {
+      return mi2_parser_parse_var_children (parser, line + 1);
+    }
+  if (strncmp (line, "," MEMORY_ADDR "=", strlen ("," MEMORY_ADDR "=")) == 0)
+    {
+      return mi2_parser_parse_memory_locate (parser, line + 1);
+    }
+
   next = line;
   while (next != NULL && *next != '\0' && ret == 0)
     {
@@ -1637,6 +2544,18 @@ mi2_parser_parse_done (mi2_parser * parser, char *line)
 	{
 	  ret = mi2_parser_parsestack (parser, value);
 	}
+      else if (name && strcmp (name, DONE_DEPTH) == 0)
+	{
+	  /* A new stack, the frames will follow page by page. */
+	  stack_clean_frame (parser->stack, -1);
+	  parser->stack->total_depth = strtol (value, &endptr, 0);
+	  LOG_ERR_IF_RETURN (value == endptr, -1, NOT_A_NUMBER, value);
+	  ret = 0;
+	}
+      else if (name && strcmp (name, DONE_CHANGELIST) == 0)
+	{
+	  ret = mi2_parser_parse_var_update (parser, value);
+	}
       else if (name && strcmp (name, DONE_VARIABLES) == 0)
 	{
 	  ret = mi2_parser_parse_variables (parser, value);
@@ -1674,16 +2593,12 @@ mi2_parser_parse_done (mi2_parser * parser, char *line)
 	  if (ret == 0)
 	    {
 	      view_update_threads (parser->view, parser->thread_groups);
+	      mi2_parser_prefetch_sources (parser);
 	    }
 	}
-      else if (name && strcmp (name, DONE_FILES) == 0)
-	{
-	  mi2_parser_parse_files (parser, value);
-	  ret = 0;
-	}
-      else if (name && strcmp (name, DONE_ASM_INSNS) == 0)
+      else if (name && strcmp (name, DONE_SYMBOLS) == 0)
 	{
-	  mi2_parser_parse_asm (parser, value);
+	  mi2_parser_parse_symbols (parser, value);
 	  ret = 0;
 	}
       else if (name && strcmp (name, DONE_REGISTER_NAMES) == 0)
@@ -1703,9 +2618,13 @@ mi2_parser_parse_done (mi2_parser * parser, char *line)
 	}
       else if (name && strcmp (name, DONE_VALUE) == 0)
 	{
-	  parser->pc = strtol (value, NULL, 0);
+	  mi2_parser_show_pc (parser, strtoull (value, NULL, 0));
 	  ret = 0;
 	}
+      else if (name && strcmp (name, DONE_MEMORY) == 0)
+	{
+	  ret = mi2_parser_parse_memory (parser, value);
+	}
       else
 	{
 	  LOG_ERR (PARSE_ERROR, name == NULL ? (value ? value : "") : name);
@@ -1868,6 +2787,10 @@ mi2_parser_parse_stopped (mi2_parser * parser, char *line)
 
   stack_clean_frame (parser->stack, -1);
 
+  /* The memory may have changed, read the shown pages again. */
+  mem_cache_invalidate (parser->memory, 0, UINT64_MAX);
+  parser->mem_refresh = parser->memory->length > 0;
+
   next = line;
   while (next != NULL && *next != 0)
     {
@@ -2255,7 +3178,8 @@ error:
  * =library-unloaded,id=".",host-name=".",target-name=".",symbols-loaded="1/0"
  * @endcode
  *
- * The view will be updated with the new library information.
+ * The library view is not updated here, it is marked as changed and updated
+ * by mi2_parser_flush when the current burst of records has been parsed.
  *
  * @param parser The parser.
  * @param line The line after "=library-"
@@ -2332,18 +3256,523 @@ mi2_parser_parse_library (mi2_parser * parser, char *line)
 		     loaded_symbols == -1 && load_library == 1 ?
 		     " symbols-loaded" : "");
 
+  /* New symbols may add source files and functions. */
+  if (load_library == 0 || loaded_symbols == 1)
+    {
+      parser->files_loaded = 0;
+      parser->symbols_loaded = 0;
+    }
+
   if (load_library == 0)
     {
-      library_remove (&parser->libraries, id, target, host);
+      library_remove (parser->libraries, id, target, host);
     }
   else
     {
-      ret = library_add (&parser->libraries, id, target, host,
+      ret = library_add (parser->libraries, id, target, host,
 			 loaded_symbols);
       LOG_ERR_IF_RETURN (ret < 0, -1, "Could add library");
     }
 
-  view_update_libraries (parser->view, parser->libraries);
+  parser->libraries_changed = 1;
+
+  return 0;
+}
+
+/**
+ * @brief Get the current frame.
+ *
+ * @param parser The parser.
+ *
+ * @return The current frame, or NULL if no frame is selected.
+ */
+static frame *
+mi2_parser_current_frame (mi2_parser * parser)
+{
+  assert (parser);
+
+  if (parser->frame < 0 || parser->frame >= parser->stack->depth)
+    {
+      return NULL;
+    }
+
+  return &parser->stack->stack[parser->frame];
+}
+
+/**
+ * @brief Find a variable by its variable object.
+ *
+ * Search the scopes for the variable of a variable object.
+ *
+ * @param parser The parser.
+ * @param var_name The name of the variable object.
+ * @param parent If 1 the parent of @a var_name is searched for instead.
+ * @param owner If non NULL it will be set to the scope of the variable.
+ *
+ * @return The variable, or NULL if not found.
+ */
+static variable *
+mi2_parser_find_object (mi2_parser * parser, const char *var_name,
+			int parent, scope ** owner)
+{
+  scope *s;
+  variable *v;
+
+  for (s = parser->scopes; s != NULL; s = s->next)
+    {
+      if (parent)
+	{
+	  v = variable_find_parent (s->args, var_name);
+	  if (v == NULL)
+	    {
+	      v = variable_find_parent (s->variables, var_name);
+	    }
+	}
+      else
+	{
+	  v = variable_find_object (s->args, var_name);
+	  if (v == NULL)
+	    {
+	      v = variable_find_object (s->variables, var_name);
+	    }
+	}
+      if (v != NULL)
+	{
+	  if (owner != NULL)
+	    {
+	      *owner = s;
+	    }
+	  return v;
+	}
+    }
+
+  return NULL;
+}
+
+/**
+ * @brief Add a variable object request.
+ *
+ * Add a command for the mi2 interface to send, see
+ * mi2_parser_next_var_request().
+ *
+ * @param parser The parser.
+ * @param action #VAR_ACTION_CREATE or #VAR_ACTION_DELETE.
+ * @param frame The level of the frame of the variable.
+ * @param var_name The name of the variable object.
+ * @param exp The expression of the variable object, NULL when deleting.
+ */
+static void
+mi2_parser_add_var_request (mi2_parser * parser, int action, int frame,
+			    const char *var_name, const char *exp)
+{
+  var_request *request;
+
+  request = (var_request *) malloc (sizeof (*request));
+  LOG_ERR_IF_FATAL (request == NULL, ERR_MSG_CREATE ("variable request"));
+  request->action = action;
+  request->thread_id = parser->thread_id;
+  request->frame = frame;
+  request->var_name = strdup (var_name);
+  LOG_ERR_IF_FATAL (request->var_name == NULL, ERR_MSG_CREATE ("string"));
+  request->exp = NULL;
+  if (exp != NULL)
+    {
+      request->exp = strdup (exp);
+      LOG_ERR_IF_FATAL (request->exp == NULL, ERR_MSG_CREATE ("string"));
+    }
+  request->next = NULL;
+
+  *parser->last_request = request;
+  parser->last_request = &request->next;
+}
+
+/**
+ * @brief Drop a scope.
+ *
+ * Request the variable objects of the scope to be deleted, and remove the
+ * scope. The frames showing the variables of the scope are left empty.
+ *
+ * @param parser The parser.
+ * @param s The scope to drop.
+ */
+static void
+mi2_parser_drop_scope (mi2_parser * parser, scope * s)
+{
+  variable *lists[2];
+  variable *v;
+  int i;
+
+  DINFO (3, "Dropping scope %s at height %d", s->func, s->height);
+
+  lists[0] = s->args;
+  lists[1] = s->variables;
+  for (i = 0; i < 2; i++)
+    {
+      for (v = lists[i]; v != NULL; v = v->next)
+	{
+	  if (v->var_name != NULL)
+	    {
+	      mi2_parser_add_var_request (parser, VAR_ACTION_DELETE, -1,
+					  v->var_name, NULL);
+	    }
+	}
+    }
+
+  for (i = 0; i < parser->stack->max_depth; i++)
+    {
+      if (parser->stack->stack[i].scope == s)
+	{
+	  parser->stack->stack[i].args = NULL;
+	  parser->stack->stack[i].variables = NULL;
+	  parser->stack->stack[i].scope = NULL;
+	  parser->frame_changed = 1;
+	}
+    }
+
+  scope_remove (&parser->scopes, s);
+}
+
+/**
+ * @brief Parse the response of -var-create.
+ *
+ * The response has the form:
+ *
+ * @code
+ * name="lv3",numchild="2",value="{...}",type="struct P",thread-id="1",
+ * has_more="0"
+ * @endcode
+ *
+ * The variable with the variable object is updated. Fields not used by
+ * lvdbg, e.g. thread-id, are ignored.
+ *
+ * @param parser The parser.
+ * @param line The response after "^done,".
+ *
+ * @return 0 if parsed, otherwise -1.
+ */
+static int
+mi2_parser_parse_var_create (mi2_parser * parser, char *line)
+{
+  int ret;
+  char *name;
+  char *value;
+  char *next;
+  char *endptr;
+  char *var_name = NULL;
+  char *type = NULL;
+  char *val = NULL;
+  int numchild = -1;
+  variable *v;
+
+  next = line;
+  while (next != NULL && *next != '\0')
+    {
+      ret = get_next_param (next, &name, &value, &next);
+      LOG_ERR_IF_RETURN (ret < 0 || name == NULL || value == NULL, -1,
+			 PARSE_ERROR, line);
+      if (strcmp (name, VAR_NAME) == 0)
+	{
+	  var_name = value;
+	}
+      else if (strcmp (name, VAR_NUMCHILD) == 0)
+	{
+	  numchild = strtol (value, &endptr, 0);
+	  LOG_ERR_IF_RETURN (value == endptr, -1, NOT_A_NUMBER, value);
+	}
+      else if (strcmp (name, VAR_TYPE) == 0)
+	{
+	  type = value;
+	}
+      else if (strcmp (name, VAR_VALUE) == 0)
+	{
+	  val = value;
+	}
+    }
+  LOG_ERR_IF_RETURN (var_name == NULL, -1, PARSE_ERROR, line);
+
+  v = mi2_parser_find_object (parser, var_name, 0, NULL);
+  if (v == NULL)
+    {
+      DINFO (1, "No variable for variable object '%s'", var_name);
+      return 0;
+    }
+
+  v->numchild = numchild;
+  if (type != NULL && v->type == NULL)
+    {
+      v->type = strdup (type);
+      LOG_ERR_IF_FATAL (v->type == NULL, ERR_MSG_CREATE ("string"));
+    }
+  if (val != NULL)
+    {
+      if (v->value != NULL)
+	{
+	  free (v->value);
+	}
+      v->value = strdup (val);
+      LOG_ERR_IF_FATAL (v->value == NULL, ERR_MSG_CREATE ("string"));
+    }
+
+  /* All variables of a new scope are created at once, draw them once. */
+  parser->frame_changed = 1;
+
+  return 0;
+}
+
+/**
+ * @brief Parse the response of -var-list-children.
+ *
+ * The response has the form:
+ *
+ * @code
+ * numchild="2",children=[child={name="lv3.a",exp="a",numchild="0",
+ * value="1",type="int",thread-id="1"},child={...}],has_more="0"
+ * @endcode
+ *
+ * The children replace the old children of the parent variable.
+ *
+ * @param parser The parser.
+ * @param line The response after "^done,".
+ *
+ * @return 0 if parsed, otherwise -1.
+ */
+static int
+mi2_parser_parse_var_children (mi2_parser * parser, char *line)
+{
+  int ret;
+  char *name;
+  char *value;
+  char *next;
+  char *child_name;
+  char *child_value;
+  char *child_next;
+  char *field_name;
+  char *field_value;
+  char *endptr;
+  char *var_name;
+  char *exp;
+  char *type;
+  char *val;
+  int numchild;
+  variable *parent = NULL;
+
+  next = line;
+  while (next != NULL && *next != '\0')
+    {
+      ret = get_next_param (next, &name, &value, &next);
+      LOG_ERR_IF_RETURN (ret < 0 || name == NULL || value == NULL, -1,
+			 PARSE_ERROR, line);
+      if (strcmp (name, VAR_CHILDREN) != 0)
+	{
+	  continue;
+	}
+      child_next = value;
+      while (child_next != NULL && *child_next != '\0')
+	{
+	  ret = get_next_param (child_next, &child_name, &child_value,
+				&child_next);
+	  LOG_ERR_IF_RETURN (ret != '{' || child_name == NULL
+			     || strcmp (child_name, VAR_CHILD) != 0, -1,
+			     PARSE_ERROR, value);
+	  var_name = NULL;
+	  exp = NULL;
+	  type = NULL;
+	  val = NULL;
+	  numchild = -1;
+	  while (child_value != NULL && *child_value != '\0')
+	    {
+	      ret = get_next_param (child_value, &field_name, &field_value,
+				    &child_value);
+	      LOG_ERR_IF_RETURN (ret < 0 || field_name == NULL
+				 || field_value == NULL, -1, PARSE_ERROR,
+				 value);
+	      if (strcmp (field_name, VAR_NAME) == 0)
+		{
+		  var_name = field_value;
+		}
+	      else if (strcmp (field_name, VAR_EXP) == 0)
+		{
+		  exp = field_value;
+		}
+	      else if (strcmp (field_name, VAR_NUMCHILD) == 0)
+		{
+		  numchild = strtol (field_value, &endptr, 0);
+		  LOG_ERR_IF_RETURN (field_value == endptr, -1, NOT_A_NUMBER,
+				     field_value);
+		}
+	      else if (strcmp (field_name, VAR_TYPE) == 0)
+		{
+		  type = field_value;
+		}
+	      else if (strcmp (field_name, VAR_VALUE) == 0)
+		{
+		  val = field_value;
+		}
+	    }
+	  LOG_ERR_IF_RETURN (var_name == NULL || exp == NULL, -1,
+			     PARSE_ERROR, value);
+	  if (parent == NULL)
+	    {
+	      parent = mi2_parser_find_object (parser, var_name, 1, NULL);
+	      if (parent == NULL)
+		{
+		  DINFO (1, "No parent for variable object '%s'", var_name);
+		  return 0;
+		}
+	      variable_delete_list (parent->children);
+	      parent->children = NULL;
+	    }
+	  variable_add_child (parent, exp, var_name, type, val, numchild);
+	}
+    }
+
+  if (parent != NULL)
+    {
+      parent->expanded = 1;
+      view_update_frame (parser->view, parser->stack, parser->frame);
+    }
+
+  return 0;
+}
+
+/**
+ * @brief Parse the response of -var-update.
+ *
+ * The changelist has the form:
+ *
+ * @code
+ * {name="lv3",value="5",in_scope="true",type_changed="false",has_more="0"},
+ * {name="lv4",in_scope="false",has_more="0"}
+ * @endcode
+ *
+ * Only the variable objects that changed since the last update are listed.
+ * Their variables are marked as changed, and the changed marks of the last
+ * update are cleared. A variable object out of scope means that its frame is
+ * gone, and the whole scope is dropped. If the type changed the children are
+ * no longer valid and are removed.
+ *
+ * @param parser The parser.
+ * @param changelist The changelist value.
+ *
+ * @return 0 if parsed, otherwise -1.
+ */
+static int
+mi2_parser_parse_var_update (mi2_parser * parser, char *changelist)
+{
+  int ret;
+  char *name;
+  char *value;
+  char *next;
+  char *field_name;
+  char *field_value;
+  char *field_next;
+  char *endptr;
+  char *var_name;
+  char *val;
+  char *new_type;
+  int in_scope;
+  int type_changed;
+  int numchild;
+  scope *s;
+  variable *v;
+
+  for (s = parser->scopes; s != NULL; s = s->next)
+    {
+      variable_clear_changed (s->args);
+      variable_clear_changed (s->variables);
+    }
+  parser->frame_changed = 1;
+
+  next = changelist;
+  while (next != NULL && *next != '\0')
+    {
+      ret = get_next_param (next, &name, &value, &next);
+      LOG_ERR_IF_RETURN (ret != '{' || value == NULL, -1, PARSE_ERROR,
+			 changelist);
+
+      var_name = NULL;
+      val = NULL;
+      new_type = NULL;
+      in_scope = 1;
+      type_changed = 0;
+      numchild = -1;
+      field_next = value;
+      while (field_next != NULL && *field_next != '\0')
+	{
+	  ret = get_next_param (field_next, &field_name, &field_value,
+				&field_next);
+	  LOG_ERR_IF_RETURN (ret < 0 || field_name == NULL
+			     || field_value == NULL, -1, PARSE_ERROR, value);
+	  if (strcmp (field_name, VAR_NAME) == 0)
+	    {
+	      var_name = field_value;
+	    }
+	  else if (strcmp (field_name, VAR_VALUE) == 0)
+	    {
+	      val = field_value;
+	    }
+	  else if (strcmp (field_name, VAR_IN_SCOPE) == 0)
+	    {
+	      in_scope = strcmp (field_value, "true") == 0;
+	    }
+	  else if (strcmp (field_name, VAR_TYPE_CHANGED) == 0)
+	    {
+	      type_changed = strcmp (field_value, "true") == 0;
+	    }
+	  else if (strcmp (field_name, VAR_NEW_TYPE) == 0)
+	    {
+	      new_type = field_value;
+	    }
+	  else if (strcmp (field_name, VAR_NEW_NUM_CHILDREN) == 0)
+	    {
+	      numchild = strtol (field_value, &endptr, 0);
+	      LOG_ERR_IF_RETURN (field_value == endptr, -1, NOT_A_NUMBER,
+				 field_value);
+	    }
+	}
+      LOG_ERR_IF_RETURN (var_name == NULL, -1, PARSE_ERROR, value);
+
+      v = mi2_parser_find_object (parser, var_name, 0, &s);
+      if (v == NULL)
+	{
+	  /* E.g. a child of a scope dropped earlier in the list. */
+	  DINFO (3, "No variable for variable object '%s'", var_name);
+	  continue;
+	}
+      if (!in_scope)
+	{
+	  mi2_parser_drop_scope (parser, s);
+	  continue;
+	}
+
+      if (type_changed)
+	{
+	  if (v->type != NULL)
+	    {
+	      free (v->type);
+	      v->type = NULL;
+	    }
+	  if (new_type != NULL)
+	    {
+	      v->type = strdup (new_type);
+	      LOG_ERR_IF_FATAL (v->type == NULL, ERR_MSG_CREATE ("string"));
+	    }
+	  variable_delete_list (v->children);
+	  v->children = NULL;
+	  v->expanded = 0;
+	  v->numchild = numchild;
+	}
+      if (val != NULL)
+	{
+	  if (v->value != NULL)
+	    {
+	      free (v->value);
+	    }
+	  v->value = strdup (val);
+	  LOG_ERR_IF_FATAL (v->value == NULL, ERR_MSG_CREATE ("string"));
+	}
+      v->changed = 1;
+    }
 
   return 0;
 }
@@ -2380,20 +3809,41 @@ mi2_parser_create (view * view, configuration * conf)
   new_parser->breakpoint_table = bp_table_create ();
 
   new_parser->thread_groups = NULL;
-  new_parser->libraries = NULL;
+  new_parser->libraries = library_table_create ();
+  new_parser->libraries_changed = 0;
   new_parser->frame = -1;
+  new_parser->frame_changed = 0;
+  new_parser->scopes = NULL;
+  new_parser->requests = NULL;
+  new_parser->last_request = &new_parser->requests;
   new_parser->stack = stack_create (10);
   new_parser->thread_id = -1;
   new_parser->disassemble = 0;
   new_parser->ass_lines = ass_create ();
   LOG_ERR_IF_FATAL (new_parser->ass_lines == NULL,
 		    ERR_MSG_CREATE ("assembler"));
+  new_parser->ass_shown = NULL;
+  new_parser->ass_request = 0;
+  new_parser->pc = ASM_NO_ADDRESS;
   new_parser->changed_regs = 0;
   new_parser->regs = 0;
   new_parser->size_regs = 0;
   new_parser->registers = data_registers_create ();
   LOG_ERR_IF_FATAL (new_parser->registers == NULL,
 		    ERR_MSG_CREATE ("registers"));
+  new_parser->memory = mem_cache_create ();
+  new_parser->mem_locate = 0;
+  new_parser->mem_refresh = 0;
+  new_parser->files = file_index_create ();
+  new_parser->files_loaded = 0;
+  new_parser->symbols = symbol_index_create ();
+  new_parser->symbols_loaded = 0;
+  memset (&new_parser->streamed, 0, sizeof (new_parser->streamed));
+  new_parser->stream = mi2_stream_create ();
+  mi2_stream_register (new_parser->stream, "^done", DONE_FILES,
+		       &files_handler, new_parser);
+  mi2_stream_register (new_parser->stream, "^done", DONE_ASM_INSNS,
+		       &asm_handler, new_parser);
 
   new_parser->auto_frames = conf_get_bool (conf, NULL, "auto frames", NULL);
 
@@ -2410,6 +3860,8 @@ mi2_parser_create (view * view, configuration * conf)
 void
 mi2_parser_free (mi2_parser * parser)
 {
+  var_request *request;
+
   assert (parser);
 
   if (parser->breakpoint_table != NULL)
@@ -2422,9 +3874,23 @@ mi2_parser_free (mi2_parser * parser)
       stack_free (parser->stack);
     }
 
+  while (parser->scopes != NULL)
+    {
+      scope_remove (&parser->scopes, parser->scopes);
+    }
+
+  while (parser->requests != NULL)
+    {
+      request = parser->requests;
+      parser->requests = request->next;
+      free (request->var_name);
+      free (request->exp);
+      free (request);
+    }
+
   if (parser->libraries != NULL)
     {
-      library_remove_all (&parser->libraries);
+      library_table_free (parser->libraries);
     }
 
   if (parser->thread_groups != NULL)
@@ -2442,10 +3908,28 @@ mi2_parser_free (mi2_parser * parser)
       ass_free (parser->ass_lines);
     }
 
+  if (parser->memory != NULL)
+    {
+      mem_cache_free (parser->memory);
+    }
+
+  if (parser->files != NULL)
+    {
+      file_index_free (parser->files);
+    }
+
+  if (parser->symbols != NULL)
+    {
+      symbol_index_free (parser->symbols);
+    }
+
   if (parser->regs)
     {
       free (parser->regs);
     }
+  mi2_stream_free (parser->stream);
+  asm_function_free (parser->streamed.func);
+  mi2_parser_stream_reset (parser);
   free (parser);
 }
 
@@ -2484,6 +3968,15 @@ mi2_parser_parse (mi2_parser * parser, char *line, int *update, char **regs)
       return -1;
     }
 
+  /* The results that may be huge are parsed by their stream handlers. */
+  parser->stream_error = 0;
+  mi2_stream_feed (parser->stream, line, strlen (line));
+  if (mi2_stream_feed (parser->stream, "\n", 1))
+    {
+      LOG_ERR_IF_RETURN (parser->stream_error, -1, PARSE_ERROR, line);
+      return 0;
+    }
+
   if (strncmp (line, "^done", 5) == 0)
     {
       DINFO (3, "Got ^done");
@@ -2528,18 +4021,209 @@ mi2_parser_parse (mi2_parser * parser, char *line, int *update, char **regs)
     {
       ret = mi2_parser_parse_library (parser, line + 9);
     }
+  else if (strncmp (line, MEMORY_CHANGED, strlen (MEMORY_CHANGED)) == 0)
+    {
+      ret = mi2_parser_parse_memory_changed (parser,
+					     line + strlen (MEMORY_CHANGED));
+    }
   else
     {
       ret = -1;
     }
   if (parser->changed_regs)
     {
+      /* Handed out once, one request per stop. */
       *regs = parser->regs;
+      parser->changed_regs = 0;
     }
   LOG_ERR_IF (ret < 0, PARSE_ERROR, line);
   return ret;
 }
 
+/**
+ * @brief Parse a part of a record from the debugger.
+ *
+ * Used for records too long to be read as one line. The bytes are parsed as
+ * they arrive, the record ends with '\\n'. Only the results with a stream
+ * handler, e.g. '^done,files' and '^done,asm_insns', are parsed this way.
+ * Other records must be given to mi2_parser_parse() as a whole, once they
+ * have ended.
+ *
+ * @param parser The parser.
+ * @param buf The bytes.
+ * @param len The number of bytes.
+ *
+ * @return 1 if the record is parsed by a stream handler, otherwise 0. -1 if
+ *         a record parsed by a stream handler ended broken.
+ */
+int
+mi2_parser_feed (mi2_parser * parser, const char *buf, int len)
+{
+  int ret;
+
+  assert (parser);
+  assert (buf);
+
+  parser->stream_error = 0;
+  ret = mi2_stream_feed (parser->stream, buf, len);
+  LOG_ERR_IF_RETURN (ret && parser->stream_error, -1,
+		     "Could not parse a streamed record");
+
+  return ret;
+}
+
+/**
+ * @brief Flush pending view updates.
+ *
+ * Update the views that has been changed by the parsed records but not yet
+ * been redrawn. Should be called when there are no more records to parse,
+ * so a burst of e.g. library events only redraws the view once.
+ *
+ * @param parser The parser.
+ */
+void
+mi2_parser_flush (mi2_parser * parser)
+{
+  assert (parser);
+
+  if (parser->libraries_changed)
+    {
+      view_update_libraries (parser->view, parser->libraries->first);
+      parser->libraries_changed = 0;
+    }
+  if (parser->frame_changed)
+    {
+      view_update_frame (parser->view, parser->stack, parser->frame);
+      parser->frame_changed = 0;
+    }
+}
+
+/**
+ * @brief Get the depth of the current stack.
+ *
+ * Get the number of frames fetched for the current stack and the depth
+ * reported by the debugger.
+ *
+ * @param parser The mi2 parser.
+ * @param total Will be set to the total depth of the stack, -1 if not known.
+ *
+ * @return The number of frames fetched.
+ */
+int
+mi2_parser_get_stack_depth (mi2_parser * parser, int *total)
+{
+  assert (parser);
+  assert (total);
+
+  *total = parser->stack->total_depth;
+
+  return parser->stack->depth < 0 ? 0 : parser->stack->depth;
+}
+
+/**
+ * @brief Expand or collapse a variable.
+ *
+ * Toggle the variable with @a id in the current frame. The children of a
+ * variable are fetched the first time it is expanded, after that the
+ * variable is expanded and collapsed without asking the debugger. Variables
+ * whose variable object is not created yet can not be expanded.
+ *
+ * @param parser The mi2 parser.
+ * @param id The id of the variable.
+ * @param var_name Will be set to the variable object to list the children
+ *                 of.
+ *
+ * @return #VAR_ACTION_NONE if nothing has to be sent to the debugger,
+ *         #VAR_ACTION_CHILDREN if the children have to be listed, or -1 if
+ *         there is no such variable.
+ */
+int
+mi2_parser_var_toggle (mi2_parser * parser, int id, const char **var_name)
+{
+  frame *f;
+  variable *v;
+
+  assert (parser);
+  assert (var_name);
+
+  f = mi2_parser_current_frame (parser);
+  LOG_ERR_IF_RETURN (f == NULL, -1, "No frame selected");
+
+  v = variable_find (f->args, id);
+  if (v == NULL)
+    {
+      v = variable_find (f->variables, id);
+    }
+  LOG_ERR_IF_RETURN (v == NULL, -1, "No variable with id %d", id);
+
+  if (v->var_name == NULL || v->numchild == 0)
+    {
+      return VAR_ACTION_NONE;
+    }
+  if (v->children == NULL && !v->expanded)
+    {
+      *var_name = v->var_name;
+      return VAR_ACTION_CHILDREN;
+    }
+
+  v->expanded = !v->expanded;
+  view_update_frame (parser->view, parser->stack, parser->frame);
+
+  return VAR_ACTION_NONE;
+}
+
+/**
+ * @brief Get the next variable object request.
+ *
+ * The variable objects of the listed frames are created and deleted by the
+ * parser, but the commands are sent by the mi2 interface. Should be called
+ * after each parsed line until #VAR_ACTION_NONE is returned.
+ *
+ * @param parser The mi2 parser.
+ * @param thread_id Will be set to the thread of the frame.
+ * @param frame Will be set to the level of the frame.
+ * @param var_name Will be set to the name of the variable object. Must be
+ *                 freed by the caller.
+ * @param exp Will be set to the expression of the variable object to create,
+ *            NULL when deleting. Must be freed by the caller.
+ *
+ * @return #VAR_ACTION_CREATE or #VAR_ACTION_DELETE, or #VAR_ACTION_NONE if
+ *         there are no more requests.
+ */
+int
+mi2_parser_next_var_request (mi2_parser * parser, int *thread_id,
+			     int *frame, char **var_name, char **exp)
+{
+  var_request *request;
+  int action;
+
+  assert (parser);
+  assert (thread_id);
+  assert (frame);
+  assert (var_name);
+  assert (exp);
+
+  request = parser->requests;
+  if (request == NULL)
+    {
+      return VAR_ACTION_NONE;
+    }
+  parser->requests = request->next;
+  if (parser->requests == NULL)
+    {
+      parser->last_request = &parser->requests;
+    }
+
+  action = request->action;
+  *thread_id = request->thread_id;
+  *frame = request->frame;
+  *var_name = request->var_name;
+  *exp = request->exp;
+  free (request);
+
+  return action;
+}
+
 /**
  * @brief Set the current frame.
  *
@@ -2741,3 +4425,236 @@ mi2_parser_toggle_disassemble (mi2_parser * parser)
 
   parser->disassemble = !parser->disassemble;
 }
+
+/**
+ * @brief Check if the function at the pc must be disassembled.
+ *
+ * Set when a new pc is not inside any cached function. The request is
+ * cleared when read.
+ *
+ * @param parser The parser.
+ *
+ * @return 1 if the function should be disassembled, otherwise 0.
+ */
+int
+mi2_parser_disassembly_request (mi2_parser * parser)
+{
+  int request;
+
+  assert (parser);
+
+  request = parser->ass_request;
+  parser->ass_request = 0;
+
+  return request;
+}
+
+/**
+ * @brief Set the length of a new memory region.
+ *
+ * The mi2 interface asks the debugger for the address of the region, the
+ * region is shown when the address is parsed.
+ *
+ * @param parser The parser.
+ * @param length The length of the region.
+ */
+void
+mi2_parser_memory_locate (mi2_parser * parser, uint64_t length)
+{
+  assert (parser);
+
+  parser->mem_locate = length;
+}
+
+/**
+ * @brief Check if the pages in the memory window must be read.
+ *
+ * Set when a new region is shown or the memory may have changed. The
+ * request is cleared when read.
+ *
+ * @param parser The parser.
+ *
+ * @return 1 if the pages should be read, otherwise 0.
+ */
+int
+mi2_parser_memory_refresh (mi2_parser * parser)
+{
+  int request;
+
+  assert (parser);
+
+  request = parser->mem_refresh;
+  parser->mem_refresh = 0;
+
+  return request;
+}
+
+/**
+ * @brief Get the memory pages to read.
+ *
+ * Get the pages that must be read to show [@a address, @a address +
+ * @a length), followed by #MEM_PREFETCH pages after and before, within the
+ * region. The returned pages are marked as pending in the cache.
+ *
+ * @param parser The parser.
+ * @param address The address of the shown memory.
+ * @param length The length of the shown memory.
+ * @param pages Set to the addresses of the pages to read.
+ * @param size The size of @a pages.
+ *
+ * @return The number of pages to read.
+ */
+int
+mi2_parser_memory_pages (mi2_parser * parser, uint64_t address,
+			 uint64_t length, uint64_t * pages, int size)
+{
+  mem_cache *cache;
+  uint64_t first;
+  uint64_t last;
+  uint64_t start;
+  uint64_t end;
+  uint64_t page;
+  int nr = 0;
+  int i;
+
+  assert (parser);
+  assert (pages);
+
+  cache = parser->memory;
+  if (cache->length == 0 || length == 0)
+    {
+      return 0;
+    }
+
+  start = cache->start - cache->start % MEM_PAGE_SIZE;
+  end = cache->start + cache->length - 1;
+  first = address - address % MEM_PAGE_SIZE;
+  last = address + length - 1;
+  last -= last % MEM_PAGE_SIZE;
+
+  /* The shown pages. */
+  page = first;
+  while (nr < size)
+    {
+      if (mem_cache_request (cache, page))
+	{
+	  pages[nr++] = page;
+	}
+      if (page == last)
+	{
+	  break;
+	}
+      page += MEM_PAGE_SIZE;
+    }
+
+  /* Prefetch after and before. */
+  for (i = 1; i <= MEM_PREFETCH && nr < size; i++)
+    {
+      page = last + (uint64_t) i * MEM_PAGE_SIZE;
+      if (page > last && page <= end && mem_cache_request (cache, page))
+	{
+	  pages[nr++] = page;
+	}
+      page = first - (uint64_t) i * MEM_PAGE_SIZE;
+      if (nr < size && page < first && page >= start
+	  && mem_cache_request (cache, page))
+	{
+	  pages[nr++] = page;
+	}
+    }
+
+  return nr;
+}
+
+/**
+ * @brief Let the user find a source file.
+ *
+ * Show a search form with the source files of the program and show the
+ * selected file in the Main window.
+ *
+ * @param parser The parser.
+ *
+ * @return 0 if the form was shown, -1 if the source files must be requested
+ * first.
+ */
+int
+mi2_parser_find_file (mi2_parser * parser)
+{
+  const char *file;
+  int ret;
+
+  assert (parser);
+
+  if (!parser->files_loaded)
+    {
+      return -1;
+    }
+  if (parser->files->nr_names == 0)
+    {
+      VLOG_INFO (parser->view, _("No source files"));
+      return 0;
+    }
+
+  ret = form_search (_("Select a file"), mi2_parser_match_file,
+		     mi2_parser_get_file, parser->files);
+  if (ret == -2)
+    {
+      VLOG_ERR (parser->view, _("Could not retrieve file"));
+    }
+  else if (ret >= 0)
+    {
+      file = file_index_get_match (parser->files, ret);
+      if (file != NULL)
+	{
+	  view_show_file (parser->view, file, 0, 1);
+	}
+    }
+
+  return 0;
+}
+
+/**
+ * @brief Let the user go to a function.
+ *
+ * Show a search form with the functions of the program and show the source
+ * of the selected function in the Main window.
+ *
+ * @param parser The parser.
+ *
+ * @return 0 if the form was shown, -1 if the functions must be requested
+ * first.
+ */
+int
+mi2_parser_find_symbol (mi2_parser * parser)
+{
+  const char *file;
+  int line;
+  int ret;
+
+  assert (parser);
+
+  if (!parser->symbols_loaded)
+    {
+      return -1;
+    }
+  if (parser->symbols->nr_symbols == 0)
+    {
+      VLOG_INFO (parser->view, _("No functions"));
+      return 0;
+    }
+
+  ret = form_search (_("Go to function"), mi2_parser_match_symbol,
+		     mi2_parser_get_symbol, parser);
+  if (ret == -2)
+    {
+      VLOG_ERR (parser->view, _("Could not retrieve function"));
+    }
+  else if (ret >= 0
+	   && symbol_index_get_match (parser->symbols, ret, &file,
+				      &line) != NULL)
+    {
+      view_show_file (parser->view, file, line, 0);
+    }
+
+  return 0;
+}
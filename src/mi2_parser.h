@@ -29,6 +29,21 @@
 #include "view.h"
 #include "configuration.h"
 
+/*******************************************************************************
+ * Defines
+ ******************************************************************************/
+/**
+ * @name Variable actions.
+ *
+ * What the mi2 interface has to send for a variable object.
+ */
+/*@{*/
+#define VAR_ACTION_NONE     0 /**< Nothing to send. */
+#define VAR_ACTION_CREATE   1 /**< Create the object. */
+#define VAR_ACTION_CHILDREN 2 /**< List the children of the object. */
+#define VAR_ACTION_DELETE   3 /**< Delete the object. */
+/*@}*/
+
 /*******************************************************************************
  * Typedefs
  ******************************************************************************/
@@ -42,7 +57,14 @@ void mi2_parser_free (mi2_parser * parser);
 
 int mi2_parser_parse (mi2_parser * parser, char *line, int *update,
 		      char **regs);
+int mi2_parser_feed (mi2_parser * parser, const char *buf, int len);
+void mi2_parser_flush (mi2_parser * parser);
 void mi2_parser_set_frame (mi2_parser * parser, int frame);
+int mi2_parser_var_toggle (mi2_parser * parser, int id,
+			   const char **var_name);
+int mi2_parser_next_var_request (mi2_parser * parser, int *thread_id,
+				 int *frame, char **var_name, char **exp);
+int mi2_parser_get_stack_depth (mi2_parser * parser, int *total);
 int mi2_parser_set_thread (mi2_parser * parser, int id);
 int mi2_parser_get_thread (mi2_parser * parser);
 
@@ -51,4 +73,11 @@ breakpoint *mi2_parser_get_bp (mi2_parser * parser, const char *file_name,
 void mi2_parser_remove_bp (mi2_parser * parser, int number);
 int mi2_parser_get_location (mi2_parser * parser, char **file, int *line);
 void mi2_parser_toggle_disassemble (mi2_parser * parser);
+int mi2_parser_disassembly_request (mi2_parser * parser);
+void mi2_parser_memory_locate (mi2_parser * parser, uint64_t length);
+int mi2_parser_memory_refresh (mi2_parser * parser);
+int mi2_parser_memory_pages (mi2_parser * parser, uint64_t address,
+			     uint64_t length, uint64_t * pages, int size);
+int mi2_parser_find_file (mi2_parser * parser);
+int mi2_parser_find_symbol (mi2_parser * parser);
 #endif
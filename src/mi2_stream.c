@@ -0,0 +1,547 @@
+/* A simple front end debugger.
+   Copyright (C) 2012 Kenneth Olsson
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file mi2_stream.c
+ *
+ * @brief The implementation of the streaming mi2 record parser.
+ *
+ * A record has the form:
+ *
+ * @code
+ * ^done,name="value",name={name="value",...},name=[{...},...]\n
+ * @endcode
+ *
+ * The bytes are parsed one by one, the parser only keeps the open tuples and
+ * lists, the current name and the current string. Only the first result of a
+ * record is looked up among the registered handlers. If there is no handler,
+ * the rest of the record is skipped. Otherwise the events of the result are
+ * reported to the handler and the rest of the record is skipped.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <assert.h>
+
+#include "mi2_stream.h"
+#include "misc.h"
+#include "debug.h"
+
+#define STREAM_NAME_LEN 64   /**< Max length of a record class or a name. */
+#define STREAM_DEPTH 32	     /**< Max number of open tuples and lists. */
+#define STREAM_VALUE_START 256 /**< Start size of the string buffer. */
+
+/*******************************************************************************
+ * Internal structures and enums
+ ******************************************************************************/
+/** The states of the parser. */
+enum stream_state
+{
+  STREAM_RECORD,	/**< In the record class, e.g. ^done. */
+  STREAM_RESULT,	/**< Between results and values. */
+  STREAM_NAME,		/**< In the name of a result. */
+  STREAM_VALUE,		/**< After the '=' of a result. */
+  STREAM_STRING,	/**< In a string. */
+  STREAM_SKIP		/**< Skipping to the end of the record. */
+};
+
+/** A registered handler. */
+typedef struct stream_handler_t
+{
+  char *record;			    /**< The record class, e.g. ^done. */
+  char *name;			    /**< The name of the result. */
+  const mi2_stream_handler *handler; /**< The events. */
+  void *data;			    /**< Given to the events. */
+
+  struct stream_handler_t *next; /**< Next handler. */
+} stream_handler;
+
+/** The streaming parser. */
+struct mi2_stream_t
+{
+  stream_handler *handlers; /**< The registered handlers. */
+
+  enum stream_state state;	  /**< Where in the record the parser is. */
+  char record[STREAM_NAME_LEN]; /**< The class of the current record. */
+  char name[STREAM_NAME_LEN];	  /**< The current name. */
+  int len;			  /**< Length of @a record or @a name. */
+  char types[STREAM_DEPTH];	  /**< The open tuples and lists. */
+  int depth;			  /**< Number of open tuples and lists. */
+  char quote;			  /**< The quote of the current string. */
+  int escaped;			  /**< 1 if the last character was '\\'. */
+  char *value;			  /**< The current string. */
+  int value_len;		  /**< Length of @a value. */
+  int value_size;		  /**< Size of @a value. */
+
+  int decided;			  /**< 1 when the first result is looked up. */
+  stream_handler *current;	  /**< The handler of the record or NULL. */
+  int complete;			  /**< 1 when the handled result has ended. */
+  int error;			  /**< 1 if the handled result was broken. */
+};
+
+/*******************************************************************************
+ * Internal functions
+ ******************************************************************************/
+static void mi2_stream_error (mi2_stream * stream, char c);
+static void mi2_stream_end_record (mi2_stream * stream);
+static int mi2_stream_lookup (mi2_stream * stream, const char *name);
+static void mi2_stream_open (mi2_stream * stream, char type);
+static void mi2_stream_close (mi2_stream * stream, char type);
+static void mi2_stream_string (mi2_stream * stream);
+
+/**
+ * @brief Stop parsing the record.
+ *
+ * @param stream The parser.
+ * @param c The unexpected character.
+ */
+static void
+mi2_stream_error (mi2_stream * stream, char c)
+{
+  if (stream->current != NULL && !stream->complete)
+    {
+      LOG_ERR ("Unexpected '%c' in %s,%s", isprint (c) ? c : '.',
+	       stream->record, stream->current->name);
+      stream->error = 1;
+    }
+  stream->state = STREAM_SKIP;
+}
+
+/**
+ * @brief End the current record.
+ *
+ * Tell the handler that the record has ended and reset the parser.
+ *
+ * @param stream The parser.
+ */
+static void
+mi2_stream_end_record (mi2_stream * stream)
+{
+  if (stream->current != NULL)
+    {
+      if (!stream->complete && !stream->error)
+	{
+	  LOG_ERR ("Incomplete %s,%s", stream->record, stream->current->name);
+	  stream->error = 1;
+	}
+      stream->current->handler->done (stream->current->data, stream->error);
+    }
+  stream->state = STREAM_RECORD;
+  stream->len = 0;
+  stream->depth = 0;
+  stream->decided = 0;
+  stream->current = NULL;
+  stream->complete = 0;
+  stream->error = 0;
+}
+
+/**
+ * @brief Look up the handler of the first result.
+ *
+ * @param stream The parser.
+ * @param name The name of the result, NULL if the record does not start with
+ *             a result.
+ *
+ * @return 1 if the result is handled, otherwise 0 and the rest of the record
+ *         is skipped.
+ */
+static int
+mi2_stream_lookup (mi2_stream * stream, const char *name)
+{
+  stream_handler *h;
+
+  stream->decided = 1;
+  for (h = stream->handlers; name != NULL && h != NULL; h = h->next)
+    {
+      if (strcmp (h->record, stream->record) == 0
+	  && strcmp (h->name, name) == 0)
+	{
+	  DINFO (3, "Streaming %s,%s", h->record, h->name);
+	  stream->current = h;
+	  return 1;
+	}
+    }
+  stream->state = STREAM_SKIP;
+  return 0;
+}
+
+/**
+ * @brief A tuple or list starts.
+ *
+ * @param stream The parser.
+ * @param type '{' or '['.
+ */
+static void
+mi2_stream_open (mi2_stream * stream, char type)
+{
+  const char *name = stream->len > 0 ? stream->name : NULL;
+  int ret;
+
+  if (!stream->decided && !mi2_stream_lookup (stream, name))
+    {
+      return;
+    }
+  if (stream->depth == STREAM_DEPTH)
+    {
+      LOG_ERR ("Nested too deep in %s", stream->record);
+      mi2_stream_error (stream, type);
+      return;
+    }
+  stream->types[stream->depth++] = type;
+  stream->state = STREAM_RESULT;
+  stream->len = 0;
+
+  ret = stream->current->handler->start (stream->current->data, name, type);
+  if (ret < 0)
+    {
+      stream->error = 1;
+      stream->state = STREAM_SKIP;
+    }
+}
+
+/**
+ * @brief The last started tuple or list ends.
+ *
+ * @param stream The parser.
+ * @param type '}' or ']'.
+ */
+static void
+mi2_stream_close (mi2_stream * stream, char type)
+{
+  char open = type == '}' ? '{' : '[';
+  int ret;
+
+  if (stream->depth == 0 || stream->types[stream->depth - 1] != open)
+    {
+      mi2_stream_error (stream, type);
+      return;
+    }
+  stream->depth--;
+
+  ret = stream->current->handler->end (stream->current->data, open);
+  if (ret < 0)
+    {
+      stream->error = 1;
+      stream->state = STREAM_SKIP;
+    }
+  else if (stream->depth == 0)
+    {
+      stream->complete = 1;
+      stream->state = STREAM_SKIP;
+    }
+}
+
+/**
+ * @brief A string has ended.
+ *
+ * @param stream The parser.
+ */
+static void
+mi2_stream_string (mi2_stream * stream)
+{
+  const char *name = stream->len > 0 ? stream->name : NULL;
+  int ret;
+
+  stream->value[stream->value_len] = '\0';
+  stream->state = STREAM_RESULT;
+  stream->len = 0;
+  if (!stream->decided && !mi2_stream_lookup (stream, name))
+    {
+      return;
+    }
+  if (unescape (stream->value, NULL) < 0)
+    {
+      mi2_stream_error (stream, stream->quote);
+      return;
+    }
+
+  ret = stream->current->handler->value (stream->current->data, name,
+					 stream->value);
+  if (ret < 0)
+    {
+      stream->error = 1;
+      stream->state = STREAM_SKIP;
+    }
+  else if (stream->depth == 0)
+    {
+      stream->complete = 1;
+      stream->state = STREAM_SKIP;
+    }
+}
+
+/*******************************************************************************
+ * Public functions
+ ******************************************************************************/
+
+/**
+ * @brief Create a streaming parser.
+ *
+ * @return The parser.
+ */
+mi2_stream *
+mi2_stream_create (void)
+{
+  mi2_stream *stream;
+
+  stream = (mi2_stream *) calloc (1, sizeof (*stream));
+  LOG_ERR_IF_FATAL (stream == NULL, ERR_MSG_CREATE ("mi2 stream"));
+
+  stream->value_size = STREAM_VALUE_START;
+  stream->value = (char *) malloc (stream->value_size);
+  LOG_ERR_IF_FATAL (stream->value == NULL, ERR_MSG_CREATE ("mi2 stream"));
+  stream->state = STREAM_RECORD;
+
+  return stream;
+}
+
+/**
+ * @brief Free a streaming parser.
+ *
+ * @param stream The parser.
+ */
+void
+mi2_stream_free (mi2_stream * stream)
+{
+  stream_handler *h;
+
+  if (stream == NULL)
+    {
+      return;
+    }
+  while (stream->handlers != NULL)
+    {
+      h = stream->handlers;
+      stream->handlers = h->next;
+      free (h->record);
+      free (h->name);
+      free (h);
+    }
+  free (stream->value);
+  free (stream);
+}
+
+/**
+ * @brief Register a handler of a result.
+ *
+ * The handler gets the events of the result @a name when it is the first
+ * result of a @a record record, e.g. the files of ^done,files=[...].
+ *
+ * @param stream The parser.
+ * @param record The record class, e.g. "^done".
+ * @param name The name of the result.
+ * @param handler The events. Must be kept while the parser is used.
+ * @param data Given to the events.
+ *
+ * @return 0 on success, -1 if the names are too long.
+ */
+int
+mi2_stream_register (mi2_stream * stream, const char *record,
+		     const char *name, const mi2_stream_handler * handler,
+		     void *data)
+{
+  stream_handler *h;
+
+  assert (stream);
+  assert (record);
+  assert (name);
+  assert (handler);
+
+  LOG_ERR_IF_RETURN (strlen (record) >= STREAM_NAME_LEN
+		     || strlen (name) >= STREAM_NAME_LEN, -1,
+		     "Too long name %s,%s", record, name);
+
+  h = (stream_handler *) malloc (sizeof (*h));
+  LOG_ERR_IF_FATAL (h == NULL, ERR_MSG_CREATE ("stream handler"));
+  h->record = strdup (record);
+  h->name = strdup (name);
+  LOG_ERR_IF_FATAL (h->record == NULL || h->name == NULL,
+		    ERR_MSG_CREATE ("stream handler"));
+  h->handler = handler;
+  h->data = data;
+  h->next = stream->handlers;
+  stream->handlers = h;
+
+  return 0;
+}
+
+/**
+ * @brief Feed the parser.
+ *
+ * Parse the bytes from the debugger. A record ends with '\\n', the bytes of
+ * a record may be fed in any number of calls.
+ *
+ * @param stream The parser.
+ * @param buf The bytes.
+ * @param len The number of bytes.
+ *
+ * @return 1 if the record of the last byte has a registered handler,
+ *         otherwise 0.
+ */
+int
+mi2_stream_feed (mi2_stream * stream, const char *buf, int len)
+{
+  const char *p;
+  int handled;
+  int i;
+  char c;
+
+  assert (stream);
+  assert (buf);
+
+  handled = stream->current != NULL;
+  for (i = 0; i < len; i++)
+    {
+      if (stream->state == STREAM_SKIP)
+	{
+	  p = (const char *) memchr (buf + i, '\n', len - i);
+	  if (p == NULL)
+	    {
+	      break;
+	    }
+	  i = p - buf;
+	}
+
+      c = buf[i];
+      if (c == '\n')
+	{
+	  handled = stream->current != NULL;
+	  mi2_stream_end_record (stream);
+	  continue;
+	}
+      if (c == '\r' && stream->state != STREAM_STRING)
+	{
+	  continue;
+	}
+
+      switch (stream->state)
+	{
+	case STREAM_RECORD:
+	  if (c == ',')
+	    {
+	      stream->record[stream->len] = '\0';
+	      stream->len = 0;
+	      stream->state = STREAM_RESULT;
+	    }
+	  else if (stream->len < STREAM_NAME_LEN - 1)
+	    {
+	      stream->record[stream->len++] = c;
+	    }
+	  else
+	    {
+	      stream->state = STREAM_SKIP;
+	    }
+	  break;
+	case STREAM_RESULT:
+	  if (c == ' ' || c == ',')
+	    {
+	      break;
+	    }
+	  if (c == '{' || c == '[')
+	    {
+	      mi2_stream_open (stream, c);
+	    }
+	  else if (!stream->decided)
+	    {
+	      if (isalpha (c) || c == '_')
+		{
+		  stream->name[stream->len++] = c;
+		  stream->state = STREAM_NAME;
+		}
+	      else
+		{
+		  mi2_stream_lookup (stream, NULL);
+		}
+	    }
+	  else if (c == '}' || c == ']')
+	    {
+	      mi2_stream_close (stream, c);
+	    }
+	  else if (c == '"' || c == '\'')
+	    {
+	      stream->quote = c;
+	      stream->escaped = 0;
+	      stream->value_len = 0;
+	      stream->state = STREAM_STRING;
+	    }
+	  else if (isalpha (c) || c == '_')
+	    {
+	      stream->name[stream->len++] = c;
+	      stream->state = STREAM_NAME;
+	    }
+	  else
+	    {
+	      mi2_stream_error (stream, c);
+	    }
+	  break;
+	case STREAM_NAME:
+	  if (c == '=')
+	    {
+	      stream->name[stream->len] = '\0';
+	      stream->state = STREAM_VALUE;
+	    }
+	  else if ((isalnum (c) || c == '_' || c == '-')
+		   && stream->len < STREAM_NAME_LEN - 1)
+	    {
+	      stream->name[stream->len++] = c;
+	    }
+	  else
+	    {
+	      mi2_stream_error (stream, c);
+	    }
+	  break;
+	case STREAM_VALUE:
+	  if (c == '{' || c == '[')
+	    {
+	      mi2_stream_open (stream, c);
+	    }
+	  else if (c == '"' || c == '\'')
+	    {
+	      stream->quote = c;
+	      stream->escaped = 0;
+	      stream->value_len = 0;
+	      stream->state = STREAM_STRING;
+	    }
+	  else if (c != ' ')
+	    {
+	      mi2_stream_error (stream, c);
+	    }
+	  break;
+	case STREAM_STRING:
+	  if (c == stream->quote && !stream->escaped)
+	    {
+	      mi2_stream_string (stream);
+	      break;
+	    }
+	  stream->escaped = c == '\\' && !stream->escaped;
+	  if (stream->value_len + 1 >= stream->value_size)
+	    {
+	      stream->value_size *= 2;
+	      stream->value = (char *) realloc (stream->value,
+						stream->value_size);
+	      LOG_ERR_IF_FATAL (stream->value == NULL,
+				ERR_MSG_CREATE ("mi2 stream"));
+	    }
+	  stream->value[stream->value_len++] = c;
+	  break;
+	case STREAM_SKIP:
+	  break;
+	}
+      handled = stream->current != NULL;
+    }
+
+  return handled;
+}
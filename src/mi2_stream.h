@@ -0,0 +1,62 @@
+/* A simple front end debugger.
+   Copyright (C) 2012 Kenneth Olsson
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file mi2_stream.h
+ *
+ * @brief Interface for the streaming mi2 record parser.
+ *
+ * The records are parsed as the bytes arrive. The results that have a
+ * registered handler are reported as events, so a record never has to be
+ * kept in memory as a whole.
+ */
+#ifndef MI2_STREAM_H
+#define MI2_STREAM_H
+
+/*******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+typedef struct mi2_stream_t mi2_stream;
+
+/**
+ * @brief The events of a result.
+ *
+ * The strings are only valid during the call. A handler returning -1 stops
+ * the events of the record, done is then called with @a error set.
+ */
+typedef struct mi2_stream_handler_t
+{
+  /** A tuple, @a type '{', or a list, @a type '[', starts. */
+  int (*start) (void *data, const char *name, int type);
+  /** The last started tuple or list ends. */
+  int (*end) (void *data, int type);
+  /** A value. @a name is NULL for the values of a list. */
+  int (*value) (void *data, const char *name, const char *value);
+  /** The record ends. @a error is 1 if the result was not complete. */
+  void (*done) (void *data, int error);
+} mi2_stream_handler;
+
+/*******************************************************************************
+ * Public functions
+ ******************************************************************************/
+mi2_stream *mi2_stream_create (void);
+void mi2_stream_free (mi2_stream * stream);
+int mi2_stream_register (mi2_stream * stream, const char *record,
+			 const char *name, const mi2_stream_handler * handler,
+			 void *data);
+int mi2_stream_feed (mi2_stream * stream, const char *buf, int len);
+#endif
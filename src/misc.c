@@ -38,6 +38,7 @@
 #include "debug.h"
 
 #define ESCAPE_CHAR '\\'		   /**< The escape character. */
+#define UNESCAPE_STOP_LEN 32		   /**< Max length of the stop set. */
 #define C_ESCAPES_CHARS "ntvbrfa\\?'\""	   /**< Valid escape chars in a
                                             *   c-string.
                                             */
@@ -71,10 +72,33 @@ unescape (char *text, const char *skip)
   char *w;
   char *p;
   char nr[4];
+  char stop[UNESCAPE_STOP_LEN];
+  char stop_quote[UNESCAPE_STOP_LEN];
+  size_t n;
   int in_quote = 0;
   int in_dquote = 0;
 
   DINFO (7, "unescpe '%s'", text);
+
+  /*
+   * The characters that may change the output, the runs between them are
+   * copied as they are. If the skip set is too long every character is
+   * checked.
+   */
+  n = skip != NULL ? strlen (skip) : 0;
+  if (n < UNESCAPE_STOP_LEN - 4)
+    {
+      memcpy (stop, "\\'\"", 3);
+      memcpy (stop + 3, skip != NULL ? skip : "", n + 1);
+      stop_quote[0] = '\'';
+      memcpy (stop_quote + 1, skip != NULL ? skip : "", n + 1);
+    }
+  else
+    {
+      stop[0] = '\0';
+      stop_quote[0] = '\0';
+    }
+
   p = &(text[strlen (text) - 1]);
   while (p > text && isspace (*p))
     {
@@ -93,6 +117,14 @@ unescape (char *text, const char *skip)
 
   while (*r)
     {
+      n = stop[0] == '\0' ? 0 : strcspn (r, in_quote ? stop_quote : stop);
+      if (n > 0)
+	{
+	  memmove (w, r, n);
+	  w += n;
+	  r += n;
+	  continue;
+	}
       if (*r == ESCAPE_CHAR && in_quote == 0 && in_dquote == 0)
 	{
 	  if ((p = strchr (C_ESCAPES_CHARS, *(r + 1))) != NULL)
@@ -28,6 +28,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <ctype.h>
 
 #include "objects.h"
 #include "debug.h"
@@ -39,6 +40,29 @@
 
 #define FRAME_INCREASE 10
 
+#define ASM_CACHE_SIZE 32 /**< Max number of cached functions. */
+
+#define MEM_CACHE_PAGES 2048 /**< Max number of cached pages, 8 MiB. */
+
+#define FILE_BLOCK_SIZE 65536 /**< Size of a block of interned file names. */
+#define FILE_INDEX_START 64   /**< Initial number of names in a file index. */
+
+#define SYMBOL_INDEX_START 1024 /**< Initial number of symbols in an index. */
+#define SYMBOL_TRIGRAM_BITS 16	/**< Number of bits of a trigram bucket. */
+#define SYMBOL_TRIGRAMS (1 << SYMBOL_TRIGRAM_BITS) /**< Number of buckets. */
+
+#define RECORD_LOG_START 1024 /**< Initial number of records in a log. */
+
+#define LIBRARY_START 16 /**< Initial number of slots in a library table. */
+/** Marks a slot where a library has been removed. */
+#define LIBRARY_TOMBSTONE (&library_tombstone)
+
+/*******************************************************************************
+ * Static variables
+ ******************************************************************************/
+static library library_tombstone; /**< Tombstone for removed libraries. */
+static int variable_last_id = 0;  /**< The last id given to a variable. */
+
 /*******************************************************************************
  * Public functions
  ******************************************************************************/
@@ -642,15 +666,162 @@ thread_clear (thread * pt)
  * @name Library functions.
  *
  * Libray helper functions. Functions for handle which library that are loaded.
+ * The libraries are kept in a table hashed on the id. An unloaded library
+ * leaves a tombstone in its slot, the tombstones are dropped the next time
+ * the table is rebuilt.
  */
 /*@{*/
+/**
+ * @brief Hash a string.
+ *
+ * Used for library ids and file names.
+ *
+ * @param id The string.
+ *
+ * @return The hash value.
+ */
+static unsigned int
+string_hash (const char *id)
+{
+  unsigned int hash = 5381;
+
+  while (*id != '\0')
+    {
+      hash = (hash * 33) ^ (unsigned char) *id;
+      id++;
+    }
+
+  return hash;
+}
+
+/**
+ * @brief Check if a library matches.
+ *
+ * @param lp The library.
+ * @param id The id of the library.
+ * @param target The target name, NULL matches an empty name.
+ * @param host The host name, NULL matches an empty name.
+ *
+ * @return 1 if the library matches, otherwise 0.
+ */
+static int
+library_match (library * lp, const char *id, const char *target,
+	       const char *host)
+{
+  return (strcmp (lp->id, id) == 0
+	  && ((target == NULL && *(lp->target_name) == '\0')
+	      || (target != NULL && strcmp (lp->target_name, target) == 0))
+	  && ((host == NULL && *(lp->host_name) == '\0')
+	      || (host != NULL && strcmp (lp->host_name, host) == 0)));
+}
+
+/**
+ * @brief Rebuild the library table.
+ *
+ * Rehash all libraries into a new set of slots. Tombstones are dropped.
+ *
+ * @param lt The library table.
+ * @param size The new number of slots, must be a power of 2.
+ */
+static void
+library_table_rebuild (library_table * lt, int size)
+{
+  library **slots;
+  library *lp;
+  unsigned int i;
+
+  slots = (library **) calloc (size, sizeof (*slots));
+  LOG_ERR_IF_FATAL (slots == NULL, ERR_MSG_CREATE ("library slots"));
+
+  for (lp = lt->first; lp != NULL; lp = lp->next)
+    {
+      i = string_hash (lp->id) & (size - 1);
+      while (slots[i] != NULL)
+	{
+	  i = (i + 1) & (size - 1);
+	}
+      slots[i] = lp;
+    }
+
+  free (lt->slots);
+  lt->slots = slots;
+  lt->size = size;
+  lt->tombstones = 0;
+
+  DINFO (5, "Library table rebuilt with %d slots", size);
+}
+
+/**
+ * @brief Free a library.
+ *
+ * @param lp The library to free.
+ */
+static void
+library_free (library * lp)
+{
+  if (lp->host_name != NULL)
+    {
+      free (lp->host_name);
+    }
+  if (lp->target_name != NULL)
+    {
+      free (lp->target_name);
+    }
+  if (lp->id != NULL)
+    {
+      free (lp->id);
+    }
+  free (lp);
+}
+
+/**
+ * @brief Create a library table.
+ *
+ * Create an empty library table.
+ *
+ * @return The new library table.
+ */
+library_table *
+library_table_create (void)
+{
+  library_table *lt;
+
+  lt = (library_table *) malloc (sizeof (*lt));
+  LOG_ERR_IF_FATAL (lt == NULL, ERR_MSG_CREATE ("library table"));
+
+  lt->slots = (library **) calloc (LIBRARY_START, sizeof (*lt->slots));
+  LOG_ERR_IF_FATAL (lt->slots == NULL, ERR_MSG_CREATE ("library slots"));
+  lt->size = LIBRARY_START;
+  lt->count = 0;
+  lt->tombstones = 0;
+  lt->first = NULL;
+
+  return lt;
+}
+
+/**
+ * @brief Free a library table.
+ *
+ * Free the table and all libraries in it.
+ *
+ * @param lt The library table.
+ */
+void
+library_table_free (library_table * lt)
+{
+  assert (lt);
+
+  library_remove_all (lt);
+  free (lt->slots);
+  free (lt);
+}
+
 /**
  * @brief Add a library.
  *
- * Add a loaded library.
+ * Add a loaded library. The library is put first in the list of libraries.
  *
- * @param head A pointer to the first library, or NULL if no libraries are
- *             loaded.
+ * @param lt The library table.
  * @param id Id of the libraryi. Must not be NULL or an empty string.
  * @param target The target name of the library.
  * @param host The host name of the target.
@@ -659,32 +830,57 @@ thread_clear (thread * pt)
  * @return 0 if successful otherwise -1;
  */
 int
-library_add (library ** head, const char *id, const char *target,
+library_add (library_table * lt, const char *id, const char *target,
 	     const char *host, int loaded)
 {
   library *lp;
+  unsigned int i;
 
-  assert (head);
+  assert (lt);
 
   LOG_ERR_IF_RETURN (id == NULL || strlen (id) == 0, -1, "No id.");
   LOG_ERR_IF_RETURN (loaded != 0 && loaded != 1, -1,
 		     "Loaded neither 0 or 1 but %d", loaded);
 
+  /* Keep the load factor, tombstones included, below 3/4. */
+  if ((lt->count + lt->tombstones + 1) * 4 > lt->size * 3)
+    {
+      library_table_rebuild (lt, (lt->count + 1) * 2 > lt->size ?
+			     lt->size * 2 : lt->size);
+    }
+
   lp = (library *) malloc (sizeof (*lp));
   LOG_ERR_IF_FATAL (lp == NULL, ERR_MSG_CREATE ("library"));
 
   lp->id = strdup (id);
-  LOG_ERR_IF_FATAL (lp == NULL, ERR_MSG_CREATE ("String"));
+  LOG_ERR_IF_FATAL (lp->id == NULL, ERR_MSG_CREATE ("String"));
 
   lp->host_name = strdup (host == NULL ? "" : host);
-  LOG_ERR_IF_FATAL (lp == NULL, ERR_MSG_CREATE ("String"));
+  LOG_ERR_IF_FATAL (lp->host_name == NULL, ERR_MSG_CREATE ("String"));
 
   lp->target_name = strdup (target == NULL ? "" : target);
-  LOG_ERR_IF_FATAL (lp == NULL, ERR_MSG_CREATE ("String"));
+  LOG_ERR_IF_FATAL (lp->target_name == NULL, ERR_MSG_CREATE ("String"));
 
   lp->symbols_loaded = loaded;
-  lp->next = *head;
-  *head = lp;
+  lp->prev = NULL;
+  lp->next = lt->first;
+  if (lt->first != NULL)
+    {
+      lt->first->prev = lp;
+    }
+  lt->first = lp;
+
+  i = string_hash (id) & (lt->size - 1);
+  while (lt->slots[i] != NULL && lt->slots[i] != LIBRARY_TOMBSTONE)
+    {
+      i = (i + 1) & (lt->size - 1);
+    }
+  if (lt->slots[i] == LIBRARY_TOMBSTONE)
+    {
+      lt->tombstones--;
+    }
+  lt->slots[i] = lp;
+  lt->count++;
 
   DINFO (3, "library loaded (%d) '%s'", loaded, id);
 
@@ -694,36 +890,33 @@ library_add (library ** head, const char *id, const char *target,
 /**
  * @brief Removes a library.
  *
- * Removes a library.
+ * Removes a library. The slot of the library is marked with a tombstone.
  *
- * @param head The first library.
+ * @param lt The library table.
  * @param id The id of the library to be unloaded.
  * @param target The target name of the library to be unloaded.
  * @param host The host name of the library to be unloaded.
  */
 void
-library_remove (library ** head, const char *id, const char *target,
+library_remove (library_table * lt, const char *id, const char *target,
 		const char *host)
 {
-  library *p;
-  library *prev = NULL;
+  library *p = NULL;
+  unsigned int i;
 
-  assert (head);
+  assert (lt);
   assert (id);
 
-  p = *head;
-  while (p != NULL)
+  i = string_hash (id) & (lt->size - 1);
+  while (lt->slots[i] != NULL)
     {
-      if (strcmp (p->id, id) == 0
-	  && ((target == NULL && *(p->target_name) == '\0')
-	      || (target != NULL && strcmp (p->target_name, target) == 0))
-	  && ((host == NULL && *(p->host_name) == '\0')
-	      || (host != NULL && strcmp (p->host_name, host) == 0)))
+      if (lt->slots[i] != LIBRARY_TOMBSTONE
+	  && library_match (lt->slots[i], id, target, host))
 	{
+	  p = lt->slots[i];
 	  break;
 	}
-      prev = p;
-      p = p->next;
+      i = (i + 1) & (lt->size - 1);
     }
   if (p == NULL)
     {
@@ -733,28 +926,24 @@ library_remove (library ** head, const char *id, const char *target,
       return;
     }
 
-  if (prev == NULL)
+  lt->slots[i] = LIBRARY_TOMBSTONE;
+  lt->tombstones++;
+  lt->count--;
+
+  if (p->prev == NULL)
     {
-      *head = p->next;
+      lt->first = p->next;
     }
   else
     {
-      prev->next = p->next;
-    }
-  if (p->host_name != NULL)
-    {
-      free (p->host_name);
-    }
-  if (p->target_name != NULL)
-    {
-      free (p->target_name);
+      p->prev->next = p->next;
     }
-  if (p->id != NULL)
+  if (p->next != NULL)
     {
-      free (p->id);
+      p->next->prev = p->prev;
     }
 
-  free (p);
+  library_free (p);
 
   DINFO (3, "library removed '%s'", id);
 }
@@ -762,38 +951,29 @@ library_remove (library ** head, const char *id, const char *target,
 /**
  * @brief Removes all libraries.
  *
- * Removes and free all libraries.
+ * Removes and free all libraries. The table is left empty.
  *
- * @param head The first library to be removed. Head will be set to NULL.
+ * @param lt The library table.
  */
 void
-library_remove_all (library ** head)
+library_remove_all (library_table * lt)
 {
   library *p;
   library *next;
 
-  assert (head);
+  assert (lt);
 
-  p = *head;
+  p = lt->first;
   while (p != NULL)
     {
       next = p->next;
-      if (p->host_name != NULL)
-	{
-	  free (p->host_name);
-	}
-      if (p->target_name != NULL)
-	{
-	  free (p->target_name);
-	}
-      if (p->id != NULL)
-	{
-	  free (p->id);
-	}
-      free (p);
+      library_free (p);
       p = next;
     }
-  *head = NULL;
+  lt->first = NULL;
+  memset (lt->slots, 0, lt->size * sizeof (*lt->slots));
+  lt->count = 0;
+  lt->tombstones = 0;
 
   DINFO (3, "All libraries unloaded");
 }
@@ -837,6 +1017,8 @@ stack_create (int depth)
   new_stack->depth = -1;
   new_stack->max_depth = depth;
   new_stack->thread_id = -1;
+  new_stack->total_depth = -1;
+  new_stack->appended = 0;
   new_stack->stack = (frame *) malloc (depth * sizeof (frame));
   LOG_ERR_IF_FATAL (new_stack == NULL, ERR_MSG_CREATE ("frames"));
 
@@ -847,6 +1029,7 @@ stack_create (int depth)
       new_stack->stack[i].file = NULL;
       new_stack->stack[i].func = NULL;
       new_stack->stack[i].fullname = NULL;
+      new_stack->stack[i].scope = NULL;
       stack_clean_frame (new_stack, i);
     }
 
@@ -888,26 +1071,33 @@ frame *
 stack_get_frame (stack * stack, int level)
 {
   int i;
+  int max_depth;
 
   assert (stack);
 
   if (level >= stack->max_depth)
     {
+      /* Grow at least by the double, deep stacks are fetched page by page. */
+      max_depth = level + FRAME_INCREASE;
+      if (max_depth < stack->max_depth * 2)
+	{
+	  max_depth = stack->max_depth * 2;
+	}
       stack->stack = (frame *) realloc (stack->stack,
-					(level +
-					 FRAME_INCREASE) * sizeof (frame));
+					max_depth * sizeof (frame));
       LOG_ERR_IF_FATAL (stack->stack == NULL, ERR_MSG_CREATE ("frame"));
 
-      for (i = stack->max_depth; i < level + FRAME_INCREASE; i++)
+      for (i = stack->max_depth; i < max_depth; i++)
 	{
 	  stack->stack[i].args = NULL;
 	  stack->stack[i].variables = NULL;
 	  stack->stack[i].file = NULL;
 	  stack->stack[i].func = NULL;
 	  stack->stack[i].fullname = NULL;
+	  stack->stack[i].scope = NULL;
 	  stack_clean_frame (stack, i);
 	}
-      stack->max_depth = level + FRAME_INCREASE;
+      stack->max_depth = max_depth;
 
       DINFO (1, "Increased stack level to %d", stack->max_depth);
     }
@@ -954,10 +1144,15 @@ stack_clean_frame (stack * stack, int level)
   for (level = istart; level < istop; level++)
     {
       DINFO (10, "Clearing level %d", level);
-      variable_delete_list (stack->stack[level].args);
-      variable_delete_list (stack->stack[level].variables);
+      /* Variables of a scope are kept for the next stop. */
+      if (stack->stack[level].scope == NULL)
+	{
+	  variable_delete_list (stack->stack[level].args);
+	  variable_delete_list (stack->stack[level].variables);
+	}
       stack->stack[level].args = NULL;
       stack->stack[level].variables = NULL;
+      stack->stack[level].scope = NULL;
       if (stack->stack[level].file != NULL)
 	{
 	  free (stack->stack[level].file);
@@ -986,7 +1181,8 @@ stack_clean_frame (stack * stack, int level)
  * the @a type matches if both types are non NULL. If the @a type does not
  * match -1 is returned. If the new type is non NULL, but the type in the
  * list are NULL, we will set the new type. The reason is that the debugger
- * does not always send a type.
+ * does not always send a type. Both @a type and @a value are NULL if only the
+ * names of the variables are listed.
  *
  * If @a variable in non 0, the new variable is inserted in the variable list.
  * If the @a variable is 0 the new variable is inserted in the frames args list.
@@ -1011,8 +1207,6 @@ frame_insert_variable (frame * frame, char *name, char *type, char *value,
   assert (frame);
   assert (name);
 
-  LOG_ERR_IF_RETURN (type == NULL
-		     && value == NULL, -1, "Neither type or value");
   if (var)
     {
       pv = frame->variables;
@@ -1082,6 +1276,12 @@ frame_insert_variable (frame * frame, char *name, char *type, char *value,
   /* Create a new variable. */
   new_variable = (variable *) malloc (sizeof (*new_variable));
   LOG_ERR_IF_RETURN (new_variable == NULL, -1, ERR_MSG_CREATE ("variable"));
+  new_variable->id = ++variable_last_id;
+  new_variable->var_name = NULL;
+  new_variable->numchild = -1;
+  new_variable->expanded = 0;
+  new_variable->changed = 0;
+  new_variable->children = NULL;
   new_variable->name = strdup (name);
   LOG_ERR_IF_RETURN (new_variable->name == NULL, -1,
 		     ERR_MSG_CREATE ("string"));
@@ -1149,7 +1349,7 @@ frame_insert_variable (frame * frame, char *name, char *type, char *value,
 /**
  * @brief Delete a list of variables.
  *
- * Delete a list of variables and free the resources.
+ * Delete a list of variables, and their children, and free the resources.
  *
  * @param var_list List of variables.
  */
@@ -1175,521 +1375,2627 @@ variable_delete_list (variable * var_list)
 	{
 	  free (p->value);
 	}
+      if (p->var_name != NULL)
+	{
+	  free (p->var_name);
+	}
+      variable_delete_list (p->children);
       free (p);
       p = next;
     }
 }
 
-/*@}*/
-
-/*******************************************************************************
- * Assembler functions
- ******************************************************************************/
 /**
- * @name Assembler functions.
- *
- * Assembler line helper functions.
+ * @brief Find a variable by its id.
  *
- * Functions for storing source line and assmbler line for the current thread.
- */
-/*@{*/
-/**
- * @brief Create an assembler.
+ * Search the variables, and the fetched children, for the variable with
+ * @a id.
  *
- * Creates an assembler object, which holds the assembler lines of a function.
+ * @param var_list List of variables.
+ * @param id The id of the variable.
  *
- * @return Pointer to the assembler object.
+ * @return The variable, or NULL if not found.
  */
-assembler *
-ass_create (void)
+variable *
+variable_find (variable * var_list, int id)
 {
-  assembler *fat_ass;
+  variable *p;
+  variable *found;
 
-  fat_ass = (assembler *) malloc (sizeof (*fat_ass));
-  LOG_ERR_IF_FATAL (fat_ass == NULL, "Memory");
-  memset (fat_ass, 0, sizeof (*fat_ass));
+  for (p = var_list; p != NULL; p = p->next)
+    {
+      if (p->id == id)
+	{
+	  return p;
+	}
+      found = variable_find (p->children, id);
+      if (found != NULL)
+	{
+	  return found;
+	}
+    }
 
-  return fat_ass;
+  return NULL;
 }
 
 /**
- * @brief Free the assembler.
+ * @brief Find a variable by its variable object.
  *
- * Free the assembler and it's resources.
+ * @param var_list List of variables.
+ * @param var_name The name of the variable object.
  *
- * @param ass The sorry ass to be set free.
+ * @return The variable, or NULL if not found.
  */
-void
-ass_free (assembler * ass)
+variable *
+variable_find_object (variable * var_list, const char *var_name)
 {
-  asm_line *p;
-  asm_line *next;
-  src_line *s;
-  src_line *sn;
-
-  assert (ass);
+  variable *p;
+  variable *found;
 
-  /* Clear src pool. */
-  s = ass->src_pool;
-  while (s)
-    {
-      sn = s->next;
-      free (s);
-      s = sn;
-    }
+  assert (var_name);
 
-  /* Clear asm pool */
-  p = ass->pool;
-  while (p)
+  for (p = var_list; p != NULL; p = p->next)
     {
-      if (p->inst)
+      if (p->var_name != NULL && strcmp (p->var_name, var_name) == 0)
 	{
-	  free (p->inst);
+	  return p;
 	}
-      next = p->next;
-      free (p);
-      p = next;
-    }
-
-  /* Clear all in use src lines */
-  s = ass->lines;
-  while (s)
-    {
-      p = s->lines;
-      while (p)
+      found = variable_find_object (p->children, var_name);
+      if (found != NULL)
 	{
-	  if (p->inst)
-	    {
-	      free (p->inst);
-	    }
-	  next = p->next;
-	  free (p);
-	  p = next;
+	  return found;
 	}
-      sn = s->next;
-      free (s);
-      s = sn;
     }
 
-  /* Clear function & file. */
-  if (ass->function)
-    {
-      free (ass->function);
-    }
-  if (ass->file)
-    {
-      free (ass->file);
-    }
-  free (ass);
+  return NULL;
 }
 
 /**
- * @brief Reset the ass lines.
+ * @brief Find the parent of a variable object.
  *
- * Reset the lines without releasing any resources.
+ * The debugger names the children of a variable object "parent.exp". The
+ * parent is the variable with the longest variable object name that,
+ * followed by a '.', is a prefix of @a var_name.
  *
- * @param ass The sorry ass.
+ * @param var_list List of variables.
+ * @param var_name The name of the child's variable object.
+ *
+ * @return The parent, or NULL if not found.
  */
-void
-ass_reset (assembler * ass)
+variable *
+variable_find_parent (variable * var_list, const char *var_name)
 {
-  asm_line *pal;
-  asm_line *alnext;
-  src_line *psl;
-  src_line *slnext;
+  variable *p;
+  variable *found;
+  variable *best = NULL;
+  int len;
+
+  assert (var_name);
 
-  psl = ass->lines;
-  while (psl)
+  for (p = var_list; p != NULL; p = p->next)
     {
-      pal = psl->lines;
-      while (pal)
+      if (p->var_name == NULL)
 	{
-	  alnext = pal->next;
-	  pal->next = ass->pool;
-	  ass->pool = pal;
-	  pal = alnext;
+	  continue;
+	}
+      len = strlen (p->var_name);
+      if (strncmp (p->var_name, var_name, len) != 0 || var_name[len] != '.')
+	{
+	  continue;
+	}
+      best = p;
+      found = variable_find_parent (p->children, var_name);
+      if (found != NULL)
+	{
+	  best = found;
 	}
-      psl->lines = NULL;
-      slnext = psl->next;
-      psl->next = ass->src_pool;
-      ass->src_pool = psl;
-      psl = slnext;
-    }
-  ass->current_line = NULL;
-  ass->lines = NULL;
-  if (ass->function)
-    {
-      ass->function[0] = '\0';
     }
 
+  return best;
 }
 
 /**
- * @brief Insert a new asm line.
+ * @brief Add a child to a variable.
  *
- * Insert a new asm line in the assembler. If it belongs to a new the function
- * the old lines are removed.
+ * Append a child, fetched from the debugger, to the children of @a parent.
  *
- * @param ass The assembler lines.
- * @param file The name of the source file.
- * @param func The function name.
- * @param line_nr The source file line number.
- * @param address The address of the line.
- * @param offset The offset from function start.
- * @param inst The instruction.
+ * @param parent The parent variable.
+ * @param name The expression of the child.
+ * @param var_name The name of the child's variable object.
+ * @param type The type of the child, may be NULL.
+ * @param value The value of the child, may be NULL.
+ * @param numchild The number of children of the child.
  *
- * @return 0 if the new line is in the old function. 1 if it belongs to a new
- *         function.
+ * @return The new child.
  */
-int
-ass_add_line (assembler * ass, const char *file, const char *func,
-	      int line_nr, int address, int offset, const char *inst)
-{
-  char *t;
-  int ret = 0;
-  asm_line *pal;
-  asm_line *qal;
-  asm_line *preval;
-  src_line *psl;
-  src_line *qsl;
-  src_line *prevsl;
+variable *
+variable_add_child (variable * parent, const char *name,
+		    const char *var_name, const char *type, const char *value,
+		    int numchild)
+{
+  variable *child;
+  variable **pp;
 
-  assert (ass);
-  assert (file);
+  assert (parent);
+  assert (name);
+  assert (var_name);
 
-  if ((ass->function && func && strcmp (func, ass->function) != 0)
-      || (ass->function == NULL && func)
-      || (address - offset != ass->address && address > 0)
-      || (ass->file && strcmp (file, ass->file) != 0))
-    {
-      DINFO (3, "New function %s 0x%0X-> %s 0x%0X", ass->function,
-	     ass->address, func, address);
-      /* Move all lines to pools */
-      psl = ass->lines;
-      while (psl)
-	{
-	  pal = psl->lines;
-	  while (pal)
-	    {
-	      qal = pal->next;
-	      pal->next = ass->pool;
-	      ass->pool = pal;
-	      pal = qal;
-	    }
-	  psl->last = NULL;
-	  psl->lines = NULL;
-	  qsl = psl->next;
-	  psl->next = ass->src_pool;
-	  ass->src_pool = psl;
-	  psl = qsl;
-	}
-      ass->current_line = NULL;
-      ass->lines = NULL;
+  child = (variable *) malloc (sizeof (*child));
+  LOG_ERR_IF_FATAL (child == NULL, ERR_MSG_CREATE ("variable"));
 
-      /* Update file && function. */
-      LPRINT (ass->file, 1, ass->file_size, "%s", file);
-      LOG_ERR_IF_FATAL (ass->file == NULL, ERR_MSG_CREATE ("file"));
-      LPRINT (ass->function, 1, ass->size, "%s", func ? func : "");
-      LOG_ERR_IF_FATAL (ass->function == NULL, ERR_MSG_CREATE ("function"));
-      ass->address = address;
-      ret = 1;
+  child->id = ++variable_last_id;
+  child->name = strdup (name);
+  LOG_ERR_IF_FATAL (child->name == NULL, ERR_MSG_CREATE ("string"));
+  child->var_name = strdup (var_name);
+  LOG_ERR_IF_FATAL (child->var_name == NULL, ERR_MSG_CREATE ("string"));
+  child->type = NULL;
+  if (type != NULL)
+    {
+      child->type = strdup (type);
+      LOG_ERR_IF_FATAL (child->type == NULL, ERR_MSG_CREATE ("string"));
+    }
+  child->value = NULL;
+  if (value != NULL)
+    {
+      child->value = strdup (value);
+      LOG_ERR_IF_FATAL (child->value == NULL, ERR_MSG_CREATE ("string"));
     }
+  child->numchild = numchild;
+  child->expanded = 0;
+  child->changed = 0;
+  child->children = NULL;
+  child->next = NULL;
 
-  /* Check if it belongs to a new source line. */
-  if (ass->current_line && ass->current_line->line_nr == line_nr)
+  pp = &parent->children;
+  while (*pp != NULL)
     {
-      /* same src file line number. */
-      DINFO (5, "Same src line");
-      psl = ass->current_line;
+      pp = &(*pp)->next;
     }
-  else
+  *pp = child;
+
+  return child;
+}
+
+/**
+ * @brief Merge a fresh list of variables into a list.
+ *
+ * The variables in @a list that are also in @a fresh, by name, are kept
+ * together with their variable objects and children, in the order of
+ * @a fresh. A type or value in @a fresh replaces the kept one. The variables
+ * of @a fresh that are new are moved to @a list, and the variables no longer
+ * listed are moved to @a removed.
+ *
+ * Both lists are in the order of the debugger, so a kept variable is found
+ * after the one kept before it, and an unchanged list is merged in one pass.
+ *
+ * @param list The list to update.
+ * @param fresh The variables just listed by the debugger. Consumed.
+ * @param removed The variables that were removed from @a list are prepended
+ *                to this list.
+ */
+void
+variable_merge_list (variable ** list, variable * fresh, variable ** removed)
+{
+  variable *merged = NULL;
+  variable **tail = &merged;
+  variable *dropped = NULL;
+  variable **dropped_tail = &dropped;
+  variable **pp;
+  variable *old;
+  variable *next;
+
+  assert (list);
+  assert (removed);
+
+  for (; fresh != NULL; fresh = next)
     {
-      /* Get a new src line */
-      if (ass->src_pool == NULL)
-	{
-	  psl = (src_line *) malloc (sizeof (*psl));
-	  LOG_ERR_IF_FATAL (psl == NULL, ERR_MSG_CREATE ("src line"));
-	}
-      else
-	{
-	  psl = ass->src_pool;
-	  ass->src_pool = psl->next;
-	  psl->next = NULL;
-	}
-      psl->lines = NULL;
-      psl->next = NULL;
-      psl->line_nr = line_nr;
-      psl->last = NULL;
+      next = fresh->next;
+      fresh->next = NULL;
 
-      /* Insert the src line in order. */
-      if (ass->current_line && ass->current_line->line_nr < psl->line_nr
-	  && ass->current_line->next == NULL)
+      /* The variables kept before are already taken from the list. */
+      pp = list;
+      while (*pp != NULL && strcmp ((*pp)->name, fresh->name) != 0)
 	{
-	  prevsl = ass->current_line;
-	  qsl = ass->current_line->next;
+	  pp = &(*pp)->next;
 	}
-      else
+      old = *pp;
+      if (old == NULL)
 	{
-	  prevsl = NULL;
-	  qsl = ass->lines;
+	  *tail = fresh;
+	  tail = &fresh->next;
+	  continue;
 	}
-      while (qsl && qsl->line_nr < psl->line_nr)
+
+      /* The variables skipped are not listed again. */
+      if (pp != list)
 	{
-	  prevsl = qsl;
-	  qsl = qsl->next;
+	  *dropped_tail = *list;
+	  *pp = NULL;
+	  dropped_tail = pp;
 	}
-      psl->next = qsl;
-      if (prevsl != NULL)
+      *list = old->next;
+      old->next = NULL;
+      if (fresh->type != NULL)
 	{
-	  prevsl->next = psl;
+	  free (old->type);
+	  old->type = fresh->type;
+	  fresh->type = NULL;
 	}
-      else
+      if (fresh->value != NULL)
 	{
-	  ass->lines = psl;
+	  free (old->value);
+	  old->value = fresh->value;
+	  fresh->value = NULL;
 	}
-      ass->current_line = psl;
+      variable_delete_list (fresh);
+      *tail = old;
+      tail = &old->next;
     }
 
-  if (func == NULL)
+  /* What is left was not listed again. */
+  *dropped_tail = *list;
+  if (dropped != NULL)
     {
-      DINFO (3, "Add empt src line %s %d %s", file, line_nr, func);
-      /* No asm lines. */
-      return ret;
+      pp = dropped_tail;
+      while (*pp != NULL)
+	{
+	  pp = &(*pp)->next;
+	}
+      *pp = *removed;
+      *removed = dropped;
     }
+  *list = merged;
+}
 
-  /* Get a new asm line */
-  if (ass->pool != NULL)
-    {
-      pal = ass->pool;
-      ass->pool = pal->next;
-    }
-  else
+/**
+ * @brief Clear the changed flag.
+ *
+ * Clear the changed flag of the variables and their children.
+ *
+ * @param var_list List of variables.
+ */
+void
+variable_clear_changed (variable * var_list)
+{
+  for (; var_list != NULL; var_list = var_list->next)
     {
-      pal = (asm_line *) malloc (sizeof (*pal));
-      pal->inst = 0;
-      pal->size = 0;
+      var_list->changed = 0;
+      variable_clear_changed (var_list->children);
     }
-  pal->address = address;
-  pal->offset = offset;
-  pal->next = NULL;
+}
+
+/**
+ * @brief Get the scope of a frame.
+ *
+ * Find the scope of the frame identified by @a thread_id, @a height and
+ * @a func. A new, empty, scope is created if not found.
+ *
+ * @param scopes The list of scopes.
+ * @param thread_id The thread of the frame.
+ * @param height The number of frames below the frame.
+ * @param func The function of the frame, may be NULL.
+ *
+ * @return The scope. Will never return NULL as it will exit if failing to
+ *         allocate a scope.
+ */
+scope *
+scope_get (scope ** scopes, int thread_id, int height, const char *func)
+{
+  scope *s;
 
-  if (psl->last && pal->address > psl->last->address
-      && psl->last->next == NULL)
+  assert (scopes);
+
+  if (func == NULL)
     {
-      psl->last->next = pal;
+      func = "";
     }
-  else
+  for (s = *scopes; s != NULL; s = s->next)
     {
-      qal = psl->lines;
-      preval = NULL;
-      while (qal && qal->address < pal->address)
-	{
-	  preval = qal;
-	  qal = qal->next;
-	}
-      pal->next = qal;
-
-      if (preval == NULL)
+      if (s->thread_id == thread_id && s->height == height
+	  && strcmp (s->func, func) == 0)
 	{
-	  psl->lines = pal;
-	}
-      else
-	{
-	  preval->next = pal;
+	  return s;
 	}
     }
-  t = pal->inst;
-  if (t == NULL)
-    {
-      pal->inst = strdup (inst ? inst : "");
-      pal->size = strlen (pal->inst) + 1;
-    }
-  else
+
+  s = (scope *) malloc (sizeof (*s));
+  LOG_ERR_IF_FATAL (s == NULL, ERR_MSG_CREATE ("scope"));
+  s->thread_id = thread_id;
+  s->height = height;
+  s->func = strdup (func);
+  LOG_ERR_IF_FATAL (s->func == NULL, ERR_MSG_CREATE ("string"));
+  s->args = NULL;
+  s->variables = NULL;
+  s->next = *scopes;
+  *scopes = s;
+
+  DINFO (3, "New scope %s at height %d in thread %d", func, height,
+	 thread_id);
+
+  return s;
+}
+
+/**
+ * @brief Remove a scope.
+ *
+ * Remove the scope from the list and free it together with its variables.
+ * Frames must not refer to the scope when it is removed.
+ *
+ * @param scopes The list of scopes.
+ * @param s The scope to remove.
+ */
+void
+scope_remove (scope ** scopes, scope * s)
+{
+  scope **pp;
+
+  assert (scopes);
+  assert (s);
+
+  pp = scopes;
+  while (*pp != NULL && *pp != s)
     {
-      LPRINT (pal->inst, 1, pal->size, "%s", inst);
+      pp = &(*pp)->next;
     }
-  LOG_ERR_IF_FATAL (pal->inst == NULL, ERR_MSG_CREATE ("line"));
-  psl->last = pal;
-
-  DINFO (3, "Add src line %s %d %s: 0x%0X %s", file, line_nr, func, address,
-	 inst);
+  LOG_ERR_IF_RETURN (*pp == NULL,, "Scope not found");
+  *pp = s->next;
 
-  return ret;
+  variable_delete_list (s->args);
+  variable_delete_list (s->variables);
+  free (s->func);
+  free (s);
 }
 
 /*@}*/
 
 /*******************************************************************************
- * Register functions
+ * Assembler functions
  ******************************************************************************/
 /**
- * @name Register functions.
+ * @name Assembler functions.
  *
- * Register function.
+ * Assembler line helper functions.
  *
- * Functions for holding information of the registers.
+ * Functions for caching the disassembled functions.
  */
 /*@{*/
 /**
- * @brief Create register object.
+ * @brief Create an assembler.
  *
- * Create a register object to handle all registers.
+ * Creates an assembler object, the cache of the disassembled functions.
  *
- * @return A pointer to the new object.
+ * @return Pointer to the assembler object.
  */
-data_registers *
-data_registers_create (void)
+assembler *
+ass_create (void)
 {
-  data_registers *registers;
+  assembler *fat_ass;
 
-  registers = (data_registers *) malloc (sizeof (*registers));
-  LOG_ERR_IF_FATAL (registers == NULL, ERR_MSG_CREATE ("registers"));
-  memset (registers, 0, sizeof (*registers));
+  fat_ass = (assembler *) malloc (sizeof (*fat_ass));
+  LOG_ERR_IF_FATAL (fat_ass == NULL, "Memory");
+  memset (fat_ass, 0, sizeof (*fat_ass));
 
-  registers->registers = (data_reg *) malloc (128 * sizeof (data_reg));
-  LOG_ERR_IF_FATAL (registers->registers == NULL,
-		    ERR_MSG_CREATE ("registers"));
-  registers->size = 128;
-  registers->len = 0;
+  fat_ass->functions =
+    (asm_function **) malloc (ASM_CACHE_SIZE * sizeof (asm_function *));
+  LOG_ERR_IF_FATAL (fat_ass->functions == NULL, "Memory");
 
-  memset (registers->registers, 0, 128 * sizeof (data_reg));
+  return fat_ass;
+}
 
-  return registers;
+/**
+ * @brief Free the assembler.
+ *
+ * Free the assembler and all cached functions.
+ *
+ * @param ass The sorry ass to be set free.
+ */
+void
+ass_free (assembler * ass)
+{
+  assert (ass);
+
+  ass_reset (ass);
+  free (ass->functions);
+  free (ass);
 }
 
 /**
- * @brief Free register object.
+ * @brief Reset the assembler.
  *
- * Free a register object and it's resources.
+ * Drop all cached functions, e.g. when the addresses are no longer valid.
  *
- * @param registers The registers.
+ * @param ass The sorry ass.
  */
 void
-data_registers_free (data_registers * registers)
+ass_reset (assembler * ass)
 {
   int i;
 
-  for (i = 0; i < registers->size; i++)
+  assert (ass);
+
+  for (i = 0; i < ass->nr_functions; i++)
+    {
+      asm_function_free (ass->functions[i]);
+    }
+  ass->nr_functions = 0;
+}
+
+/**
+ * @brief Find the first cached function which starts after an address.
+ *
+ * @param ass The assembler.
+ * @param address The address.
+ *
+ * @return The index of the function, or the number of functions if none
+ *         starts after @a address.
+ */
+static int
+ass_upper_bound (assembler * ass, uint64_t address)
+{
+  int lo = 0;
+  int hi = ass->nr_functions;
+  int mid;
+
+  while (lo < hi)
     {
-      if (registers->registers[i].reg_name)
+      mid = lo + (hi - lo) / 2;
+      if (ass->functions[mid]->address <= address)
 	{
-	  free (registers->registers[i].reg_name);
+	  lo = mid + 1;
 	}
-      if (registers->registers[i].type == 2 && registers->registers[i].svalue)
+      else
 	{
-	  free (registers->registers[i].svalue);
+	  hi = mid;
 	}
     }
-  free (registers->registers);
 
-  free (registers);
+  return lo;
 }
 
 /**
- * @brief Add a register.
+ * @brief Insert a function in the cache.
  *
- * Add a register to the register object.
+ * Insert a function, finished by @a asm_function_done, in the cache. Cached
+ * functions overlapping the new one are freed. If the cache is full the
+ * least recently used function is freed.
  *
- * @param registers The registers.
- * @param nr The number associated with the new register.
- * @param name The name of the register.
+ * @param ass The assembler.
+ * @param func The function. The assembler takes over the ownership.
+ *
+ * @return The inserted function.
  */
-void
-data_registers_add (data_registers * registers, int nr, const char *name)
+asm_function *
+ass_insert (assembler * ass, asm_function * func)
 {
-  data_reg *t;
+  int i;
+  int j;
+  int lru;
 
-  assert (registers);
+  assert (ass);
+  assert (func);
 
-  if (nr >= registers->size)
+  /* Remove overlapping functions. */
+  i = 0;
+  j = 0;
+  while (i < ass->nr_functions)
     {
-      registers->size += 10;
-      t = (data_reg *) realloc (registers->registers,
-				registers->size * sizeof (data_reg));
-      LOG_ERR_IF_FATAL (t == NULL, ERR_MSG_CREATE ("registers"));
-      memset (&t[registers->size - 10], 0, 10 * sizeof (data_reg));
-      registers->registers = t;
+      if (ass->functions[i]->address <= func->end
+	  && ass->functions[i]->end >= func->address)
+	{
+	  DINFO (3, "Drop cached function %s", ass->functions[i]->function);
+	  asm_function_free (ass->functions[i]);
+	}
+      else
+	{
+	  ass->functions[j] = ass->functions[i];
+	  j++;
+	}
+      i++;
     }
+  ass->nr_functions = j;
 
-  if (registers->registers[nr].reg_name != NULL)
+  if (ass->nr_functions == ASM_CACHE_SIZE)
     {
-      free (registers->registers[nr].reg_name);
+      lru = 0;
+      for (i = 1; i < ass->nr_functions; i++)
+	{
+	  if (ass->functions[i]->last_used < ass->functions[lru]->last_used)
+	    {
+	      lru = i;
+	    }
+	}
+      asm_function_free (ass->functions[lru]);
+      memmove (ass->functions + lru, ass->functions + lru + 1,
+	       (ass->nr_functions - lru - 1) * sizeof (asm_function *));
+      ass->nr_functions--;
     }
-  if (nr + 1 > registers->len)
+
+  i = ass_upper_bound (ass, func->address);
+  memmove (ass->functions + i + 1, ass->functions + i,
+	   (ass->nr_functions - i) * sizeof (asm_function *));
+  ass->functions[i] = func;
+  ass->nr_functions++;
+  func->last_used = ++ass->clock;
+
+  return func;
+}
+
+/**
+ * @brief Find the cached function containing an address.
+ *
+ * @param ass The assembler.
+ * @param pc The address.
+ *
+ * @return The function or NULL if no cached function contains @a pc.
+ */
+asm_function *
+ass_find (assembler * ass, uint64_t pc)
+{
+  int i;
+  asm_function *func;
+
+  assert (ass);
+
+  /* The last function starting at or before pc. */
+  i = ass_upper_bound (ass, pc) - 1;
+  if (i < 0)
     {
-      registers->len = nr + 1;
+      return NULL;
+    }
+  func = ass->functions[i];
+  if (pc > func->end)
+    {
+      return NULL;
     }
+  func->last_used = ++ass->clock;
 
-  registers->registers[nr].reg_name = strdup (name);
-  LOG_ERR_IF_FATAL (registers->registers[nr].reg_name == NULL,
-		    ERR_MSG_CREATE ("register"));
-  registers->registers[nr].type = 2;
-  registers->registers[nr].svalue = NULL;
-  registers->registers[nr].size = 0;
+  return func;
 }
 
 /**
- * @brief Set a value of a register.
+ * @brief Create a function.
  *
- * Set a value of a register.
+ * Create an empty function, to be filled by @a asm_function_add_line.
  *
- * @param registers The register object.
- * @param nr The register number to be set.
- * @param value The value.
+ * @param file The source file of the function.
  *
- * @return 0 upon success. -1 if the register does not exists.
+ * @return The new function.
+ */
+asm_function *
+asm_function_create (const char *file)
+{
+  asm_function *func;
+
+  assert (file);
+
+  func = (asm_function *) malloc (sizeof (*func));
+  LOG_ERR_IF_FATAL (func == NULL, ERR_MSG_CREATE ("function"));
+  memset (func, 0, sizeof (*func));
+  func->file = strdup (file);
+  LOG_ERR_IF_FATAL (func->file == NULL, ERR_MSG_CREATE ("file"));
+  func->address = ASM_NO_ADDRESS;
+  func->end = ASM_NO_ADDRESS;
+
+  return func;
+}
+
+/**
+ * @brief Free a function.
+ *
+ * @param func The function.
+ */
+void
+asm_function_free (asm_function * func)
+{
+  int i;
+
+  if (func == NULL)
+    {
+      return;
+    }
+  for (i = 0; i < func->nr_lines; i++)
+    {
+      free (func->lines[i].inst);
+    }
+  free (func->lines);
+  free (func->src_lines);
+  free (func->function);
+  free (func->file);
+  free (func);
+}
+
+/**
+ * @brief Add a line to a function.
+ *
+ * Add a source line and, if @a name is given, an instruction belonging to
+ * it. The lines may come in any order, they are sorted by
+ * @a asm_function_done.
+ *
+ * @param func The function.
+ * @param name The function name of the instruction, or NULL for a source
+ *             line without instructions.
+ * @param line_nr The source file line number.
+ * @param address The address of the instruction.
+ * @param offset The offset from function start.
+ * @param inst The instruction.
+ *
+ * @return 0 on success.
  */
 int
-data_registers_set_value (data_registers * registers, int nr, uint64_t value)
+asm_function_add_line (asm_function * func, const char *name, int line_nr,
+		       uint64_t address, int offset, const char *inst)
 {
-  assert (registers);
+  asm_line *line;
 
-  LOG_ERR_IF_RETURN (nr < 0 || nr >= registers->size, -1,
-		     "Reg nr %d out out bounds", nr);
+  assert (func);
+
+  if (func->nr_src_lines == 0
+      || func->src_lines[func->nr_src_lines - 1] != line_nr)
+    {
+      if (func->nr_src_lines == func->src_size)
+	{
+	  func->src_size = func->src_size ? func->src_size * 2 : 16;
+	  func->src_lines = (int *) realloc (func->src_lines,
+					     func->src_size * sizeof (int));
+	  LOG_ERR_IF_FATAL (func->src_lines == NULL,
+			    ERR_MSG_CREATE ("src line"));
+	}
+      func->src_lines[func->nr_src_lines++] = line_nr;
+    }
 
-  if (registers->registers[nr].type == 2 && registers->registers[nr].svalue)
+  if (name == NULL)
     {
-      free (registers->registers[nr].svalue);
-      registers->registers[nr].size = 0;
+      DINFO (3, "Add empty src line %s %d", func->file, line_nr);
+      return 0;
+    }
+
+  if (func->function == NULL)
+    {
+      func->function = strdup (name);
+      LOG_ERR_IF_FATAL (func->function == NULL, ERR_MSG_CREATE ("function"));
     }
-  registers->registers[nr].type = 0;
-  registers->registers[nr].u64 = value;
+  if (func->nr_lines == func->size)
+    {
+      func->size = func->size ? func->size * 2 : 32;
+      func->lines = (asm_line *) realloc (func->lines,
+					  func->size * sizeof (asm_line));
+      LOG_ERR_IF_FATAL (func->lines == NULL, ERR_MSG_CREATE ("line"));
+    }
+  line = func->lines + func->nr_lines;
+  line->address = address;
+  line->offset = offset;
+  line->line_nr = line_nr;
+  line->row = -1;
+  line->inst = strdup (inst ? inst : "");
+  LOG_ERR_IF_FATAL (line->inst == NULL, ERR_MSG_CREATE ("line"));
+  func->nr_lines++;
+
+  DINFO (3, "Add src line %s %d %s: 0x%" PRIX64 " %s", func->file, line_nr,
+	 name, address, inst);
 
   return 0;
 }
 
 /**
- * @brief Set a value of a register.
+ * @brief Compare two instructions by address.
+ */
+static int
+asm_line_cmp (const void *a, const void *b)
+{
+  const asm_line *la = (const asm_line *) a;
+  const asm_line *lb = (const asm_line *) b;
+
+  return la->address < lb->address ? -1 : la->address > lb->address;
+}
+
+/**
+ * @brief Compare two source line numbers.
+ */
+static int
+src_line_cmp (const void *a, const void *b)
+{
+  int la = *(const int *) a;
+  int lb = *(const int *) b;
+
+  return la < lb ? -1 : la > lb;
+}
+
+/**
+ * @brief Find the index of a source line.
  *
- * Set a value of a register. The value is a string.
+ * @param func The function.
+ * @param line_nr The source line number.
  *
- * @param registers The register object.
- * @param nr The register number to be set.
- * @param value The value.
+ * @return The index in @a src_lines.
+ */
+static int
+asm_function_src_index (asm_function * func, int line_nr)
+{
+  int *p;
+
+  p = (int *) bsearch (&line_nr, func->src_lines, func->nr_src_lines,
+		       sizeof (int), src_line_cmp);
+  assert (p);
+
+  return p - func->src_lines;
+}
+
+/**
+ * @brief Finish a function.
  *
- * @return 0 upon success. -1 if the register does not exists.
+ * Sort the instructions by address, drop duplicates and calculate the
+ * address range and the window row of every instruction. The window shows
+ * a header row followed by the source lines in order, each followed by its
+ * instructions.
+ *
+ * @param func The function.
  */
-int
-data_registers_set_str_value (data_registers * registers, int nr,
-			      const char *value)
+void
+asm_function_done (asm_function * func)
 {
-  assert (registers);
+  int i;
+  int j;
+  int k;
+  int *rows;
 
-  DINFO (5, "Setting reg %d %s to %s", nr, nr >= 0 && nr < registers->len ?
-	 registers->registers[nr].reg_name : "", value);
-  LOG_ERR_IF_RETURN (nr < 0 || nr >= registers->size, -1,
-		     "Reg nr %d out out bounds", nr);
+  assert (func);
 
-  if (registers->registers[nr].type != 2)
+  if (func->nr_src_lines > 1)
     {
-      registers->registers[nr].svalue = NULL;
-      registers->registers[nr].size = 0;
+      qsort (func->src_lines, func->nr_src_lines, sizeof (int),
+	     src_line_cmp);
+      j = 1;
+      for (i = 1; i < func->nr_src_lines; i++)
+	{
+	  if (func->src_lines[i] != func->src_lines[j - 1])
+	    {
+	      func->src_lines[j++] = func->src_lines[i];
+	    }
+	}
+      func->nr_src_lines = j;
     }
-  registers->registers[nr].type = 2;
-  LPRINT (registers->registers[nr].svalue, 1, registers->registers[nr].size,
-	  "%s", value);
 
-  return 0;
+  if (func->nr_lines == 0)
+    {
+      return;
+    }
+
+  qsort (func->lines, func->nr_lines, sizeof (asm_line), asm_line_cmp);
+  j = 0;
+  for (i = 0; i < func->nr_lines; i++)
+    {
+      if (i + 1 < func->nr_lines
+	  && func->lines[i].address == func->lines[i + 1].address)
+	{
+	  free (func->lines[i].inst);
+	  continue;
+	}
+      func->lines[j++] = func->lines[i];
+    }
+  func->nr_lines = j;
+  func->address = func->lines[0].address;
+  if ((uint64_t) func->lines[0].offset <= func->address)
+    {
+      func->address -= func->lines[0].offset;
+    }
+  func->end = func->lines[func->nr_lines - 1].address;
+
+  /* Count the instructions of each source line ... */
+  rows = (int *) calloc (func->nr_src_lines, sizeof (int));
+  LOG_ERR_IF_FATAL (rows == NULL, ERR_MSG_CREATE ("rows"));
+  for (i = 0; i < func->nr_lines; i++)
+    {
+      rows[asm_function_src_index (func, func->lines[i].line_nr)]++;
+    }
+  /* ... turn the counts into the row of each source line ... */
+  k = 1;
+  for (i = 0; i < func->nr_src_lines; i++)
+    {
+      j = rows[i];
+      rows[i] = k;
+      k += j + 1;
+    }
+  /* ... and place the instructions after it in address order. */
+  for (i = 0; i < func->nr_lines; i++)
+    {
+      j = asm_function_src_index (func, func->lines[i].line_nr);
+      rows[j]++;
+      func->lines[i].row = rows[j];
+    }
+  free (rows);
+}
+
+/**
+ * @brief Find the instruction at an address.
+ *
+ * @param func The function.
+ * @param pc The address.
+ *
+ * @return The instruction or NULL if there is no instruction at @a pc.
+ */
+asm_line *
+asm_function_find_line (asm_function * func, uint64_t pc)
+{
+  int lo = 0;
+  int hi;
+  int mid;
+
+  assert (func);
+
+  hi = func->nr_lines - 1;
+  while (lo <= hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      if (func->lines[mid].address == pc)
+	{
+	  return func->lines + mid;
+	}
+      if (func->lines[mid].address < pc)
+	{
+	  lo = mid + 1;
+	}
+      else
+	{
+	  hi = mid - 1;
+	}
+    }
+
+  return NULL;
+}
+
+/*@}*/
+
+/*******************************************************************************
+ * Register functions
+ ******************************************************************************/
+/**
+ * @name Register functions.
+ *
+ * Register function.
+ *
+ * Functions for holding information of the registers.
+ */
+/*@{*/
+/**
+ * @brief Create register object.
+ *
+ * Create a register object to handle all registers.
+ *
+ * @return A pointer to the new object.
+ */
+data_registers *
+data_registers_create (void)
+{
+  data_registers *registers;
+
+  registers = (data_registers *) malloc (sizeof (*registers));
+  LOG_ERR_IF_FATAL (registers == NULL, ERR_MSG_CREATE ("registers"));
+  memset (registers, 0, sizeof (*registers));
+
+  registers->registers = (data_reg *) malloc (128 * sizeof (data_reg));
+  LOG_ERR_IF_FATAL (registers->registers == NULL,
+		    ERR_MSG_CREATE ("registers"));
+  registers->size = 128;
+  registers->len = 0;
+
+  memset (registers->registers, 0, 128 * sizeof (data_reg));
+
+  registers->changed = (uint32_t *) calloc (128 / 32, sizeof (uint32_t));
+  LOG_ERR_IF_FATAL (registers->changed == NULL,
+		    ERR_MSG_CREATE ("registers"));
+
+  return registers;
+}
+
+/**
+ * @brief Free register object.
+ *
+ * Free a register object and it's resources.
+ *
+ * @param registers The registers.
+ */
+void
+data_registers_free (data_registers * registers)
+{
+  int i;
+
+  for (i = 0; i < registers->size; i++)
+    {
+      free (registers->registers[i].reg_name);
+      free (registers->registers[i].svalue);
+      free (registers->registers[i].lanes);
+      free (registers->registers[i].fvalue);
+    }
+  free (registers->registers);
+  free (registers->changed);
+
+  free (registers);
+}
+
+/**
+ * @brief Add a register.
+ *
+ * Add a register to the register object.
+ *
+ * @param registers The registers.
+ * @param nr The number associated with the new register.
+ * @param name The name of the register.
+ */
+void
+data_registers_add (data_registers * registers, int nr, const char *name)
+{
+  data_reg *t;
+  uint32_t *c;
+  int size;
+
+  assert (registers);
+
+  if (nr >= registers->size)
+    {
+      /* Keep the size a multiple of the bitmap word. */
+      size = (nr / 32 + 1) * 32;
+      t = (data_reg *) realloc (registers->registers,
+				size * sizeof (data_reg));
+      LOG_ERR_IF_FATAL (t == NULL, ERR_MSG_CREATE ("registers"));
+      memset (&t[registers->size], 0,
+	      (size - registers->size) * sizeof (data_reg));
+      registers->registers = t;
+      c = (uint32_t *) realloc (registers->changed,
+				size / 32 * sizeof (uint32_t));
+      LOG_ERR_IF_FATAL (c == NULL, ERR_MSG_CREATE ("registers"));
+      memset (&c[registers->size / 32], 0,
+	      (size - registers->size) / 32 * sizeof (uint32_t));
+      registers->changed = c;
+      registers->size = size;
+    }
+
+  if (registers->registers[nr].reg_name != NULL)
+    {
+      free (registers->registers[nr].reg_name);
+    }
+  if (nr + 1 > registers->len)
+    {
+      registers->len = nr + 1;
+    }
+
+  registers->registers[nr].reg_name = strdup (name);
+  LOG_ERR_IF_FATAL (registers->registers[nr].reg_name == NULL,
+		    ERR_MSG_CREATE ("register"));
+  registers->registers[nr].name_len = strlen (name);
+  registers->registers[nr].type = DATA_REG_NONE;
+  registers->registers[nr].nr_lanes = 0;
+  registers->registers[nr].flen = -1;
+}
+
+/**
+ * @brief Set a value of a register.
+ *
+ * Set a value of a register.
+ *
+ * @param registers The register object.
+ * @param nr The register number to be set.
+ * @param value The value.
+ *
+ * @return 0 upon success. -1 if the register does not exists.
+ */
+int
+data_registers_set_value (data_registers * registers, int nr, uint64_t value)
+{
+  data_reg *reg;
+
+  assert (registers);
+
+  LOG_ERR_IF_RETURN (nr < 0 || nr >= registers->size, -1,
+		     "Reg nr %d out out bounds", nr);
+
+  reg = registers->registers + nr;
+  if (reg->type != DATA_REG_INT || reg->u64 != value)
+    {
+      reg->type = DATA_REG_INT;
+      reg->u64 = value;
+      reg->flen = -1;
+    }
+
+  return 0;
+}
+
+/**
+ * @brief Set a value of a register.
+ *
+ * Set a value of a register. The value is a string, used for values that
+ * are not numbers.
+ *
+ * @param registers The register object.
+ * @param nr The register number to be set.
+ * @param value The value.
+ *
+ * @return 0 upon success. -1 if the register does not exists.
+ */
+int
+data_registers_set_str_value (data_registers * registers, int nr,
+			      const char *value)
+{
+  data_reg *reg;
+
+  assert (registers);
+
+  DINFO (5, "Setting reg %d %s to %s", nr, nr >= 0 && nr < registers->len ?
+	 registers->registers[nr].reg_name : "", value);
+  LOG_ERR_IF_RETURN (nr < 0 || nr >= registers->size, -1,
+		     "Reg nr %d out out bounds", nr);
+
+  reg = registers->registers + nr;
+  if (reg->type != DATA_REG_STRING || strcmp (reg->svalue, value) != 0)
+    {
+      reg->type = DATA_REG_STRING;
+      LPRINT (reg->svalue, 1, reg->size, "%s", value);
+      reg->flen = -1;
+    }
+
+  return 0;
+}
+
+/**
+ * @brief Set the lanes of a vector register.
+ *
+ * @param registers The register object.
+ * @param nr The register number to be set.
+ * @param lanes The lanes.
+ * @param nr_lanes Number of lanes.
+ *
+ * @return 0 upon success. -1 if the register does not exists.
+ */
+int
+data_registers_set_lanes (data_registers * registers, int nr,
+			  const uint64_t * lanes, int nr_lanes)
+{
+  data_reg *reg;
+
+  assert (registers);
+  assert (lanes || nr_lanes == 0);
+
+  LOG_ERR_IF_RETURN (nr < 0 || nr >= registers->size, -1,
+		     "Reg nr %d out out bounds", nr);
+
+  reg = registers->registers + nr;
+  if (reg->type == DATA_REG_VECTOR && reg->nr_lanes == nr_lanes
+      && (nr_lanes == 0
+	  || memcmp (reg->lanes, lanes, nr_lanes * sizeof (uint64_t)) == 0))
+    {
+      return 0;
+    }
+  if (nr_lanes > reg->lanes_size)
+    {
+      reg->lanes = (uint64_t *) realloc (reg->lanes,
+					 nr_lanes * sizeof (uint64_t));
+      LOG_ERR_IF_FATAL (reg->lanes == NULL, ERR_MSG_CREATE ("lanes"));
+      reg->lanes_size = nr_lanes;
+    }
+  if (nr_lanes > 0)
+    {
+      memcpy (reg->lanes, lanes, nr_lanes * sizeof (uint64_t));
+    }
+  reg->nr_lanes = nr_lanes;
+  reg->type = DATA_REG_VECTOR;
+  reg->flen = -1;
+
+  return 0;
+}
+
+/**
+ * @brief Format the value of a register.
+ *
+ * Integers and lanes are formatted as hexadecimal numbers, the lanes
+ * separated by ", ".
+ *
+ * @param registers The register object.
+ * @param nr The register number.
+ * @param buf The buffer for the formatted value.
+ * @param size The size of @a buf.
+ *
+ * @return The length of the formatted value, which is truncated to fit in
+ *         @a buf. -1 if the register does not exists.
+ */
+int
+data_registers_format (data_registers * registers, int nr, char *buf,
+		       int size)
+{
+  data_reg *reg;
+  int len = 0;
+  int i;
+
+  assert (registers);
+  assert (buf && size > 0);
+
+  LOG_ERR_IF_RETURN (nr < 0 || nr >= registers->size, -1,
+		     "Reg nr %d out out bounds", nr);
+
+  reg = registers->registers + nr;
+  buf[0] = '\0';
+  switch (reg->type)
+    {
+    case DATA_REG_INT:
+      len = snprintf (buf, size, "0x%" PRIx64, reg->u64);
+      break;
+    case DATA_REG_VECTOR:
+      for (i = 0; i < reg->nr_lanes && len < size; i++)
+	{
+	  len += snprintf (buf + len, size - len, "%s0x%" PRIx64,
+			   i == 0 ? "" : ", ", reg->lanes[i]);
+	}
+      break;
+    case DATA_REG_STRING:
+      len = snprintf (buf, size, "%s", reg->svalue ? reg->svalue : "");
+      break;
+    default:
+      break;
+    }
+
+  return len < size ? len : size - 1;
+}
+
+/**
+ * @brief Get the formatted value of a register.
+ *
+ * The value is formatted as by data_registers_format() and cached until
+ * the value of the register changes.
+ *
+ * @param registers The register object.
+ * @param nr The register number.
+ * @param len Set to the length of the value, if not NULL.
+ *
+ * @return The formatted value. NULL if the register does not exists.
+ */
+const char *
+data_registers_get_str (data_registers * registers, int nr, int *len)
+{
+  data_reg *reg;
+  int size;
+
+  assert (registers);
+
+  LOG_ERR_IF_RETURN (nr < 0 || nr >= registers->size, NULL,
+		     "Reg nr %d out out bounds", nr);
+
+  reg = registers->registers + nr;
+  if (reg->flen < 0 || reg->fvalue == NULL)
+    {
+      if (reg->fvalue == NULL)
+	{
+	  reg->fsize = 64;
+	  reg->fvalue = (char *) malloc (reg->fsize);
+	  LOG_ERR_IF_FATAL (reg->fvalue == NULL, ERR_MSG_CREATE ("register"));
+	}
+      reg->flen = data_registers_format (registers, nr, reg->fvalue,
+					 reg->fsize);
+      /* A full buffer may be truncated, grow until it fits. */
+      while (reg->flen == reg->fsize - 1)
+	{
+	  size = 2 * reg->fsize;
+	  free (reg->fvalue);
+	  reg->fvalue = (char *) malloc (size);
+	  LOG_ERR_IF_FATAL (reg->fvalue == NULL, ERR_MSG_CREATE ("register"));
+	  reg->fsize = size;
+	  reg->flen = data_registers_format (registers, nr, reg->fvalue,
+					     reg->fsize);
+	}
+    }
+  if (len)
+    {
+      *len = reg->flen;
+    }
+
+  return reg->fvalue;
+}
+
+/**
+ * @brief Clear the changed registers.
+ *
+ * @param registers The register object.
+ */
+void
+data_registers_clear_changed (data_registers * registers)
+{
+  assert (registers);
+
+  memset (registers->changed, 0, registers->size / 32 * sizeof (uint32_t));
+}
+
+/**
+ * @brief Mark a register as changed.
+ *
+ * @param registers The register object.
+ * @param nr The register number.
+ *
+ * @return 0 upon success. -1 if the register does not exists.
+ */
+int
+data_registers_set_changed (data_registers * registers, int nr)
+{
+  assert (registers);
+
+  LOG_ERR_IF_RETURN (nr < 0 || nr >= registers->size, -1,
+		     "Reg nr %d out out bounds", nr);
+
+  registers->changed[nr / 32] |= 1U << (nr % 32);
+
+  return 0;
+}
+
+/**
+ * @brief Check if a register has changed.
+ *
+ * @param registers The register object.
+ * @param nr The register number.
+ *
+ * @return 1 if the register changed at the last stop, otherwise 0.
+ */
+int
+data_registers_is_changed (data_registers * registers, int nr)
+{
+  assert (registers);
+
+  if (nr < 0 || nr >= registers->size)
+    {
+      return 0;
+    }
+
+  return (registers->changed[nr / 32] >> (nr % 32)) & 1;
+}
+
+/*@}*/
+
+/*******************************************************************************
+ * Memory functions
+ ******************************************************************************/
+/**
+ * @name Memory functions.
+ *
+ * Functions for caching the pages of the memory window.
+ */
+/*@{*/
+/**
+ * @brief Create a memory cache.
+ *
+ * @return A pointer to the new cache.
+ */
+mem_cache *
+mem_cache_create (void)
+{
+  mem_cache *cache;
+
+  cache = (mem_cache *) malloc (sizeof (*cache));
+  LOG_ERR_IF_FATAL (cache == NULL, ERR_MSG_CREATE ("memory"));
+  memset (cache, 0, sizeof (*cache));
+
+  cache->pages = (mem_page **) malloc (MEM_CACHE_PAGES * sizeof (mem_page *));
+  LOG_ERR_IF_FATAL (cache->pages == NULL, ERR_MSG_CREATE ("memory"));
+
+  return cache;
+}
+
+/**
+ * @brief Free a memory cache.
+ *
+ * @param cache The cache.
+ */
+void
+mem_cache_free (mem_cache * cache)
+{
+  assert (cache);
+
+  mem_cache_reset (cache);
+  free (cache->pages);
+  free (cache);
+}
+
+/**
+ * @brief Remove all pages.
+ *
+ * @param cache The cache.
+ */
+void
+mem_cache_reset (mem_cache * cache)
+{
+  int i;
+
+  assert (cache);
+
+  for (i = 0; i < cache->nr_pages; i++)
+    {
+      free (cache->pages[i]);
+    }
+  cache->nr_pages = 0;
+}
+
+/**
+ * @brief Set the region shown in the memory window.
+ *
+ * The cached pages are kept, they may be part of the new region.
+ *
+ * @param cache The cache.
+ * @param start The start address of the region.
+ * @param length The length of the region.
+ */
+void
+mem_cache_set_region (mem_cache * cache, uint64_t start, uint64_t length)
+{
+  assert (cache);
+
+  cache->start = start;
+  /* Do not wrap around the end of the address space. */
+  cache->length = length > UINT64_MAX - start ? UINT64_MAX - start : length;
+}
+
+/**
+ * @brief Mark pages as stale.
+ *
+ * The pages overlapping [@a address, @a address + @a length) are marked
+ * stale. They keep their bytes until they have been read again.
+ *
+ * @param cache The cache.
+ * @param address The start of the changed memory.
+ * @param length The length of the changed memory.
+ */
+void
+mem_cache_invalidate (mem_cache * cache, uint64_t address, uint64_t length)
+{
+  int i;
+  uint64_t last;
+
+  assert (cache);
+
+  if (length == 0)
+    {
+      return;
+    }
+  last = length - 1 > UINT64_MAX - address ?
+    UINT64_MAX : address + length - 1;
+  for (i = 0; i < cache->nr_pages; i++)
+    {
+      if (cache->pages[i]->address <= last
+	  && cache->pages[i]->address + (MEM_PAGE_SIZE - 1) >= address)
+	{
+	  cache->pages[i]->state = MEM_PAGE_STALE;
+	}
+    }
+}
+
+/**
+ * @brief Value of a hexadecimal digit.
+ *
+ * @param c The digit.
+ *
+ * @return The value, -1 if @a c is not a hexadecimal digit.
+ */
+static int
+mem_hex_value (char c)
+{
+  if (c >= '0' && c <= '9')
+    {
+      return c - '0';
+    }
+  if (c >= 'a' && c <= 'f')
+    {
+      return c - 'a' + 10;
+    }
+  if (c >= 'A' && c <= 'F')
+    {
+      return c - 'A' + 10;
+    }
+  return -1;
+}
+
+/**
+ * @brief Find the first page after an address.
+ *
+ * @param cache The cache.
+ * @param address The address.
+ *
+ * @return The index of the first page starting after @a address.
+ */
+static int
+mem_cache_upper_bound (mem_cache * cache, uint64_t address)
+{
+  int lo = 0;
+  int hi = cache->nr_pages;
+  int mid;
+
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      if (cache->pages[mid]->address <= address)
+	{
+	  lo = mid + 1;
+	}
+      else
+	{
+	  hi = mid;
+	}
+    }
+
+  return lo;
+}
+
+/**
+ * @brief Find the page holding an address.
+ *
+ * @param cache The cache.
+ * @param address The address.
+ *
+ * @return The page or NULL if the page is not cached.
+ */
+mem_page *
+mem_cache_find (mem_cache * cache, uint64_t address)
+{
+  int i;
+  mem_page *page;
+
+  assert (cache);
+
+  i = mem_cache_upper_bound (cache, address) - 1;
+  if (i < 0)
+    {
+      return NULL;
+    }
+  page = cache->pages[i];
+  if (address - page->address >= MEM_PAGE_SIZE)
+    {
+      return NULL;
+    }
+  page->last_used = ++cache->clock;
+
+  return page;
+}
+
+/**
+ * @brief Request the page holding an address.
+ *
+ * A missing page is added as pending, the least recently used page is
+ * dropped if the cache is full. A stale page becomes pending.
+ *
+ * @param cache The cache.
+ * @param address The address.
+ *
+ * @return 1 if the page must be read, otherwise 0.
+ */
+int
+mem_cache_request (mem_cache * cache, uint64_t address)
+{
+  int i;
+  int lru;
+  mem_page *page;
+
+  assert (cache);
+
+  address -= address % MEM_PAGE_SIZE;
+  page = mem_cache_find (cache, address);
+  if (page != NULL)
+    {
+      if (page->state != MEM_PAGE_STALE)
+	{
+	  return 0;
+	}
+      page->state = MEM_PAGE_PENDING;
+      return 1;
+    }
+
+  if (cache->nr_pages == MEM_CACHE_PAGES)
+    {
+      lru = 0;
+      for (i = 1; i < cache->nr_pages; i++)
+	{
+	  if (cache->pages[i]->last_used < cache->pages[lru]->last_used)
+	    {
+	      lru = i;
+	    }
+	}
+      free (cache->pages[lru]);
+      memmove (cache->pages + lru, cache->pages + lru + 1,
+	       (cache->nr_pages - lru - 1) * sizeof (mem_page *));
+      cache->nr_pages--;
+    }
+
+  page = (mem_page *) malloc (sizeof (*page));
+  LOG_ERR_IF_FATAL (page == NULL, ERR_MSG_CREATE ("memory"));
+  memset (page->valid, 0, sizeof (page->valid));
+  page->address = address;
+  page->state = MEM_PAGE_PENDING;
+  page->last_used = ++cache->clock;
+
+  i = mem_cache_upper_bound (cache, address);
+  memmove (cache->pages + i + 1, cache->pages + i,
+	   (cache->nr_pages - i) * sizeof (mem_page *));
+  cache->pages[i] = page;
+  cache->nr_pages++;
+
+  return 1;
+}
+
+/**
+ * @brief Store read bytes.
+ *
+ * Store the bytes of a block of read memory in the cached pages. Bytes of
+ * pages that are not cached are dropped. A page that was not read before
+ * gets its old bytes cleared and becomes read.
+ *
+ * @param cache The cache.
+ * @param address The address of the first byte.
+ * @param hex The bytes as hexadecimal digits, two per byte.
+ *
+ * @return The number of stored bytes. -1 if @a hex is not hexadecimal.
+ */
+int
+mem_cache_set_bytes (mem_cache * cache, uint64_t address, const char *hex)
+{
+  mem_page *page = NULL;
+  uint64_t base = 0;
+  int looked_up = 0;
+  int stored = 0;
+  int offset;
+  int hi;
+  int lo;
+
+  assert (cache);
+  assert (hex);
+
+  while (hex[0] != '\0' && hex[1] != '\0')
+    {
+      hi = mem_hex_value (hex[0]);
+      lo = mem_hex_value (hex[1]);
+      LOG_ERR_IF_RETURN (hi < 0 || lo < 0, -1, "Not hexadecimal '%s'", hex);
+      if (!looked_up || address - base >= MEM_PAGE_SIZE)
+	{
+	  /* Look up each page once. */
+	  base = address - address % MEM_PAGE_SIZE;
+	  looked_up = 1;
+	  page = mem_cache_find (cache, address);
+	  if (page != NULL && page->state != MEM_PAGE_READ)
+	    {
+	      memset (page->valid, 0, sizeof (page->valid));
+	      page->state = MEM_PAGE_READ;
+	    }
+	}
+      if (page != NULL)
+	{
+	  offset = address - base;
+	  page->data[offset] = hi << 4 | lo;
+	  page->valid[offset / 8] |= 1 << (offset % 8);
+	  stored++;
+	}
+      address++;
+      hex += 2;
+    }
+
+  return stored;
+}
+
+/*@}*/
+
+/*******************************************************************************
+ * Source file functions
+ ******************************************************************************/
+/**
+ * @name Source file functions.
+ *
+ * Functions for the index of source files. The names are interned in a hash
+ * table so each name is stored once, no matter how many compilation units
+ * that refer to it.
+ */
+/*@{*/
+/**
+ * @brief Free a list of blocks.
+ *
+ * @param blocks The list, set to NULL.
+ */
+static void
+file_block_free (file_block ** blocks)
+{
+  file_block *block;
+
+  while (*blocks != NULL)
+    {
+      block = *blocks;
+      *blocks = block->next;
+      free (block);
+    }
+}
+
+/**
+ * @brief Create a file index.
+ *
+ * @return A pointer to the new index.
+ */
+file_index *
+file_index_create (void)
+{
+  file_index *index;
+
+  index = (file_index *) malloc (sizeof (*index));
+  LOG_ERR_IF_FATAL (index == NULL, ERR_MSG_CREATE ("file index"));
+  memset (index, 0, sizeof (*index));
+
+  return index;
+}
+
+/**
+ * @brief Free a file index.
+ *
+ * @param index The index.
+ */
+void
+file_index_free (file_index * index)
+{
+  assert (index);
+
+  file_index_reset (index);
+  free (index->slots);
+  free (index->names);
+  free (index->matches);
+  free (index);
+}
+
+/**
+ * @brief Remove all names.
+ *
+ * @param index The index.
+ */
+void
+file_index_reset (file_index * index)
+{
+  assert (index);
+
+  file_block_free (&index->blocks);
+  if (index->slots != NULL)
+    {
+      memset (index->slots, 0, index->nr_slots * sizeof (*index->slots));
+    }
+  index->nr_names = 0;
+  index->nr_matches = 0;
+  free (index->pattern);
+  index->pattern = NULL;
+}
+
+/**
+ * @brief Allocate memory for strings in a list of blocks.
+ *
+ * @param blocks The list of blocks, a new block is added first if @a len
+ * bytes do not fit in the first block.
+ * @param len The number of bytes.
+ *
+ * @return The memory, valid until the blocks are freed.
+ */
+static char *
+file_block_alloc (file_block ** blocks, int len)
+{
+  file_block *block;
+  char *copy;
+  int size;
+
+  block = *blocks;
+  if (block == NULL || block->size - block->used < len)
+    {
+      size = len > FILE_BLOCK_SIZE ? len : FILE_BLOCK_SIZE;
+      block = (file_block *) malloc (sizeof (*block) + size);
+      LOG_ERR_IF_FATAL (block == NULL, ERR_MSG_CREATE ("file block"));
+      block->next = *blocks;
+      block->used = 0;
+      block->size = size;
+      *blocks = block;
+    }
+  copy = block->names + block->used;
+  block->used += len;
+
+  return copy;
+}
+
+/**
+ * @brief Rehash the names into a new set of slots.
+ *
+ * @param index The index.
+ * @param size The new number of slots, must be a power of 2.
+ */
+static void
+file_index_rehash (file_index * index, int size)
+{
+  const char **slots;
+  unsigned int j;
+  int i;
+
+  slots = (const char **) calloc (size, sizeof (*slots));
+  LOG_ERR_IF_FATAL (slots == NULL, ERR_MSG_CREATE ("file slots"));
+
+  for (i = 0; i < index->nr_names; i++)
+    {
+      j = string_hash (index->names[i]) & (size - 1);
+      while (slots[j] != NULL)
+	{
+	  j = (j + 1) & (size - 1);
+	}
+      slots[j] = index->names[i];
+    }
+
+  free (index->slots);
+  index->slots = slots;
+  index->nr_slots = size;
+}
+
+/**
+ * @brief Add a name.
+ *
+ * The name is interned, adding a name that already is in the index returns
+ * the name already added. The index must be sorted again by
+ * file_index_sort() before it is matched.
+ *
+ * @param index The index.
+ * @param name The name to add.
+ *
+ * @return The interned name.
+ */
+const char *
+file_index_add (file_index * index, const char *name)
+{
+  unsigned int j;
+  int len;
+
+  assert (index);
+  assert (name);
+
+  /* Keep the slots at most half full. */
+  if (2 * (index->nr_names + 1) > index->nr_slots)
+    {
+      file_index_rehash (index, index->nr_slots == 0 ?
+			 2 * FILE_INDEX_START : 2 * index->nr_slots);
+    }
+  j = string_hash (name) & (index->nr_slots - 1);
+  while (index->slots[j] != NULL)
+    {
+      if (strcmp (index->slots[j], name) == 0)
+	{
+	  return index->slots[j];
+	}
+      j = (j + 1) & (index->nr_slots - 1);
+    }
+
+  len = strlen (name) + 1;
+  if (index->nr_names == index->size)
+    {
+      index->size = index->size == 0 ? FILE_INDEX_START : 2 * index->size;
+      index->names = (const char **) realloc (index->names, index->size *
+					      sizeof (*index->names));
+      LOG_ERR_IF_FATAL (index->names == NULL, ERR_MSG_CREATE ("file names"));
+      index->matches = (file_match *) realloc (index->matches, index->size *
+					       sizeof (*index->matches));
+      LOG_ERR_IF_FATAL (index->matches == NULL,
+			ERR_MSG_CREATE ("file matches"));
+    }
+
+  index->slots[j] = file_block_alloc (&index->blocks, len);
+  memcpy ((char *) index->slots[j], name, len);
+  index->names[index->nr_names++] = index->slots[j];
+
+  /* A new name invalidates the matches. */
+  free (index->pattern);
+  index->pattern = NULL;
+  index->nr_matches = 0;
+
+  return index->slots[j];
+}
+
+/**
+ * @brief Compare two names, used by qsort.
+ *
+ * @param a The first name.
+ * @param b The second name.
+ *
+ * @return Less than, equal or greater than 0 as strcmp.
+ */
+static int
+file_index_cmp_name (const void *a, const void *b)
+{
+  return strcmp (*(const char *const *) a, *(const char *const *) b);
+}
+
+/**
+ * @brief Sort the names.
+ *
+ * @param index The index.
+ */
+void
+file_index_sort (file_index * index)
+{
+  assert (index);
+
+  if (index->nr_names > 1)
+    {
+      qsort (index->names, index->nr_names, sizeof (*index->names),
+	     file_index_cmp_name);
+    }
+  free (index->pattern);
+  index->pattern = NULL;
+  index->nr_matches = 0;
+}
+
+/**
+ * @brief Score a fuzzy match.
+ *
+ * The characters of @a pattern must be found in order in @a str, ignoring
+ * case. Consecutive characters and characters at the start of a word give
+ * a higher score.
+ *
+ * @param name The whole name.
+ * @param str Where in @a name to start matching.
+ * @param pattern The pattern.
+ *
+ * @return The score, -1 if @a str does not match.
+ */
+static int
+file_index_score_from (const char *name, const char *str,
+		       const char *pattern)
+{
+  const char *prev = NULL;
+  int score = 0;
+
+  while (*pattern != '\0')
+    {
+      while (*str != '\0' && tolower ((unsigned char) *str) !=
+	     tolower ((unsigned char) *pattern))
+	{
+	  str++;
+	}
+      if (*str == '\0')
+	{
+	  return -1;
+	}
+      score++;
+      if (prev != NULL && str == prev + 1)
+	{
+	  score += 4;
+	}
+      if (str == name || strchr ("/_-.", str[-1]) != NULL)
+	{
+	  score += 3;
+	}
+      prev = str;
+      str++;
+      pattern++;
+    }
+
+  return score;
+}
+
+/**
+ * @brief Score a name.
+ *
+ * A match within the file name, not counting the directories, is preferred.
+ *
+ * @param name The name.
+ * @param pattern The pattern.
+ *
+ * @return The score, -1 if @a name does not match.
+ */
+static int
+file_index_score (const char *name, const char *pattern)
+{
+  const char *base;
+  int score;
+
+  base = strrchr (name, '/');
+  if (base != NULL)
+    {
+      score = file_index_score_from (name, base + 1, pattern);
+      if (score >= 0)
+	{
+	  return score + 8;
+	}
+    }
+
+  return file_index_score_from (name, name, pattern);
+}
+
+/**
+ * @brief Compare two matches, used by qsort.
+ *
+ * Higher score first, then shorter names and then in name order.
+ *
+ * @param a The first match.
+ * @param b The second match.
+ *
+ * @return Less than 0 if @a a should be first.
+ */
+static int
+file_index_cmp_match (const void *a, const void *b)
+{
+  const file_match *ma = (const file_match *) a;
+  const file_match *mb = (const file_match *) b;
+
+  if (ma->score != mb->score)
+    {
+      return mb->score - ma->score;
+    }
+  if (ma->len != mb->len)
+    {
+      return ma->len - mb->len;
+    }
+  return ma->name - mb->name;
+}
+
+/**
+ * @brief Match the names against a pattern.
+ *
+ * Find the names that contain the characters of @a pattern in order. When
+ * @a pattern extends the previous pattern only the previous matches are
+ * searched, so typing one character at the time is cheap.
+ *
+ * @param index The index.
+ * @param pattern The pattern, an empty pattern matches all names.
+ *
+ * @return The number of matches.
+ */
+int
+file_index_match (file_index * index, const char *pattern)
+{
+  file_match *m;
+  int incremental;
+  int nr;
+  int name;
+  int len;
+  int score;
+  int i;
+
+  assert (index);
+  assert (pattern);
+
+  incremental = index->pattern != NULL
+    && strncmp (pattern, index->pattern, strlen (index->pattern)) == 0;
+  nr = incremental ? index->nr_matches : index->nr_names;
+
+  index->nr_matches = 0;
+  for (i = 0; i < nr; i++)
+    {
+      /* The matches are written at or before the read position. */
+      name = incremental ? index->matches[i].name : i;
+      len = incremental ? index->matches[i].len : -1;
+      score = file_index_score (index->names[name], pattern);
+      if (score >= 0)
+	{
+	  m = &index->matches[index->nr_matches++];
+	  m->name = name;
+	  m->score = score;
+	  m->len = len >= 0 ? len : (int) strlen (index->names[name]);
+	}
+    }
+  if (*pattern != '\0' && index->nr_matches > 1)
+    {
+      qsort (index->matches, index->nr_matches, sizeof (*index->matches),
+	     file_index_cmp_match);
+    }
+
+  free (index->pattern);
+  index->pattern = strdup (pattern);
+  LOG_ERR_IF_FATAL (index->pattern == NULL, ERR_MSG_CREATE ("pattern"));
+
+  return index->nr_matches;
+}
+
+/**
+ * @brief Get a match.
+ *
+ * @param index The index.
+ * @param nr The number of the match, 0 is the best match.
+ *
+ * @return The name or NULL if there is no such match.
+ */
+const char *
+file_index_get_match (file_index * index, int nr)
+{
+  assert (index);
+
+  if (nr < 0 || nr >= index->nr_matches)
+    {
+      return NULL;
+    }
+
+  return index->names[index->matches[nr].name];
+}
+
+/*@}*/
+
+/**
+ * @name Symbol index.
+ *
+ * Functions for the index of the functions in the debugged program. The
+ * names are matched as substrings ignoring case. Patterns of at least three
+ * characters only look at the symbols in the smallest trigram bucket of the
+ * pattern and a pattern extending the previous pattern only looks at the
+ * previous hits, so matching stays fast with hundreds of thousands of
+ * symbols.
+ */
+/*@{*/
+/**
+ * @brief Create a symbol index.
+ *
+ * @return A pointer to the new index.
+ */
+symbol_index *
+symbol_index_create (void)
+{
+  symbol_index *index;
+
+  index = (symbol_index *) malloc (sizeof (*index));
+  LOG_ERR_IF_FATAL (index == NULL, ERR_MSG_CREATE ("symbol index"));
+  memset (index, 0, sizeof (*index));
+  index->files = file_index_create ();
+
+  return index;
+}
+
+/**
+ * @brief Free a symbol index.
+ *
+ * @param index The index.
+ */
+void
+symbol_index_free (symbol_index * index)
+{
+  assert (index);
+
+  symbol_index_reset (index);
+  file_index_free (index->files);
+  free (index->symbols);
+  free (index->hits);
+  free (index->scores);
+  free (index->matches);
+  free (index);
+}
+
+/**
+ * @brief Remove all symbols.
+ *
+ * @param index The index.
+ */
+void
+symbol_index_reset (symbol_index * index)
+{
+  assert (index);
+
+  file_block_free (&index->blocks);
+  file_index_reset (index->files);
+  free (index->trigrams);
+  index->trigrams = NULL;
+  free (index->postings);
+  index->postings = NULL;
+  index->nr_symbols = 0;
+  index->nr_hits = 0;
+  free (index->pattern);
+  index->pattern = NULL;
+}
+
+/**
+ * @brief Get the bit of a character.
+ *
+ * Letters, digits and '_' have their own bit, the other characters share
+ * the rest.
+ *
+ * @param c The character in lower case.
+ *
+ * @return The bit.
+ */
+static uint64_t
+symbol_index_char (char c)
+{
+  if (c >= 'a' && c <= 'z')
+    {
+      return (uint64_t) 1 << (c - 'a');
+    }
+  if (c >= '0' && c <= '9')
+    {
+      return (uint64_t) 1 << (26 + c - '0');
+    }
+  if (c == '_')
+    {
+      return (uint64_t) 1 << 36;
+    }
+  return (uint64_t) 1 << (37 + (unsigned char) c % 27);
+}
+
+/**
+ * @brief Add a symbol.
+ *
+ * The index must be sorted by symbol_index_sort() before it is matched.
+ *
+ * @param index The index.
+ * @param name The name of the function.
+ * @param file The source file.
+ * @param line The line of the definition.
+ */
+void
+symbol_index_add (symbol_index * index, const char *name, const char *file,
+		  int line)
+{
+  symbol_entry *symbol;
+  char *copy;
+  int len;
+  int i;
+
+  assert (index);
+  assert (name);
+  assert (file);
+
+  if (index->nr_symbols == index->size)
+    {
+      index->size = index->size == 0 ? SYMBOL_INDEX_START : 2 * index->size;
+      index->symbols = (symbol_entry *) realloc (index->symbols, index->size *
+						 sizeof (*index->symbols));
+      index->hits = (int *) realloc (index->hits,
+				     index->size * sizeof (*index->hits));
+      index->scores = (unsigned char *) realloc (index->scores, index->size);
+      index->matches = (int *) realloc (index->matches,
+					index->size * sizeof (*index->matches));
+      LOG_ERR_IF_FATAL (index->symbols == NULL || index->hits == NULL
+			|| index->scores == NULL || index->matches == NULL,
+			ERR_MSG_CREATE ("symbols"));
+    }
+
+  /* The name in lower case is kept after the name. */
+  len = strlen (name);
+  copy = file_block_alloc (&index->blocks, 2 * (len + 1));
+  memcpy (copy, name, len + 1);
+  symbol = &index->symbols[index->nr_symbols++];
+  symbol->name = copy;
+  symbol->file = file_index_add (index->files, file);
+  symbol->line = line;
+  symbol->len = len;
+  symbol->chars = 0;
+  copy += len + 1;
+  for (i = 0; i < len; i++)
+    {
+      copy[i] = tolower ((unsigned char) name[i]);
+      symbol->chars |= symbol_index_char (copy[i]);
+    }
+  copy[len] = '\0';
+
+  /* A new symbol invalidates the hits and the trigrams. */
+  free (index->pattern);
+  index->pattern = NULL;
+  index->nr_hits = 0;
+  free (index->trigrams);
+  index->trigrams = NULL;
+}
+
+/**
+ * @brief Compare two symbols, used by qsort.
+ *
+ * @param a The first symbol.
+ * @param b The second symbol.
+ *
+ * @return Less than, equal or greater than 0 ordering the symbols by name,
+ * file and line.
+ */
+static int
+symbol_index_cmp (const void *a, const void *b)
+{
+  const symbol_entry *sa = (const symbol_entry *) a;
+  const symbol_entry *sb = (const symbol_entry *) b;
+  int ret;
+
+  ret = strcmp (sa->name, sb->name);
+  if (ret == 0)
+    {
+      ret = strcmp (sa->file, sb->file);
+    }
+  if (ret == 0)
+    {
+      ret = sa->line - sb->line;
+    }
+  return ret;
+}
+
+/**
+ * @brief Get the bucket of a trigram.
+ *
+ * @param str The first character of the trigram.
+ *
+ * @return The bucket.
+ */
+static unsigned int
+symbol_index_trigram (const char *str)
+{
+  unsigned int t;
+
+  t = tolower ((unsigned char) str[0]) << 16
+    | tolower ((unsigned char) str[1]) << 8
+    | tolower ((unsigned char) str[2]);
+
+  return (t * 2654435761U) >> (32 - SYMBOL_TRIGRAM_BITS);
+}
+
+/**
+ * @brief Sort the symbols and build the trigram index.
+ *
+ * Symbols that are listed more than once are only kept once. The names are
+ * moved to new blocks in the sorted order, so matching reads the names in
+ * the order they are stored.
+ *
+ * @param index The index.
+ */
+void
+symbol_index_sort (symbol_index * index)
+{
+  symbol_entry *symbols;
+  file_block *blocks = NULL;
+  char *copy;
+  int *last;
+  int *next;
+  unsigned int t;
+  int nr;
+  int i;
+  int j;
+
+  assert (index);
+
+  symbols = index->symbols;
+  if (index->nr_symbols > 1)
+    {
+      qsort (symbols, index->nr_symbols, sizeof (*symbols), symbol_index_cmp);
+      nr = 1;
+      for (i = 1; i < index->nr_symbols; i++)
+	{
+	  if (symbol_index_cmp (&symbols[nr - 1], &symbols[i]) != 0)
+	    {
+	      symbols[nr++] = symbols[i];
+	    }
+	}
+      index->nr_symbols = nr;
+    }
+  for (i = 0; i < index->nr_symbols; i++)
+    {
+      copy = file_block_alloc (&blocks, 2 * (symbols[i].len + 1));
+      memcpy (copy, symbols[i].name, 2 * (symbols[i].len + 1));
+      symbols[i].name = copy;
+    }
+  file_block_free (&index->blocks);
+  index->blocks = blocks;
+
+  free (index->trigrams);
+  free (index->postings);
+  index->trigrams = (int *) calloc (SYMBOL_TRIGRAMS + 1, sizeof (int));
+  last = (int *) malloc (SYMBOL_TRIGRAMS * sizeof (*last));
+  next = (int *) malloc (SYMBOL_TRIGRAMS * sizeof (*next));
+  LOG_ERR_IF_FATAL (index->trigrams == NULL || last == NULL || next == NULL,
+		    ERR_MSG_CREATE ("trigrams"));
+
+  /* Count the symbols of each bucket, each symbol once. */
+  memset (last, 0xff, SYMBOL_TRIGRAMS * sizeof (*last));
+  for (i = 0; i < index->nr_symbols; i++)
+    {
+      for (j = 0; j + 2 < symbols[i].len; j++)
+	{
+	  t = symbol_index_trigram (symbols[i].name + j);
+	  if (last[t] != i)
+	    {
+	      last[t] = i;
+	      index->trigrams[t + 1]++;
+	    }
+	}
+    }
+  for (t = 0; t < SYMBOL_TRIGRAMS; t++)
+    {
+      index->trigrams[t + 1] += index->trigrams[t];
+    }
+
+  index->postings = (int *) malloc ((index->trigrams[SYMBOL_TRIGRAMS] + 1) *
+				    sizeof (*index->postings));
+  LOG_ERR_IF_FATAL (index->postings == NULL, ERR_MSG_CREATE ("trigrams"));
+  memcpy (next, index->trigrams, SYMBOL_TRIGRAMS * sizeof (*next));
+  memset (last, 0xff, SYMBOL_TRIGRAMS * sizeof (*last));
+  for (i = 0; i < index->nr_symbols; i++)
+    {
+      for (j = 0; j + 2 < symbols[i].len; j++)
+	{
+	  t = symbol_index_trigram (symbols[i].name + j);
+	  if (last[t] != i)
+	    {
+	      last[t] = i;
+	      index->postings[next[t]++] = i;
+	    }
+	}
+    }
+  free (last);
+  free (next);
+
+  free (index->pattern);
+  index->pattern = NULL;
+  index->nr_hits = 0;
+}
+
+/**
+ * @brief Score a symbol.
+ *
+ * @param symbol The symbol.
+ * @param pattern The pattern in lower case.
+ * @param len The length of @a pattern.
+ *
+ * @return 0 if the name is @a pattern, 1 if it starts with @a pattern, 2 if
+ * a word starts with @a pattern, 3 if it contains @a pattern and -1 if it
+ * does not match.
+ */
+static int
+symbol_index_score (const symbol_entry * symbol, const char *pattern,
+		    int len)
+{
+  const char *lower = symbol->name + symbol->len + 1;
+  const char *found;
+  int score = -1;
+
+  found = strstr (lower, pattern);
+  if (found == lower)
+    {
+      return len == symbol->len ? 0 : 1;
+    }
+  while (found != NULL)
+    {
+      if (strchr ("_:.", found[-1]) != NULL)
+	{
+	  return 2;
+	}
+      score = 3;
+      found = strstr (found + 1, pattern);
+    }
+
+  return score;
+}
+
+/**
+ * @brief Match the symbols against a pattern.
+ *
+ * Find the symbols whose name contain @a pattern, ignoring case. The best
+ * matches are the symbols named @a pattern, then the names starting with
+ * it, then the names with a word starting with it and last the rest. Names
+ * that match equally well are kept in name order.
+ *
+ * @param index The index.
+ * @param pattern The pattern, an empty pattern matches all symbols.
+ *
+ * @return The number of matches.
+ */
+int
+symbol_index_match (symbol_index * index, const char *pattern)
+{
+  char *lower;
+  const int *candidates;
+  int nr_candidates;
+  int start[5];
+  uint64_t chars = 0;
+  unsigned int t;
+  int score;
+  int len;
+  int nr;
+  int i;
+
+  assert (index);
+  assert (pattern);
+
+  len = strlen (pattern);
+  lower = strdup (pattern);
+  LOG_ERR_IF_FATAL (lower == NULL, ERR_MSG_CREATE ("pattern"));
+  for (i = 0; i < len; i++)
+    {
+      lower[i] = tolower ((unsigned char) lower[i]);
+      chars |= symbol_index_char (lower[i]);
+    }
+
+  /* Find the smallest set of symbols that may contain the pattern. */
+  candidates = NULL;
+  nr_candidates = index->nr_symbols;
+  if (index->pattern != NULL
+      && strncmp (lower, index->pattern, strlen (index->pattern)) == 0)
+    {
+      candidates = index->hits;
+      nr_candidates = index->nr_hits;
+    }
+  for (i = 0; index->trigrams != NULL && i + 2 < len; i++)
+    {
+      t = symbol_index_trigram (lower + i);
+      nr = index->trigrams[t + 1] - index->trigrams[t];
+      if (nr < nr_candidates)
+	{
+	  candidates = index->postings + index->trigrams[t];
+	  nr_candidates = nr;
+	}
+    }
+
+  /* The hits are written at or before the read position. */
+  memset (start, 0, sizeof (start));
+  index->nr_hits = 0;
+  for (i = 0; i < nr_candidates; i++)
+    {
+      nr = candidates != NULL ? candidates[i] : i;
+      if ((index->symbols[nr].chars & chars) != chars)
+	{
+	  continue;
+	}
+      score = symbol_index_score (&index->symbols[nr], lower, len);
+      if (score >= 0)
+	{
+	  index->hits[index->nr_hits] = nr;
+	  index->scores[index->nr_hits++] = score;
+	  start[score + 1]++;
+	}
+    }
+
+  /* Order the hits by score, keeping the name order. */
+  for (i = 1; i < 4; i++)
+    {
+      start[i] += start[i - 1];
+    }
+  for (i = 0; i < index->nr_hits; i++)
+    {
+      index->matches[start[index->scores[i]]++] = index->hits[i];
+    }
+
+  free (index->pattern);
+  index->pattern = lower;
+
+  return index->nr_hits;
+}
+
+/**
+ * @brief Get a match.
+ *
+ * @param index The index.
+ * @param nr The number of the match, 0 is the best match.
+ * @param file Set to the source file of the symbol.
+ * @param line Set to the line of the symbol.
+ *
+ * @return The name or NULL if there is no such match.
+ */
+const char *
+symbol_index_get_match (symbol_index * index, int nr, const char **file,
+			int *line)
+{
+  symbol_entry *symbol;
+
+  assert (index);
+  assert (file);
+  assert (line);
+
+  if (nr < 0 || nr >= index->nr_hits)
+    {
+      return NULL;
+    }
+
+  symbol = &index->symbols[index->matches[nr]];
+  *file = symbol->file;
+  *line = symbol->line;
+
+  return symbol->name;
+}
+
+/*@}*/
+
+/**
+ * @name Record log.
+ *
+ * Functions for storing the raw records from the debugger.
+ */
+/*@{*/
+
+/**
+ * @brief Create a record log.
+ *
+ * @return A pointer to the new log.
+ */
+record_log *
+record_log_create (void)
+{
+  record_log *log;
+
+  log = (record_log *) malloc (sizeof (*log));
+  LOG_ERR_IF_FATAL (log == NULL, ERR_MSG_CREATE ("record log"));
+  memset (log, 0, sizeof (*log));
+
+  return log;
+}
+
+/**
+ * @brief Free a record log.
+ *
+ * @param log The log.
+ */
+void
+record_log_free (record_log * log)
+{
+  assert (log);
+
+  file_block_free (&log->blocks);
+  free (log->records);
+  free (log);
+}
+
+/**
+ * @brief Add a record.
+ *
+ * @param log The log.
+ * @param record The record.
+ *
+ * @return The number of the record.
+ */
+int
+record_log_add (record_log * log, const char *record)
+{
+  record_entry *entry;
+  char *copy;
+  int len;
+
+  assert (log);
+  assert (record);
+
+  if (log->nr_records == log->size)
+    {
+      log->size = log->size == 0 ? RECORD_LOG_START : 2 * log->size;
+      log->records = (record_entry *) realloc (log->records, log->size *
+					       sizeof (*log->records));
+      LOG_ERR_IF_FATAL (log->records == NULL, ERR_MSG_CREATE ("records"));
+    }
+
+  len = strlen (record);
+  copy = file_block_alloc (&log->blocks, len + 1);
+  memcpy (copy, record, len + 1);
+  entry = &log->records[log->nr_records];
+  entry->text = copy;
+  entry->len = len;
+  entry->expanded = 0;
+
+  return log->nr_records++;
+}
+
+/**
+ * @brief Get a record.
+ *
+ * @param log The log.
+ * @param nr The number of the record.
+ * @param len Set to the length of the record.
+ *
+ * @return The record, valid until the log is freed. NULL if there is no
+ * such record.
+ */
+const char *
+record_log_get (record_log * log, int nr, int *len)
+{
+  assert (log);
+  assert (len);
+
+  if (nr < 0 || nr >= log->nr_records)
+    {
+      return NULL;
+    }
+
+  *len = log->records[nr].len;
+  return log->records[nr].text;
+}
+
+/**
+ * @brief Toggle whether a record is shown as a whole or truncated.
+ *
+ * @param log The log.
+ * @param nr The number of the record.
+ *
+ * @return 1 if the record is expanded, 0 if it is truncated. -1 if there is
+ * no such record.
+ */
+int
+record_log_toggle (record_log * log, int nr)
+{
+  assert (log);
+
+  if (nr < 0 || nr >= log->nr_records)
+    {
+      return -1;
+    }
+
+  log->records[nr].expanded = !log->records[nr].expanded;
+  return log->records[nr].expanded;
 }
 
 /*@}*/
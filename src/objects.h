@@ -32,6 +32,8 @@
  * @li Stack and frame. Stack and frame information.
  * @li Assembler information. Assembler information.
  * @li Registers.
+ * @li Memory. Pages of the inferior's memory.
+ * @li Source files. Index of the source files of the program.
  *
  * @todo Split in several files?
  */
@@ -46,6 +48,27 @@
 #define BP_TYPE_BREAKPOINT 0
 #define BP_TYPE_WATCHPOINT 1
 
+/** @name Register value types. */
+/*@{*/
+#define DATA_REG_NONE 0	  /**< No value yet. */
+#define DATA_REG_INT 1	  /**< An integer value. */
+#define DATA_REG_VECTOR 2 /**< Vector lanes. */
+#define DATA_REG_STRING 3 /**< A value that could not be parsed. */
+/*@}*/
+
+/** The address of a function without instructions. */
+#define ASM_NO_ADDRESS ((uint64_t) -1)
+
+/** @name Memory pages. */
+/*@{*/
+#define MEM_PAGE_SIZE 4096 /**< Size of a cached memory page. */
+#define MEM_PAGE_PENDING 0 /**< The page has been requested. */
+#define MEM_PAGE_READ 1	   /**< The page has been read. */
+#define MEM_PAGE_STALE 2   /**< The page must be read again. */
+/** 1 if byte @a i of @a page has been read. */
+#define MEM_PAGE_VALID(page, i) (((page)->valid[(i) / 8] >> ((i) % 8)) & 1)
+/*@}*/
+
 /*******************************************************************************
  * Structures
  ******************************************************************************/
@@ -68,7 +91,7 @@ typedef struct breakpoint_t
 	      */
   int disp;    /**< Disposition, keep or delete. */
   int enabled; /**< Enabled. */
-  int addr;    /**< The address of the breakpoint. */
+  uint64_t addr; /**< The address of the breakpoint. */
   char *func;  /**< The function where the breakpoint is located. */
   char *file;  /**< The file where the breakpoint is located. */
   char *fullname; /**< The full filename. */
@@ -103,7 +126,9 @@ typedef struct breakpoint_table_t
  * @name Library.
  *
  * Structure to hold the currently loaded libraries. The libraries are stored
- * in a list.
+ * in a table hashed on the library id, so load and unload events are handled
+ * without walking all loaded libraries. The libraries are also linked in a
+ * list, last loaded first, which is used when showing the libraries.
  */
 /*@{*/
 typedef struct library_t
@@ -114,7 +139,22 @@ typedef struct library_t
   int symbols_loaded; /**< Set to 1 if the symbols of the library are loaded. */
 
   struct library_t *next; /**< The next library. */
+  struct library_t *prev; /**< The previous library. */
 } library;
+
+/**
+ * Table of loaded libraries. Open addressing with linear probing, removed
+ * entries are marked with a tombstone until the table is rebuilt.
+ */
+typedef struct library_table_t
+{
+  library **slots; /**< The hash slots, NULL if empty. */
+  int size;	   /**< Number of slots, always a power of 2. */
+  int count;	   /**< Number of libraries in the table. */
+  int tombstones;  /**< Number of slots holding a tombstone. */
+
+  library *first;  /**< The last loaded library. */
+} library_table;
 /*@}*/
 
 /**
@@ -124,23 +164,55 @@ typedef struct library_t
  * thread.
  */
 /*@{*/
-/**Holds either an argument or a local variable. */
+/**
+ * Holds either an argument or a local variable. A variable can be backed by
+ * a variable object in the debugger, which lets the variable be expanded into
+ * its children. The children are only fetched when the variable is expanded.
+ */
 typedef struct variable_t
 {
-  char *name;  /**< The variable's name. */
+  char *name;  /**< The variable's name, or the expression of a child. */
   char *type;  /**< The type of the variable. */
   char *value; /**< The variable's value. */
 
+  int id;	  /**< Unique id of the variable. */
+  char *var_name; /**< The variable object, NULL if not created. */
+  int numchild;	  /**< The number of children, -1 if not known. */
+  int expanded;	  /**< 1 if the children should be shown. */
+  int changed;	  /**< 1 if the value changed at the last update. */
+  struct variable_t *children; /**< The fetched children. */
+
   struct variable_t *next; /**< Next variable. */
 } variable;
 
+/**
+ * The variables of a frame, kept between stops. The variables are backed by
+ * variable objects which the debugger updates, so the values do not have to
+ * be listed again for every stop. A scope is identified by the thread, the
+ * function and the height of the frame, i.e. the number of frames below it.
+ */
+typedef struct scope_t
+{
+  int thread_id; /**< The thread of the frame. */
+  int height;	 /**< The number of frames below the frame. */
+  char *func;	 /**< The function of the frame. */
+  variable *args; /**< List of arguments. */
+  variable *variables; /**< List of variables. */
+
+  struct scope_t *next; /**< Next scope. */
+} scope;
+
 /** The information of a frame. */
 typedef struct frame_t
 {
-  int addr;   /**< The address of the frame's function. */
+  uint64_t addr; /**< The address of the frame's function. */
   char *func; /**< The function for the frame. */
   variable *args; /**< List of arguments for the function. */
   variable *variables; /**< List of variables. */
+  scope *scope; /**<
+                 * The scope owning @a args and @a variables, or NULL if the
+                 * lists are owned by the frame.
+                 */
   char *file; /**< The current file of the function. */
   char *fullname; /**< Fullname of the file. */
   int line; /**< Line number of the current position. */
@@ -158,6 +230,13 @@ typedef struct stack_t
 
   int max_depth; /**< The available depth of the stack. */
   frame *stack;	 /**< A set of frames in the stack. */
+
+  int total_depth; /**<
+                    * The depth of the stack reported by the debugger, or -1
+                    * if not known. Only the first @a depth frames are
+                    * fetched.
+                    */
+  int appended;	   /**< 1 if the last frames parsed were added to the end. */
 } stack;
 /*@}*/
 
@@ -191,56 +270,56 @@ typedef struct thread_group_t
 /**
  * @name Assembler.
  *
- * The assembler lines when the front end is in disassembly mode. A set of
- * assembler lines belongs to one source line.
+ * The disassembled functions when the front end is in disassembly mode. Each
+ * function keeps its instructions in one array sorted by address. The
+ * functions are cached in the @a assembler, sorted by start address, so a
+ * function only has to be disassembled once.
  */
 /*@{*/
 /**
- * Structure for a single line. The assembler lines are grouped to a source
- * line.
+ * Structure for a single instruction.
  */
 typedef struct asm_line_t
 {
-  int address; /**< The address of the line. */
+  uint64_t address; /**< The address of the line. */
   int offset; /**< The offset from the function start. */
+  int line_nr; /**< The source line number of the instruction. */
+  int row;     /**< The row of the instruction in the disassemble window. */
   char *inst; /**< The assembler instruction. */
-  int size;   /**< Size of the instruction. */
-
-  struct asm_line_t *next; /**<
-			    * The next instruction belonging to the same
-			    * source line.
-			    */
 } asm_line;
 
 /**
- * The source line which could have several assembler lines.
+ * A disassembled function.
  */
-typedef struct src_line_t
+typedef struct asm_function_t
 {
-  int line_nr; /**< The source line number. */
+  char *function; /**< The name of the function. */
+  char *file;	  /**< The file for the function. */
+  uint64_t address; /**<
+		     * The start address of the function, #ASM_NO_ADDRESS
+		     * without instructions.
+		     */
+  uint64_t end;	    /**< The address of the last instruction. */
   asm_line *lines; /**<
-		    * A list of assembler line belonging to the source line.
+		    * The instructions sorted by address, the index from
+		    * address to window row.
 		    */
-  asm_line *last; /**< The last assembler line that we know of. */
-
-  struct src_line_t *next; /**< The next source line. */
-} src_line;
+  int nr_lines;	   /**< Number of instructions. */
+  int size;	   /**< Allocated size of @a lines. */
+  int *src_lines;  /**< The source line numbers, sorted. */
+  int nr_src_lines; /**< Number of source lines. */
+  int src_size;	    /**< Allocated size of @a src_lines. */
+  int last_used;    /**< When the function was last looked up. */
+} asm_function;
 
 /**
- * The object of all source and assembler lines. */
+ * The cache of disassembled functions.
+ */
 typedef struct assembler_t
 {
-  char *function; /**< The function where the lines are located. */
-  char *file;	  /**< The file for the function. */
-  src_line *lines; /**< A list of source lines. */
-  int address; /**< The address of the function. */
-  src_line *current_line; /**< The current source line. */
-
-  int size; /**< Size of function. */
-  int file_size; /**< Size of the file name. */
-
-  asm_line *pool; /**< A pool of unused assembler lines. */
-  src_line *src_pool; /**< A pool of unused source lines. */
+  asm_function **functions; /**< The functions, sorted by start address. */
+  int nr_functions; /**< Number of cached functions. */
+  int clock; /**< Counter used for finding the least recently used. */
 } assembler;
 /*@}*/
 
@@ -256,22 +335,20 @@ typedef struct assembler_t
 typedef struct data_reg_t
 {
   char *reg_name; /**< The register's name. */
+  int name_len;	  /**< The length of the name. */
   int type; /**<
-	     * Type of register. Note: Only type 2 string is used for the
-	     * moment.
+	     * Type of the value, #DATA_REG_NONE, #DATA_REG_INT,
+	     * #DATA_REG_VECTOR or #DATA_REG_STRING.
 	     */
-  union
-  {
-    uint64_t u64;      /**< The unsigned 64 bit value. */
-    uint64_t u128[2];  /**< The 128 bit value. */
-    char *svalue;      /**< The corresponding string, e.g. 0x00. */
-  };
-  int changed;	/**<
-		 * Not used, but 1 if the register has changed value and
-		 * needs to be updated.
-		 */
-
-  int size; /**< Size of the name. */
+  uint64_t u64;	     /**< The value of an integer register. */
+  uint64_t *lanes;   /**< The lanes of a vector register. */
+  int nr_lanes;	     /**< Number of lanes in use. */
+  int lanes_size;    /**< Allocated number of lanes. */
+  char *svalue;	     /**< A value that is not a number, e.g. <unavailable>. */
+  int size; /**< Size of svalue. */
+  char *fvalue; /**< The cached formatted value. */
+  int fsize;	/**< Size of fvalue. */
+  int flen;	/**< Length of fvalue, -1 if it must be formatted again. */
 } data_reg;
 
 /**
@@ -282,11 +359,173 @@ typedef struct data_registers_t
   data_reg *registers; /**< The registers. */
   int len; /**< Number of registers in use. */
   int size; /**< The available size of the table. */
+  uint32_t *changed; /**<
+		      * Bitmap of the registers that changed at the last
+		      * stop.
+		      */
 
   int pc; /**< Pc register, not in use. */
 } data_registers;
 /*@}*/
 
+/**
+ * @name Memory.
+ *
+ * The memory shown in the memory window. The memory is read a page at the
+ * time and the pages are cached in @a mem_cache, sorted by address. Stale
+ * pages keep their bytes until they have been read again.
+ */
+/*@{*/
+/**
+ * A page of memory.
+ */
+typedef struct mem_page_t
+{
+  uint64_t address; /**< The address of the page, page aligned. */
+  int state; /**<
+	      * #MEM_PAGE_PENDING, #MEM_PAGE_READ or #MEM_PAGE_STALE.
+	      */
+  int last_used; /**< When the page was last looked up. */
+  unsigned char data[MEM_PAGE_SIZE]; /**< The bytes of the page. */
+  unsigned char valid[MEM_PAGE_SIZE / 8]; /**< Bitmap of the read bytes. */
+} mem_page;
+
+/**
+ * The cache of memory pages.
+ */
+typedef struct mem_cache_t
+{
+  mem_page **pages; /**< The pages, sorted by address. */
+  int nr_pages;	    /**< Number of cached pages. */
+  int clock; /**< Counter used for finding the least recently used. */
+  uint64_t start;  /**< The start of the shown region. */
+  uint64_t length; /**< The length of the shown region, 0 if none. */
+} mem_cache;
+/*@}*/
+
+/**
+ * @name Source files.
+ *
+ * The source files of the debugged program. Each name is interned once in
+ * blocks that are never moved, and the names are kept sorted. The index is
+ * searched with an incremental fuzzy matcher, see file_index_match().
+ */
+/*@{*/
+/**
+ * A block of interned names.
+ */
+typedef struct file_block_t
+{
+  struct file_block_t *next; /**< The next block. */
+  int used;		     /**< Number of used bytes. */
+  int size;		     /**< Size of @a names. */
+  char names[];		     /**< The names. */
+} file_block;
+
+/**
+ * A name matching the current pattern.
+ */
+typedef struct file_match_t
+{
+  int name;  /**< Index of the name. */
+  int score; /**< How well the name matches, higher is better. */
+  int len;   /**< Length of the name. */
+} file_match;
+
+/**
+ * Index of source files.
+ */
+typedef struct file_index_t
+{
+  file_block *blocks; /**< The interned names. */
+  const char **slots; /**< Hash slots of the names, NULL if empty. */
+  int nr_slots;	      /**< Number of slots, always a power of 2. */
+  const char **names; /**< The names, sorted after file_index_sort(). */
+  int nr_names;	      /**< Number of names. */
+  int size;	      /**< Available size of @a names. */
+
+  file_match *matches; /**< Names matching @a pattern, best first. */
+  int nr_matches;      /**< Number of matches. */
+  char *pattern;       /**< The last matched pattern, NULL if none. */
+} file_index;
+/*@}*/
+
+/**
+ * @name Symbols.
+ *
+ * The functions of the debugged program, sorted by name. Each symbol is
+ * listed under the trigrams, three consecutive characters, of its name so a
+ * pattern only needs to be matched against the symbols that contain one of
+ * its trigrams, see symbol_index_match().
+ */
+/*@{*/
+/**
+ * A function.
+ */
+typedef struct symbol_entry_t
+{
+  const char *name; /**< The name, followed by the name in lower case. */
+  const char *file; /**< The source file, interned in the file index. */
+  int line;	    /**< The line of the definition. */
+  int len;	    /**< Length of @a name. */
+  uint64_t chars;   /**< A bit for each character in @a name. */
+} symbol_entry;
+
+/**
+ * Index of functions.
+ */
+typedef struct symbol_index_t
+{
+  file_block *blocks;	 /**< The symbol names. */
+  file_index *files;	 /**< The source files of the symbols. */
+  symbol_entry *symbols; /**< The symbols, sorted after symbol_index_sort(). */
+  int nr_symbols;	 /**< Number of symbols. */
+  int size;		 /**< Available size of the symbol arrays. */
+
+  int *trigrams; /**<
+		  * Start of each trigram bucket in @a postings, NULL until
+		  * the symbols are sorted.
+		  */
+  int *postings; /**< The symbols of each trigram, in symbol order. */
+
+  int *hits;		  /**< Symbols matching @a pattern, in symbol order. */
+  unsigned char *scores;  /**< How well each hit matches, 0 is best. */
+  int nr_hits;		  /**< Number of hits. */
+  int *matches;		  /**< The hits, best first. */
+  char *pattern;	  /**< The last pattern in lower case, NULL if none. */
+} symbol_index;
+/*@}*/
+
+/**
+ * @name Records.
+ *
+ * The raw records from the debugger, in the order they were received. The
+ * records are copied once into an append-only arena of blocks, see
+ * record_log_add().
+ */
+/*@{*/
+/**
+ * A record.
+ */
+typedef struct record_entry_t
+{
+  const char *text; /**< The record, in the arena. */
+  int len;	    /**< Length of @a text. */
+  int expanded;	    /**< 1 if the record is shown as a whole. */
+} record_entry;
+
+/**
+ * The records.
+ */
+typedef struct record_log_t
+{
+  file_block *blocks;	 /**< The arena. */
+  record_entry *records; /**< The records. */
+  int nr_records;	 /**< Number of records. */
+  int size;		 /**< Available size of @a records. */
+} record_log;
+/*@}*/
+
 /*******************************************************************************
  * Public functions
  ******************************************************************************/
@@ -310,11 +549,13 @@ int thread_set_running (thread_group * head, int group_id, int thread_id,
 			int running, int core);
 void thread_clear (thread * pt);
 
-int library_add (library ** head, const char *id, const char *target,
+library_table *library_table_create (void);
+void library_table_free (library_table * lt);
+int library_add (library_table * lt, const char *id, const char *target,
 		 const char *host, int loaded);
-void library_remove (library ** head, const char *id, const char *target,
+void library_remove (library_table * lt, const char *id, const char *target,
 		     const char *name);
-void library_remove_all (library ** head);
+void library_remove_all (library_table * lt);
 
 stack *stack_create (int depth);
 void stack_free (stack * stack);
@@ -323,12 +564,32 @@ void stack_clean_frame (stack * stack, int level);
 int frame_insert_variable (frame * frame, char *name, char *type, char *value,
 			   int var, int back);
 void variable_delete_list (variable * var_list);
+variable *variable_find (variable * var_list, int id);
+variable *variable_find_object (variable * var_list, const char *var_name);
+variable *variable_find_parent (variable * var_list, const char *var_name);
+variable *variable_add_child (variable * parent, const char *name,
+			      const char *var_name, const char *type,
+			      const char *value, int numchild);
+void variable_merge_list (variable ** list, variable * fresh,
+			  variable ** removed);
+void variable_clear_changed (variable * var_list);
+
+scope *scope_get (scope ** scopes, int thread_id, int height,
+		  const char *func);
+void scope_remove (scope ** scopes, scope * s);
 
 assembler *ass_create (void);
 void ass_free (assembler * ass);
 void ass_reset (assembler * ass);
-int ass_add_line (assembler * ass, const char *file, const char *func,
-		  int line_nr, int address, int offset, const char *inst);
+asm_function *ass_insert (assembler * ass, asm_function * func);
+asm_function *ass_find (assembler * ass, uint64_t pc);
+asm_function *asm_function_create (const char *file);
+void asm_function_free (asm_function * func);
+int asm_function_add_line (asm_function * func, const char *name,
+			   int line_nr, uint64_t address, int offset,
+			   const char *inst);
+void asm_function_done (asm_function * func);
+asm_line *asm_function_find_line (asm_function * func, uint64_t pc);
 
 data_registers *data_registers_create (void);
 void data_registers_free (data_registers * registers);
@@ -338,5 +599,50 @@ int data_registers_set_value (data_registers * registers, int nr,
 			      uint64_t value);
 int data_registers_set_str_value (data_registers * registers, int nr,
 				  const char *value);
+int data_registers_set_lanes (data_registers * registers, int nr,
+			      const uint64_t * lanes, int nr_lanes);
+int data_registers_format (data_registers * registers, int nr, char *buf,
+			   int size);
+const char *data_registers_get_str (data_registers * registers, int nr,
+				    int *len);
+void data_registers_clear_changed (data_registers * registers);
+int data_registers_set_changed (data_registers * registers, int nr);
+int data_registers_is_changed (data_registers * registers, int nr);
 unsigned long int data_registers_get_pc (data_registers * registers);
+
+mem_cache *mem_cache_create (void);
+void mem_cache_free (mem_cache * cache);
+void mem_cache_reset (mem_cache * cache);
+void mem_cache_set_region (mem_cache * cache, uint64_t start,
+			   uint64_t length);
+void mem_cache_invalidate (mem_cache * cache, uint64_t address,
+			   uint64_t length);
+mem_page *mem_cache_find (mem_cache * cache, uint64_t address);
+int mem_cache_request (mem_cache * cache, uint64_t address);
+int mem_cache_set_bytes (mem_cache * cache, uint64_t address,
+			 const char *hex);
+
+file_index *file_index_create (void);
+void file_index_free (file_index * index);
+void file_index_reset (file_index * index);
+const char *file_index_add (file_index * index, const char *name);
+void file_index_sort (file_index * index);
+int file_index_match (file_index * index, const char *pattern);
+const char *file_index_get_match (file_index * index, int nr);
+
+symbol_index *symbol_index_create (void);
+void symbol_index_free (symbol_index * index);
+void symbol_index_reset (symbol_index * index);
+void symbol_index_add (symbol_index * index, const char *name,
+		       const char *file, int line);
+void symbol_index_sort (symbol_index * index);
+int symbol_index_match (symbol_index * index, const char *pattern);
+const char *symbol_index_get_match (symbol_index * index, int nr,
+				    const char **file, int *line);
+
+record_log *record_log_create (void);
+void record_log_free (record_log * log);
+int record_log_add (record_log * log, const char *record);
+const char *record_log_get (record_log * log, int nr, int *len);
+int record_log_toggle (record_log * log, int nr);
 #endif
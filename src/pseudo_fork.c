@@ -28,6 +28,9 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
+#include <fcntl.h>
+
+#include "debug.h"
 
 #define FORK_SHELL "/bin/sh"
 #define FORK_COMMAND "sh"
@@ -109,3 +112,44 @@ start_forkpty (int *fd, pid_t * cpid, char *debugger, char **args)
 
   return 0;
 }
+
+/**
+ * @brief Open a pseudo terminal for the program that is debugged.
+ *
+ * The debugger is told to use the slave as the terminal of the program, so
+ * the output of the program is read from the master instead of being mixed
+ * with the records of the debugger. The slave is kept open so reading the
+ * master does not fail while no program is running.
+ *
+ * @param fd Set to the master, non blocking. -1 upon failure.
+ * @param slave_fd Set to the slave. -1 upon failure.
+ * @param name Set to the name of the slave.
+ * @param size The size of @a name.
+ *
+ * @return 0 if the terminal was opened, otherwise -1.
+ */
+int
+open_pty (int *fd, int *slave_fd, char *name, int size)
+{
+  if (openpty (fd, slave_fd, NULL, NULL, NULL) < 0)
+    {
+      *fd = -1;
+      *slave_fd = -1;
+      LOG_ERR ("Could not open a pseudo terminal: %m");
+      return -1;
+    }
+  if (ttyname_r (*slave_fd, name, size) != 0
+      || fcntl (*fd, F_SETFL, fcntl (*fd, F_GETFL) | O_NONBLOCK) < 0)
+    {
+      LOG_ERR ("Could not set up the pseudo terminal: %m");
+      close (*fd);
+      close (*slave_fd);
+      *fd = -1;
+      *slave_fd = -1;
+      return -1;
+    }
+  fcntl (*fd, F_SETFD, FD_CLOEXEC);
+  fcntl (*slave_fd, F_SETFD, FD_CLOEXEC);
+
+  return 0;
+}
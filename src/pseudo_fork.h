@@ -32,4 +32,5 @@
  * Public functions
  ******************************************************************************/
 int start_forkpty (int *fd, pid_t * cpid, char *debugger, char **args);
+int open_pty (int *fd, int *slave_fd, char *name, int size);
 #endif
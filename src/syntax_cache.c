@@ -0,0 +1,418 @@
+/* A simple front end debugger.
+   Copyright (C) 2012 Kenneth Olsson
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file syntax_cache.c
+ *
+ * @brief The implementation of the cache of scanned source files.
+ *
+ * Each source file has its own cache file in $XDG_CACHE_HOME/lvdbg, or
+ * ~/.cache/lvdbg, named after a hash of the file name. A cache file is only
+ * used if the path, modification time and size of the source file and the
+ * hash of the syntax definitions all are the same as when it was written.
+ * The cache file is mapped and has the layout:
+ *
+ * @code
+ * cache_header
+ * the path of the source file, padded to 4 bytes
+ * uint32_t start[nr_lines + 1], the first span of each line
+ * id_entry spans[nr_spans]
+ * @endcode
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "syntax_cache.h"
+#include "debug.h"
+
+#define SYNTAX_CACHE_MAGIC "lvdbgsc1" /**< Identifies a cache file. */
+#define SYNTAX_CACHE_PATH_LEN 1024     /**< Max length of a cache path. */
+
+/*******************************************************************************
+ * Internal structures and enums
+ ******************************************************************************/
+/** The start of a cache file. */
+typedef struct cache_header_t
+{
+  char magic[8];       /**< SYNTAX_CACHE_MAGIC, not terminated. */
+  uint64_t syntax;     /**< Hash of the syntax definitions. */
+  int64_t mtime;       /**< Modification time of the file, seconds. */
+  int64_t mtime_nsec;  /**< Modification time of the file, nanoseconds. */
+  int64_t size;	       /**< Size of the file. */
+  uint32_t path_len;   /**< Length of the path of the file. */
+  uint32_t nr_lines;   /**< Number of lines. */
+  uint32_t nr_spans;   /**< Number of spans. */
+  uint32_t reserved;   /**< Always 0. */
+} cache_header;
+
+/** A mapped cache file. */
+struct syntax_cache_t
+{
+  void *map;		    /**< The mapped file. */
+  size_t size;		    /**< Size of @a map. */
+  const cache_header *header; /**< The header. */
+  const uint32_t *start;      /**< The first span of each line. */
+  const id_entry *spans;      /**< The spans. */
+};
+
+/*******************************************************************************
+ * Internal functions
+ ******************************************************************************/
+/**
+ * @brief Hash a string, FNV-1a.
+ *
+ * @param str The string.
+ *
+ * @return The hash.
+ */
+static uint64_t
+syntax_cache_hash_string (const char *str)
+{
+  uint64_t hash = 14695981039346656037ULL;
+
+  while (*str != '\0')
+    {
+      hash ^= (unsigned char) *str++;
+      hash *= 1099511628211ULL;
+    }
+
+  return hash;
+}
+
+/**
+ * @brief Get the path of the cache file of a source file.
+ *
+ * @param file_name The source file.
+ * @param path Set to the path.
+ * @param size The size of @a path.
+ * @param create If 1 the cache directory is created if needed.
+ *
+ * @return 0 upon success, -1 if there is no cache directory.
+ */
+static int
+syntax_cache_path (const char *file_name, char *path, int size, int create)
+{
+  const char *base;
+  const char *sub = "lvdbg";
+  int len;
+
+  base = getenv ("XDG_CACHE_HOME");
+  if (base == NULL || *base != '/')
+    {
+      base = getenv ("HOME");
+      sub = ".cache/lvdbg";
+      if (base == NULL || *base == '\0')
+	{
+	  return -1;
+	}
+    }
+
+  len = snprintf (path, size, "%s/%s", base, sub);
+  if (len >= size)
+    {
+      return -1;
+    }
+  if (create)
+    {
+      if (strcmp (sub, "lvdbg") != 0)
+	{
+	  path[len - strlen ("/lvdbg")] = '\0';
+	  mkdir (path, 0700);
+	  path[len - strlen ("/lvdbg")] = '/';
+	}
+      if (mkdir (path, 0700) < 0 && errno != EEXIST)
+	{
+	  DINFO (1, "Could not create '%s': %s", path, strerror (errno));
+	  return -1;
+	}
+    }
+
+  len = snprintf (path + len, size - len, "/%016" PRIx64,
+		  syntax_cache_hash_string (file_name));
+
+  return len < 0 || len >= size ? -1 : 0;
+}
+
+/**
+ * @brief Get the offset of the start array.
+ *
+ * @param path_len The length of the path.
+ *
+ * @return The offset.
+ */
+static size_t
+syntax_cache_start_offset (uint32_t path_len)
+{
+  return sizeof (cache_header) + ((path_len + 3) & ~3U);
+}
+
+/*******************************************************************************
+ * Public functions
+ ******************************************************************************/
+/**
+ * @brief Hash the syntax definitions.
+ *
+ * @param definitions The definitions of the scanner.
+ *
+ * @return The hash.
+ */
+uint64_t
+syntax_cache_hash (const char *definitions)
+{
+  assert (definitions);
+
+  return syntax_cache_hash_string (definitions);
+}
+
+/**
+ * @brief Open the cache of a file.
+ *
+ * @param file_name The source file.
+ * @param syntax The hash of the syntax definitions.
+ *
+ * @return The cache or NULL if the file is not cached or the cache is
+ * out of date.
+ */
+syntax_cache *
+syntax_cache_open (const char *file_name, uint64_t syntax)
+{
+  char path[SYNTAX_CACHE_PATH_LEN];
+  syntax_cache *cache;
+  const cache_header *h;
+  struct stat file_st;
+  struct stat st;
+  void *map;
+  size_t size;
+  int fd;
+
+  assert (file_name);
+
+  if (stat (file_name, &file_st) < 0
+      || syntax_cache_path (file_name, path, sizeof (path), 0) < 0)
+    {
+      return NULL;
+    }
+
+  fd = open (path, O_RDONLY);
+  if (fd < 0)
+    {
+      DINFO (1, "No cache of '%s'", file_name);
+      return NULL;
+    }
+  if (fstat (fd, &st) < 0 || st.st_size < (off_t) sizeof (cache_header))
+    {
+      close (fd);
+      return NULL;
+    }
+  map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (map == MAP_FAILED)
+    {
+      return NULL;
+    }
+
+  /* The same file, unchanged and scanned with the same definitions. */
+  h = (const cache_header *) map;
+  size = syntax_cache_start_offset (h->path_len)
+    + ((size_t) h->nr_lines + 1) * sizeof (uint32_t)
+    + (size_t) h->nr_spans * sizeof (id_entry);
+  if (memcmp (h->magic, SYNTAX_CACHE_MAGIC, sizeof (h->magic)) != 0
+      || h->syntax != syntax || h->mtime != (int64_t) file_st.st_mtim.tv_sec
+      || h->mtime_nsec != (int64_t) file_st.st_mtim.tv_nsec
+      || h->size != (int64_t) file_st.st_size
+      || h->path_len != strlen (file_name) || size != (size_t) st.st_size
+      || memcmp ((const char *) map + sizeof (*h), file_name,
+		 h->path_len) != 0)
+    {
+      DINFO (1, "The cache of '%s' is out of date", file_name);
+      munmap (map, st.st_size);
+      return NULL;
+    }
+
+  cache = (syntax_cache *) malloc (sizeof (*cache));
+  LOG_ERR_IF_FATAL (cache == NULL, ERR_MSG_CREATE ("syntax cache"));
+  cache->map = map;
+  cache->size = st.st_size;
+  cache->header = h;
+  cache->start = (const uint32_t *) ((const char *) map +
+				     syntax_cache_start_offset (h->path_len));
+  cache->spans = (const id_entry *) (cache->start + h->nr_lines + 1);
+
+  return cache;
+}
+
+/**
+ * @brief Close a cache.
+ *
+ * @param cache The cache.
+ */
+void
+syntax_cache_close (syntax_cache * cache)
+{
+  assert (cache);
+
+  munmap (cache->map, cache->size);
+  free (cache);
+}
+
+/**
+ * @brief Get the number of lines of the cached file.
+ *
+ * @param cache The cache.
+ *
+ * @return The number of lines.
+ */
+int
+syntax_cache_nr_of_lines (syntax_cache * cache)
+{
+  assert (cache);
+
+  return cache->header->nr_lines;
+}
+
+/**
+ * @brief Get the ids of a line.
+ *
+ * @param cache The cache.
+ * @param line The line.
+ * @param len Set to the number of ids.
+ *
+ * @return The ids, valid until the cache is closed. NULL if the line is not
+ * in the cache.
+ */
+const id_entry *
+syntax_cache_get_line (syntax_cache * cache, int line, int *len)
+{
+  assert (cache);
+  assert (len);
+
+  if (line < 0 || line >= (int) cache->header->nr_lines
+      || cache->start[line] > cache->start[line + 1]
+      || cache->start[line + 1] > cache->header->nr_spans)
+    {
+      return NULL;
+    }
+
+  *len = cache->start[line + 1] - cache->start[line];
+  return cache->spans + cache->start[line];
+}
+
+/**
+ * @brief Store the ids of a file.
+ *
+ * The cache is written to a temporary file that replaces the old cache, so
+ * a cache being read is never changed.
+ *
+ * @param file_name The source file.
+ * @param syntax The hash of the syntax definitions.
+ * @param nr_of_lines The number of lines.
+ * @param get_line Gets the ids of a line.
+ * @param data Passed to @a get_line.
+ *
+ * @return 0 upon success, otherwise -1.
+ */
+int
+syntax_cache_store (const char *file_name, uint64_t syntax,
+		    int nr_of_lines, syntax_cache_line_func get_line,
+		    void *data)
+{
+  char path[SYNTAX_CACHE_PATH_LEN];
+  char tmp[SYNTAX_CACHE_PATH_LEN + 32];
+  const char pad[4] = { 0 };
+  cache_header h;
+  const id_table *ids;
+  struct stat st;
+  uint32_t start;
+  FILE *file;
+  int ret = 0;
+  int i;
+  int j;
+
+  assert (file_name);
+  assert (get_line);
+
+  if (stat (file_name, &st) < 0
+      || syntax_cache_path (file_name, path, sizeof (path), 1) < 0)
+    {
+      return -1;
+    }
+  snprintf (tmp, sizeof (tmp), "%s.%d", path, (int) getpid ());
+  file = fopen (tmp, "w");
+  LOG_ERR_IF_RETURN (file == NULL, -1, "Could not create '%s': %s", tmp,
+		     strerror (errno));
+
+  memset (&h, 0, sizeof (h));
+  memcpy (h.magic, SYNTAX_CACHE_MAGIC, sizeof (h.magic));
+  h.syntax = syntax;
+  h.mtime = st.st_mtim.tv_sec;
+  h.mtime_nsec = st.st_mtim.tv_nsec;
+  h.size = st.st_size;
+  h.path_len = strlen (file_name);
+  h.nr_lines = nr_of_lines;
+  for (i = 0; i < nr_of_lines; i++)
+    {
+      h.nr_spans += get_line (data, i)->len;
+    }
+
+  if (fwrite (&h, sizeof (h), 1, file) != 1
+      || fwrite (file_name, 1, h.path_len, file) != h.path_len
+      || fwrite (pad, 1, -h.path_len & 3, file) != (-h.path_len & 3))
+    {
+      ret = -1;
+    }
+  start = 0;
+  for (i = 0; i <= nr_of_lines && ret == 0; i++)
+    {
+      if (fwrite (&start, sizeof (start), 1, file) != 1)
+	{
+	  ret = -1;
+	}
+      if (i < nr_of_lines)
+	{
+	  start += get_line (data, i)->len;
+	}
+    }
+  for (i = 0; i < nr_of_lines && ret == 0; i++)
+    {
+      ids = get_line (data, i);
+      for (j = 0; j < ids->len && ret == 0; j++)
+	{
+	  if (fwrite (id_table_get (ids, j), sizeof (id_entry), 1, file) != 1)
+	    {
+	      ret = -1;
+	    }
+	}
+    }
+
+  if (fclose (file) != 0 || ret < 0 || rename (tmp, path) < 0)
+    {
+      LOG_ERR ("Could not write '%s': %s", path, strerror (errno));
+      unlink (tmp);
+      return -1;
+    }
+
+  DINFO (1, "Cached %d spans of '%s'", h.nr_spans, file_name);
+  return 0;
+}
@@ -0,0 +1,60 @@
+/* A simple front end debugger.
+   Copyright (C) 2012 Kenneth Olsson
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file syntax_cache.h
+ *
+ * @brief Interface for the cache of scanned source files.
+ *
+ * The highlighting of a source file is stored on disk, so the file does not
+ * have to be scanned again the next time it is loaded.
+ */
+#ifndef SYNTAX_CACHE_H
+#define SYNTAX_CACHE_H
+
+#include <stdint.h>
+
+#include "vsscanner.h"
+
+/*******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+typedef struct syntax_cache_t syntax_cache;
+
+/**
+ * @brief Get the scanned ids of a line, used when storing a file.
+ *
+ * @param data The data given to syntax_cache_store().
+ * @param line The line.
+ *
+ * @return The ids of the line.
+ */
+typedef const id_table *(*syntax_cache_line_func) (void *data, int line);
+
+/*******************************************************************************
+ * Public functions
+ ******************************************************************************/
+uint64_t syntax_cache_hash (const char *definitions);
+syntax_cache *syntax_cache_open (const char *file_name, uint64_t syntax);
+void syntax_cache_close (syntax_cache * cache);
+int syntax_cache_nr_of_lines (syntax_cache * cache);
+const id_entry *syntax_cache_get_line (syntax_cache * cache, int line,
+				       int *len);
+int syntax_cache_store (const char *file_name, uint64_t syntax,
+			int nr_of_lines, syntax_cache_line_func get_line,
+			void *data);
+#endif
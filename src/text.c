@@ -45,6 +45,7 @@ typedef struct Line_t
 {
   char *line; /**< The text string on the line. */
   int len;    /**< The length of the text line. */
+  int size;   /**< The allocated size of @a line. */
 } Line;
 
 /** The structure for the whole text. */
@@ -56,6 +57,19 @@ struct text_t
   int tab_size;	   /**< The tabsize used when converting tabs '\\t' to spaces.*/
 };
 
+/**
+ * @brief A search pattern.
+ *
+ * The pattern is searched for with Boyer-Moore-Horspool, one byte patterns
+ * with memchr.
+ */
+struct text_pattern_t
+{
+  char *pattern; /**< The pattern. */
+  int len;	 /**< The length of the pattern. */
+  int skip[256]; /**< How far to shift on a mismatch, per last byte. */
+};
+
 /*******************************************************************************
  * Public Functions
  ******************************************************************************/
@@ -90,6 +104,7 @@ text_create ()
     {
       new_text->lines[i].len = -1;
       new_text->lines[i].line = NULL;
+      new_text->lines[i].size = 0;
     }
 
   return new_text;
@@ -213,26 +228,25 @@ error:
 }
 
 /**
- * @brief Add a text line to the text.
+ * @brief Copy a text line.
  *
- * Add a line of text to the text obejct.
+ * Copy a line of text, converting tabs to spaces, into a text line. The text
+ * line's buffer is reused if it is large enough.
  *
  * @param text The text object.
- * @param line The line of text to be added.
+ * @param l The text line.
+ * @param line The line of text.
  *
- * @return The number of lines in the text object. -1 if failed to add the
- *         line.
+ * @return The length of the line. -1 if the line is not printable.
  */
-int
-text_add_line (text * text, const char *line)
+static int
+text_copy_line (text * text, Line * l, const char *line)
 {
   int len;
   const char *r;
   char *w;
   int i;
 
-  assert (text);
-
   len = 0;
   r = line;
   while (*r != '\0' && strchr ("\r\n", *r) == NULL)
@@ -257,21 +271,17 @@ text_add_line (text * text, const char *line)
    * Check if we already has room for the line, otherwise allocate a new line
    * with enought space.
    */
-  if (text->lines[text->nr_of_lines].line != NULL
-      && sizeof (text->lines[text->nr_of_lines].line) >= len)
+  if (l->line == NULL || l->size < len + 1)
     {
-      w = text->lines[text->nr_of_lines].line;
-    }
-  else
-    {
-      if (text->lines[text->nr_of_lines].line != NULL)
+      if (l->line != NULL)
 	{
-	  free (text->lines[text->nr_of_lines].line);
+	  free (l->line);
 	}
-      w = (char *) malloc (len + 1);
-      LOG_ERR_IF_FATAL (w == NULL, ERR_MSG_CREATE ("line"));
-      text->lines[text->nr_of_lines].line = w;
+      l->line = (char *) malloc (len + 1);
+      LOG_ERR_IF_FATAL (l->line == NULL, ERR_MSG_CREATE ("line"));
+      l->size = len + 1;
     }
+  w = l->line;
   r = line;
   while (*r != '\0' && strchr ("\r\n", *r) == NULL)
     {
@@ -291,8 +301,36 @@ text_add_line (text * text, const char *line)
       r++;
     }
   *w = '\0';
+  l->len = len;
+
+  return len;
+}
+
+/**
+ * @brief Add a text line to the text.
+ *
+ * Add a line of text to the text obejct.
+ *
+ * @param text The text object.
+ * @param line The line of text to be added.
+ *
+ * @return The number of lines in the text object. -1 if failed to add the
+ *         line.
+ */
+int
+text_add_line (text * text, const char *line)
+{
+  int len;
+  int i;
+
+  assert (text);
+
+  len = text_copy_line (text, &text->lines[text->nr_of_lines], line);
+  if (len < 0)
+    {
+      return -1;
+    }
 
-  text->lines[text->nr_of_lines].len = len;
   DINFO (4, "Added line nr %d of length %d: '%s",
 	 text->nr_of_lines,
 	 text->lines[text->nr_of_lines].len,
@@ -310,12 +348,36 @@ text_add_line (text * text, const char *line)
 	{
 	  text->lines[i].len = -1;
 	  text->lines[i].line = NULL;
+	  text->lines[i].size = 0;
 	}
     }
 
   return text->nr_of_lines;
 }
 
+/**
+ * @brief Replace a text line.
+ *
+ * Replace the text of an existing line.
+ *
+ * @param text The text object.
+ * @param nr The line number.
+ * @param line The new line of text.
+ *
+ * @return The length of the new line. -1 if failed to set the line.
+ */
+int
+text_set_line (text * text, int nr, const char *line)
+{
+  assert (text);
+  assert (line);
+
+  LOG_ERR_IF_RETURN (nr < 0 || nr >= text->nr_of_lines, -1,
+		     "Line %d out of bounds", nr);
+
+  return text_copy_line (text, &text->lines[nr], line);
+}
+
 /**
  * @brief Retrieve a text line.
  *
@@ -392,3 +454,195 @@ text_dump (text * text)
       fprintf (stdout, "%s\r\n", text->lines[i].line);
     }
 }
+
+/**
+ * @brief Create a search pattern.
+ *
+ * @param pattern The string to search for. Must not be empty.
+ *
+ * @return The new pattern.
+ */
+text_pattern *
+text_pattern_create (const char *pattern)
+{
+  text_pattern *p;
+  int i;
+
+  assert (pattern);
+  assert (*pattern);
+
+  p = (text_pattern *) malloc (sizeof (*p));
+  LOG_ERR_IF_FATAL (p == NULL, ERR_MSG_CREATE ("pattern"));
+  p->pattern = strdup (pattern);
+  LOG_ERR_IF_FATAL (p->pattern == NULL, ERR_MSG_CREATE ("pattern"));
+  p->len = strlen (pattern);
+
+  for (i = 0; i < 256; i++)
+    {
+      p->skip[i] = p->len;
+    }
+  for (i = 0; i < p->len - 1; i++)
+    {
+      p->skip[(unsigned char) pattern[i]] = p->len - 1 - i;
+    }
+
+  return p;
+}
+
+/**
+ * @brief Free a search pattern.
+ *
+ * @param pattern The pattern.
+ */
+void
+text_pattern_free (text_pattern * pattern)
+{
+  assert (pattern);
+
+  free (pattern->pattern);
+  free (pattern);
+}
+
+/**
+ * @brief Get the string of a search pattern.
+ *
+ * @param pattern The pattern.
+ * @param len Set to the length of the string, if not NULL.
+ *
+ * @return The string searched for.
+ */
+const char *
+text_pattern_get (text_pattern * pattern, int *len)
+{
+  assert (pattern);
+
+  if (len != NULL)
+    {
+      *len = pattern->len;
+    }
+  return pattern->pattern;
+}
+
+/**
+ * @brief Find a pattern in a string.
+ *
+ * @param pattern The pattern.
+ * @param str The string to search.
+ * @param len The length of @a str.
+ *
+ * @return The first match or NULL if not found.
+ */
+const char *
+text_pattern_find (text_pattern * pattern, const char *str, int len)
+{
+  const char *p;
+  const char *end;
+  unsigned char last;
+  int n;
+
+  assert (pattern);
+  assert (str);
+
+  n = pattern->len;
+  if (len < n)
+    {
+      return NULL;
+    }
+  if (n == 1)
+    {
+      return (const char *) memchr (str, pattern->pattern[0], len);
+    }
+
+  last = pattern->pattern[n - 1];
+  end = str + len - n;
+  p = str;
+  while (p <= end)
+    {
+      if ((unsigned char) p[n - 1] == last
+	  && memcmp (p, pattern->pattern, n - 1) == 0)
+	{
+	  return p;
+	}
+      p += pattern->skip[(unsigned char) p[n - 1]];
+    }
+
+  return NULL;
+}
+
+/**
+ * @brief Find the next line matching a pattern.
+ *
+ * @param text The text.
+ * @param pattern The pattern.
+ * @param nr The first line to search.
+ * @param dir 1 to search forward, -1 to search backward.
+ *
+ * @return The number of the first matching line or -1 if none matches.
+ */
+int
+text_find (text * text, text_pattern * pattern, int nr, int dir)
+{
+  Line *l;
+
+  assert (text);
+  assert (pattern);
+
+  while (nr >= 0 && nr < text->nr_of_lines)
+    {
+      l = &text->lines[nr];
+      if (text_pattern_find (pattern, l->line, l->len) != NULL)
+	{
+	  return nr;
+	}
+      nr += dir;
+    }
+
+  return -1;
+}
+
+/**
+ * @brief Count the matches of a pattern.
+ *
+ * Count the non overlapping matches in the lines [@a nr, @a nr +
+ * @a nr_of_lines), and add them to @a count. Used for counting a large text
+ * a part at the time.
+ *
+ * @param text The text.
+ * @param pattern The pattern.
+ * @param nr The first line to count.
+ * @param nr_of_lines The max number of lines to count.
+ * @param count The number of matches is added to it.
+ *
+ * @return The next line to count.
+ */
+int
+text_count (text * text, text_pattern * pattern, int nr, int nr_of_lines,
+	    int *count)
+{
+  const char *p;
+  const char *end;
+  int stop;
+
+  assert (text);
+  assert (pattern);
+  assert (count);
+
+  stop = nr + nr_of_lines;
+  if (stop > text->nr_of_lines)
+    {
+      stop = text->nr_of_lines;
+    }
+  while (nr < stop)
+    {
+      p = text->lines[nr].line;
+      end = p + text->lines[nr].len;
+      while ((p = text_pattern_find (pattern, p, end - p)) != NULL)
+	{
+	  (*count)++;
+	  p += pattern->len;
+	}
+      nr++;
+    }
+
+  return nr;
+}
@@ -30,6 +30,7 @@
  * Typedefs
  ******************************************************************************/
 typedef struct text_t text;
+typedef struct text_pattern_t text_pattern;
 
 /*******************************************************************************
  * Public functions
@@ -39,8 +40,18 @@ text *text_load_file (const char *file_name);
 int text_update_from_file (text * text, const char *file_name);
 text *text_create ();
 int text_add_line (text * text, const char *line);
+int text_set_line (text * text, int nr, const char *line);
 const char *text_get_line (text * text, int nr, int *len);
 void text_clear (text * text);
 int text_nr_of_lines (text * text);
 void text_dump (text * text);
+
+text_pattern *text_pattern_create (const char *pattern);
+void text_pattern_free (text_pattern * pattern);
+const char *text_pattern_get (text_pattern * pattern, int *len);
+const char *text_pattern_find (text_pattern * pattern, const char *str,
+			       int len);
+int text_find (text * text, text_pattern * pattern, int nr, int dir);
+int text_count (text * text, text_pattern * pattern, int nr, int nr_of_lines,
+		int *count);
 #endif
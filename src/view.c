@@ -32,18 +32,41 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdarg.h>
+#include <time.h>
+#include <sys/ioctl.h>
 
 #include "view.h"
 #include "lvdbg.h"
 #include "configuration.h"
 #include "text.h"
 #include "win_handler.h"
+#include "file_loader.h"
 #include "debug.h"
 #include "objects.h"
 #include "misc.h"
 #include "lvdbg.h"
 
-#define LAST_WINDOW WIN_REGISTERS
+#define LAST_WINDOW WIN_MEMORY
+#define REG_VALUE_LEN 1024 /**< Max width of a register value column. */
+#define REG_LINE_LEN (2 * REG_VALUE_LEN + 128) /**< Max length of a row. */
+#define SEARCH_COUNT_LINES 4096 /**< Lines counted at the time when idle. */
+#define RECORD_ROW_LEN 512 /**< Max length of a row in the responses view. */
+#define MEM_MAX_BYTES 16 /**< Max number of bytes in a row of the memory view. */
+/**
+ * Size of a row with @a n bytes: the address and ": ", the hex, a space, the
+ * characters and the '\\0'.
+ */
+#define MEM_ROW_LEN(n) (4 * (n) + 20)
+#define REFRESH_MAX_QUEUE 4096 /**<
+                                * Max bytes waiting to be written to the
+                                * terminal before the screen is updated.
+                                */
+#define REFRESH_POLL 20000 /**< Microseconds between checks of the queue. */
+#define REFRESH_MAX_DELAY 250000 /**< Max microseconds between updates. */
+#define REFRESH_FACTOR 4 /**<
+                          * The time between updates in number of times the
+                          * time of the last update.
+                          */
 
 /*******************************************************************************
 * Internal structures and enums
@@ -86,6 +109,34 @@ struct view_t
   int view_mode; /**<
 		  * If set to 0, normal ncurse mode. 1 the ncurse is suspended.
                   */
+
+  int reg_len;	/**< Number of registers in the registers view. */
+  int reg_nlen;	/**< Width of the register names. */
+  int reg_vlen;	/**< Width of the register values. */
+  char *reg_marked; /**< 1 for the rows in the registers view marked '*'. */
+
+  mem_cache *memory; /**< The memory shown in the memory view. */
+  uint64_t mem_start; /**< The start of the shown region. */
+  uint64_t mem_top;   /**< The address of the top row. */
+  int mem_bytes;      /**< Number of bytes in a row. */
+  int mem_rows;	      /**< Number of rows in the memory view. */
+
+  record_log *responses; /**< The records shown in the responses view. */
+  int record_cols;	 /**< The width the records are truncated at. */
+
+  int stack_lines; /**< The number of frames in the stack window. */
+
+  char *layout;	 /**< The layout the windows were set up from. */
+  int resizing;	 /**< 1 while the windows are laid out again. */
+
+  int refresh_pending; /**< 1 if the screen lacks the last changes. */
+  uint64_t refresh_next; /**< Earliest time of the next screen update. */
+
+  file_loader *loader; /**< Loads the files of the main window, or NULL. */
+  char *load_name; /**< The file being loaded, NULL if none. */
+  int load_line;   /**< The line to show when @a load_name is loaded. */
+  int load_mark;   /**< 1 if the stop mark is set when it is loaded. */
+  breakpoint_table *breakpoints; /**< The breakpoints, NULL if none. */
 };
 
 /**
@@ -113,14 +164,15 @@ static struct view_windows out_windows[] = {
   {_("Console"), {0, 0, NULL, 0, NULL}},
   {_("Target"), {0, 0, NULL, 0, NULL}},
   {_("Log"), {0, 0, NULL, 0, NULL}},
-  {_("Responses"), {0, 0, NULL, 0, NULL}},
+  {_("Responses"), {0, WIN_PROP_CURSOR, NULL, 0, NULL}},
   {_("Breakpoints"), {0, WIN_PROP_CURSOR, NULL, 0, NULL}},
   {_("Threads"), {0, WIN_PROP_CURSOR, NULL, 0, NULL}},
   {_("Libraries"), {0, WIN_PROP_CURSOR, NULL, 0, NULL}},
   {_("Stack"), {0, WIN_PROP_CURSOR, NULL, 0, NULL}},
-  {_("Frame"), {0, WIN_PROP_CURSOR, NULL, 0, NULL}},
+  {_("Frame"), {1, WIN_PROP_CURSOR | WIN_PROP_MARKS, NULL, 0, NULL}},
   {_("Disassemble"), {1, WIN_PROP_CURSOR | WIN_PROP_MARKS, NULL, 0, NULL}},
-  {_("Registers"), {0, WIN_PROP_CURSOR, NULL, 0, NULL}},
+  {_("Registers"), {1, WIN_PROP_CURSOR | WIN_PROP_MARKS, NULL, 0, NULL}},
+  {_("Memory"), {0, 0, NULL, 0, NULL}},
 };
 
 /*******************************************************************************
@@ -130,6 +182,25 @@ void view_setup_colors (view * view, configuration * conf);
 int viewParseLayout (view * view, char *layout, int starty, int startx,
 		     int height, int width, int *used_height,
 		     int *used_width);
+int view_layout (view * view);
+uint64_t view_time (void);
+void view_refresh (view * view);
+void view_add_variables (view * view, variable * v, int indent);
+int view_register_row (view * view, data_registers * regs, int i, char *line,
+		       int size);
+void view_memory_row (view * view, uint64_t address, char *line);
+void view_draw_memory (view * view);
+int view_scroll_memory (view * view, int n);
+void view_printable (char *line, char tab);
+int view_record_cols (view * view);
+int view_record_row (view * view, int nr, char *row);
+void view_record_rows (view * view);
+void view_mark_breakpoints (view * view);
+int view_show_loaded (view * view, const char *file_name, int line,
+		      int mark_stop);
+void view_cancel_load (view * view);
+int view_install_file (view * view, const char *file_name, text * text,
+		       int line, int mark_stop);
 
 /** @brief Set up the syntax color.
  *
@@ -494,6 +565,16 @@ viewParseLayout (view * view, char *layout, int starty, int startx,
 		}
 	      LOG_ERR_IF_RETURN (i > LAST_WINDOW, -1, "Unknown window '%s'",
 				 value);
+	      if (view->resizing)
+		{
+		  /* The windows and groups are already set up. */
+		  ret = win_resize (view->windows[i], starty, startx, h, w);
+		  LOG_ERR_IF_RETURN (ret < 0, -1, "Could not resize '%s'-window",
+				     out_windows[i].name);
+		  *used_height = h;
+		  *used_width = w;
+		  break;
+		}
 	      if (view->windows[i] == NULL)
 		{
 		  view->windows[i] =
@@ -564,276 +645,796 @@ viewParseLayout (view * view, char *layout, int starty, int startx,
   return 0;
 }
 
-/*******************************************************************************
- * Public Functions
- ******************************************************************************/
 /**
- * @brief Setup the view.
-*
-* Sets up the screen and initiates all output windows. The resulting view is
-* strored in @a v.
-*
-* @param v Structure to hold the new view information.
-* @param conf The configuration for the debugger.
-*
-* @return 0 if successful. -1 if failed to set up the screen.
-*/
-int
-view_setup (view ** v, configuration * conf)
+ * @brief Monotonic time.
+ *
+ * @return The time in microseconds.
+ */
+uint64_t
+view_time (void)
 {
-  int height;
-  int width;
-  int starty;
-  int startx;
-  int max_width;
-  int max_height;
-  int used_width;
-  int used_height;
-  int ret;
-  const char *layout_conf;
-  char *layout;
-  const char **p;
-  const char *copy[] = {
-      "Copyright (C) 2012 Kenneth Olsson.",
-      "License GPLv3+: GNU GPL version 3 or later ",
-      "<http://gnu.org/licenses/gpl.html>",
-      "This is free software: you are free to change and redistribute it.",
-      "There is NO WARRANTY, to the extent permitted by law.",
-      NULL ,
-  };
-  char default_layout[] =
-    "view={{height='75',[width='50',name='Main'],"
-    "[{rows='5',name='threads'},{rows='4',name='breakpoints'},"
-    "{rows='3', name='Libraries'},"
-    "{rows='2', name='stack'},"
-    "{name='frame'}]},"
-    "{name='Console',name='Target',name='Log',name='Responses',"
-    "name='Messages'}},"
-    "view={[width='50',name='Disassemble'],[name='Registers']}";
+  struct timespec ts;
 
-  assert (v);
-  *v = NULL;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
 
-  DINFO (1, "Initializing screen");
+/**
+ * @brief Update the screen.
+ *
+ * The screen is updated at a pace the terminal can keep up with. The update
+ * is put off while the terminal has not written the output of the earlier
+ * updates, or if it is too soon after the last update. The time between
+ * updates follows the time the last update took, so a slow terminal gets
+ * fewer updates. A put off update is done by view_idle() and always shows
+ * the latest state of the windows.
+ *
+ * @param view The view.
+ */
+void
+view_refresh (view * view)
+{
+  uint64_t now;
+  uint64_t delay;
+  int queued = 0;
 
-  if (initscr () == NULL)
+  view->refresh_pending = 1;
+  if (view->view_mode)
     {
-      LOG_ERR ("Could not initialize screen");
-      return -1;
+      /* The screen is updated when the ncurses mode is back. */
+      return;
     }
-
-  /* Set options for the screen. */
-  cbreak ();
-  raw ();
-  noecho ();
-  keypad (stdscr, TRUE);
-  nonl ();
-  nodelay (stdscr, TRUE);
-  curs_set (0);
-  start_color ();
-
-  getmaxyx (stdscr, max_height, max_width);
-  leaveok (stdscr, TRUE);
-
-  layout_conf = conf_get_string (conf, "Output Window", "layout", NULL);
-  if (layout_conf && strlen (layout_conf) > 0)
+  now = view_time ();
+  if (now < view->refresh_next)
     {
-      layout = strdup (layout_conf);
-      LOG_ERR_IF_FATAL (layout == NULL, ERR_MSG_CREATE ("layout"));
+      return;
     }
-  else
+#ifdef TIOCOUTQ
+  if (ioctl (1, TIOCOUTQ, &queued) == 0 && queued > REFRESH_MAX_QUEUE)
     {
-      layout = default_layout;
+      DINFO (5, "%d bytes queued to the terminal", queued);
+      view->refresh_next = now + REFRESH_POLL;
+      return;
     }
-  *v = (view *) malloc (sizeof **v);
-  LOG_ERR_IF_FATAL (*v == NULL, ERR_MSG_CREATE ("view"));
-  memset (*v, 0, sizeof (**v));
+#endif
 
-  /* Set up colors and syntax. */
-  view_setup_colors (*v, conf);
+  update_panels ();
+  doupdate ();
+  view->refresh_pending = 0;
 
-  starty = 0;
-  startx = 0;
-  height = max_height;
-  width = max_width;
-  ret = viewParseLayout (*v, layout, starty,
-			 startx, max_height - 1, max_width, &used_height,
-			 &used_width);
-  if (layout != default_layout)
-    {
-      free (layout);
-    }
-  if (ret < 0)
-    {
-      goto error;
-    }
-  if ((*v)->views == 0)
-    {
-      (*v)->views = 1;
-    }
+  delay = (view_time () - now) * REFRESH_FACTOR;
+  view->refresh_next = view_time () +
+    (delay < REFRESH_MAX_DELAY ? delay : REFRESH_MAX_DELAY);
+}
 
-  (*v)->current_window = (*v)->windows[0];
-  (*v)->current_index = 0;
-  (*v)->view_mode = 0;
-  win_to_top ((*v)->current_window);
-  win_set_focus ((*v)->current_window, 1);
-  (*v)->last_stop_mark = -1;
+/**
+ * @brief Lay out the windows on the screen.
+ *
+ * Parses the layout of the view for the current screen size. The layout is
+ * parsed from a copy, since the parsing changes the string.
+ *
+ * @param view The view.
+ *
+ * @return 0 on success. -1 on failure.
+ */
+int
+view_layout (view * view)
+{
+  int max_height;
+  int max_width;
+  int used_height;
+  int used_width;
+  char *layout;
+  int ret;
 
-  win_to_top ((*v)->windows[WIN_MESSAGES]);
-  view_next_window (*v, -1, 2);
-  view_next_window (*v, 1, 2);
+  getmaxyx (stdscr, max_height, max_width);
+  layout = strdup (view->layout);
+  LOG_ERR_IF_FATAL (layout == NULL, ERR_MSG_CREATE ("layout"));
+  ret = viewParseLayout (view, layout, 0, 0, max_height - 1, max_width,
+			 &used_height, &used_width);
+  free (layout);
+  return ret;
+}
 
-  update_panels ();
-  doupdate ();
-  DINFO (1, "Screen init done");
+/**
+ * @brief Add variables to the frame window.
+ *
+ * Add a list of variables to the frame window, followed by the children of
+ * the expanded variables. Variables that can be expanded are marked with '+'
+ * and expanded variables with '-'. Variables whose value changed at the last
+ * stop get a '*' in the mark column. The tag of a line is the id of the
+ * variable.
+ *
+ * @param view The view.
+ * @param v The list of variables.
+ * @param indent The indentation of the variables.
+ */
+void
+view_add_variables (view * view, variable * v, int indent)
+{
+  char line[80];
+  char *pl = line;
+  int size = 80;
+  const char *mark;
 
-  /* copyright info */
-  p = copy;
-  while (*p && (*v)->windows[WIN_MESSAGES])
+  for (; v != NULL; v = v->next)
     {
-      win_add_line ((*v)->windows[WIN_MESSAGES], *p, 1, 0);
-      p++;
+      if (v->numchild > 0 || (v->numchild < 0 && v->value == NULL))
+	{
+	  mark = v->expanded ? "- " : "+ ";
+	}
+      else
+	{
+	  mark = "";
+	}
+      LPRINT (pl, pl != line, size, "%*s%s%s%s%s%s%s;", indent, "", mark,
+	      v->type ? v->type : "", v->type ? " " : "", v->name,
+	      v->value ? " = " : "", v->value ? v->value : "");
+      win_add_line (view->windows[WIN_FRAME], pl, 1, v->id);
+      win_set_mark (view->windows[WIN_FRAME], -1, 0, v->changed ? '*' : ' ');
+      if (v->expanded)
+	{
+	  view_add_variables (view, v->children, indent + 2);
+	}
     }
 
-  return 0;
-
-error:
-  LOG_ERR ("Failed to initialize the screen");
-  if (*v != NULL)
+  if (pl != line)
     {
-      view_cleanup (*v);
+      free (pl);
     }
-
-  fprintf (stderr, "Failed to initialize the screen.\n");
-
-  return -1;
 }
 
+
 /**
- * @brief Release a view.
+ * @brief Make a line printable.
  *
- * Free a view and it's allocated resources. Also restores the screen.
+ * Replaces the characters that can not be printed by '?'.
  *
- * @param view The view to be set free.
+ * @param line The line.
+ * @param tab The character tabs are replaced by, '\t' keeps them.
  */
 void
-view_cleanup (view * view)
+view_printable (char *line, char tab)
 {
-  int i;
-
-  assert (view);
-
-  DINFO (1, "Freeing view");
+  char *p;
 
-  for (i = 0; i <= LAST_WINDOW; i++)
+  for (p = line; *p != '\0'; p++)
     {
-      if (view->windows[i] != NULL)
+      if (*p == '\t')
 	{
-	  win_free (view->windows[i]);
+	  *p = tab;
 	}
-      if (out_windows[i].props.scan_definitions != NULL)
+      else if (!isprint ((unsigned char) *p))
 	{
-	  free (out_windows[i].props.scan_definitions);
-	  out_windows[i].props.scan_definitions = NULL;
+	  *p = '?';
 	}
     }
-  memset (view, 0, sizeof (*view));
-  free (view);
-  endwin ();
 }
 
 /**
- * @brief Output to message window.
- *
- * Output a message out the message window.
+ * @brief Get the width the records are truncated at.
  *
  * @param view The view.
- * @param level The leve. (Currently not used)
- * @param msg The format of the message.
- * @param ... The message arguments.
  *
- * @return 0 upon success otherwise -1.
+ * @return The width of the responses view, at most #RECORD_ROW_LEN - 1. 0
+ *         if there is no responses view.
  */
 int
-view_add_message (view * view, int level, const char *msg, ...)
+view_record_cols (view * view)
 {
-  int ret;
-  va_list ap;
-  char buf[512];
-  char *p = buf;
-  char *t;
-  int size = 512;
-
-  assert (view);
+  int rows;
+  int cols;
 
-  if (view->windows[WIN_MESSAGES] == NULL)
+  if (view->windows[WIN_RESPONSES] == NULL)
     {
       return 0;
     }
-  while (1)
-    {
-      va_start (ap, msg);
-      ret = vsnprintf (p, size, msg, ap);
-      va_end (ap);
-      if (ret > -1 && ret < size)
-	{
-	  break;
-	}
-      if (ret > -1)
-	{
-	  size = ret + 1;
-	}
-      else
-	{
-	  size *= 2;
-	}
-      if (p == buf)
-	{
-	  p = NULL;
-	}
-      t = (char *) realloc (p, size);
-      LOG_ERR_IF_FATAL (t == NULL, "Memory");
-      p = t;
-    }
-
-  ret = win_add_line (view->windows[WIN_MESSAGES], buf, 1, 0);
-
-  update_panels ();
-  doupdate ();
+  win_get_size (view->windows[WIN_RESPONSES], &rows, &cols);
 
-  if (p != buf)
-    {
-      free (p);
-    }
-  return ret;
+  return cols < RECORD_ROW_LEN ? cols : RECORD_ROW_LEN - 1;
 }
 
 /**
- * @brief Add a line of text.
- *
- * Adds a line of text to a specified window.
+ * @brief Get the row of a record in the responses view.
  *
- * @todo Why call the function view_add_line? viewAddLine!?
+ * A record wider than the window is truncated and ends with its length.
  *
- * @param view The view object.
- * @param type The type of window that the line of text should be added to.
- *             WIN_MAIN, WIN_CONSTOL,...WIN_FRAME are valid types.
- * @param line The line to be added.
- * @param tag The tag that is associated to the line.
+ * @param view The view.
+ * @param nr The number of the record.
+ * @param row Set to the row, #RECORD_ROW_LEN bytes.
  *
- * @return 0 if the line was added otherwise -1.
+ * @return 0 upon success, -1 if there is no such record.
  */
 int
-view_add_line (view * view, int type, const char *line, int tag)
+view_record_row (view * view, int nr, char *row)
 {
-  int ret;
-
-  LOG_ERR_IF_RETURN (type < 0
-		     || type > LAST_WINDOW, -1, "Wrong type %d", type);
-  ret = win_add_line (view->windows[type], line, 1, tag);
+  const char *text;
+  char mark[32] = "";
+  int cols;
+  int len;
+  int n;
 
-  update_panels ();
-  doupdate ();
+  text = record_log_get (view->responses, nr, &len);
+  if (text == NULL)
+    {
+      return -1;
+    }
+
+  cols = view_record_cols (view);
+  n = len;
+  if (len > cols)
+    {
+      snprintf (mark, sizeof (mark), " [%d bytes]", len);
+      n = cols - strlen (mark);
+      if (n <= 0)
+	{
+	  n = cols > 0 ? cols : 0;
+	  mark[0] = '\0';
+	}
+    }
+  memcpy (row, text, n);
+  row[n] = '\0';
+  view_printable (row, ' ');
+  strcpy (row + n, mark);
+
+  return 0;
+}
+
+/**
+ * @brief Truncate the records again after the width changed.
+ *
+ * Only the collapsed records that are wider than the old or the new width
+ * are changed.
+ *
+ * @param view The view.
+ */
+void
+view_record_rows (view * view)
+{
+  record_log *log = view->responses;
+  char row[RECORD_ROW_LEN];
+  int cols;
+  int min;
+  int nr;
+
+  cols = view_record_cols (view);
+  if (cols == view->record_cols || view->windows[WIN_RESPONSES] == NULL)
+    {
+      return;
+    }
+  min = cols < view->record_cols ? cols : view->record_cols;
+  for (nr = 0; nr < log->nr_records; nr++)
+    {
+      if (!log->records[nr].expanded && log->records[nr].len > min)
+	{
+	  view_record_row (view, nr, row);
+	  win_set_line (view->windows[WIN_RESPONSES], nr, row);
+	}
+    }
+  view->record_cols = cols;
+}
+
+/**
+ * @brief Mark the breakpoints of the file in the main window.
+ *
+ * @param view The view.
+ */
+void
+view_mark_breakpoints (view * view)
+{
+  breakpoint_table *bpt = view->breakpoints;
+  const char *main_file_name;
+  int i;
+
+  main_file_name = win_get_filename (view->windows[WIN_MAIN]);
+  if (bpt == NULL || main_file_name == NULL)
+    {
+      return;
+    }
+  for (i = 0; i < bpt->rows; i++)
+    {
+      if (bpt->breakpoints[i] == NULL
+	  || bpt->breakpoints[i]->type == BP_TYPE_WATCHPOINT
+	  || bpt->breakpoints[i]->fullname == NULL
+	  || strcmp (main_file_name, bpt->breakpoints[i]->fullname) != 0)
+	{
+	  continue;
+	}
+      win_set_mark (view->windows[WIN_MAIN], bpt->breakpoints[i]->line, 0,
+		    bpt->breakpoints[i]->disp ? 'B' : 'b');
+      win_set_mark (view->windows[WIN_MAIN], bpt->breakpoints[i]->line, 1,
+		    bpt->breakpoints[i]->enabled ? 'e' : 'd');
+    }
+}
+
+/**
+ * @brief Show a line of a file in the main window.
+ *
+ * The file is loaded first, if it is not the one shown.
+ *
+ * @param view The view.
+ * @param file_name The file name.
+ * @param line The line that should be in the middle of the window.
+ * @param mark_stop If set to 1 an 'S' will be shown in the main window.
+ *
+ * @return 0 if successful otherise -1.
+ */
+int
+view_show_loaded (view * view, const char *file_name, int line,
+		  int mark_stop)
+{
+  int ret;
+
+  ret = win_load_file (view->windows[WIN_MAIN], file_name);
+  LOG_ERR_IF_RETURN (ret < 0, -1, "Could not load file '%s'", file_name);
+
+  if (mark_stop)
+    {
+      if (view->last_stop_mark >= 0)
+	{
+	  ret =
+	    win_set_mark (view->windows[WIN_MAIN], view->last_stop_mark, 2,
+			  ' ');
+	  LOG_ERR_IF (ret < 0, "Could not un-set mark");
+	}
+      ret = win_set_mark (view->windows[WIN_MAIN], line - 1, 2, 'S');
+      LOG_ERR_IF_RETURN (ret < 0, -1, "Could not set mark");
+      view->last_stop_mark = line - 1;
+    }
+  ret = win_go_to_line (view->windows[WIN_MAIN], line - 1);
+  LOG_ERR_IF_RETURN (ret < 0, -1, "Could not goto '%s':%d", file_name, line);
+
+  view_refresh (view);
+
+  return 0;
+}
+
+/**
+ * @brief Forget the file being loaded.
+ *
+ * The file is thrown away when it has been loaded.
+ *
+ * @param view The view.
+ */
+void
+view_cancel_load (view * view)
+{
+  if (view->load_name == NULL)
+    {
+      return;
+    }
+  free (view->load_name);
+  view->load_name = NULL;
+  win_set_status (view->windows[WIN_MAIN], out_windows[WIN_MAIN].name);
+}
+
+/**
+ * @brief Show a loaded file in the main window.
+ *
+ * The file that was shown is prefetched again, so going back to it is fast.
+ *
+ * @param view The view.
+ * @param file_name The file name.
+ * @param text The text of the file. The main window takes it over.
+ * @param line The line that should be in the middle of the window.
+ * @param mark_stop If set to 1 an 'S' will be shown in the main window.
+ *
+ * @return 0 if successful otherise -1.
+ */
+int
+view_install_file (view * view, const char *file_name, text * text,
+		   int line, int mark_stop)
+{
+  char *shown = NULL;
+  int ret;
+
+  if (win_get_filename (view->windows[WIN_MAIN]) != NULL)
+    {
+      shown = strdup (win_get_filename (view->windows[WIN_MAIN]));
+    }
+
+  ret = win_set_text (view->windows[WIN_MAIN], file_name, text);
+  if (ret == 0)
+    {
+      view_mark_breakpoints (view);
+      ret = view_show_loaded (view, file_name, line, mark_stop);
+    }
+
+  if (shown != NULL)
+    {
+      view_prefetch_file (view, shown);
+      free (shown);
+    }
+
+  return ret;
+}
+
+/*******************************************************************************
+ * Public Functions
+ ******************************************************************************/
+/**
+ * @brief Setup the view.
+*
+* Sets up the screen and initiates all output windows. The resulting view is
+* strored in @a v.
+*
+* @param v Structure to hold the new view information.
+* @param conf The configuration for the debugger.
+*
+* @return 0 if successful. -1 if failed to set up the screen.
+*/
+int
+view_setup (view ** v, configuration * conf)
+{
+  int ret;
+  const char *layout;
+  const char **p;
+  const char *copy[] = {
+      "Copyright (C) 2012 Kenneth Olsson.",
+      "License GPLv3+: GNU GPL version 3 or later ",
+      "<http://gnu.org/licenses/gpl.html>",
+      "This is free software: you are free to change and redistribute it.",
+      "There is NO WARRANTY, to the extent permitted by law.",
+      NULL ,
+  };
+  char default_layout[] =
+    "view={{height='75',[width='50',name='Main'],"
+    "[{rows='5',name='threads'},{rows='4',name='breakpoints'},"
+    "{rows='3', name='Libraries'},"
+    "{rows='2', name='stack'},"
+    "{name='frame'}]},"
+    "{name='Console',name='Target',name='Log',name='Responses',"
+    "name='Messages'}},"
+    "view={[width='50',name='Disassemble'],[name='Registers',name='Memory']}";
+
+  assert (v);
+  *v = NULL;
+
+  DINFO (1, "Initializing screen");
+
+  if (initscr () == NULL)
+    {
+      LOG_ERR ("Could not initialize screen");
+      return -1;
+    }
+
+  /* Set options for the screen. */
+  cbreak ();
+  raw ();
+  noecho ();
+  keypad (stdscr, TRUE);
+  nonl ();
+  nodelay (stdscr, TRUE);
+  curs_set (0);
+  start_color ();
+
+  leaveok (stdscr, TRUE);
+
+  layout = conf_get_string (conf, "Output Window", "layout", NULL);
+  if (layout == NULL || strlen (layout) == 0)
+    {
+      layout = default_layout;
+    }
+  *v = (view *) malloc (sizeof **v);
+  LOG_ERR_IF_FATAL (*v == NULL, ERR_MSG_CREATE ("view"));
+  memset (*v, 0, sizeof (**v));
+  (*v)->layout = strdup (layout);
+  LOG_ERR_IF_FATAL ((*v)->layout == NULL, ERR_MSG_CREATE ("layout"));
+
+  /* Set up colors and syntax. */
+  view_setup_colors (*v, conf);
+
+  ret = view_layout (*v);
+  if (ret < 0)
+    {
+      goto error;
+    }
+  if ((*v)->views == 0)
+    {
+      (*v)->views = 1;
+    }
+
+  (*v)->current_window = (*v)->windows[0];
+  (*v)->current_index = 0;
+  (*v)->view_mode = 0;
+  win_to_top ((*v)->current_window);
+  win_set_focus ((*v)->current_window, 1);
+  (*v)->last_stop_mark = -1;
+  (*v)->responses = record_log_create ();
+  (*v)->record_cols = view_record_cols (*v);
+  (*v)->loader = file_loader_create ();
+
+  win_to_top ((*v)->windows[WIN_MESSAGES]);
+  view_next_window (*v, -1, 2);
+  view_next_window (*v, 1, 2);
+
+  view_refresh (*v);
+  DINFO (1, "Screen init done");
+
+  /* copyright info */
+  p = copy;
+  while (*p && (*v)->windows[WIN_MESSAGES])
+    {
+      win_add_line ((*v)->windows[WIN_MESSAGES], *p, 1, 0);
+      p++;
+    }
+
+  return 0;
+
+error:
+  LOG_ERR ("Failed to initialize the screen");
+  if (*v != NULL)
+    {
+      view_cleanup (*v);
+    }
+
+  fprintf (stderr, "Failed to initialize the screen.\n");
+
+  return -1;
+}
+
+/**
+ * @brief Release a view.
+ *
+ * Free a view and it's allocated resources. Also restores the screen.
+ *
+ * @param view The view to be set free.
+ */
+void
+view_cleanup (view * view)
+{
+  int i;
+
+  assert (view);
+
+  DINFO (1, "Freeing view");
+
+  for (i = 0; i <= LAST_WINDOW; i++)
+    {
+      if (view->windows[i] != NULL)
+	{
+	  win_free (view->windows[i]);
+	}
+      if (out_windows[i].props.scan_definitions != NULL)
+	{
+	  free (out_windows[i].props.scan_definitions);
+	  out_windows[i].props.scan_definitions = NULL;
+	}
+    }
+  file_loader_free (view->loader);
+  free (view->load_name);
+  free (view->reg_marked);
+  free (view->layout);
+  if (view->responses != NULL)
+    {
+      record_log_free (view->responses);
+    }
+  memset (view, 0, sizeof (*view));
+  free (view);
+  endwin ();
+}
+
+/**
+ * @brief Output to message window.
+ *
+ * Output a message out the message window.
+ *
+ * @param view The view.
+ * @param level The leve. (Currently not used)
+ * @param msg The format of the message.
+ * @param ... The message arguments.
+ *
+ * @return 0 upon success otherwise -1.
+ */
+int
+view_add_message (view * view, int level, const char *msg, ...)
+{
+  int ret;
+  va_list ap;
+  char buf[512];
+  char *p = buf;
+  char *t;
+  int size = 512;
+
+  assert (view);
+
+  if (view->windows[WIN_MESSAGES] == NULL)
+    {
+      return 0;
+    }
+  while (1)
+    {
+      va_start (ap, msg);
+      ret = vsnprintf (p, size, msg, ap);
+      va_end (ap);
+      if (ret > -1 && ret < size)
+	{
+	  break;
+	}
+      if (ret > -1)
+	{
+	  size = ret + 1;
+	}
+      else
+	{
+	  size *= 2;
+	}
+      if (p == buf)
+	{
+	  p = NULL;
+	}
+      t = (char *) realloc (p, size);
+      LOG_ERR_IF_FATAL (t == NULL, "Memory");
+      p = t;
+    }
+
+  ret = win_add_line (view->windows[WIN_MESSAGES], buf, 1, 0);
+
+  view_refresh (view);
+
+  if (p != buf)
+    {
+      free (p);
+    }
+  return ret;
+}
+
+/**
+ * @brief Add a line of text.
+ *
+ * Adds a line of text to a specified window.
+ *
+ * @todo Why call the function view_add_line? viewAddLine!?
+ *
+ * @param view The view object.
+ * @param type The type of window that the line of text should be added to.
+ *             WIN_MAIN, WIN_CONSTOL,...WIN_FRAME are valid types.
+ * @param line The line to be added.
+ * @param tag The tag that is associated to the line.
+ *
+ * @return 0 if the line was added otherwise -1.
+ */
+int
+view_add_line (view * view, int type, const char *line, int tag)
+{
+  int ret;
+
+  LOG_ERR_IF_RETURN (type < 0
+		     || type > LAST_WINDOW, -1, "Wrong type %d", type);
+  ret = win_add_line (view->windows[type], line, 1, tag);
+
+  view_refresh (view);
+
+  return ret;
+}
+
+/**
+ * @brief Add a record from the debugger to the responses view.
+ *
+ * The record is kept as it is and shown as a row truncated to the width of
+ * the window, so a huge record is not formatted unless it is expanded by
+ * view_toggle_record().
+ *
+ * @param view The view object.
+ * @param record The record.
+ *
+ * @return 0 if the record was added otherwise -1.
+ */
+int
+view_add_record (view * view, const char *record)
+{
+  char row[RECORD_ROW_LEN];
+  int nr;
+  int ret;
+
+  assert (view);
+  assert (record);
+
+  nr = record_log_add (view->responses, record);
+  view_record_row (view, nr, row);
+  ret = win_add_line (view->windows[WIN_RESPONSES], row, 1, nr);
+
+  view_refresh (view);
+
+  return ret;
+}
+
+/**
+ * @brief Expand or truncate the record under the cursor in the responses
+ * view.
+ *
+ * @param view The view object.
+ *
+ * @return 0 upon success, otherwise -1.
+ */
+int
+view_toggle_record (view * view)
+{
+  Win *win;
+  char row[RECORD_ROW_LEN];
+  const char *text;
+  char *copy;
+  int expanded;
+  int line;
+  int nr;
+  int len;
+  int ret;
+
+  assert (view);
+
+  win = view->windows[WIN_RESPONSES];
+  line = win_get_cursor (win);
+  nr = win_get_tag (win);
+  expanded = record_log_toggle (view->responses, nr);
+  LOG_ERR_IF_RETURN (expanded < 0, -1, "No record %d", nr);
+
+  if (!expanded)
+    {
+      view_record_row (view, nr, row);
+      ret = win_set_line (win, line, row);
+    }
+  else
+    {
+      text = record_log_get (view->responses, nr, &len);
+      copy = strdup (text);
+      LOG_ERR_IF_FATAL (copy == NULL, ERR_MSG_CREATE ("record"));
+      view_printable (copy, '\t');
+      ret = win_set_line (win, line, copy);
+      free (copy);
+    }
+
+  view_refresh (view);
+
+  return ret;
+}
+
+/**
+ * @brief Add lines of text.
+ *
+ * Adds the lines to a window and draws the window once, after the last
+ * line. A carriage return starts the line over and characters that can not
+ * be printed are shown as '?'.
+ *
+ * @param view The view object.
+ * @param type The type of window that the lines should be added to.
+ * @param lines The lines, separated by '\n'. Changed by the function.
+ *
+ * @return 0 if the lines were added otherwise -1.
+ */
+int
+view_add_lines (view * view, int type, char *lines)
+{
+  char *line;
+  char *next;
+  char *p;
+  int ret = 0;
+
+  assert (lines);
+
+  LOG_ERR_IF_RETURN (type < 0
+		     || type > LAST_WINDOW, -1, "Wrong type %d", type);
+  for (line = lines; line != NULL && ret == 0; line = next)
+    {
+      next = strchr (line, '\n');
+      if (next != NULL)
+	{
+	  *next++ = '\0';
+	}
+      p = line + strlen (line);
+      while (p > line && p[-1] == '\r')
+	{
+	  *--p = '\0';
+	}
+      p = strrchr (line, '\r');
+      if (p != NULL)
+	{
+	  line = p + 1;
+	}
+      view_printable (line, '\t');
+      ret = win_add_line (view->windows[type], line, next == NULL, -1);
+    }
+
+  view_refresh (view);
 
   return ret;
 }
@@ -853,8 +1454,6 @@ view_update_breakpoints (view * view, breakpoint_table * bpt)
   char buf[128];
   char *line = buf;
   int size = 128;
-  char mark[3];
-  const char *main_file_name;
 
   assert (view);
   assert (bpt);
@@ -878,8 +1477,8 @@ view_update_breakpoints (view * view, breakpoint_table * bpt)
 			bpt->breakpoints[i]->number);
 	  continue;
 	}
-      LPRINT (line, line != buf, size, "%2d %c%c%c 0x%08X %.20s %3d %3d "
-	      "%.20s:%-4d %s",
+      LPRINT (line, line != buf, size, "%2d %c%c%c 0x%08" PRIX64
+	      " %.20s %3d %3d %.20s:%-4d %s",
 	      bpt->breakpoints[i]->number,
 	      bpt->breakpoints[i]->type ? 'w' : 'b',
 	      bpt->breakpoints[i]->disp ? 'k' : 'd',
@@ -893,20 +1492,6 @@ view_update_breakpoints (view * view, breakpoint_table * bpt)
 	      bpt->breakpoints[i]->cond ? bpt->breakpoints[i]->cond : "");
       win_add_line (view->windows[WIN_BREAKPOINTS], line, 1,
 		    bpt->breakpoints[i]->number);
-
-      /* Set mark in window. */
-      mark[0] = bpt->breakpoints[i]->disp ? 'B' : 'b';
-      mark[1] = bpt->breakpoints[i]->enabled ? 'e' : 'd';
-      mark[2] = '\0';
-      main_file_name = win_get_filename (view->windows[WIN_MAIN]);
-      if (main_file_name != NULL && bpt->breakpoints[i]->fullname != NULL
-	  && strcmp (main_file_name, bpt->breakpoints[i]->fullname) == 0)
-	{
-	  win_set_mark (view->windows[WIN_MAIN], bpt->breakpoints[i]->line, 0,
-			mark[0]);
-	  win_set_mark (view->windows[WIN_MAIN], bpt->breakpoints[i]->line, 1,
-			mark[1]);
-	}
     }
 
   if (line != buf)
@@ -914,8 +1499,11 @@ view_update_breakpoints (view * view, breakpoint_table * bpt)
       free (line);
     }
 
-  update_panels ();
-  doupdate ();
+  /* Set marks in the main window. */
+  view->breakpoints = bpt;
+  view_mark_breakpoints (view);
+
+  view_refresh (view);
 
   return;
 }
@@ -998,8 +1586,7 @@ view_update_threads (view * view, thread_group * thread_groups)
       free (pl);
     }
 
-  update_panels ();
-  doupdate ();
+  view_refresh (view);
 }
 
 /**
@@ -1032,8 +1619,7 @@ view_update_libraries (view * view, library * libraries)
       win_add_line (view->windows[WIN_LIBRARIES], line, 1, count);
       l = l->next;
     }
-  update_panels ();
-  doupdate ();
+  view_refresh (view);
 
   if (pl != line)
     {
@@ -1058,7 +1644,6 @@ view_update_frame (view * view, stack * stack, int level)
   char *pl = line;
   int size = 80;
   frame *f;
-  variable *v;
 
   assert (view);
 
@@ -1076,29 +1661,16 @@ view_update_frame (view * view, stack * stack, int level)
   /* Show file, func and line number. */
   LPRINT (pl, pl != line, size, "#%-2d %s:%d %s()", level, f->file, f->line,
 	  f->func);
-  win_add_line (view->windows[WIN_FRAME], line, 1, -1);
+  win_add_line (view->windows[WIN_FRAME], pl, 1, -1);
+  win_set_mark (view->windows[WIN_FRAME], -1, 0, ' ');
 
-  /* Show frame's arguments. */
-  v = f->args;
-  while (v != NULL)
-    {
-      LPRINT (pl, pl != line, size, "    %s %s%s%s;", v->type ? v->type : "",
-	      v->name, v->value ? " = " : "", v->value ? v->value : "");
-      win_add_line (view->windows[WIN_FRAME], line, 1, -1);
-      v = v->next;
-    }
-
-  /* Show frame's variables. */
+  /* Show frame's arguments and variables, changed values are marked. */
+  view_add_variables (view, f->args, 4);
   win_add_line (view->windows[WIN_FRAME], "{", 1, -1);
-  v = f->variables;
-  while (v != NULL)
-    {
-      LPRINT (pl, pl != line, size, "  %s %s%s%s;", v->type ? v->type : "",
-	      v->name, v->value ? " = " : "", v->value ? v->value : "");
-      win_add_line (view->windows[WIN_FRAME], line, 1, -1);
-      v = v->next;
-    }
+  win_set_mark (view->windows[WIN_FRAME], -1, 0, ' ');
+  view_add_variables (view, f->variables, 2);
   win_add_line (view->windows[WIN_FRAME], "}", 1, -1);
+  win_set_mark (view->windows[WIN_FRAME], -1, 0, ' ');
 
   if (f->fullname != NULL)
     {
@@ -1106,8 +1678,7 @@ view_update_frame (view * view, stack * stack, int level)
     }
 out:
   /* Update the window. */
-  update_panels ();
-  doupdate ();
+  view_refresh (view);
 
   if (pl != line)
     {
@@ -1118,7 +1689,9 @@ out:
 /**
  * @brief Update stack window.
  *
- * Update the stack window with the list of frames in \a stack.
+ * Update the stack window with the list of frames in \a stack. If the frames
+ * were appended to the stack, e.g. when scrolling a deep stack, only the new
+ * frames are added to the window and the cursor is kept at the same frame.
  *
  * @param view The view.
  * @param stack The stack that should be viewed.
@@ -1130,28 +1703,40 @@ view_update_stack (view * view, stack * stack)
   char *pl = line;
   int size = 80;
   int i;
+  int cursor;
   frame *f;
 
   assert (view);
 
   DINFO (3, "Updating stack window %d", WIN_STACK);
 
-  win_clear (view->windows[WIN_STACK]);
+  cursor = win_get_cursor (view->windows[WIN_STACK]);
+  if (!stack->appended || cursor < 0 || cursor >= stack->depth)
+    {
+      cursor = 0;
+    }
+
+  /* A page of frames added to the stack is added to the window. */
+  if (!stack->appended || view->stack_lines > stack->depth)
+    {
+      win_clear (view->windows[WIN_STACK]);
+      view->stack_lines = 0;
+    }
 
-  /* Loop all frames and print the file, func and line number. */
-  for (i = 0; i < stack->depth; i++)
+  /* Loop the new frames and print the file, func and line number. */
+  for (i = view->stack_lines; i < stack->depth; i++)
     {
       f = &stack->stack[i];
       LPRINT (pl, pl != line, size, "#%-2d %s:%d %s()", i, f->file, f->line,
 	      f->func);
-      win_add_line (view->windows[WIN_STACK], line, 1, i);
+      win_add_line (view->windows[WIN_STACK], pl, 1, i);
     }
+  view->stack_lines = stack->depth;
 
   /* Update the stack window. */
-  win_go_to_line (view->windows[WIN_STACK], 0);
+  win_go_to_line (view->windows[WIN_STACK], cursor);
 
-  update_panels ();
-  doupdate ();
+  view_refresh (view);
 
   if (pl != line)
     {
@@ -1162,31 +1747,37 @@ view_update_stack (view * view, stack * stack)
 /**
  * @brief Update the assembler view.
  *
- * Update the assembler view.
+ * Update the assembler view with a function. The rows of the instructions
+ * are calculated by asm_function_done().
  *
  * @param view The view.
- * @param ass The assembler lines.
+ * @param func The function.
  * @param pc The current pc, used for setting a marker on the current asm line.
  */
 void
-view_update_ass (view * view, assembler * ass, int pc)
+view_update_ass (view * view, asm_function * func, uint64_t pc)
 {
   char buf[512];
   char *p = buf;
   char *t;
   int size = 512;
   int ret;
-  src_line *sline;
+  int i;
+  int row;
+  int src;
+  int nr_rows;
+  asm_line **rows = NULL;
   asm_line *line;
   int show_text;
 
   assert (view);
+  assert (func);
 
   win_clear (view->windows[WIN_DISASSAMBLE]);
   if (win_get_filename (view->windows[WIN_MAIN]) != NULL)
     {
       show_text = strstr (win_get_filename (view->windows[WIN_MAIN]),
-			  ass->file) != NULL;
+			  func->file) != NULL;
     }
   else
     {
@@ -1194,7 +1785,8 @@ view_update_ass (view * view, assembler * ass, int pc)
     }
 
   t = p;
-  LPRINT (p, p != buf, size, " 0x%08X - %s ()", ass->address, ass->function);
+  LPRINT (p, p != buf, size, " 0x%08" PRIX64 " - %s ()", func->address,
+	  func->function ? func->function : "");
   if (p != t && t != buf)
     {
       free (t);
@@ -1206,109 +1798,447 @@ view_update_ass (view * view, assembler * ass, int pc)
       LOG_ERR ("Failed to add asm line");
       goto error;
     }
+  win_set_mark (view->windows[WIN_DISASSAMBLE], -1, 0, ' ');
+
+  /* Map the rows to the instructions, the other rows are source lines. */
+  nr_rows = 1 + func->nr_src_lines + func->nr_lines;
+  rows = (asm_line **) calloc (nr_rows, sizeof (asm_line *));
+  LOG_ERR_IF_FATAL (rows == NULL, "Memory");
+  for (i = 0; i < func->nr_lines; i++)
+    {
+      rows[func->lines[i].row] = func->lines + i;
+    }
 
-  sline = ass->lines;
-  while (sline)
+  src = 0;
+  for (row = 1; row < nr_rows; row++)
     {
-      LPRINT (p, p != buf, size, "%4d %s", sline->line_nr, show_text ?
-	      win_get_line (view->windows[WIN_MAIN],
-			    sline->line_nr - 1) : "");
+      line = rows[row];
+      t = p;
+      if (line == NULL)
+	{
+	  LPRINT (p, p != buf, size, "%4d %s", func->src_lines[src],
+		  show_text ? win_get_line (view->windows[WIN_MAIN],
+					    func->src_lines[src] - 1) : "");
+	  src++;
+	}
+      else
+	{
+	  LPRINT (p, p != buf, size, "+0x%08X - %s", line->offset,
+		  line->inst);
+	}
       if (p != t && t != buf)
 	{
 	  free (t);
 	}
+
       ret = win_add_line (view->windows[WIN_DISASSAMBLE], p, 1, 0);
       if (ret < 0)
 	{
 	  LOG_ERR ("Failed to add asm line");
 	  goto error;
 	}
-      line = sline->lines;
-      while (line)
+      win_set_mark (view->windows[WIN_DISASSAMBLE], -1, 0, ' ');
+    }
+  line = asm_function_find_line (func, pc);
+  if (line != NULL)
+    {
+      win_set_mark (view->windows[WIN_DISASSAMBLE], line->row, 0, 'S');
+    }
+  view_refresh (view);
+error:
+  free (rows);
+  if (p != buf)
+    {
+      free (p);
+    }
+}
+
+/**
+ * @brief Move the pc marker in the assembler view.
+ *
+ * Move the marker of the current asm line when the pc is still in the shown
+ * function. Only the two affected rows are redrawn.
+ *
+ * @param view The view.
+ * @param func The function shown in the assembler view.
+ * @param old_pc The previously marked pc.
+ * @param pc The current pc.
+ */
+void
+view_move_ass_pc (view * view, asm_function * func, uint64_t old_pc,
+		  uint64_t pc)
+{
+  asm_line *line;
+
+  assert (view);
+  assert (func);
+
+  line = asm_function_find_line (func, old_pc);
+  if (line != NULL)
+    {
+      win_set_mark (view->windows[WIN_DISASSAMBLE], line->row, 0, ' ');
+    }
+  line = asm_function_find_line (func, pc);
+  if (line != NULL)
+    {
+      win_set_mark (view->windows[WIN_DISASSAMBLE], line->row, 0, 'S');
+    }
+  view_refresh (view);
+}
+
+/**
+ * @brief Format a row in the registers view.
+ *
+ * Format the row holding register @a i and @a i + 1 with the column widths
+ * of the registers view.
+ *
+ * @param view The view.
+ * @param regs The registers.
+ * @param i The register in the first column.
+ * @param line The buffer for the row.
+ * @param size The size of @a line.
+ *
+ * @return 0 upon success. -1 if a value is wider than its column.
+ */
+int
+view_register_row (view * view, data_registers * regs, int i, char *line,
+		   int size)
+{
+  const char *v1;
+  const char *v2 = "";
+  int l1;
+  int l2 = 0;
+
+  v1 = data_registers_get_str (regs, i, &l1);
+  if (i + 1 < regs->len)
+    {
+      v2 = data_registers_get_str (regs, i + 1, &l2);
+    }
+  if ((l1 > view->reg_vlen && view->reg_vlen < REG_VALUE_LEN)
+      || (l2 > view->reg_vlen && view->reg_vlen < REG_VALUE_LEN))
+    {
+      return -1;
+    }
+  snprintf (line, size, "%*s %*.*s %*s %*.*s", view->reg_nlen,
+	    regs->registers[i].reg_name, view->reg_vlen, REG_VALUE_LEN, v1,
+	    view->reg_nlen,
+	    i + 1 < regs->len ? regs->registers[i + 1].reg_name : "",
+	    view->reg_vlen, REG_VALUE_LEN, v2);
+
+  return 0;
+}
+
+/**
+ * @brief Update the registers view.
+ *
+ * Update the registers view. Only the rows with registers that changed at
+ * the last stop are redrawn, and marked with '*'. The whole view is rebuilt
+ * when the registers are new or a value no longer fits its column.
+ *
+ * @param view The view.
+ * @param regs The registers.
+ */
+void
+view_update_registers (view * view, data_registers * regs)
+{
+  int i;
+  int ret;
+  int row;
+  int changed;
+  char line[REG_LINE_LEN];
+  Win *win;
+
+  assert (view);
+  assert (regs);
+
+  win = view->windows[WIN_REGISTERS];
+  if (regs->len == view->reg_len)
+    {
+      for (i = 0; i < regs->len; i += 2)
 	{
-	  t = p;
-	  LPRINT (p, p != buf, size, "+0x%08X - %s", line->offset,
-		  line->inst);
-	  if (p != t && t != buf)
+	  row = i / 2;
+	  changed = data_registers_is_changed (regs, i)
+	    || data_registers_is_changed (regs, i + 1);
+	  if (changed)
 	    {
-	      free (t);
+	      ret = view_register_row (view, regs, i, line, REG_LINE_LEN);
+	      if (ret < 0)
+		{
+		  break;
+		}
+	      win_set_line (win, row, line);
 	    }
-
-	  ret = win_add_line (view->windows[WIN_DISASSAMBLE], p, 1, 0);
-	  if (ret < 0)
+	  if (changed != view->reg_marked[row])
 	    {
-	      LOG_ERR ("Failed to add asm line");
-	      goto error;
+	      win_set_mark (win, row, 0, changed ? '*' : ' ');
+	      view->reg_marked[row] = changed;
 	    }
-	  win_set_mark (view->windows[WIN_DISASSAMBLE], -1, 0,
-			line->address == pc ? 'S' : ' ');
-	  line = line->next;
 	}
-      sline = sline->next;
+      if (i >= regs->len)
+	{
+	  goto out;
+	}
     }
-  update_panels ();
-  doupdate ();
-error:
-  if (p != buf)
+
+  /* Rebuild the view. */
+  view->reg_nlen = 0;
+  view->reg_vlen = 0;
+  for (i = 0; i < regs->len; i++)
+    {
+      if (regs->registers[i].name_len > view->reg_nlen)
+	{
+	  view->reg_nlen = regs->registers[i].name_len;
+	}
+      data_registers_get_str (regs, i, &ret);
+      if (ret > view->reg_vlen)
+	{
+	  view->reg_vlen = ret < REG_VALUE_LEN ? ret : REG_VALUE_LEN;
+	}
+    }
+  if (regs->len != view->reg_len)
+    {
+      free (view->reg_marked);
+      view->reg_marked = (char *) malloc (regs->len / 2 + 1);
+      LOG_ERR_IF_FATAL (view->reg_marked == NULL, "Memory");
+      view->reg_len = regs->len;
+    }
+
+  win_clear (win);
+  for (i = 0; i < regs->len; i += 2)
+    {
+      row = i / 2;
+      view_register_row (view, regs, i, line, REG_LINE_LEN);
+      win_add_line (win, line, 1, i);
+      view->reg_marked[row] = data_registers_is_changed (regs, i)
+	|| data_registers_is_changed (regs, i + 1);
+      win_set_mark (win, -1, 0, view->reg_marked[row] ? '*' : ' ');
+    }
+
+out:
+  view_refresh (view);
+}
+
+/**
+ * @brief Format a row in the memory view.
+ *
+ * The row shows the address, the bytes in hexadecimal and the bytes as
+ * characters. Bytes that have not been read are shown as '??'.
+ *
+ * @param view The view.
+ * @param address The address of the first byte of the row.
+ * @param line The buffer for the row, at least MEM_ROW_LEN (MEM_MAX_BYTES)
+ *        long.
+ */
+void
+view_memory_row (view * view, uint64_t address, char *line)
+{
+  mem_cache *cache = view->memory;
+  mem_page *page = NULL;
+  uint64_t end = cache->start + cache->length;
+  uint64_t a;
+  char byte[4];
+  char *hex;
+  char *chars;
+  int offset;
+  int i;
+
+  line[0] = '\0';
+  if (address >= end || address < cache->start)
+    {
+      return;
+    }
+
+  sprintf (line, "%016" PRIx64 ": ", address);
+  hex = line + 18;
+  chars = hex + 3 * view->mem_bytes;
+  *chars++ = ' ';
+  for (i = 0; i < view->mem_bytes; i++)
+    {
+      a = address + i;
+      if (a >= end || a < address)
+	{
+	  memcpy (hex + 3 * i, "   ", 3);
+	  chars[i] = ' ';
+	  continue;
+	}
+      if (page == NULL || a - page->address >= MEM_PAGE_SIZE)
+	{
+	  page = mem_cache_find (cache, a);
+	}
+      offset = page != NULL ? (int) (a - page->address) : 0;
+      if (page != NULL && MEM_PAGE_VALID (page, offset))
+	{
+	  snprintf (byte, sizeof (byte), "%02x ", page->data[offset]);
+	  memcpy (hex + 3 * i, byte, 3);
+	  chars[i] = isprint (page->data[offset]) ? page->data[offset] : '.';
+	}
+      else
+	{
+	  memcpy (hex + 3 * i, "?? ", 3);
+	  chars[i] = '?';
+	}
+    }
+  chars[i] = '\0';
+}
+
+/**
+ * @brief Draw the memory view.
+ *
+ * Only the rows that fit in the window are formatted, so the length of the
+ * region does not matter. The window is filled once, after that the rows
+ * are replaced.
+ *
+ * @param view The view.
+ */
+void
+view_draw_memory (view * view)
+{
+  Win *win = view->windows[WIN_MEMORY];
+  char line[MEM_ROW_LEN (MEM_MAX_BYTES)];
+  int rows;
+  int cols;
+  int i;
+
+  win_get_size (win, &rows, &cols);
+  if (view->mem_rows != rows)
+    {
+      win_clear (win);
+      for (i = 0; i < rows; i++)
+	{
+	  view_memory_row (view, view->mem_top + (uint64_t) i *
+			   view->mem_bytes, line);
+	  win_add_line (win, line, 0, i);
+	}
+      win_go_to_line (win, 0);
+      view->mem_rows = rows;
+    }
+  else
+    {
+      for (i = 0; i < rows; i++)
+	{
+	  view_memory_row (view, view->mem_top + (uint64_t) i *
+			   view->mem_bytes, line);
+	  win_set_line (win, i, line);
+	}
+    }
+}
+
+/**
+ * @brief Scroll the memory view.
+ *
+ * @param view The view.
+ * @param n Number of rows to scroll, negative to scroll up.
+ *
+ * @return 0 if the view was scrolled, -1 at the start or end of the region.
+ */
+int
+view_scroll_memory (view * view, int n)
+{
+  uint64_t rows;
+  uint64_t row;
+  uint64_t last;
+
+  if (view->memory == NULL || view->memory->length == 0)
+    {
+      return -1;
+    }
+
+  rows = (view->memory->length + view->mem_bytes - 1) / view->mem_bytes;
+  last = rows > (uint64_t) view->mem_rows ? rows - view->mem_rows : 0;
+  row = (view->mem_top - view->mem_start) / view->mem_bytes;
+  if (n < 0)
+    {
+      row = row > (uint64_t) -n ? row + n : 0;
+    }
+  else
+    {
+      row = last - row > (uint64_t) n ? row + n : last;
+    }
+  if (view->mem_start + row * view->mem_bytes == view->mem_top)
+    {
+      return -1;
+    }
+  view->mem_top = view->mem_start + row * view->mem_bytes;
+  view_draw_memory (view);
+
+  return 0;
+}
+
+/**
+ * @brief Update the memory view.
+ *
+ * The view is moved to the start of the region when the region changes.
+ *
+ * @param view The view.
+ * @param cache The memory, with the region to show.
+ */
+void
+view_update_memory (view * view, mem_cache * cache)
+{
+  int rows;
+  int cols;
+  char status[64];
+
+  assert (view);
+  assert (cache);
+
+  if (view->windows[WIN_MEMORY] == NULL)
+    {
+      return;
+    }
+
+  if (view->memory != cache || view->mem_start != cache->start)
     {
-      free (p);
+      view->memory = cache;
+      view->mem_start = cache->start;
+      view->mem_top = cache->start;
+      win_get_size (view->windows[WIN_MEMORY], &rows, &cols);
+      view->mem_bytes = MEM_MAX_BYTES;
+      while (view->mem_bytes > 4 && MEM_ROW_LEN (view->mem_bytes) - 1 > cols)
+	{
+	  view->mem_bytes /= 2;
+	}
+      snprintf (status, sizeof (status), "%s 0x%" PRIx64, _("Memory"),
+		cache->start);
+      win_set_status (view->windows[WIN_MEMORY], status);
     }
+  view_draw_memory (view);
+
+  view_refresh (view);
 }
 
 /**
- * @brief Update the registers view.
- *
- * Update the registers view.
+ * @brief Get the shown memory.
  *
  * @param view The view.
- * @param regs The registers.
+ * @param address Set to the address of the top row.
+ * @param length Set to the number of bytes in the view.
+ *
+ * @return 0 upon success. -1 if no memory is shown.
  */
-void
-view_update_registers (view * view, data_registers * regs)
+int
+view_get_memory_view (view * view, uint64_t * address, uint64_t * length)
 {
-  int i;
-  char buf[512];
-  char *p = buf;
-  int size = 512;
-  int nlen = 0;
-  int vlen = 0;
+  uint64_t end;
 
   assert (view);
+  assert (address);
+  assert (length);
 
-  for (i = 0; i < regs->len; i++)
+  if (view->memory == NULL || view->memory->length == 0)
     {
-      if (strlen (regs->registers[i].reg_name) > nlen)
-	{
-	  nlen = strlen (regs->registers[i].reg_name);
-	}
-      if (regs->registers[i].svalue
-	  && strlen (regs->registers[i].svalue) > vlen)
-	{
-	  vlen = strlen (regs->registers[i].svalue);
-	}
+      return -1;
     }
-  win_clear (view->windows[WIN_REGISTERS]);
 
-  for (i = 0; i < regs->len; i += 2)
+  end = view->memory->start + view->memory->length;
+  *address = view->mem_top;
+  *length = (uint64_t) view->mem_rows * view->mem_bytes;
+  if (*length > end - view->mem_top)
     {
-      LPRINT (p, p != buf, size, "%*s %*s %*s %*s", nlen,
-	      regs->registers[i].reg_name,
-	      vlen,
-	      regs->registers[i].svalue ? regs->registers[i].svalue : "",
-	      nlen, i + 1 < regs->len ? regs->registers[i + 1].reg_name : "",
-	      vlen,
-	      i + 1 <
-	      regs->len ? (regs->registers[i + 1].svalue ? regs->
-			   registers[i + 1].svalue : "") : "");
-      win_add_line (view->windows[WIN_REGISTERS], p, 1, i);
+      *length = end - view->mem_top;
     }
 
-  update_panels ();
-  doupdate ();
-  if (p != buf)
-    {
-      free (p);
-    }
+  return 0;
 }
 
 /**
@@ -1335,8 +2265,7 @@ view_remove_breakpoint (view * view, const char *file_name, int line_nr)
   win_set_mark (view->windows[WIN_MAIN], line_nr, 0, ' ');
   win_set_mark (view->windows[WIN_MAIN], line_nr, 1, ' ');
 
-  update_panels ();
-  doupdate ();
+  view_refresh (view);
 }
 
 /**
@@ -1345,6 +2274,11 @@ view_remove_breakpoint (view * view, const char *file_name, int line_nr)
  * Clear the main window and load a text file to the main window. Set \a line
  * in the middle of the window.
  *
+ * A file that is not shown is loaded in the background, the main window
+ * shows that it is loading until view_file_loaded() shows it. A prefetched
+ * file is also handed over by the loader thread, which checks that the file
+ * has not changed, so a slow file system never stops the user interface.
+ *
  * @param view The view.
  * @param file_name The file name.
  * @param line The line that should be in the middle of the window.
@@ -1355,6 +2289,8 @@ view_remove_breakpoint (view * view, const char *file_name, int line_nr)
 int
 view_show_file (view * view, const char *file_name, int line, int mark_stop)
 {
+  const char *shown;
+  char *status;
   int ret;
 
   assert (view);
@@ -1363,33 +2299,135 @@ view_show_file (view * view, const char *file_name, int line, int mark_stop)
 
   if (file_name == NULL || strlen (file_name) == 0)
     {
+      view_cancel_load (view);
       win_clear (view->windows[WIN_MAIN]);
       return 0;
     }
 
-  ret = win_load_file (view->windows[WIN_MAIN], file_name);
-  LOG_ERR_IF_RETURN (ret < 0, -1, "Could not load file '%s'", file_name);
+  shown = win_get_filename (view->windows[WIN_MAIN]);
+  if (view->loader == NULL
+      || (shown != NULL && strcmp (shown, file_name) == 0))
+    {
+      view_cancel_load (view);
+      return view_show_loaded (view, file_name, line, mark_stop);
+    }
 
-  if (mark_stop)
+  if (view->load_name == NULL || strcmp (view->load_name, file_name) != 0)
     {
-      if (view->last_stop_mark >= 0)
+      ret = file_loader_request (view->loader, file_name);
+      LOG_ERR_IF_RETURN (ret < 0, -1, "Could not load file '%s'", file_name);
+      free (view->load_name);
+      view->load_name = strdup (file_name);
+      LOG_ERR_IF_FATAL (view->load_name == NULL,
+			ERR_MSG_CREATE ("file name"));
+
+      status = (char *) malloc (strlen (file_name) + 32);
+      LOG_ERR_IF_FATAL (status == NULL, ERR_MSG_CREATE ("status"));
+      sprintf (status, _("Loading %s"), file_name);
+      win_set_status (view->windows[WIN_MAIN], status);
+      free (status);
+      view_refresh (view);
+    }
+  view->load_line = line;
+  view->load_mark = mark_stop;
+
+  return 0;
+}
+
+/**
+ * @brief Get the file descriptor of the file loader.
+ *
+ * @param view The view.
+ *
+ * @return A descriptor that is readable when view_file_loaded() should be
+ *         called, -1 if the files are loaded at once.
+ */
+int
+view_loader_fd (view * view)
+{
+  assert (view);
+
+  return view->loader != NULL ? file_loader_fd (view->loader) : -1;
+}
+
+/**
+ * @brief Show a file loaded in the background.
+ *
+ * Show the file last asked for by view_show_file(), if it has been loaded.
+ *
+ * @param view The view.
+ *
+ * @return 1 if the file is shown, 0 if it is not loaded yet, -1 if it could
+ *         not be loaded.
+ */
+int
+view_file_loaded (view * view)
+{
+  char *file_name;
+  text *text;
+  int ret;
+
+  assert (view);
+
+  if (view->loader == NULL
+      || file_loader_take (view->loader, &file_name, &text) == 0)
+    {
+      return 0;
+    }
+  if (view->load_name == NULL || strcmp (view->load_name, file_name) != 0)
+    {
+      /* Not wanted any more. */
+      free (file_name);
+      if (text != NULL)
 	{
-	  ret =
-	    win_set_mark (view->windows[WIN_MAIN], view->last_stop_mark, 2,
-			  ' ');
-	  LOG_ERR_IF (ret < 0, "Could not un-set mark");
+	  text_free (text);
 	}
-      ret = win_set_mark (view->windows[WIN_MAIN], line - 1, 2, 'S');
-      LOG_ERR_IF_RETURN (ret < 0, -1, "Could not set mark");
-      view->last_stop_mark = line - 1;
+      return 0;
     }
-  ret = win_go_to_line (view->windows[WIN_MAIN], line - 1);
-  LOG_ERR_IF_RETURN (ret < 0, -1, "Could not goto '%s':%d", file_name, line);
+  view_cancel_load (view);
 
-  update_panels ();
-  doupdate ();
+  if (text == NULL)
+    {
+      VLOG_ERR (view, _("Could not load file '%s'"), file_name);
+      free (file_name);
+      view_refresh (view);
+      return -1;
+    }
+  ret = view_install_file (view, file_name, text, view->load_line,
+			   view->load_mark);
+  free (file_name);
 
-  return 0;
+  return ret < 0 ? -1 : 1;
+}
+
+/**
+ * @brief Prefetch a file for the main window.
+ *
+ * Read a file in the background, so it is shown at once if it is selected.
+ * The shown file and the file being loaded are not prefetched.
+ *
+ * @param view The view.
+ * @param file_name The file name.
+ *
+ * @return 0 upon success, -1 if the file could not be prefetched.
+ */
+int
+view_prefetch_file (view * view, const char *file_name)
+{
+  const char *shown;
+
+  assert (view);
+  assert (file_name);
+
+  shown = win_get_filename (view->windows[WIN_MAIN]);
+  if (view->loader == NULL || *file_name == '\0'
+      || (shown != NULL && strcmp (shown, file_name) == 0)
+      || (view->load_name != NULL && strcmp (view->load_name, file_name) == 0))
+    {
+      return 0;
+    }
+
+  return file_loader_prefetch (view->loader, file_name) < 0 ? -1 : 0;
 }
 
 /**
@@ -1412,8 +2450,7 @@ view_set_status (view * view, int type, const char *status)
 		     || type > LAST_WINDOW, -1, "Wrong type %d", type);
   win_set_status (view->windows[type], status);
 
-  update_panels ();
-  doupdate ();
+  view_refresh (view);
 
   return 0;
 }
@@ -1448,8 +2485,7 @@ view_set_focus (view * view, int type)
   win_to_top (view->current_window);
 
   /* Update the screen. */
-  update_panels ();
-  doupdate ();
+  view_refresh (view);
 
   return 0;
 }
@@ -1504,10 +2540,16 @@ view_scroll_up (view * view)
 
   assert (view);
 
-  ret = win_move (view->current_window, 1);
+  if (view->current_index == WIN_MEMORY)
+    {
+      ret = view_scroll_memory (view, 1);
+    }
+  else
+    {
+      ret = win_move (view->current_window, 1);
+    }
 
-  update_panels ();
-  doupdate ();
+  view_refresh (view);
 
   return ret;
 }
@@ -1528,14 +2570,196 @@ view_scroll_down (view * view)
 
   assert (view);
 
-  ret = win_move (view->current_window, -1);
+  if (view->current_index == WIN_MEMORY)
+    {
+      ret = view_scroll_memory (view, -1);
+    }
+  else
+    {
+      ret = win_move (view->current_window, -1);
+    }
+
+  view_refresh (view);
 
-  update_panels ();
-  doupdate ();
+  return ret;
+}
+
+/**
+ * @brief Scroll the window a page.
+ *
+ * Scroll the current window one window height.
+ *
+ * @param view The view.
+ * @param dir 1 to scroll down, -1 to scroll up.
+ *
+ * @return 0 if the current window was scrolled. -1 if failed.
+ */
+int
+view_scroll_page (view * view, int dir)
+{
+  int ret;
+  int rows;
+  int cols;
+
+  assert (view);
+
+  win_get_size (view->current_window, &rows, &cols);
+  if (view->current_index == WIN_MEMORY)
+    {
+      ret = view_scroll_memory (view, dir * rows);
+    }
+  else
+    {
+      ret = win_move (view->current_window, dir * rows);
+    }
+
+  view_refresh (view);
+
+  return ret;
+}
+
+/**
+ * @brief Toggle the wrapping of the long lines.
+ *
+ * Toggles between wrapping the long lines of the current window and cutting
+ * them at the window width.
+ *
+ * @param view The view.
+ *
+ * @return 0 on success. -1 if failed.
+ */
+int
+view_toggle_wrap (view * view)
+{
+  int ret;
+
+  assert (view);
+
+  ret = win_set_wrap (view->current_window,
+		      !win_get_wrap (view->current_window));
+
+  view_refresh (view);
+
+  return ret;
+}
+
+/**
+ * @brief Scroll the window sideways.
+ *
+ * Scroll the current window, with cut lines, half a window width.
+ *
+ * @param view The view.
+ * @param dir 1 to scroll right, -1 to scroll left.
+ *
+ * @return 0 if the current window was scrolled. -1 if failed.
+ */
+int
+view_scroll_columns (view * view, int dir)
+{
+  int ret;
+  int rows;
+  int cols;
+
+  assert (view);
+
+  win_get_size (view->current_window, &rows, &cols);
+  ret = win_scroll_columns (view->current_window, dir * (cols + 1) / 2);
+
+  view_refresh (view);
+
+  return ret;
+}
+
+/**
+ * @brief Search the current window.
+ *
+ * Highlight the matches of @a pattern in the current window and go to the
+ * next match. The matches are counted by view_idle().
+ *
+ * @param view The view.
+ * @param pattern The pattern, NULL or an empty string removes the search.
+ * @param dir 1 to search forward, -1 to search backward.
+ * @param skip 1 to go to the next match after the current line. 0 to stay if
+ *             the current line matches.
+ *
+ * @return 0 if a match was found or the search removed. -1 if not found.
+ */
+int
+view_search (view * view, const char *pattern, int dir, int skip)
+{
+  int ret = 0;
+
+  assert (view);
+
+  win_set_search (view->current_window, pattern);
+  if (pattern != NULL && *pattern != '\0')
+    {
+      ret = win_search (view->current_window, dir, skip) < 0 ? -1 : 0;
+    }
+
+  view_refresh (view);
 
   return ret;
 }
 
+/**
+ * @brief Do work when there is no input.
+ *
+ * Count the matches of the searched patterns a part at the time, so a large
+ * text does not block the input. Do the screen update that was put off, if
+ * it is time for it, see view_refresh_time().
+ *
+ * @param view The view.
+ *
+ * @return 1 if there may be more work to do, otherwise 0.
+ */
+int
+view_idle (view * view)
+{
+  int more = 0;
+  int i;
+
+  assert (view);
+
+  for (i = 0; i <= LAST_WINDOW; i++)
+    {
+      if (view->windows[i] != NULL
+	  && win_count_matches (view->windows[i], SEARCH_COUNT_LINES))
+	{
+	  more = 1;
+	}
+    }
+  if (more || view->refresh_pending)
+    {
+      view_refresh (view);
+    }
+
+  return more;
+}
+
+/**
+ * @brief Time until the screen is updated.
+ *
+ * @param view The view.
+ *
+ * @return Microseconds until the screen update that was put off should be
+ *         done by view_idle(). -1 if the screen is up to date.
+ */
+long
+view_refresh_time (view * view)
+{
+  uint64_t now;
+
+  assert (view);
+
+  if (!view->refresh_pending || view->view_mode)
+    {
+      return -1;
+    }
+  now = view_time ();
+  return now < view->refresh_next ? (long) (view->refresh_next - now) : 0;
+}
+
 /**
  * @brief Select the next window.
  *
@@ -1604,8 +2828,7 @@ view_next_window (view * view, int dir, int type)
   win_set_focus (view->current_window, 1);
   win_to_top (view->current_window);
 
-  update_panels ();
-  doupdate ();
+  view_refresh (view);
 
   return 0;
 }
@@ -1631,8 +2854,7 @@ view_move_cursor (view * view, int n)
 
   if (ret == 0)
     {
-      update_panels ();
-      doupdate ();
+      view_refresh (view);
     }
 
   return ret;
@@ -1718,6 +2940,7 @@ view_toggle_view_mode (view * view)
       refresh ();
       doupdate ();
       view->view_mode = 0;
+      view->refresh_pending = 0;
     }
   else
     {
@@ -1726,3 +2949,39 @@ view_toggle_view_mode (view * view)
       view->view_mode = 1;
     }
 }
+
+/**
+ * @brief Lay out the windows again after the terminal was resized.
+ *
+ * The layout the view was set up from is parsed again for the new size of
+ * the screen. The windows keep their text, groups and focus.
+ *
+ * @param view The view.
+ *
+ * @return 0 on success. -1 on failure.
+ */
+int
+view_resize (view * view)
+{
+  unsigned int views;
+  int ret;
+
+  assert (view);
+
+  views = view->views;
+  view->views = 0;
+  view->resizing = 1;
+  ret = view_layout (view);
+  view->resizing = 0;
+  view->views = views;
+  LOG_ERR_IF_RETURN (ret < 0, -1, "Could not lay out the windows");
+
+  view_record_rows (view);
+  if (view->memory != NULL)
+    {
+      view_draw_memory (view);
+    }
+  view_refresh (view);
+
+  return 0;
+}
@@ -89,6 +89,7 @@ enum window_type
   WIN_FRAME,
   WIN_DISASSAMBLE,
   WIN_REGISTERS,
+  WIN_MEMORY,
 };
 
 /*******************************************************************************
@@ -103,25 +104,43 @@ int view_go_to_line (view * view, int type, int line_nr);
 
 int view_add_message (view * view, int level, const char *msg, ...);
 int view_add_line (view * view, int type, const char *line, int tag);
+int view_add_lines (view * view, int type, char *lines);
+int view_add_record (view * view, const char *record);
+int view_toggle_record (view * view);
 void view_update_breakpoints (view * view, breakpoint_table * bpt);
 void view_update_threads (view * view, thread_group * thread_groups);
 void view_update_libraries (view * view, library * libraries);
 void view_update_frame (view * view, stack * stack, int level);
 void view_update_stack (view * view, stack * stack);
-void view_update_ass (view * view, assembler * ass, int pc);
+void view_update_ass (view * view, asm_function * func, uint64_t pc);
+void view_move_ass_pc (view * view, asm_function * func, uint64_t old_pc,
+		       uint64_t pc);
 void view_update_registers (view * view, data_registers * regs);
+void view_update_memory (view * view, mem_cache * cache);
+int view_get_memory_view (view * view, uint64_t * address,
+			  uint64_t * length);
 void view_remove_breakpoint (view * view, const char *file_name, int line_nr);
 
 int view_show_file (view * view, const char *file_name, int line,
 		    int mark_stop);
+int view_loader_fd (view * view);
+int view_file_loaded (view * view);
+int view_prefetch_file (view * view, const char *file_name);
 
 int view_scroll_up (view * view);
 int view_scroll_down (view * view);
+int view_scroll_page (view * view, int dir);
+int view_scroll_columns (view * view, int dir);
+int view_toggle_wrap (view * view);
 int view_next_window (view * view, int dir, int type);
 int view_move_cursor (view * view, int n);
+int view_search (view * view, const char *pattern, int dir, int skip);
+int view_idle (view * view);
+long view_refresh_time (view * view);
 
 int view_get_tag (view * view, int *win);
 int view_get_cursor (view * view, int *win, int *line_nr,
 		     const char **file_name);
 void view_toggle_view_mode (view * view);
+int view_resize (view * view);
 #endif
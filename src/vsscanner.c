@@ -261,6 +261,66 @@ id_table_add (id_table * idt, int id, int index, int len)
   return 0;
 }
 
+/**
+ * @brief Get an id from the table.
+ *
+ * @param idt The table.
+ * @param nr The number of the id, less than the length of the table.
+ *
+ * @return The id.
+ */
+const id_entry *
+id_table_get (const id_table * idt, int nr)
+{
+  assert (idt);
+  assert (nr >= 0 && nr < idt->len);
+
+  return nr < DEF_IDT_LEN ? &idt->id[nr] : &idt->extra_id[nr - DEF_IDT_LEN];
+}
+
+/**
+ * @brief Replace the ids in the table.
+ *
+ * @param idt The table.
+ * @param ids The new ids.
+ * @param len The number of new ids.
+ *
+ * @return 0 upon success.
+ */
+int
+id_table_set (id_table * idt, const id_entry * ids, int len)
+{
+  id_entry *t;
+  int size;
+
+  assert (idt);
+  assert (ids || len == 0);
+
+  if (len > idt->size)
+    {
+      size = (len + DEF_IDT_LEN - 1) / DEF_IDT_LEN * DEF_IDT_LEN;
+      t = (id_entry *) realloc (idt->extra_id,
+				(size - DEF_IDT_LEN) * sizeof (id_entry));
+      if (t == NULL)
+	{
+	  return -1;
+	}
+      idt->extra_id = t;
+      idt->size = size;
+    }
+
+  memcpy (idt->id, ids, (len < DEF_IDT_LEN ? len : DEF_IDT_LEN) *
+	  sizeof (id_entry));
+  if (len > DEF_IDT_LEN)
+    {
+      memcpy (idt->extra_id, ids + DEF_IDT_LEN,
+	      (len - DEF_IDT_LEN) * sizeof (id_entry));
+    }
+  idt->len = len;
+
+  return 0;
+}
+
 /**
  * @brief Test if a part is a match.
  *
@@ -764,10 +824,10 @@ vsscanner_scan_match (vsscanner * scanner, scan_match * sm, const char *text,
       len = strlen (sm->first->match);
       DINFO (10, "Checking word '%s' (%d) cmp to '%s'", sm->first->match, len,
 	     text);
-      if ((*ind == 0 || ispunct (text[*ind - 1]) || isblank (text[*ind - 1]))
+      if (strncmp (text + *ind, sm->first->match, len) == 0
+	  && (*ind == 0 || ispunct (text[*ind - 1]) || isblank (text[*ind - 1]))
 	  && (text[*ind + len] == '\0' || ispunct (text[*ind + len])
-	      || isspace (text[*ind + len]))
-	  && strncmp (text + *ind, sm->first->match, len) == 0)
+	      || isspace (text[*ind + len])))
 	{
 	  /* Word matches. */
 	  r = text + *ind + len;
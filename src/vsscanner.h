@@ -73,4 +73,6 @@ void vsscanner_restart (vsscanner * scanner);
 int vsscanner_scan (vsscanner * scanner, const char *text, id_table * ids);
 int vsscanner_add_rule (vsscanner * scanner, const char *rule, int id,
 			int multiline, int word);
+const id_entry *id_table_get (const id_table * idt, int nr);
+int id_table_set (id_table * idt, const id_entry * ids, int len);
 #endif
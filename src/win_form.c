@@ -43,12 +43,16 @@
 
 #define HELP_STRING _("Use keys <UP> and <DOWN> to select item and <ENTER> " \
 		       "to chose item. <ESC> or `q' to cancel.")
+#define SEARCH_HELP_STRING _("Type to search. <UP> and <DOWN> to select " \
+			      "item and <ENTER> to chose item. <ESC> to cancel.")
 #define ENT_INCREASE 20
+#define SEARCH_PATTERN_LEN 256 /**< Max length of a search pattern. */
 /*******************************************************************************
  * Internal Functions
  ******************************************************************************/
 static void form_wait (void);
-static char *form_get_input (const char *value, const char *header);
+static char *form_get_input (const char *value, const char *header,
+			     form_update_func update, void *data);
 static int form_draw (input_field * fields, const char *header, WINDOW * win,
 		      int height, int width, int indent, int start_index,
 		      int selected);
@@ -56,6 +60,9 @@ static int form_exec (input_field * fields, const char *header, WINDOW * win,
 		      int height, int width, int indent);
 static int form_exec_selection (Win * win, char **list);
 static int form_exec_file (Win * win, char **list, const char *header);
+static int form_exec_search (Win * win, const char *header,
+			     form_match_func match, form_item_func item,
+			     void *data);
 
 /**
  * @brief Wait for user input.
@@ -82,16 +89,23 @@ form_wait (void)
  * end of line. The user does not need to be at end of line while pressing
  * '@<CR@>'.
  *
+ * If @a update is set it is called each time the value is edited, and the
+ * box is drawn at the bottom of the screen to not hide what is updated.
+ *
  * @param value The default value that is shown.
  * @param header A small help text shown in the box.
+ * @param update Called with the edited value, NULL if not used.
+ * @param data Passed to @a update.
  *
  * @return A pointer to a new value if user pressed @<CR@>. If the user pressed
  *         @<ESC@> a NULL pointer is returned.
  */
 static char *
-form_get_input (const char *value, const char *header)
+form_get_input (const char *value, const char *header,
+		form_update_func update, void *data)
 {
   char *out;
+  char *last;
   int len;
   WINDOW *win;
   int max_width;
@@ -128,10 +142,12 @@ form_get_input (const char *value, const char *header)
     {
       out[0] = '\0';
     }
+  last = strdup (out);
+  LOG_ERR_IF_FATAL (last == NULL, "Memory");
   getmaxyx (stdscr, max_height, max_width);
   width = max_width / 4 - 2;
-  win = newwin (3, max_width / 4, max_height / 2 - 1,
-		max_width / 2 - max_width / 8);
+  win = newwin (3, max_width / 4, update != NULL ? max_height - 3 :
+		max_height / 2 - 1, max_width / 2 - max_width / 8);
   box (win, 0, 0);
   keypad (win, 1);
   if (header != NULL)
@@ -148,6 +164,8 @@ form_get_input (const char *value, const char *header)
       wclrtoeol (win);
       box (win, 0, 0);
       wmove (win, y, x);
+      /* The update may have drawn over the box. */
+      touchwin (win);
       wnoutrefresh (win);
       doupdate ();
       form_wait ();
@@ -244,6 +262,7 @@ form_get_input (const char *value, const char *header)
 		  out = (char *) realloc (out, len + 64);
 		  if (out == NULL)
 		    {
+		      free (last);
 		      return NULL;
 		    }
 		  len += 64;
@@ -267,6 +286,7 @@ form_get_input (const char *value, const char *header)
 		      out = (char *) realloc (out, len + 64);
 		      if (out == NULL)
 			{
+			  free (last);
 			  return NULL;
 			}
 		      len += 64;
@@ -284,8 +304,17 @@ form_get_input (const char *value, const char *header)
       else
 	{
 	  DINFO (1, "KEY %d", c);
+	  continue;
+	}
+      if (update != NULL && strcmp (out, last) != 0)
+	{
+	  update (data, out);
+	  free (last);
+	  last = strdup (out);
+	  LOG_ERR_IF_FATAL (last == NULL, "Memory");
 	}
     }
+  free (last);
   wclear (win);
   wnoutrefresh (win);
   doupdate ();
@@ -545,7 +574,7 @@ form_exec (input_field * fields, const char *header, WINDOW * win, int height,
 	  if (fields[selected].type == INPUT_TYPE_STRING)
 	    {
 	      p = form_get_input (fields[selected].string_value,
-				  fields[selected].help);
+				  fields[selected].help, NULL, NULL);
 	      if (p != NULL)
 		{
 		  if (fields[selected].string_value != NULL
@@ -560,7 +589,7 @@ form_exec (input_field * fields, const char *header, WINDOW * win, int height,
 	  else if (fields[selected].type == INPUT_TYPE_INT)
 	    {
 	      snprintf (buf, 64, "%d", fields[selected].int_value);
-	      p = form_get_input (buf, fields[selected].help);
+	      p = form_get_input (buf, fields[selected].help, NULL, NULL);
 	      if (p != NULL)
 		{
 		  fields[selected].int_value = strtol (p, NULL, 0);
@@ -834,6 +863,115 @@ out:
   return ret;
 }
 
+/**
+ * @brief Execute a search form.
+ *
+ * Let the user type a pattern and show the matching items as the pattern is
+ * typed. Only the best matches that fit in the window are drawn.
+ *
+ * @param win The window.
+ * @param header Header shown in the form.
+ * @param match Matches the items against the pattern.
+ * @param item Gets the matching items.
+ * @param data Data passed to @a match and @a item.
+ *
+ * @return -2 on error. -1 if canceled. >=0 the number of the chosen match.
+ */
+static int
+form_exec_search (Win * win, const char *header, form_match_func match,
+		  form_item_func item, void *data)
+{
+  char pattern[SEARCH_PATTERN_LEN];
+  char line[SEARCH_PATTERN_LEN + 64];
+  const char *name;
+  int len = 0;
+  int changed = 1;
+  int nr_matches;
+  int rows;
+  int cols;
+  int ret;
+  int c;
+  int i;
+
+  pattern[0] = '\0';
+  win_to_top (win);
+  win_set_focus (win, 1);
+  win_get_size (win, &rows, &cols);
+
+  do
+    {
+      if (changed)
+	{
+	  nr_matches = match (data, pattern);
+	  snprintf (line, sizeof (line), "%s (%d)", header, nr_matches);
+	  win_set_status (win, line);
+	  win_clear (win);
+	  snprintf (line, sizeof (line), "> %s", pattern);
+	  ret = win_add_line (win, line, 1, -1);
+	  LOG_ERR_IF_RETURN (ret < 0, -2, "Could not add lines.");
+	  i = 0;
+	  while (i < nr_matches && i < rows - 2
+		 && (name = item (data, i)) != NULL)
+	    {
+	      ret = win_add_line (win, name, 1, i);
+	      LOG_ERR_IF_RETURN (ret < 0, -2, "Could not add lines.");
+	      i++;
+	    }
+	  if (i == 0)
+	    {
+	      ret = win_add_line (win, SEARCH_HELP_STRING, 1, -1);
+	      LOG_ERR_IF_RETURN (ret < 0, -2, "Could not add lines.");
+	    }
+	  win_go_to_line (win, 1);
+	  changed = 0;
+	}
+
+      update_panels ();
+      doupdate ();
+      /* Wait for input. */
+      form_wait ();
+      c = getch ();
+      switch (c)
+	{
+	case '\x1b':		/* <ESC> */
+	  return -1;
+	case KEY_UP:
+	  win_move_cursor (win, -1);
+	  break;
+	case KEY_DOWN:
+	  win_move_cursor (win, 1);
+	  break;
+	case KEY_BACKSPACE:
+	case '\b':
+	case 127:
+	  if (len > 0)
+	    {
+	      pattern[--len] = '\0';
+	      changed = 1;
+	    }
+	  break;
+	case '\r':
+	  ret = win_get_tag (win);
+	  if (ret >= 0)
+	    {
+	      return ret;
+	    }
+	  break;
+	default:
+	  if (c > 0 && c < 256 && isprint (c) && len < SEARCH_PATTERN_LEN - 1)
+	    {
+	      pattern[len++] = c;
+	      pattern[len] = '\0';
+	      changed = 1;
+	    }
+	}
+    }
+  while (1);
+
+  /* Never reached. */
+  return -1;
+}
+
 /*******************************************************************************
  * Public Functions
  ******************************************************************************/
@@ -1007,3 +1145,78 @@ form_selection (char **list, const char *header)
   win_free (win);
   return ret;
 }
+
+/**
+ * @brief Make a search form.
+ *
+ * Make a form where the user types a pattern and selects one of the items
+ * matching the pattern. The matches are updated for each typed character.
+ *
+ * @param header Header to be shown.
+ * @param match Matches the items against the pattern.
+ * @param item Gets the matching items.
+ * @param data Data passed to @a match and @a item.
+ *
+ * @return -1 if the user canceled, otherwise the number of the chosen match,
+ * as given to @a item. -2 on failure.
+ */
+int
+form_search (const char *header, form_match_func match, form_item_func item,
+	     void *data)
+{
+  int width;
+  int height;
+  int starty;
+  int startx;
+  int max_height;
+  int max_width;
+  int ret;
+  Win *win;
+  win_properties props =
+    { 0, WIN_PROP_CURSOR | WIN_PROP_BORDER, NULL, 0, NULL };
+
+  assert (header);
+  assert (match);
+  assert (item);
+
+  /* Get screen dimensions. */
+  getmaxyx (stdscr, max_height, max_width);
+
+  height = max_height * 0.5;
+  width = max_width * 2 / 3;
+  starty = max_height / 2 - height / 2;
+  startx = max_width / 2 - width / 2;
+
+  win = win_create (starty, startx, height, width, &props);
+  LOG_ERR_IF_RETURN (win == NULL, -2, "Could not create search window");
+
+  DINFO (1, "Running form search '%s' %dx%d at (%d; %d)", header, height,
+	 width, starty, startx);
+
+  ret = form_exec_search (win, header, match, item, data);
+
+  win_free (win);
+  return ret;
+}
+
+/**
+ * @brief Let the user type a value.
+ *
+ * Show a box where the user types a value. @a update is called each time the
+ * value is edited, e.g. for searching as the user types.
+ *
+ * @param value The default value, NULL if none.
+ * @param header Header shown in the box.
+ * @param update Called with the edited value, NULL if not used.
+ * @param data Passed to @a update.
+ *
+ * @return The value, the caller must free it. NULL if the user canceled.
+ */
+char *
+form_input (const char *value, const char *header, form_update_func update,
+	    void *data)
+{
+  assert (header);
+
+  return form_get_input (value, header, update, data);
+}
@@ -83,9 +83,41 @@ typedef struct input_field_t
                            */
 } input_field;
 
+/**
+ * @brief Match the items of a search form against a pattern.
+ *
+ * @param data The data given to form_search().
+ * @param pattern The pattern typed by the user.
+ *
+ * @return The number of matching items.
+ */
+typedef int (*form_match_func) (void *data, const char *pattern);
+
+/**
+ * @brief Get a matching item of a search form.
+ *
+ * @param data The data given to form_search().
+ * @param nr The number of the match, 0 is the best match.
+ *
+ * @return The item, NULL if there is no such match.
+ */
+typedef const char *(*form_item_func) (void *data, int nr);
+
+/**
+ * @brief Called when the value of an input form is edited.
+ *
+ * @param data The data given to form_input().
+ * @param value The edited value.
+ */
+typedef void (*form_update_func) (void *data, const char *value);
+
 /*******************************************************************************
  * Public functions
  ******************************************************************************/
 int form_run (input_field * fields, const char *header);
 int form_selection (char **list, const char *header);
+int form_search (const char *header, form_match_func match,
+		 form_item_func item, void *data);
+char *form_input (const char *value, const char *header,
+		  form_update_func update, void *data);
 #endif
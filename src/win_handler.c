@@ -31,9 +31,11 @@
 #include <ctype.h>
 
 #include "win_handler.h"
+#include "lvdbg.h"
 #include "text.h"
 #include "debug.h"
 #include "vsscanner.h"
+#include "syntax_cache.h"
 #include "misc.h"
 
 #define MARKS_LEN 10 /**< Max number of markers. */
@@ -42,8 +44,16 @@
                           * text line info.
                           */
 
+/** Attribute of a match, the cursor line is already reversed. */
+#define MATCH_ATTR(cursor) ((cursor) ? A_UNDERLINE : A_REVERSE)
+
 #define NEEDS_TEXT_LINE_INFO(x) ((x) & (WIN_PROP_MARKS | WIN_PROP_CURSOR))
 
+/** The last part of a text line, lines are not wrapped in no-wrap mode. */
+#define LAST_PART(win, len, width) ((win)->nowrap ? 0 : (len) / (width))
+/** Number of screen rows of a text line. */
+#define LINE_ROWS(win, len, width) (LAST_PART (win, len, width) + 1)
+
 /*******************************************************************************
  * Internal structures and enums
  ******************************************************************************/
@@ -113,19 +123,54 @@ struct Win_t
                     * file.
                     */
   vsscanner *scanner; /**< Scanner used for finding parts to highlight. */
+  uint64_t syntax;    /**< Hash of the scanner definitions. */
+
+  text_pattern *search; /**< The pattern searched for, NULL if none. */
+  int search_line;	/**< The line of the last match, -1 if none. */
+  int search_count;	/**< Number of matches in the counted lines. */
+  int search_counted;	/**< Number of counted lines. */
+  int *rows;	   /**<
+                    * Fenwick tree of the number of screen rows of the text
+                    * lines. Node i holds the rows of the lines
+                    * (i - (i & -i), i].
+                    */
+  int rows_size;   /**< Allocated length of @a rows. */
+  int rows_valid;  /**< Number of text lines in @a rows. */
+  int rows_width;  /**< The text width @a rows was counted for. */
+  int nowrap;	   /**< 1 if the lines are cut instead of wrapped. */
+  int column;	   /**< The first shown column in no-wrap mode. */
+  int hidden;	   /**<
+                    * 1 if another window covers the window. Only the text
+                    * is updated while hidden.
+                    */
+  int dirty;	   /**< 1 if the window is redrawn when it is shown. */
+  int show_last;   /**< 1 if the last line is shown when it is shown. */
 };
 
 /*******************************************************************************
  * Internal Functions
  ******************************************************************************/
 int win_setup_scanner (Win * win);
+int win_load_syntax_cache (Win * win);
+const id_table *win_get_ids (void *data, int line);
 int win_draw_text_line (Win * win, int n);
 int win_draw_line (Win * win, int y, int width);
+void win_draw_matches (Win * win, int y, int width, int cursor);
 int win_update_cursor (Win * win, int pos);
 void win_add_text_line_info (Win * win, int tli_len);
 void win_redraw_status (Win * win);
 int win_redraw_show_top (Win * win, int line);
 int win_redraw_show_bottom (Win * win, int line);
+int win_redraw_from (Win * win, int line, int part);
+int win_rows_update (Win * win);
+int win_rows_before (Win * win, int line);
+int win_rows_find (Win * win, int row, int *part);
+void win_rows_set (Win * win, int line, int old_len, int len);
+int win_scroll_rows (Win * win, int nr_of_lines);
+int win_line_start (Win * win, int y, int width);
+int win_reflow (Win * win, int top, int bottom);
+int win_covers (Win * win, PANEL * panel);
+void win_catch_up (Win * win);
 
 /**
  * @brief Set up scanner.
@@ -174,6 +219,7 @@ win_setup_scanner (Win * win)
       LOG_ERR ("Could not create definitions");
       goto error;
     }
+  win->syntax = syntax_cache_hash (text);
 
   next = text;
   while (next && *next)
@@ -266,6 +312,62 @@ error:
   return -1;
 }
 
+/**
+ * @brief Load the highlighting of a file from the cache.
+ *
+ * @param win The window, with the file loaded in the text.
+ *
+ * @return 0 if the highlighting was loaded, -1 if the file must be scanned.
+ */
+int
+win_load_syntax_cache (Win * win)
+{
+  syntax_cache *cache;
+  const id_entry *ids;
+  int lines;
+  int len;
+  int ret = 0;
+  int i;
+
+  cache = syntax_cache_open (win->file_name, win->syntax);
+  if (cache == NULL)
+    {
+      return -1;
+    }
+
+  lines = text_nr_of_lines (win->text);
+  if (syntax_cache_nr_of_lines (cache) != lines)
+    {
+      ret = -1;
+    }
+  for (i = 0; i < lines && ret == 0; i++)
+    {
+      ids = syntax_cache_get_line (cache, i, &len);
+      if (ids == NULL
+	  || id_table_set (&win->text_line_info[i].ids, ids, len) < 0)
+	{
+	  ret = -1;
+	}
+    }
+  syntax_cache_close (cache);
+
+  return ret;
+}
+
+/**
+ * @brief Get the ids of a line, used when storing the syntax cache.
+ *
+ * @param data The window.
+ * @param line The line.
+ *
+ * @return The ids.
+ */
+const id_table *
+win_get_ids (void *data, int line)
+{
+  return &((Win *) data)->text_line_info[line].ids;
+}
+
 /**
  * @brief Draw a line of text.
  *
@@ -299,6 +401,21 @@ win_draw_text_line (Win * win, int n)
   return 0;
 }
 
+/**
+ * @brief The first text column shown on a window line.
+ *
+ * @param win The window.
+ * @param y The window line.
+ * @param width The window body text width. The window width - indent.
+ *
+ * @return The column of the text line.
+ */
+int
+win_line_start (Win * win, int y, int width)
+{
+  return win->nowrap ? win->column : win->line_info[y].part * width;
+}
+
 /**
  * @brief Draw a line in the window.
  *
@@ -317,8 +434,10 @@ win_draw_line (Win * win, int y, int width)
   int part;
   int ret = 0;
   int i;
+  int j;
   int xstart;
   int xstop;
+  int end;
   id_table *pid;
   int x;
   int border = win->props.properties & WIN_PROP_BORDER ? 1 : 0;
@@ -341,18 +460,36 @@ win_draw_line (Win * win, int y, int width)
       wattron (win->window, A_REVERSE);
     }
 
+  xstart = win_line_start (win, y, width);
+  xstop = xstart + width < win->line_info[y].len ?
+    xstart + width : win->line_info[y].len;
+  if (xstart >= xstop)
+    {
+      /* Nothing in the shown columns. */
+      goto out;
+    }
   if ((win->props.properties & WIN_PROP_SYNTAX) == 0)
     {
       ret = mvwaddnstr (win->window, y + border, win->props.indent + border,
-			win->line_info[y].text +
-			win->line_info[y].part * width, width);
+			win->line_info[y].text + xstart, xstop - xstart);
       goto out;
     }
-  i = 0;
+
+  /* The first id that ends in the shown columns. */
   pid = &win->text_line_info[n].ids;
-  xstart = win->line_info[y].part * width;
-  xstop = xstart + (win->line_info[y].part < win->line_info[y].len / width ?
-		    width : win->line_info[y].len % width);
+  i = 0;
+  j = pid->len;
+  while (i < j)
+    {
+      if (pid->id[(i + j) / 2].index + pid->id[(i + j) / 2].len <= xstart)
+	{
+	  i = (i + j) / 2 + 1;
+	}
+      else
+	{
+	  j = (i + j) / 2;
+	}
+    }
   x = xstart;
   while (x < xstop)
     {
@@ -365,39 +502,32 @@ win_draw_line (Win * win, int y, int width)
 	{
 	  DINFO (1, "Attr %d %d", win->props.attributes[pid->id[i].id].color,
 		 win->props.attributes[pid->id[i].id].attr);
+	  end = pid->id[i].index + pid->id[i].len;
+	  end = end < xstop ? end : xstop;
 	  wattron (win->window,
 		   COLOR_PAIR (win->props.attributes[pid->id[i].id].color));
 	  wattron (win->window, win->props.attributes[pid->id[i].id].attr);
-	  ret = mvwaddnstr (win->window, y, win->props.indent + x - xstart,
-			    win->line_info[y].text + x,
-			    pid->id[i].index + pid->id[i].len - x);
+	  ret = mvwaddnstr (win->window, y + border,
+			    win->props.indent + border + x - xstart,
+			    win->line_info[y].text + x, end - x);
 	  wattroff (win->window, win->props.attributes[pid->id[i].id].attr);
 	  wattroff (win->window,
 		    COLOR_PAIR (win->props.attributes[pid->id[i].id].color));
 	  DINFO (10, "Draw attr %d %d %d %d %d '%.*s'",
 		 i, n, x, pid->id[i].index, pid->id[i].len,
-		 pid->id[i].index + pid->id[i].len - x,
-		 win->line_info[y].text + x);
-	  x = pid->id[i].index + pid->id[i].len;
-	}
-      else if (i < pid->len && pid->id[i].len > 0)
-	{
-	  ret = mvwaddnstr (win->window, y, win->props.indent + x - xstart,
-			    win->line_info[y].text + x, pid->id[i].index - x);
-	  DINFO (10, "Draw to attr %d %d %d %d %d '%.*s'",
-		 i, n, x, pid->id[i].index, pid->id[i].len,
-		 pid->id[i].index - x, win->line_info[y].text + x);
-	  x = pid->id[i].index;
+		 end - x, win->line_info[y].text + x);
 	}
       else
 	{
-	  ret = mvwaddnstr (win->window, y, win->props.indent + x - xstart,
-			    win->line_info[y].text + x, xstop - x);
-	  DINFO (10, "Draw %d %d %d %d %d '%.*s'",
-		 i, n, x, pid->id[i].index, pid->id[i].len,
-		 xstop - x, win->line_info[y].text + x);
-	  x = xstop;
+	  end = i < pid->len && pid->id[i].index < xstop ?
+	    pid->id[i].index : xstop;
+	  ret = mvwaddnstr (win->window, y + border,
+			    win->props.indent + border + x - xstart,
+			    win->line_info[y].text + x, end - x);
+	  DINFO (10, "Draw %d %d %d '%.*s'", i, n, x, end - x,
+		 win->line_info[y].text + x);
 	}
+      x = end;
     }
 
 out:
@@ -405,6 +535,14 @@ out:
       && win->text_line_info[n].cur_pos)
     {
       wattroff (win->window, A_REVERSE);
+      if (win->search != NULL)
+	{
+	  win_draw_matches (win, y, width, 1);
+	}
+    }
+  else if (win->search != NULL)
+    {
+      win_draw_matches (win, y, width, 0);
     }
 
   if (win->props.properties & WIN_PROP_BORDER)
@@ -414,6 +552,52 @@ out:
   return ret;
 }
 
+/**
+ * @brief Highlight the matches on a window line.
+ *
+ * Changes the attributes of the matches of the searched pattern that are
+ * drawn on window line @a y.
+ *
+ * @param win The window.
+ * @param y The window line.
+ * @param width The window body text width. The window width - indent.
+ * @param cursor 1 if the line is the cursor line.
+ */
+void
+win_draw_matches (Win * win, int y, int width, int cursor)
+{
+  const char *text = win->line_info[y].text;
+  const char *p;
+  const char *end;
+  int xstart;
+  int xstop;
+  int start;
+  int stop;
+  int len;
+  int border = win->props.properties & WIN_PROP_BORDER ? 1 : 0;
+
+  text_pattern_get (win->search, &len);
+  xstart = win_line_start (win, y, width);
+  xstop = xstart + width < win->line_info[y].len ?
+    xstart + width : win->line_info[y].len;
+  p = text;
+  end = text + win->line_info[y].len;
+  while ((p = text_pattern_find (win->search, p, end - p)) != NULL
+	 && p - text < xstop)
+    {
+      start = p - text;
+      stop = start + len > xstop ? xstop : start + len;
+      if (stop > xstart)
+	{
+	  start = start < xstart ? xstart : start;
+	  mvwchgat (win->window, y + border,
+		    win->props.indent + border + start - xstart,
+		    stop - start, MATCH_ATTR (cursor), 0, NULL);
+	}
+      p += len;
+    }
+}
+
 /**
  * @brief Set cursor position.
  *
@@ -501,6 +685,7 @@ win_add_text_line_info (Win * win, int nr)
       win->text_line_info[i].cur_pos = 0;
       win->text_line_info[i].ids.len = 0;
       win->text_line_info[i].ids.size = DEF_IDT_LEN;
+      win->text_line_info[i].ids.extra_id = NULL;
     }
 
   win->tli_len = nr;
@@ -516,6 +701,8 @@ win_add_text_line_info (Win * win, int nr)
 void
 win_redraw_status (Win * win)
 {
+  char count[64];
+  int len;
   int ret;
   int border = win->props.properties & WIN_PROP_BORDER ? 1 : 0;
   if (win->focus)
@@ -528,6 +715,21 @@ win_redraw_status (Win * win)
     }
   ret = mvwaddnstr (win->window, win->height - 1 + border, border,
 		    win->status_line, win->width);
+  if (win->search != NULL)
+    {
+      /* The number of matches, '+' while still counting. */
+      len = snprintf (count, sizeof (count), " %d%s %s ", win->search_count,
+		      win->search_counted < text_nr_of_lines (win->text) ?
+		      "+" : "", win->search_count == 1 ? _("match") :
+		      _("matches"));
+      if (len < win->width)
+	{
+	  wclrtoeol (win->window);
+	  ret = mvwaddstr (win->window, win->height - 1 + border,
+			   border + win->width - len, count);
+	}
+    }
+  wmove (win->window, win->height - 1 + border, border);
   wchgat (win->window, -1, win->focus ? A_UNDERLINE : A_REVERSE, 1, NULL);
   if (win->focus)
     {
@@ -553,14 +755,6 @@ win_redraw_status (Win * win)
 int
 win_redraw_show_top (Win * win, int line)
 {
-  int y;
-  int n;
-  int part;
-  int len;
-  int width = win->width - win->props.indent;
-  const char *text = NULL;
-  int ret;
-
   if (line < 0)
     {
       line = 0;
@@ -569,45 +763,7 @@ win_redraw_show_top (Win * win, int line)
     {
       line = text_nr_of_lines (win->text) - 1;
     }
-  n = line - 1;
-  y = 0;
-  part = 0;
-  len = 0;
-  while (y < win->height - 1)
-    {
-      if (part == len / width)
-	{
-	  n++;
-	  text = text_get_line (win->text, n, &len);
-	  if (text == NULL)
-	    {
-	      /* No more text */
-	      goto out;
-	    }
-	  part = 0;
-	}
-      else
-	{
-	  part++;
-	}
-      win->line_info[y].len = len;
-      win->line_info[y].n = n;
-      win->line_info[y].part = part;
-      win->line_info[y].text = text;
-      ret = win_draw_line (win, y, width);
-      y++;
-    }
-  return 0;
-
-out:
-  while (y < win->height - 2)
-    {
-      win->line_info[y].len = -1;
-      win->line_info[y].n = -1;
-      win->line_info[y].part = -1;
-      y++;
-    }
-  return 0;
+  return win_redraw_from (win, line, 0);
 }
 
 /**
@@ -643,6 +799,7 @@ win_redraw_show_bottom (Win * win, int line)
       line = text_nr_of_lines (win->text) - 1;
     }
 
+  win->show_last = 0;
   width = win->width - win->props.indent;
   y = win->height - 2;
   n = line + 1;
@@ -657,7 +814,7 @@ win_redraw_show_bottom (Win * win, int line)
 	    {
 	      goto error;
 	    }
-	  part = len / width;
+	  part = LAST_PART (win, len, width);
 	}
       else
 	{
@@ -677,6 +834,362 @@ error:
   return -1;
 }
 
+/**
+ * @brief Redraws the window from a part of a line.
+ *
+ * Redraws the window with the part @a part of the text line @a line as the
+ * first line in the window.
+ *
+ * @param win The window.
+ * @param line The text line.
+ * @param part The part of the text line.
+ *
+ * @return 0 on success. -1 on failure.
+ */
+int
+win_redraw_from (Win * win, int line, int part)
+{
+  int y;
+  int len;
+  int width = win->width - win->props.indent;
+  const char *text;
+  int ret;
+
+  win->show_last = 0;
+  text = text_get_line (win->text, line, &len);
+  y = 0;
+  while (text != NULL && y < win->height - 1)
+    {
+      win->line_info[y].len = len;
+      win->line_info[y].n = line;
+      win->line_info[y].part = part;
+      win->line_info[y].text = text;
+      ret = win_draw_line (win, y, width);
+      y++;
+      if (part == LAST_PART (win, len, width))
+	{
+	  line++;
+	  part = 0;
+	  text = text_get_line (win->text, line, &len);
+	}
+      else
+	{
+	  part++;
+	}
+    }
+
+  /* No more text. */
+  while (y < win->height - 1)
+    {
+      win->line_info[y].len = -1;
+      win->line_info[y].n = -1;
+      win->line_info[y].part = -1;
+      win->line_info[y].text = NULL;
+      y++;
+    }
+  return 0;
+}
+
+/**
+ * @brief Bring the row index up to date.
+ *
+ * The index is counted again if the text width changed. Otherwise only the
+ * lines added since the last call are added to it.
+ *
+ * @param win The window.
+ *
+ * @return 0 on success. -1 on failure.
+ */
+int
+win_rows_update (Win * win)
+{
+  int width = win->width - win->props.indent;
+  int lines = text_nr_of_lines (win->text);
+  int *rows;
+  int len;
+  int i;
+  int j;
+
+  if (win->rows_width != width)
+    {
+      win->rows_valid = 0;
+      win->rows_width = width;
+    }
+  if (lines >= win->rows_size)
+    {
+      rows = (int *) realloc (win->rows, (lines + TLI_INCREASE) *
+			      sizeof (*rows));
+      LOG_ERR_IF_RETURN (rows == NULL, -1, ERR_MSG_CREATE ("rows"));
+      win->rows = rows;
+      win->rows_size = lines + TLI_INCREASE;
+    }
+  for (i = win->rows_valid + 1; i <= lines; i++)
+    {
+      text_get_line (win->text, i - 1, &len);
+      win->rows[i] = LINE_ROWS (win, len, width);
+      for (j = i - 1; j > i - (i & -i); j -= j & -j)
+	{
+	  win->rows[i] += win->rows[j];
+	}
+    }
+  win->rows_valid = lines;
+  return 0;
+}
+
+/**
+ * @brief Number of screen rows before a line.
+ *
+ * @param win The window.
+ * @param line The text line, at most the number of indexed lines.
+ *
+ * @return The screen rows of the lines before @a line.
+ */
+int
+win_rows_before (Win * win, int line)
+{
+  int rows = 0;
+
+  for (; line > 0; line -= line & -line)
+    {
+      rows += win->rows[line];
+    }
+  return rows;
+}
+
+/**
+ * @brief Find the text line of a screen row.
+ *
+ * @param win The window.
+ * @param row The screen row, counted from the first text line.
+ * @param part Returns the part of the line.
+ *
+ * @return The text line. The number of indexed lines if @a row is after the
+ *         text.
+ */
+int
+win_rows_find (Win * win, int row, int *part)
+{
+  int line = 0;
+  int step = 1;
+
+  while (step * 2 <= win->rows_valid)
+    {
+      step *= 2;
+    }
+  for (; step > 0; step /= 2)
+    {
+      if (line + step <= win->rows_valid && win->rows[line + step] <= row)
+	{
+	  line += step;
+	  row -= win->rows[line];
+	}
+    }
+  *part = row;
+  return line;
+}
+
+/**
+ * @brief Update the row index for a changed line.
+ *
+ * @param win The window.
+ * @param line The text line.
+ * @param old_len The previous length of the line.
+ * @param len The new length of the line.
+ */
+void
+win_rows_set (Win * win, int line, int old_len, int len)
+{
+  int width = win->width - win->props.indent;
+  int diff;
+
+  if (line >= win->rows_valid || win->rows_width != width)
+    {
+      return;
+    }
+  diff = LINE_ROWS (win, len, width) - LINE_ROWS (win, old_len, width);
+  for (line++; diff != 0 && line <= win->rows_valid; line += line & -line)
+    {
+      win->rows[line] += diff;
+    }
+}
+
+/**
+ * @brief Scroll many screen rows at once.
+ *
+ * The new first row is looked up in the row index and the window is
+ * redrawn, instead of scrolling one row at the time.
+ *
+ * @param win The window, which must be filled.
+ * @param nr_of_lines The number of screen rows to scroll.
+ *
+ * @return 0 on success. -1 if the window could not be scrolled all the rows.
+ */
+int
+win_scroll_rows (Win * win, int nr_of_lines)
+{
+  int row;
+  int last;
+  int part;
+  int line;
+  int ret;
+
+  ret = win_rows_update (win);
+  LOG_ERR_IF_RETURN (ret < 0, -1, "Could not index the rows");
+
+  row = win_rows_before (win, win->line_info[0].n) + win->line_info[0].part
+    + nr_of_lines;
+  last = win_rows_before (win, win->rows_valid) - (win->height - 1);
+  ret = 0;
+  if (row > last)
+    {
+      row = last;
+      ret = -1;
+    }
+  if (row < 0)
+    {
+      row = 0;
+      ret = -1;
+    }
+  line = win_rows_find (win, row, &part);
+
+  werase (win->window);
+  if (win->props.properties & WIN_PROP_BORDER)
+    {
+      box (win->window, 0, 0);
+    }
+  win_redraw_status (win);
+  win_redraw_from (win, line, part);
+  return ret;
+}
+
+/**
+ * @brief Flow the shown lines again.
+ *
+ * Redraws the whole window after the size or the wrapping of the lines
+ * changed. The window keeps the text line @a top first, or the last line if
+ * @a bottom was the last line. A window with a cursor keeps the cursor in
+ * sight.
+ *
+ * @param win The window.
+ * @param top The first shown text line, -1 if none.
+ * @param bottom The last shown text line.
+ *
+ * @return 0 on success. -1 on failure.
+ */
+int
+win_reflow (Win * win, int top, int bottom)
+{
+  int last;
+  int i;
+  int ret;
+
+  werase (win->window);
+  if (win->props.properties & WIN_PROP_BORDER)
+    {
+      box (win->window, 0, 0);
+    }
+  win_redraw_status (win);
+  for (i = 0; i < win->height - 1; i++)
+    {
+      win->line_info[i].len = -1;
+      win->line_info[i].n = -1;
+      win->line_info[i].part = -1;
+      win->line_info[i].text = NULL;
+    }
+  if (top < 0)
+    {
+      /* Nothing shown. */
+      return 0;
+    }
+
+  last = text_nr_of_lines (win->text) - 1;
+  if (bottom == last && top > 0)
+    {
+      ret = win_redraw_show_bottom (win, last);
+    }
+  else
+    {
+      ret = win_redraw_show_top (win, top);
+    }
+  if (ret == 0 && (win->props.properties & WIN_PROP_CURSOR)
+      && win->cursor_pos >= 0)
+    {
+      ret = win_move_cursor (win, 0);
+    }
+  return ret;
+}
+
+/**
+ * @brief Check if the window covers a panel.
+ *
+ * @param win The window.
+ * @param panel The panel.
+ *
+ * @return 1 if @a panel is entirely within the window. Otherwise 0.
+ */
+int
+win_covers (Win * win, PANEL * panel)
+{
+  WINDOW *w = panel_window (panel);
+  int y;
+  int x;
+  int h;
+  int wd;
+  int top_y;
+  int top_x;
+  int top_h;
+  int top_w;
+
+  getbegyx (w, y, x);
+  getmaxyx (w, h, wd);
+  getbegyx (win->window, top_y, top_x);
+  getmaxyx (win->window, top_h, top_w);
+  return y >= top_y && x >= top_x && y + h <= top_y + top_h
+    && x + wd <= top_x + top_w;
+}
+
+/**
+ * @brief Redraw a window that was hidden.
+ *
+ * The text was changed while the window was hidden, so the window is drawn
+ * once from the text.
+ *
+ * @param win The window.
+ */
+void
+win_catch_up (Win * win)
+{
+  int line = win->line_info[0].n;
+  int part = win->line_info[0].part;
+  int len;
+
+  DINFO (5, "Catching up hidden window '%s'",
+	 win->status_line ? win->status_line : "-");
+  win->dirty = 0;
+  werase (win->window);
+  if (win->props.properties & WIN_PROP_BORDER)
+    {
+      box (win->window, 0, 0);
+    }
+  win_redraw_status (win);
+  if (win->show_last && text_nr_of_lines (win->text) > 0)
+    {
+      win_redraw_show_bottom (win, text_nr_of_lines (win->text) - 1);
+    }
+  else if (line >= 0 && text_get_line (win->text, line, &len) != NULL)
+    {
+      if (part > LAST_PART (win, len, win->width - win->props.indent))
+	{
+	  part = 0;
+	}
+      win_redraw_from (win, line, part);
+    }
+  else
+    {
+      win_redraw_show_top (win, 0);
+    }
+}
+
 /*******************************************************************************
  * Public Functions
  ******************************************************************************/
@@ -714,6 +1227,8 @@ win_create (int starty, int startx, int height, int width,
   wnd->file_name = NULL;
   wnd->scanner = NULL;
   wnd->focus = 0;
+  wnd->search = NULL;
+  wnd->search_line = -1;
 
   /* Create nurces objects. */
   wnd->window = newwin (height, width, starty, startx);
@@ -726,6 +1241,7 @@ win_create (int starty, int startx, int height, int width,
     {
       goto error;
     }
+  set_panel_userptr (wnd->panel, wnd);
 
   wnd->text = text_create ();
   if (wnd->text == NULL)
@@ -801,10 +1317,26 @@ error:
 void
 win_free (Win * win)
 {
+  int i;
+
+  PANEL *panel;
+  Win *below;
+
   assert (win);
 
   if (win->panel != NULL)
     {
+      /* The covered windows might be seen again. */
+      for (panel = panel_below (win->panel); panel != NULL;
+	   panel = panel_below (panel))
+	{
+	  below = (Win *) panel_userptr (panel);
+	  if (below != NULL && below->hidden && win_covers (win, panel))
+	    {
+	      below->hidden = 0;
+	      win_catch_up (below);
+	    }
+	}
       del_panel (win->panel);
     }
   if (win->window != NULL)
@@ -822,6 +1354,10 @@ win_free (Win * win)
 
   if (win->text_line_info != NULL)
     {
+      for (i = 0; i < win->tli_len; i++)
+	{
+	  free (win->text_line_info[i].ids.extra_id);
+	}
       free (win->text_line_info);
     }
 
@@ -833,11 +1369,90 @@ win_free (Win * win)
     {
       vsscanner_free (win->scanner);
     }
+  if (win->search != NULL)
+    {
+      text_pattern_free (win->search);
+    }
+  free (win->rows);
   text_free (win->text);
 
   free (win);
 }
 
+/**
+ * @brief Resize and move the window.
+ *
+ * Only the shown rows are flowed again to the new size, see win_reflow.
+ *
+ * @param win The window.
+ * @param starty New start of the window.
+ * @param startx New start of the window.
+ * @param height New height of the window.
+ * @param width New width of the window.
+ *
+ * @return 0 on success. -1 on failure.
+ */
+int
+win_resize (Win * win, int starty, int startx, int height, int width)
+{
+  int border = win->props.properties & WIN_PROP_BORDER ? 1 : 0;
+  line_info *li;
+  int top;
+  int bottom;
+  int rows;
+  int y;
+  int ret;
+
+  assert (win);
+
+  if (height < 2 + 2 * border)
+    {
+      height = 2 + 2 * border;
+    }
+  if (width < win->props.indent + 1 + 2 * border)
+    {
+      width = win->props.indent + 1 + 2 * border;
+    }
+
+  top = win->line_info[0].n;
+  bottom = win->line_info[win->height - 2].n;
+  rows = win->height - 1;
+
+  li = (line_info *) realloc (win->line_info, (height - 1) * sizeof (*li));
+  LOG_ERR_IF_RETURN (li == NULL, -1, ERR_MSG_CREATE ("line info"));
+  win->line_info = li;
+
+  ret = wresize (win->window, height, width);
+  LOG_ERR_IF_RETURN (ret == ERR, -1, "Could not resize window to %dx%d",
+		     height, width);
+  ret = move_panel (win->panel, starty, startx);
+  LOG_ERR_IF_RETURN (ret == ERR, -1, "Could not move window to (%d; %d)",
+		     starty, startx);
+  win->height = height - 2 * border;
+  win->width = width - 2 * border;
+  win->starty = starty;
+  win->startx = startx;
+  wsetscrreg (win->window, border, height - 2 - border);
+
+  if (win->hidden)
+    {
+      /* Drawn by win_catch_up() when shown, which keeps show_last. */
+      for (y = rows; y < win->height - 1; y++)
+	{
+	  win->line_info[y].len = -1;
+	  win->line_info[y].n = -1;
+	  win->line_info[y].part = -1;
+	  win->line_info[y].text = NULL;
+	}
+      win->dirty = 1;
+      return 0;
+    }
+  ret = win_reflow (win, top, bottom);
+  DINFO (1, "Resized window to height %d width %d at (%d; %d)", height,
+	 width, starty, startx);
+  return ret;
+}
+
 /**
  * @brief Set a new status line of the window.
  *
@@ -904,6 +1519,8 @@ win_add_line (Win * win, const char *line, int scroll, int tag)
 {
   int pos;
   line_info *li;
+  int width;
+  int len;
   int ret;
 
   assert (win);
@@ -934,14 +1551,22 @@ win_add_line (Win * win, const char *line, int scroll, int tag)
       /* No update of the window. */
       return 0;
     }
+  if (win->hidden)
+    {
+      /* Show the last line when the window is shown again. */
+      win->dirty = 1;
+      win->show_last = 1;
+      return 0;
+    }
 
   /* Scroll or move to to the new line. */
   li = &win->line_info[win->height - 2];
   if (li->n == pos - 2 && li->n != -1)
     {
-      ret = win_scroll (win, li->len / (win->width - win->props.indent) -
-			li->part + strlen (line) / (win->width -
-						    win->props.indent) + 1);
+      width = win->width - win->props.indent;
+      text_get_line (win->text, pos - 1, &len);
+      ret = win_scroll (win, LAST_PART (win, li->len, width) - li->part +
+			LINE_ROWS (win, len, width));
     }
   else
     {
@@ -950,6 +1575,84 @@ win_add_line (Win * win, const char *line, int scroll, int tag)
   return ret;
 }
 
+/**
+ * @brief Replace a line in the window.
+ *
+ * Replace the text of a line and redraw it, if it is shown. The syntax
+ * highlighting is not updated.
+ *
+ * @param win The window.
+ * @param line_nr The line number.
+ * @param line The new text of the line.
+ *
+ * @return 0 upon success, otherwise < 0.
+ */
+int
+win_set_line (Win * win, int line_nr, const char *line)
+{
+  int y;
+  int len;
+  int old_len;
+  const char *text;
+  int border = win->props.properties & WIN_PROP_BORDER ? 1 : 0;
+
+  assert (win);
+  assert (line);
+
+  text = text_get_line (win->text, line_nr, &old_len);
+  LOG_ERR_IF_RETURN (text == NULL, -1, "Line %d out of bounds", line_nr);
+  len = text_set_line (win->text, line_nr, line);
+  LOG_ERR_IF_RETURN (len < 0, -1, "Could not set line %d", line_nr);
+  if (line_nr < win->search_counted)
+    {
+      /* Count the matches again. */
+      win->search_count = 0;
+      win->search_counted = 0;
+    }
+  text = text_get_line (win->text, line_nr, &len);
+  win_rows_set (win, line_nr, old_len, len);
+
+  if (win->hidden)
+    {
+      /* Only keep the shown rows pointing at the new text. */
+      for (y = 0; y < win->height - 1; y++)
+	{
+	  if (win->line_info[y].n == line_nr)
+	    {
+	      win->line_info[y].text = text;
+	      win->line_info[y].len = len;
+	    }
+	}
+      win->dirty = 1;
+      return 0;
+    }
+  if (LAST_PART (win, len, win->width - win->props.indent)
+      != LAST_PART (win, old_len, win->width - win->props.indent))
+    {
+      /* The line takes up another number of window lines. */
+      werase (win->window);
+      if (border)
+	{
+	  box (win->window, 0, 0);
+	}
+      win_redraw_status (win);
+      return win_redraw_show_top (win, win->line_info[0].n);
+    }
+  for (y = 0; y < win->height - 1; y++)
+    {
+      if (win->line_info[y].n == line_nr)
+	{
+	  win->line_info[y].text = text;
+	  win->line_info[y].len = len;
+	  wmove (win->window, y + border, 0);
+	  wclrtoeol (win->window);
+	  win_draw_line (win, y, win->width - win->props.indent);
+	}
+    }
+
+  return 0;
+}
+
 /**
  * @brief Load a text file into window.
  *
@@ -963,11 +1666,7 @@ win_add_line (Win * win, const char *line, int scroll, int tag)
 int
 win_load_file (Win * win, const char *file_name)
 {
-  int ret;
-  int len;
-  int lines;
-  int i;
-  int j;
+  text *text;
 
   assert (win);
 
@@ -977,13 +1676,42 @@ win_load_file (Win * win, const char *file_name)
       return 0;
     }
   /* Load file in text object. */
-  ret = text_update_from_file (win->text, file_name);
-  if (ret < 0)
+  text = text_load_file (file_name);
+  if (text == NULL)
     {
       LOG_ERR ("Loading file failed");
-      return ret;
+      return -1;
     }
 
+  return win_set_text (win, file_name, text);
+}
+
+/**
+ * @brief Show a loaded text file in the window.
+ *
+ * Replace the text of the window with the text of a file, loaded by
+ * text_load_file(), and show the start of it.
+ *
+ * @param win The window.
+ * @param file_name The file name of the text file.
+ * @param text The text of the file. The window takes it over.
+ *
+ * @return 0 upon success, otherwise < 0.
+ */
+int
+win_set_text (Win * win, const char *file_name, text * text)
+{
+  int len;
+  int lines;
+  int i;
+  int j;
+
+  assert (win);
+  assert (text);
+
+  text_free (win->text);
+  win->text = text;
+
   /* Check if we need more text line info. */
   lines = text_nr_of_lines (win->text);
   if (lines >= win->tli_len)
@@ -991,10 +1719,6 @@ win_load_file (Win * win, const char *file_name)
       win_add_text_line_info (win, lines);
     }
   /* Clear previous marks etc. */
-  if (win->props.properties & WIN_PROP_SYNTAX)
-    {
-      vsscanner_restart (win->scanner);
-    }
   for (i = 0; i < lines; i++)
     {
       for (j = 0; j < win->props.indent; j++)
@@ -1004,12 +1728,26 @@ win_load_file (Win * win, const char *file_name)
       win->text_line_info[i].marks[j] = '\0';
       win->text_line_info[i].marked = 0;
       win->text_line_info[i].cur_pos = 0;
-      if (win->props.properties & WIN_PROP_SYNTAX)
+    }
+
+  /* Store the file name. */
+  if (win->file_name != NULL)
+    {
+      free (win->file_name);
+    }
+  win->file_name = strdup (file_name);
+
+  /* Only scan files that are not in the cache. */
+  if ((win->props.properties & WIN_PROP_SYNTAX)
+      && win_load_syntax_cache (win) < 0)
+    {
+      vsscanner_restart (win->scanner);
+      for (i = 0; i < lines; i++)
 	{
-	  ret = vsscanner_scan (win->scanner,
-				text_get_line (win->text, i, &len),
-				&win->text_line_info[i].ids);
+	  vsscanner_scan (win->scanner, text_get_line (win->text, i, &len),
+			  &win->text_line_info[i].ids);
 	}
+      syntax_cache_store (file_name, win->syntax, lines, win_get_ids, win);
     }
 
   /* Clear line info. */
@@ -1021,18 +1759,16 @@ win_load_file (Win * win, const char *file_name)
       win->line_info[i].text = NULL;
     }
 
-  /* Store the file name. */
-  if (win->file_name != NULL)
-    {
-      free (win->file_name);
-    }
-  win->file_name = strdup (file_name);
+  win->search_line = -1;
+  win->search_count = 0;
+  win->search_counted = 0;
+  win->rows_valid = 0;
 
   DINFO (1, "Loaded '%s' nr of lines %d", file_name,
 	 text_nr_of_lines (win->text));
 
   /* Update cursor pos. */
-  ret = win_update_cursor (win, 0);
+  win_update_cursor (win, 0);
 
   return win_redraw_show_top (win, 0);
 }
@@ -1061,6 +1797,13 @@ win_scroll (Win * win, int nr_of_lines)
   int text_width = win->width - win->props.indent;
   assert (win);
 
+  if ((nr_of_lines >= win->height - 1 || -nr_of_lines >= win->height - 1)
+      && win->line_info[0].n >= 0 && win->line_info[win->height - 2].n >= 0)
+    {
+      /* Every row would be redrawn anyway. */
+      return win_scroll_rows (win, nr_of_lines);
+    }
+
   li = &win->line_info[0];
   while (nr_of_lines < 0)
     {
@@ -1083,7 +1826,7 @@ win_scroll (Win * win, int nr_of_lines)
 	}
       if (part == -1)
 	{
-	  part = len / (text_width);
+	  part = LAST_PART (win, len, text_width);
 	}
       /* Scroll */
       wscrl (win->window, -1);
@@ -1105,7 +1848,7 @@ win_scroll (Win * win, int nr_of_lines)
   li = &win->line_info[win->height - 2];
   while (nr_of_lines > 0)
     {
-      if (li->part == li->len / text_width)
+      if (li->part == LAST_PART (win, li->len, text_width))
 	{
 	  n = li->n + 1;
 	  part = 0;
@@ -1144,19 +1887,136 @@ win_scroll (Win * win, int nr_of_lines)
   return 0;
 }
 
+/**
+ * @brief Wrap or cut the long lines.
+ *
+ * In no-wrap mode every text line takes up one screen row and only the
+ * columns from the horizontal offset are shown, see win_scroll_columns.
+ *
+ * @param win The window.
+ * @param wrap 1 if the lines should be wrapped. 0 if they should be cut.
+ *
+ * @return 0 on success. -1 on failure.
+ */
+int
+win_set_wrap (Win * win, int wrap)
+{
+  assert (win);
+
+  if (win->nowrap == !wrap)
+    {
+      return 0;
+    }
+  win->nowrap = !wrap;
+  win->column = 0;
+  win->rows_valid = 0;
+  return win_reflow (win, win->line_info[0].n,
+		     win->line_info[win->height - 2].n);
+}
+
+/**
+ * @brief Check if the long lines are wrapped.
+ *
+ * @param win The window.
+ *
+ * @return 1 if the lines are wrapped. 0 if they are cut.
+ */
+int
+win_get_wrap (Win * win)
+{
+  assert (win);
+
+  return !win->nowrap;
+}
+
+/**
+ * @brief Scroll the window sideways.
+ *
+ * Moves the horizontal offset of a window in no-wrap mode. The offset is kept
+ * within the longest shown line.
+ *
+ * @param win The window.
+ * @param n The number of columns to scroll, negative to scroll left.
+ *
+ * @return 0 on success. -1 if the window could not be scrolled.
+ */
+int
+win_scroll_columns (Win * win, int n)
+{
+  int column;
+  int max = 0;
+  int y;
+
+  assert (win);
+
+  LOG_ERR_IF_RETURN (!win->nowrap, -1, "The lines are wrapped");
+  for (y = 0; y < win->height - 1 && win->line_info[y].n >= 0; y++)
+    {
+      if (win->line_info[y].len > max)
+	{
+	  max = win->line_info[y].len;
+	}
+    }
+  column = win->column + n;
+  if (column > max - (win->width - win->props.indent))
+    {
+      column = max - (win->width - win->props.indent);
+    }
+  if (column < 0)
+    {
+      column = 0;
+    }
+  if (column == win->column)
+    {
+      return -1;
+    }
+  win->column = column;
+
+  werase (win->window);
+  if (win->props.properties & WIN_PROP_BORDER)
+    {
+      box (win->window, 0, 0);
+    }
+  win_redraw_status (win);
+  if (win->line_info[0].n >= 0)
+    {
+      win_redraw_from (win, win->line_info[0].n, 0);
+    }
+  return 0;
+}
+
 /**
  * @brief Set the window on top.
  *
- * Set the window on top over all other windows.
+ * Set the window on top over all other windows. A hidden window is redrawn
+ * if its text changed, and the windows it covers are hidden.
  *
  * @param win The window.
  */
 void
 win_to_top (Win * win)
 {
+  PANEL *panel;
+  Win *below;
+
   assert (win);
 
   top_panel (win->panel);
+  win->hidden = 0;
+  if (win->dirty)
+    {
+      win_catch_up (win);
+    }
+
+  for (panel = panel_below (win->panel); panel != NULL;
+       panel = panel_below (panel))
+    {
+      below = (Win *) panel_userptr (panel);
+      if (below != NULL && win_covers (win, panel))
+	{
+	  below->hidden = 1;
+	}
+    }
 }
 
 /**
@@ -1191,6 +2051,7 @@ win_go_to_line (Win * win, int line_nr)
 
   win_update_cursor (win, line_nr);
 
+  win->show_last = 0;
   wclear (win->window);
   win_redraw_status (win);
 
@@ -1207,7 +2068,7 @@ win_go_to_line (Win * win, int line_nr)
 	  n--;
 	  line = text_get_line (win->text, n, &len);
 	  LOG_ERR_IF_RETURN (line == NULL, -1, "Could not get line %d", n);
-	  part = len / width;
+	  part = LAST_PART (win, len, width);
 	}
       else
 	{
@@ -1237,9 +2098,10 @@ win_go_to_line (Win * win, int line_nr)
   part = win->line_info[y - 1].part;
   len = win->line_info[y - 1].len;
   n = win->line_info[y - 1].n;
-  while (y < win->height - 1 && (n < nr_of_lines - 1 || part < len / width))
+  while (y < win->height - 1
+	 && (n < nr_of_lines - 1 || part < LAST_PART (win, len, width)))
     {
-      if (part == len / width)
+      if (part == LAST_PART (win, len, width))
 	{
 	  n++;
 	  line = text_get_line (win->text, n, &len);
@@ -1423,8 +2285,16 @@ win_clear (Win * win)
       win->line_info[i].text = NULL;
     }
 
-  wclear (win->window);
-  win_redraw_status (win);
+  win->show_last = 0;
+  if (win->hidden)
+    {
+      win->dirty = 1;
+    }
+  else
+    {
+      wclear (win->window);
+      win_redraw_status (win);
+    }
 
   if (win->file_name != NULL)
     {
@@ -1433,6 +2303,10 @@ win_clear (Win * win)
     }
 
   text_clear (win->text);
+  win->search_line = -1;
+  win->search_count = 0;
+  win->search_counted = 0;
+  win->rows_valid = 0;
 }
 
 /**
@@ -1496,6 +2370,27 @@ win_get_tag (Win * win)
   return win->text_line_info[win->cursor_pos].tag;
 }
 
+/**
+ * @brief Get the size of the text area.
+ *
+ * The number of rows, not counting the status line, and the number of
+ * columns after the indentation.
+ *
+ * @param win The window.
+ * @param rows Set to the number of rows.
+ * @param cols Set to the number of columns.
+ */
+void
+win_get_size (Win * win, int *rows, int *cols)
+{
+  assert (win);
+  assert (rows);
+  assert (cols);
+
+  *rows = win->height - 1;
+  *cols = win->width - win->props.indent;
+}
+
 /**
  * @brief Get the current cursor position.
  *
@@ -1564,3 +2459,138 @@ win_dump (Win * win)
 
   text_dump (win->text);
 }
+
+/**
+ * @brief Set the pattern to search for.
+ *
+ * The matches of the pattern are highlighted and counted, see
+ * win_count_matches().
+ *
+ * @param win The window.
+ * @param pattern The pattern. NULL or an empty string removes the search.
+ */
+void
+win_set_search (Win * win, const char *pattern)
+{
+  int y;
+
+  assert (win);
+
+  if (win->search != NULL)
+    {
+      if (pattern != NULL
+	  && strcmp (text_pattern_get (win->search, NULL), pattern) == 0)
+	{
+	  return;
+	}
+      text_pattern_free (win->search);
+      win->search = NULL;
+    }
+  if (pattern != NULL && *pattern != '\0')
+    {
+      win->search = text_pattern_create (pattern);
+    }
+  win->search_count = 0;
+  win->search_counted = 0;
+
+  for (y = 0; y < win->height - 1; y++)
+    {
+      if (win->line_info[y].n >= 0 && win->line_info[y].text != NULL)
+	{
+	  win_draw_line (win, y, win->width - win->props.indent);
+	}
+    }
+  win_redraw_status (win);
+}
+
+/**
+ * @brief Go to the next match.
+ *
+ * Search for the next line matching the pattern set by win_set_search(),
+ * starting at the cursor or at the last match. The search wraps around the
+ * end of the text.
+ *
+ * @param win The window.
+ * @param dir 1 to search forward, -1 to search backward.
+ * @param skip 1 to start at the line after the current line, in the
+ *             direction of the search. 0 to include the current line.
+ *
+ * @return The line of the match. -1 if no line matches.
+ */
+int
+win_search (Win * win, int dir, int skip)
+{
+  int line;
+  int n;
+
+  assert (win);
+
+  if (win->search == NULL)
+    {
+      return -1;
+    }
+
+  if ((win->props.properties & WIN_PROP_CURSOR) && win->cursor_pos >= 0)
+    {
+      line = win->cursor_pos;
+    }
+  else if (win->search_line >= 0)
+    {
+      line = win->search_line;
+    }
+  else
+    {
+      line = win->line_info[0].n >= 0 ? win->line_info[0].n : 0;
+    }
+  if (skip)
+    {
+      line += dir;
+    }
+
+  n = text_find (win->text, win->search, line, dir);
+  if (n < 0)
+    {
+      n = text_find (win->text, win->search,
+		     dir > 0 ? 0 : text_nr_of_lines (win->text) - 1, dir);
+    }
+  if (n < 0)
+    {
+      return -1;
+    }
+
+  win->search_line = n;
+  win_go_to_line (win, n);
+
+  return n;
+}
+
+/**
+ * @brief Count matches of the searched pattern.
+ *
+ * Count the matches in the next @a nr_of_lines lines that have not been
+ * counted. Lines added to the window are counted by later calls, so a large
+ * text can be counted a part at the time without blocking.
+ *
+ * @param win The window.
+ * @param nr_of_lines Max number of lines to count.
+ *
+ * @return 1 if any line was counted. 0 if there is nothing to count.
+ */
+int
+win_count_matches (Win * win, int nr_of_lines)
+{
+  assert (win);
+
+  if (win->search == NULL
+      || win->search_counted >= text_nr_of_lines (win->text))
+    {
+      return 0;
+    }
+
+  win->search_counted = text_count (win->text, win->search,
+				    win->search_counted, nr_of_lines,
+				    &win->search_count);
+  win_redraw_status (win);
+
+  return 1;
+}
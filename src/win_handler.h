@@ -26,6 +26,8 @@
 #ifndef WIN_HANDLER_H
 #define WIN_HANDLER_H
 
+#include "text.h"
+
 #define WIN_PROP_MARKS  0x0001 /**< Window has markers. */
 #define WIN_PROP_CURSOR 0x0002 /**< Window has cursor. */
 #define WIN_PROP_SYNTAX 0x0004 /**< Window has syntax highlighting. */
@@ -62,10 +64,16 @@ typedef struct win_properties_t
 Win *win_create (int starty, int startx, int height, int width,
 		 win_properties * props);
 void win_free (Win * win);
+int win_resize (Win * win, int starty, int startx, int height, int width);
 void win_set_status (Win * win, const char *line);
 int win_add_line (Win * win, const char *line, int scroll, int tag);
+int win_set_line (Win * win, int line_nr, const char *line);
 int win_load_file (Win * win, const char *filename);
+int win_set_text (Win * win, const char *file_name, text * text);
 int win_scroll (Win * win, int nr_of_lines);
+int win_set_wrap (Win * win, int wrap);
+int win_get_wrap (Win * win);
+int win_scroll_columns (Win * win, int n);
 void win_to_top (Win * win);
 int win_go_to_line (Win * win, int line_nr);
 int win_move_cursor (Win * win, int n);
@@ -75,6 +83,10 @@ void win_clear (Win * win);
 int win_set_mark (Win * win, int line, int nr, char mark);
 int win_get_tag (Win * win);
 int win_get_cursor (Win * win);
+void win_get_size (Win * win, int *rows, int *cols);
+void win_set_search (Win * win, const char *pattern);
+int win_search (Win * win, int dir, int skip);
+int win_count_matches (Win * win, int nr_of_lines);
 const char *win_get_filename (Win * win);
 const char *win_get_line (Win * win, int line_nr);
 void win_dump (Win * win);
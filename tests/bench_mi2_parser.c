@@ -0,0 +1,623 @@
+/**
+ * @file bench_mi2_parser.c
+ *
+ * @brief Replay MI2 transcripts through the parser and measure it.
+ *
+ * Every record of a transcript is unescaped and parsed by
+ * mi2_parser_parse(), as in the main loop, with a view that draws nothing.
+ * The records are grouped in classes, the record type and for ^done the
+ * first field, and for each class the throughput, allocations and latency
+ * are reported. Allocations are only counted with glibc, elsewhere they are
+ * reported as 0.
+ *
+ * Without arguments generated transcripts are replayed: a huge disassembly,
+ * thousands of threads, a deep stack and a storm of library events. Recorded
+ * transcripts, one record per line, can be given as arguments. Only result
+ * and async records are replayed, stream records and "(gdb)" are skipped,
+ * and tokens are removed.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "../src/mi2_parser.h"
+#include "../src/misc.h"
+#include "../src/objects.h"
+#include "../src/win_form.h"
+
+#define MAX_CLASSES 64	     /**< Max number of record classes. */
+#define CLASS_LEN 32	     /**< Max length of a class name. */
+#define ASM_INSTRUCTIONS 50000 /**< Instructions in a disassembly. */
+#define ASM_REPEAT 20	     /**< Times the disassembly is replayed. */
+#define NR_THREADS 4000	     /**< Number of threads. */
+#define THREAD_REPEAT 20     /**< Times the threads are listed. */
+#define STACK_DEPTH 20000    /**< Depth of the stack. */
+#define STACK_PAGE 1000	     /**< Frames per stack record. */
+#define NR_LIBRARIES 5000    /**< Libraries in the library storm. */
+
+FILE *OUT_FILE = NULL;
+int VERBOSE_LEVEL = 0;
+
+/** A record of a transcript. */
+typedef struct record_t
+{
+  char *line; /**< The record. */
+  int len;    /**< The length of the record. */
+  int class;  /**< The class of the record. */
+} record;
+
+/** The measurements of a class of records. */
+typedef struct record_class_t
+{
+  char name[CLASS_LEN]; /**< The name. */
+  int nr;		/**< Number of records. */
+  int failed;		/**< Number of records the parser failed. */
+  double bytes;		/**< Number of bytes. */
+  double ns;		/**< Total time. */
+  double allocs;	/**< Number of allocations. */
+  double *latency;	/**< Time of each record. */
+} record_class;
+
+static record *g_records;
+static int g_nr_records;
+static int g_size_records;
+static record_class g_classes[MAX_CLASSES];
+static int g_nr_classes;
+static int g_counting;
+static long g_allocs;
+
+/*******************************************************************************
+ * Allocation counting.
+ ******************************************************************************/
+#ifdef __GLIBC__
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+extern void __libc_free (void *ptr);
+
+void *
+malloc (size_t size)
+{
+  g_allocs += g_counting;
+  return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+  g_allocs += g_counting;
+  return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+  g_allocs += g_counting;
+  return __libc_realloc (ptr, size);
+}
+
+void
+free (void *ptr)
+{
+  __libc_free (ptr);
+}
+#endif /* __GLIBC__ */
+
+/*******************************************************************************
+ * A view that draws nothing.
+ ******************************************************************************/
+int
+conf_get_bool (configuration * conf, const char *group_name,
+	       const char *name, int *valid)
+{
+  return 0;
+}
+
+void
+view_update_breakpoints (view * view, breakpoint_table * bpt)
+{
+}
+
+void
+view_update_threads (view * view, thread_group * thread_groups)
+{
+}
+
+void
+view_update_libraries (view * view, library * libraries)
+{
+}
+
+void
+view_update_frame (view * view, stack * stack, int level)
+{
+}
+
+void
+view_update_stack (view * view, stack * stack)
+{
+}
+
+void
+view_update_ass (view * view, asm_function * func, uint64_t pc)
+{
+}
+
+void
+view_move_ass_pc (view * view, asm_function * func, uint64_t old_pc,
+		  uint64_t pc)
+{
+}
+
+void
+view_update_registers (view * view, data_registers * regs)
+{
+}
+
+void
+view_update_memory (view * view, mem_cache * cache)
+{
+}
+
+int
+view_show_file (view * view, const char *file_name, int line, int mark_stop)
+{
+  return 0;
+}
+
+int
+view_prefetch_file (view * view, const char *file_name)
+{
+  return 0;
+}
+
+void
+view_remove_breakpoint (view * view, const char *file_name, int line_nr)
+{
+}
+
+int
+view_add_message (view * view, int level, const char *msg, ...)
+{
+  return 0;
+}
+
+int
+form_selection (char **list, const char *header)
+{
+  return -1;
+}
+
+int
+form_search (const char *header, form_match_func match, form_item_func item,
+	     void *data)
+{
+  return -1;
+}
+
+/*******************************************************************************
+ * Transcripts.
+ ******************************************************************************/
+/**
+ * @brief Get the class of a record, adding the class if it is new.
+ *
+ * @param line The record.
+ *
+ * @return The class.
+ */
+static int
+bench_class (const char *line)
+{
+  char name[CLASS_LEN];
+  int len;
+  int i;
+
+  len = strcspn (line, ",");
+  if (strncmp (line, "^done,", 6) == 0)
+    {
+      len = 6 + strcspn (line + 6, ",=");
+    }
+  if (len >= CLASS_LEN)
+    {
+      len = CLASS_LEN - 1;
+    }
+  memcpy (name, line, len);
+  name[len] = '\0';
+
+  for (i = 0; i < g_nr_classes; i++)
+    {
+      if (strcmp (g_classes[i].name, name) == 0)
+	{
+	  return i;
+	}
+    }
+  if (g_nr_classes == MAX_CLASSES)
+    {
+      return MAX_CLASSES - 1;
+    }
+  strcpy (g_classes[g_nr_classes].name, name);
+  return g_nr_classes++;
+}
+
+/**
+ * @brief Add a record.
+ *
+ * @param line The record, tokens are removed.
+ */
+static void
+bench_add (const char *line)
+{
+  record *r;
+
+  while (isdigit ((unsigned char) *line))
+    {
+      line++;
+    }
+  if (*line == '\0' || strchr ("^*=", *line) == NULL)
+    {
+      return;
+    }
+  if (g_nr_records == g_size_records)
+    {
+      g_size_records = g_size_records == 0 ? 1024 : 2 * g_size_records;
+      g_records = (record *) realloc (g_records,
+				      g_size_records * sizeof (*g_records));
+      if (g_records == NULL)
+	{
+	  fprintf (stderr, "Out of memory\n");
+	  exit (EXIT_FAILURE);
+	}
+    }
+  r = &g_records[g_nr_records++];
+  r->line = strdup (line);
+  r->len = strlen (line);
+  r->class = bench_class (line);
+}
+
+/**
+ * @brief Append to a growing string.
+ *
+ * @param buf The string.
+ * @param len The length of the string.
+ * @param size The size of the string.
+ * @param fmt The format.
+ */
+static void
+bench_append (char **buf, int *len, int *size, const char *fmt, ...)
+{
+  va_list ap;
+  int n;
+
+  do
+    {
+      va_start (ap, fmt);
+      n = vsnprintf (*buf + *len, *size - *len, fmt, ap);
+      va_end (ap);
+      if (n < *size - *len)
+	{
+	  *len += n;
+	  return;
+	}
+      *size = 2 * *size + n;
+      *buf = (char *) realloc (*buf, *size);
+    }
+  while (*buf != NULL);
+
+  fprintf (stderr, "Out of memory\n");
+  exit (EXIT_FAILURE);
+}
+
+/**
+ * @brief Generate the transcripts.
+ */
+static void
+bench_generate (void)
+{
+  char *buf;
+  int size = 4096;
+  int len;
+  int i;
+  int j;
+
+  buf = (char *) malloc (size);
+
+  /* A huge disassembly, with source lines. */
+  for (j = 0; j < ASM_REPEAT; j++)
+    {
+      len = 0;
+      bench_append (&buf, &len, &size, "^done,asm_insns=[");
+      for (i = 0; i < ASM_INSTRUCTIONS; i++)
+	{
+	  if (i % 4 == 0)
+	    {
+	      bench_append (&buf, &len, &size,
+			    "%ssrc_and_asm_line={line=\"%d\",file=\"big.c\","
+			    "fullname=\"/home/user/project/src/big.c\","
+			    "line_asm_insn=[", i == 0 ? "" : "]},", 10 + i / 4);
+	    }
+	  bench_append (&buf, &len, &size,
+			"%s{address=\"0x%016x\",func-name=\"big_function_%d\","
+			"offset=\"%d\",inst=\"mov    0x%x(%%rbp),%%rax\"}",
+			i % 4 == 0 ? "" : ",", 0x401000 + 4 * i + 0x100000 * j,
+			j, 4 * i, i * 8);
+	}
+      bench_append (&buf, &len, &size, "]}]");
+      bench_add (buf);
+    }
+
+  /* Thousands of threads. */
+  bench_add ("=thread-group-created,id=\"4242\"");
+  for (i = 1; i <= NR_THREADS; i++)
+    {
+      len = 0;
+      bench_append (&buf, &len, &size,
+		    "=thread-created,id=\"%d\",group-id=\"4242\"", i);
+      bench_add (buf);
+    }
+  for (j = 0; j < THREAD_REPEAT; j++)
+    {
+      bench_add ("*running,thread-id=\"all\"");
+      bench_add ("*stopped,reason=\"signal-received\",signal-name=\"SIGINT\","
+		 "signal-meaning=\"Interrupt\",frame={addr=\"0x401000\","
+		 "func=\"worker\",args=[{name=\"arg\",value=\"0x0\"}],"
+		 "file=\"worker.c\",fullname=\"/home/user/project/src/"
+		 "worker.c\",line=\"42\"},thread-id=\"1\","
+		 "stopped-threads=\"all\",core=\"3\"");
+      len = 0;
+      bench_append (&buf, &len, &size, "^done,threads=[");
+      for (i = 1; i <= NR_THREADS; i++)
+	{
+	  bench_append (&buf, &len, &size,
+			"%s{id=\"%d\",target-id=\"Thread 0x7ffff%06x (LWP %d)\","
+			"frame={level=\"0\",addr=\"0x%x\",func=\"worker\","
+			"args=[{name=\"arg\",value=\"0x%x\"}],file=\"worker.c\","
+			"fullname=\"/home/user/project/src/worker.c\","
+			"line=\"%d\"},state=\"stopped\",core=\"%d\"}",
+			i == 1 ? "" : ",", i, i, 4242 + i, 0x401000 + i, i,
+			40 + i % 20, i % 64);
+	}
+      bench_append (&buf, &len, &size, "]");
+      bench_add (buf);
+    }
+
+  /* A deep stack, listed a page at the time. */
+  len = 0;
+  bench_append (&buf, &len, &size, "^done,depth=\"%d\"", STACK_DEPTH);
+  bench_add (buf);
+  for (j = 0; j < STACK_DEPTH; j += STACK_PAGE)
+    {
+      len = 0;
+      bench_append (&buf, &len, &size, "^done,stack=[");
+      for (i = j; i < j + STACK_PAGE; i++)
+	{
+	  bench_append (&buf, &len, &size,
+			"%sframe={level=\"%d\",addr=\"0x%x\",func=\"recurse\","
+			"file=\"recurse.c\",fullname=\"/home/user/project/src/"
+			"recurse.c\",line=\"%d\"}", i == j ? "" : ",", i,
+			0x402000 + i % 7, 10 + i % 7);
+	}
+      bench_append (&buf, &len, &size, "]");
+      bench_add (buf);
+    }
+
+  /* A library storm. */
+  for (i = 0; i < NR_LIBRARIES; i++)
+    {
+      len = 0;
+      bench_append (&buf, &len, &size,
+		    "=library-loaded,id=\"/usr/lib/plugins/libplugin%d.so\","
+		    "target-name=\"/usr/lib/plugins/libplugin%d.so\","
+		    "host-name=\"/usr/lib/plugins/libplugin%d.so\","
+		    "symbols-loaded=\"0\"", i, i, i);
+      bench_add (buf);
+    }
+  for (i = 0; i < NR_LIBRARIES; i += 2)
+    {
+      len = 0;
+      bench_append (&buf, &len, &size,
+		    "=library-unloaded,id=\"/usr/lib/plugins/libplugin%d.so\","
+		    "target-name=\"/usr/lib/plugins/libplugin%d.so\","
+		    "host-name=\"/usr/lib/plugins/libplugin%d.so\"", i, i, i);
+      bench_add (buf);
+    }
+
+  free (buf);
+}
+
+/**
+ * @brief Read a recorded transcript.
+ *
+ * @param file_name The transcript.
+ *
+ * @return 0 upon success, otherwise -1.
+ */
+static int
+bench_read (const char *file_name)
+{
+  char *line = NULL;
+  size_t size = 0;
+  ssize_t len;
+  FILE *file;
+
+  file = fopen (file_name, "r");
+  if (file == NULL)
+    {
+      perror (file_name);
+      return -1;
+    }
+  while ((len = getline (&line, &size, file)) >= 0)
+    {
+      while (len > 0 && strchr ("\r\n", line[len - 1]) != NULL)
+	{
+	  line[--len] = '\0';
+	}
+      bench_add (line);
+    }
+  free (line);
+  fclose (file);
+
+  return 0;
+}
+
+/*******************************************************************************
+ * Measurements.
+ ******************************************************************************/
+/**
+ * @brief Get the time.
+ *
+ * @return The time in ns.
+ */
+static double
+bench_now (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/**
+ * @brief Compare two latencies, used by qsort.
+ *
+ * @param a The first latency.
+ * @param b The second latency.
+ *
+ * @return Less than, equal or greater than 0.
+ */
+static int
+bench_cmp (const void *a, const void *b)
+{
+  double da = *(const double *) a;
+  double db = *(const double *) b;
+
+  return da < db ? -1 : da > db;
+}
+
+/**
+ * @brief Print the measurements of a class.
+ *
+ * @param c The class.
+ */
+static void
+bench_print (record_class * c)
+{
+  double p50 = 0;
+  double p99 = 0;
+
+  if (c->nr > 0 && c->latency != NULL)
+    {
+      qsort (c->latency, c->nr, sizeof (*c->latency), bench_cmp);
+      p50 = c->latency[c->nr / 2];
+      p99 = c->latency[(int) (c->nr * 0.99)];
+    }
+  printf ("%-24s %8d %6d %9.2f %11.0f %8.2f %10.1f %10.1f %10.1f\n",
+	  c->name, c->nr, c->failed, c->bytes / 1e6,
+	  c->nr / (c->ns / 1e9), c->bytes / 1e6 / (c->ns / 1e9),
+	  c->allocs / c->nr, p50 / 1e3, p99 / 1e3);
+}
+
+int
+main (int argc, char *argv[])
+{
+  record_class total;
+  mi2_parser *parser;
+  record *r;
+  record_class *c;
+  char *line = NULL;
+  int size = 0;
+  char *regs;
+  int update;
+  long allocs;
+  double start;
+  double ns;
+  int ret;
+  int i;
+
+  if (argc == 1)
+    {
+      bench_generate ();
+    }
+  for (i = 1; i < argc; i++)
+    {
+      if (bench_read (argv[i]) < 0)
+	{
+	  return EXIT_FAILURE;
+	}
+    }
+
+  for (i = 0; i < g_nr_records; i++)
+    {
+      g_classes[g_records[i].class].nr++;
+    }
+  for (i = 0; i < g_nr_classes; i++)
+    {
+      g_classes[i].latency = (double *) calloc (g_classes[i].nr + 1,
+						sizeof (double));
+      g_classes[i].nr = 0;
+    }
+  memset (&total, 0, sizeof (total));
+  strcpy (total.name, "total");
+  total.latency = (double *) calloc (g_nr_records + 1, sizeof (double));
+
+  parser = mi2_parser_create ((view *) 1, (configuration *) 1);
+  for (i = 0; i < g_nr_records; i++)
+    {
+      r = &g_records[i];
+      c = &g_classes[r->class];
+      /* The parser writes to the line. */
+      if (r->len + 1 > size)
+	{
+	  size = r->len + 1;
+	  line = (char *) realloc (line, size);
+	}
+      memcpy (line, r->line, r->len + 1);
+      regs = NULL;
+      update = 0;
+
+      allocs = g_allocs;
+      g_counting = 1;
+      start = bench_now ();
+      ret = unescape (line + 1, "\r\n\v");
+      if (ret == 0)
+	{
+	  ret = mi2_parser_parse (parser, line, &update, &regs);
+	}
+      ns = bench_now () - start;
+      g_counting = 0;
+
+      c->failed += ret < 0;
+      c->latency[c->nr++] = ns;
+      c->ns += ns;
+      c->bytes += r->len;
+      c->allocs += g_allocs - allocs;
+      total.failed += ret < 0;
+      total.latency[total.nr++] = ns;
+      total.ns += ns;
+      total.bytes += r->len;
+      total.allocs += g_allocs - allocs;
+    }
+  mi2_parser_free (parser);
+
+  printf ("%-24s %8s %6s %9s %11s %8s %10s %10s %10s\n", "class", "records",
+	  "failed", "MB", "records/s", "MB/s", "allocs/rec", "p50 us",
+	  "p99 us");
+  for (i = 0; i < g_nr_classes; i++)
+    {
+      bench_print (&g_classes[i]);
+      free (g_classes[i].latency);
+    }
+  bench_print (&total);
+  free (total.latency);
+
+  for (i = 0; i < g_nr_records; i++)
+    {
+      free (g_records[i].line);
+    }
+  free (g_records);
+  free (line);
+
+  return EXIT_SUCCESS;
+}
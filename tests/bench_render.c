@@ -0,0 +1,455 @@
+/**
+ * @file bench_render.c
+ *
+ * @brief Measure the redraw cost of the windows.
+ *
+ * The windows are drawn on a screen created with newterm() that writes to
+ * a temporary file instead of a terminal. After each operation the panels
+ * are updated as in the view, the cells that differ between the virtual
+ * and the physical screen are counted and the screen is updated. For each
+ * operation the time, the changed cells and the bytes written to the
+ * terminal are reported.
+ *
+ * The scenarios are loading, scrolling and jumping in a highlighted source
+ * file and streaming lines to the Console window. Without arguments a
+ * source file is generated, otherwise the file given is loaded. The size of
+ * the screen is taken from $LINES and $COLUMNS, by default 50x160.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <ncurses.h>
+#include <panel.h>
+
+#include "../src/win_handler.h"
+
+#define SOURCE_LINES 100000    /**< Lines of the generated source file. */
+#define STREAM_LINES 1000000   /**< Lines streamed to the Console window. */
+#define NR_JUMPS 10000	       /**< Number of jumps in the source file. */
+#define NR_LOADS 5	       /**< Number of loads from the cache. */
+#define CONSOLE_HEIGHT 12      /**< Height of the Console window. */
+#define SINK_MAX (64 << 20)    /**< Size when the terminal sink is emptied. */
+
+FILE *OUT_FILE = NULL;
+int VERBOSE_LEVEL = 0;
+
+/** The measurements of an operation. */
+typedef struct bench_op_t
+{
+  const char *name; /**< The name. */
+  long nr;	    /**< Number of operations. */
+  double ns;	    /**< Total time. */
+  double cells;	    /**< Number of changed cells. */
+  double bytes;	    /**< Number of bytes written to the terminal. */
+} bench_op;
+
+static FILE *g_sink;
+static long g_sink_pos;
+static double g_start;
+static chtype *g_old;
+static chtype *g_new;
+
+/** The highlighting of the Main window in the default configuration. */
+static const char *g_scan =
+  "{id='1',type='1',match='auto',match='register',match='static',"
+  "match='extern',match='typedef'},"
+  "{id='2',match='void',match='char',match='short',match='int',"
+  "match='long',match='float',match='double',match='signed'},"
+  "{id='3',match='const',match='volatile'},"
+  "{id='4',match='struct',match='union'},"
+  "{id='5',match='enum'},"
+  "{id='6',match='case',match='default'},"
+  "{id='7',match='if',match='else',match='switch'},"
+  "{id='8',match='while',match='do',match='for'},"
+  "{id='9',match='goto',match='continue',match='break',match='return'},"
+  "{id='10',type='0',match='^[ ]*[[:alnum:]]\\+:'},"
+  "{id='11',type='0',match='\"[^\"]*\"',match='\\'[^\\']*\\'',"
+  "match='<[^>]*\\.h>',type='1',match='NULL'},"
+  "{id='12',type='0',match='^[ ]*#[ ]*[[:alnum:]]* ',type='2',"
+  "match='/\\*.*\\*/'}";
+
+/** The attributes of the ids in #g_scan. */
+static win_attribute g_attr[] = {
+  {1, 0}, {2, 0}, {2, 0}, {2, 0}, {2, 0}, {2, 0}, {3, 0},
+  {3, 0}, {3, 0}, {3, 0}, {3, 0}, {5, A_BOLD}, {4, A_BOLD}
+};
+
+/*******************************************************************************
+ * Measurements.
+ ******************************************************************************/
+/**
+ * @brief Get the time.
+ *
+ * @return The time in ns.
+ */
+static double
+bench_now (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/**
+ * @brief Count the cells that differ between the virtual and the physical
+ * screen, the cells the next update brings up to date. If the terminal can
+ * scroll fewer cells are written.
+ *
+ * @return The number of cells.
+ */
+static long
+bench_cells (void)
+{
+  long cells = 0;
+  int cy;
+  int cx;
+  int ny;
+  int nx;
+  int y;
+  int x;
+
+  /* The cursors are restored, the cursor of curscr is the terminal's. */
+  getyx (curscr, cy, cx);
+  getyx (newscr, ny, nx);
+  for (y = 0; y < LINES; y++)
+    {
+      if (!is_linetouched (newscr, y))
+	{
+	  continue;
+	}
+      mvwinchnstr (curscr, y, 0, g_old, COLS);
+      mvwinchnstr (newscr, y, 0, g_new, COLS);
+      for (x = 0; x < COLS; x++)
+	{
+	  cells += g_old[x] != g_new[x];
+	}
+    }
+  wmove (curscr, cy, cx);
+  wmove (newscr, ny, nx);
+
+  return cells;
+}
+
+/**
+ * @brief Start an operation.
+ */
+static void
+bench_begin (void)
+{
+  g_start = bench_now ();
+}
+
+/**
+ * @brief End an operation, update the screen and measure it.
+ *
+ * @param op The operation.
+ */
+static void
+bench_end (bench_op * op)
+{
+  double ns;
+  long pos;
+
+  update_panels ();
+  ns = bench_now () - g_start;
+  op->cells += bench_cells ();
+  g_start = bench_now ();
+  doupdate ();
+  ns += bench_now () - g_start;
+
+  fflush (g_sink);
+  pos = ftell (g_sink);
+  op->bytes += pos - g_sink_pos;
+  g_sink_pos = pos;
+  if (pos > SINK_MAX)
+    {
+      rewind (g_sink);
+      if (ftruncate (fileno (g_sink), 0) < 0)
+	{
+	  perror ("ftruncate");
+	}
+      g_sink_pos = 0;
+    }
+  op->ns += ns;
+  op->nr++;
+}
+
+/**
+ * @brief Print the measurements of an operation.
+ *
+ * @param op The operation.
+ */
+static void
+bench_print (bench_op * op)
+{
+  if (op->nr == 0)
+    {
+      return;
+    }
+  printf ("%-16s %8ld %10.1f %10.2f %10.1f %10.1f %10.2f\n",
+	  op->name, op->nr, op->ns / 1e6, op->ns / op->nr / 1e3,
+	  op->cells / op->nr, op->bytes / op->nr, op->bytes / 1e6);
+}
+
+/*******************************************************************************
+ * Scenarios.
+ ******************************************************************************/
+/**
+ * @brief Generate a source file.
+ *
+ * @param file_name The name of the file.
+ *
+ * @return 0 upon success, otherwise -1.
+ */
+static int
+bench_generate (const char *file_name)
+{
+  FILE *file;
+  int i;
+
+  file = fopen (file_name, "w");
+  if (file == NULL)
+    {
+      perror (file_name);
+      return -1;
+    }
+  fprintf (file, "#include <stdio.h>\n#include <stdlib.h>\n");
+  for (i = 2; i < SOURCE_LINES; i++)
+    {
+      switch (i % 10)
+	{
+	case 0:
+	  fprintf (file, "/* Function %d, see function_%d. */\n", i, i - 10);
+	  break;
+	case 1:
+	  fprintf (file, "static int\nfunction_%d (const char *text, long n)"
+		   "\n", i);
+	  i++;
+	  break;
+	case 3:
+	  fprintf (file, "{\n  struct item *item = NULL;\n");
+	  i++;
+	  break;
+	case 5:
+	  fprintf (file, "  if (n > %d && text != NULL)\n    {\n", i);
+	  i++;
+	  break;
+	case 7:
+	  fprintf (file, "      printf (\"%%s: the value of the item is %%ld "
+		   "and the text is long enough to wrap the line of the "
+		   "window, %d\\n\", text, n);\n", i);
+	  break;
+	case 8:
+	  fprintf (file, "    }\n");
+	  break;
+	default:
+	  fprintf (file, "  return %d;\n}\n", i);
+	  i++;
+	  break;
+	}
+    }
+  fclose (file);
+
+  return 0;
+}
+
+/**
+ * @brief Create the Main window.
+ *
+ * @param props The properties.
+ *
+ * @return The window.
+ */
+static Win *
+bench_main_window (win_properties * props)
+{
+  return win_create (0, 0, LINES - CONSOLE_HEIGHT, COLS, props);
+}
+
+/**
+ * @brief Load, scroll and jump in a source file.
+ *
+ * @param file_name The file.
+ * @param ops The operations, load, cached load, line scroll, page scroll
+ * and jump.
+ *
+ * @return 0 upon success, otherwise -1.
+ */
+static int
+bench_source (const char *file_name, bench_op * ops)
+{
+  win_properties props = { 3, WIN_PROP_CURSOR | WIN_PROP_MARKS
+      | WIN_PROP_SYNTAX, g_attr, sizeof (g_attr) / sizeof (*g_attr), NULL
+  };
+  unsigned int seed = 1;
+  Win *w;
+  int nr_of_lines;
+  int rows;
+  int cols;
+  int i;
+
+  props.scan_definitions = strdup (g_scan);
+  for (i = 0; i <= NR_LOADS; i++)
+    {
+      w = bench_main_window (&props);
+      if (w == NULL)
+	{
+	  return -1;
+	}
+      bench_begin ();
+      if (win_load_file (w, file_name) < 0)
+	{
+	  fprintf (stderr, "Could not load '%s'\n", file_name);
+	  win_free (w);
+	  return -1;
+	}
+      bench_end (&ops[i == 0 ? 0 : 1]);
+      if (i < NR_LOADS)
+	{
+	  win_free (w);
+	}
+    }
+
+  for (nr_of_lines = 0; win_get_line (w, nr_of_lines) != NULL;
+       nr_of_lines++)
+    {
+    }
+  win_get_size (w, &rows, &cols);
+  for (i = 0; i < nr_of_lines; i++)
+    {
+      bench_begin ();
+      win_scroll (w, 1);
+      bench_end (&ops[2]);
+    }
+  for (i = 0; i < nr_of_lines / rows; i++)
+    {
+      bench_begin ();
+      win_scroll (w, -rows);
+      bench_end (&ops[3]);
+    }
+  for (i = 0; i < NR_JUMPS; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      bench_begin ();
+      win_go_to_line (w, (seed >> 8) % nr_of_lines);
+      bench_end (&ops[4]);
+    }
+
+  win_free (w);
+  free (props.scan_definitions);
+  return 0;
+}
+
+/**
+ * @brief Stream lines to the Console window.
+ *
+ * @param op The operation.
+ *
+ * @return 0 upon success, otherwise -1.
+ */
+static int
+bench_stream (bench_op * op)
+{
+  win_properties props = { 0, 0, NULL, 0, NULL };
+  char line[128];
+  Win *w;
+  int i;
+
+  w = win_create (LINES - CONSOLE_HEIGHT, 0, CONSOLE_HEIGHT, COLS, &props);
+  if (w == NULL)
+    {
+      return -1;
+    }
+  for (i = 0; i < STREAM_LINES; i++)
+    {
+      snprintf (line, sizeof (line), "Line %d of the output of the "
+		"program, counting %d", i, i * 7);
+      bench_begin ();
+      win_add_line (w, line, 1, 0);
+      bench_end (op);
+    }
+  win_free (w);
+
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  bench_op ops[] = {
+    {"load"}, {"load cached"}, {"scroll line"}, {"scroll page"},
+    {"go to line"}, {"add line"}
+  };
+  char dir[] = "/tmp/bench_renderXXXXXX";
+  char source[sizeof (dir) + sizeof ("/source.c")];
+  const char *file_name = source;
+  char cmd[64];
+  const char *term;
+  SCREEN *screen;
+  int ret = EXIT_SUCCESS;
+  int i;
+
+  if (mkdtemp (dir) == NULL)
+    {
+      perror ("mkdtemp");
+      return EXIT_FAILURE;
+    }
+  /* Measure the scanning, not an old cache. */
+  setenv ("XDG_CACHE_HOME", dir, 1);
+  snprintf (source, sizeof (source), "%s/source.c", dir);
+  if (argc > 1)
+    {
+      file_name = argv[1];
+    }
+  else if (bench_generate (source) < 0)
+    {
+      return EXIT_FAILURE;
+    }
+
+  setenv ("LINES", "50", 0);
+  setenv ("COLUMNS", "160", 0);
+  term = getenv ("TERM");
+  g_sink = tmpfile ();
+  screen = newterm (term != NULL ? term : "xterm", g_sink, stdin);
+  if (g_sink == NULL || screen == NULL)
+    {
+      fprintf (stderr, "Could not create the screen\n");
+      return EXIT_FAILURE;
+    }
+  start_color ();
+  for (i = 1; i < 6 && i < COLOR_PAIRS; i++)
+    {
+      init_pair (i, i == 1 ? COLOR_WHITE : i, COLOR_BLACK);
+    }
+  g_old = (chtype *) calloc (COLS + 1, sizeof (chtype));
+  g_new = (chtype *) calloc (COLS + 1, sizeof (chtype));
+
+  if (bench_source (file_name, ops) < 0 || bench_stream (&ops[5]) < 0)
+    {
+      ret = EXIT_FAILURE;
+    }
+
+  endwin ();
+  delscreen (screen);
+  fclose (g_sink);
+  free (g_old);
+  free (g_new);
+  snprintf (cmd, sizeof (cmd), "rm -rf %s", dir);
+  if (system (cmd) != 0)
+    {
+      fprintf (stderr, "Could not remove '%s'\n", dir);
+    }
+
+  printf ("%d x %d %s\n", LINES, COLS, term != NULL ? term : "xterm");
+  printf ("%-16s %8s %10s %10s %10s %10s %10s\n", "operation", "count",
+	  "ms", "us/op", "cells/op", "bytes/op", "MB");
+  for (i = 0; i < (int) (sizeof (ops) / sizeof (*ops)); i++)
+    {
+      bench_print (&ops[i]);
+    }
+
+  return ret;
+}
@@ -0,0 +1,251 @@
+#include <check.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+
+#include "../src/file_loader.h"
+#include "../src/text.h"
+
+FILE *OUT_FILE = NULL;
+int VERBOSE_LEVEL = 7;
+
+/* Wait for the loader to load a file, at most 5 seconds. */
+static int
+wait_loaded (file_loader * loader)
+{
+  fd_set rfds;
+  struct timeval timeout = { 5, 0 };
+  int fd = file_loader_fd (loader);
+
+  FD_ZERO (&rfds);
+  FD_SET (fd, &rfds);
+  return select (fd + 1, &rfds, NULL, NULL, &timeout);
+}
+
+/* Wait for a file to be prefetched, at most 5 seconds. */
+static int
+wait_prefetched (file_loader * loader, const char *file_name)
+{
+  int i;
+
+  for (i = 0; i < 500; i++)
+    {
+      if (file_loader_prefetch (loader, file_name) == 1)
+	{
+	  return 1;
+	}
+      usleep (10000);
+    }
+  return 0;
+}
+
+/* Request a file and take it when it is loaded. */
+static text *
+load (file_loader * loader, const char *file_name)
+{
+  char *loaded;
+  text *text;
+
+  if (file_loader_request (loader, file_name) < 0
+      || wait_loaded (loader) != 1
+      || file_loader_take (loader, &loaded, &text) != 1)
+    {
+      return NULL;
+    }
+  fail_unless (strcmp (loaded, file_name) == 0);
+  free (loaded);
+  return text;
+}
+
+/* Write the temporary file, keeping its time stamps if @a keep is 1. */
+static void
+write_file (const char *file_name, const char *content, int keep)
+{
+  struct timespec times[2];
+  struct stat st;
+  FILE *file;
+
+  fail_unless (stat (file_name, &st) == 0);
+  file = fopen (file_name, "w");
+  fail_unless (file != NULL);
+  fputs (content, file);
+  fclose (file);
+  if (keep)
+    {
+      times[0] = st.st_atim;
+      times[1] = st.st_mtim;
+      fail_unless (utimensat (AT_FDCWD, file_name, times, 0) == 0);
+    }
+}
+
+START_TEST (test_file_loader_load)
+{
+  file_loader *loader;
+  char *file_name;
+  text *text;
+  int ret;
+
+  loader = file_loader_create ();
+  fail_unless (loader != NULL);
+  fail_unless (file_loader_fd (loader) >= 0);
+
+  /* Nothing loaded. */
+  ret = file_loader_take (loader, &file_name, &text);
+  fail_unless (ret == 0);
+
+  /* A file. */
+  ret = file_loader_request (loader, CONFDIR "text_test.txt");
+  fail_unless (ret == 0);
+  fail_unless (wait_loaded (loader) == 1);
+  ret = file_loader_take (loader, &file_name, &text);
+  fail_unless (ret == 1);
+  fail_unless (strcmp (file_name, CONFDIR "text_test.txt") == 0);
+  fail_unless (text != NULL);
+  fail_unless (text_nr_of_lines (text) == 120);
+  free (file_name);
+  text_free (text);
+  ret = file_loader_take (loader, &file_name, &text);
+  fail_unless (ret == 0);
+
+  /* A file that does not exist. */
+  ret = file_loader_request (loader, CONFDIR "text_WRONG.txt");
+  fail_unless (ret == 0);
+  fail_unless (wait_loaded (loader) == 1);
+  ret = file_loader_take (loader, &file_name, &text);
+  fail_unless (ret == 1);
+  fail_unless (strcmp (file_name, CONFDIR "text_WRONG.txt") == 0);
+  fail_unless (text == NULL);
+  free (file_name);
+
+  /* The last requested file is loaded, the ones before may be dropped. */
+  file_loader_request (loader, CONFDIR "text_test_long.txt");
+  file_loader_request (loader, CONFDIR "text_test.txt");
+  do
+    {
+      fail_unless (wait_loaded (loader) == 1);
+      ret = file_loader_take (loader, &file_name, &text);
+      fail_unless (ret == 1);
+      fail_unless (text != NULL);
+      text_free (text);
+      ret = strcmp (file_name, CONFDIR "text_test.txt");
+      free (file_name);
+    }
+  while (ret != 0);
+
+  /* Freed while loading. */
+  file_loader_request (loader, CONFDIR "text_test_long.txt");
+  file_loader_free (loader);
+  file_loader_free (NULL);
+}
+END_TEST
+
+START_TEST (test_file_loader_prefetch)
+{
+  file_loader *loader;
+  char file_name[] = "/tmp/check_file_loader_XXXXXX";
+  const char *line;
+  text *text;
+  int len;
+  int fd;
+  int ret;
+
+  fd = mkstemp (file_name);
+  fail_unless (fd >= 0);
+  close (fd);
+  write_file (file_name, "one\n", 0);
+
+  loader = file_loader_create ();
+  fail_unless (loader != NULL);
+
+  /* Prefetched once. */
+  ret = file_loader_prefetch (loader, CONFDIR "text_test.txt");
+  fail_unless (ret == 0);
+  ret = file_loader_prefetch (loader, CONFDIR "text_test.txt");
+  fail_unless (ret == 0 || ret == 1);
+  fail_unless (wait_prefetched (loader, CONFDIR "text_test.txt"));
+
+  /* A request is served by the prefetched file, which is then dropped. */
+  text = load (loader, CONFDIR "text_test.txt");
+  fail_unless (text != NULL);
+  fail_unless (text_nr_of_lines (text) == 120);
+  text_free (text);
+  ret = file_loader_prefetch (loader, CONFDIR "text_test.txt");
+  fail_unless (ret == 0);
+
+  /* The file is not read again if its time and size are the same. */
+  ret = file_loader_prefetch (loader, file_name);
+  fail_unless (ret == 0);
+  fail_unless (wait_prefetched (loader, file_name));
+  write_file (file_name, "two\n", 1);
+  text = load (loader, file_name);
+  fail_unless (text != NULL);
+  line = text_get_line (text, 0, &len);
+  fail_unless (line != NULL && strncmp (line, "one", len) == 0);
+  text_free (text);
+
+  /* A file that changed after it was prefetched is read again. */
+  ret = file_loader_prefetch (loader, file_name);
+  fail_unless (ret == 0);
+  fail_unless (wait_prefetched (loader, file_name));
+  write_file (file_name, "three\n", 0);
+  text = load (loader, file_name);
+  fail_unless (text != NULL);
+  line = text_get_line (text, 0, &len);
+  fail_unless (line != NULL && strncmp (line, "three", len) == 0);
+  text_free (text);
+  unlink (file_name);
+
+  /* Files that can not be read are not kept. */
+  ret = file_loader_prefetch (loader, CONFDIR "text_WRONG.txt");
+  fail_unless (ret == 0);
+  ret = file_loader_prefetch (loader, CONFDIR "text_test_long.txt");
+  fail_unless (ret == 0);
+  fail_unless (wait_prefetched (loader, CONFDIR "text_test_long.txt"));
+  ret = file_loader_prefetch (loader, CONFDIR "text_WRONG.txt");
+  fail_unless (ret == 0);
+
+  /* Freed with files waiting and prefetched. */
+  file_loader_prefetch (loader, CONFDIR "text_test.txt");
+  file_loader_free (loader);
+}
+END_TEST
+
+/**
+ * @test Test file_loader.c functions.
+ *
+ * - _load: Load files in the background.
+ * - _prefetch: Prefetch files and take them.
+ */
+  Suite * file_loader_suite (void)
+{
+  Suite *s = suite_create ("file_loader");
+
+  TCase *tc_load = tcase_create ("load");
+  tcase_add_test (tc_load, test_file_loader_load);
+  suite_add_tcase (s, tc_load);
+
+  TCase *tc_prefetch = tcase_create ("prefetch");
+  tcase_add_test (tc_prefetch, test_file_loader_prefetch);
+  suite_add_tcase (s, tc_prefetch);
+
+  return s;
+}
+
+int
+main (void)
+{
+  int number_failed;
+
+  OUT_FILE = stdout;
+  Suite *s = file_loader_suite ();
+  SRunner *sr = srunner_create (s);
+
+  srunner_run_all (sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed (sr);
+  srunner_free (sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -28,6 +28,35 @@ START_TEST (test_forkpty_create)
 }
 END_TEST
 
+START_TEST (test_forkpty_open_pty)
+{
+  int fd;
+  int slave;
+  char name[64];
+  char buf[64];
+  int ret;
+
+  ret = open_pty (&fd, &slave, name, sizeof (name));
+  fail_unless (ret == 0);
+  fail_unless (strncmp (name, "/dev/", 5) == 0, "Got '%s'", name);
+
+  /* Nothing to read, the master does not block. */
+  ret = read (fd, buf, sizeof (buf));
+  fail_unless (ret < 0);
+
+  ret = write (slave, "Hello\n", 6);
+  fail_unless (ret == 6);
+  usleep (100000);
+  ret = read (fd, buf, sizeof (buf) - 1);
+  fail_unless (ret > 0);
+  buf[ret] = '\0';
+  fail_unless (strncmp (buf, "Hello", 5) == 0, "Got '%s'", buf);
+
+  close (slave);
+  close (fd);
+}
+END_TEST
+
 /**
  * \test Test pseudo_fork.c function.
  *
@@ -41,6 +70,10 @@ END_TEST
   TCase *tc_forkpty_create = tcase_create ("forkpty_create");
   tcase_add_test (tc_forkpty_create, test_forkpty_create);
   suite_add_tcase (s, tc_forkpty_create);
+
+  TCase *tc_forkpty_open_pty = tcase_create ("forkpty_open_pty");
+  tcase_add_test (tc_forkpty_open_pty, test_forkpty_open_pty);
+  suite_add_tcase (s, tc_forkpty_open_pty);
   return s;
 }
 
@@ -5,6 +5,7 @@
 #include <unistd.h>
 
 #include "../src/input.h"
+#include "../src/win_form.h"
 
 /*
  * NOTE:
@@ -121,6 +122,12 @@ int g_win_type;
 view *g_view;
 mi2_interface *g_mi2;
 view *g_view;
+const char *g_input;
+const char *g_typed;
+char g_search[64];
+int g_search_dir;
+int g_search_skip;
+int g_searches;
 
 int
 wgetch (int scr)
@@ -178,6 +185,37 @@ view_scroll_down (view * view)
   return GLOB_RETURN;
 }
 
+char *
+form_input (const char *value, const char *header, form_update_func update,
+	    void *data)
+{
+  if (g_typed != NULL)
+    {
+      update (data, g_typed);
+    }
+  return g_input != NULL ? strdup (g_input) : NULL;
+}
+
+int
+view_search (view * view, const char *pattern, int dir, int skip)
+{
+  snprintf (g_search, 64, "%s", pattern != NULL ? pattern : "(null)");
+  g_search_dir = dir;
+  g_search_skip = skip;
+  g_searches++;
+  return GLOB_RETURN;
+}
+
+int
+view_scroll_page (view * view, int dir)
+{
+  g_function = 9;
+  g_param = dir;
+  g_view = view;
+
+  return GLOB_RETURN;
+}
+
 int
 view_get_tag (view * view, int *win)
 {
@@ -186,6 +224,13 @@ view_get_tag (view * view, int *win)
   return GLOB_RETURN;
 }
 
+int
+view_get_cursor (view * view, int *win, int *line_nr, const char **file_name)
+{
+  *win = g_win_type;
+  return -1;
+}
+
 int
 view_add_message (view * view, int level, const char *msg, ...)
 {
@@ -205,6 +250,38 @@ view_toggle_view_mode (view * view)
 {
 }
 
+int
+view_toggle_record (view * view)
+{
+  g_function = 10;
+  return GLOB_RETURN;
+}
+
+int
+view_resize (view * view)
+{
+  g_function = 11;
+  g_view = view;
+  return GLOB_RETURN;
+}
+
+int
+view_toggle_wrap (view * view)
+{
+  g_function = 12;
+  g_view = view;
+  return GLOB_RETURN;
+}
+
+int
+view_scroll_columns (view * view, int dir)
+{
+  g_function = 13;
+  g_param = dir;
+  g_view = view;
+  return GLOB_RETURN;
+}
+
 int
 form_selection (char **list, const char *header)
 {
@@ -240,6 +317,52 @@ START_TEST (test_input_create)
   fail_unless (g_function == 3);
   fail_unless (g_view == (view *) 42);
 
+  /* Resize events are handled once, before the other keys. */
+  g_view = NULL;
+  g_function = 0;
+  g_index = 0;
+  g_index_max = 2;
+  g_buf[0] = KEY_RESIZE;
+  g_buf[1] = KEY_RESIZE;
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_function == 11);
+  fail_unless (g_view == (view *) 42);
+  g_index = 0;
+  g_index_max = 2;
+  g_buf[0] = KEY_RESIZE;
+  g_buf[1] = KEY_DOWN;
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_function == 3);
+
+  /* Nothing to read after an interrupted select. */
+  g_view = NULL;
+  g_function = 0;
+  g_index = 0;
+  g_index_max = 0;
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_function == 0);
+  fail_unless (g_view == NULL);
+
+  /* Key down in stack window fetches more frames. */
+  g_view = NULL;
+  g_action = -1;
+  g_param = -1;
+  g_win_type = WIN_STACK;
+  GLOB_RETURN = 0;
+  g_index = 0;
+  g_index_max = 1;
+  g_buf[0] = KEY_DOWN;
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_function == 1);
+  fail_unless (g_view == (view *) 42);
+  fail_unless (g_action == ACTION_STACK_LIST_MORE_FRAMES);
+  fail_unless (g_param == 0);
+  g_win_type = 0;
+
   /* Key up */
   g_view = NULL;
   GLOB_RETURN = 0;
@@ -251,6 +374,62 @@ START_TEST (test_input_create)
   fail_unless (g_function == 4);
   fail_unless (g_view == (view *) 42);
 
+  /* Page keys. */
+  g_view = NULL;
+  g_param = 0;
+  GLOB_RETURN = 0;
+  g_index = 0;
+  g_index_max = 1;
+  g_buf[0] = KEY_NPAGE;
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_function == 9);
+  fail_unless (g_param == 1);
+  fail_unless (g_view == (view *) 42);
+  g_index = 0;
+  g_buf[0] = KEY_PPAGE;
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_function == 9);
+  fail_unless (g_param == -1);
+
+  /* Cut lines and scroll sideways. */
+  g_view = NULL;
+  g_index = 0;
+  g_buf[0] = 'W';
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_function == 12);
+  fail_unless (g_view == (view *) 42);
+  g_index = 0;
+  g_buf[0] = '>';
+  ret = input_get_input (input);
+  fail_unless (g_function == 13);
+  fail_unless (g_param == 1);
+  g_index = 0;
+  g_buf[0] = '<';
+  ret = input_get_input (input);
+  fail_unless (g_function == 13);
+  fail_unless (g_param == -1);
+
+  /* Scrolling in the memory window reads the memory. */
+  g_win_type = WIN_MEMORY;
+  g_action = -1;
+  g_index = 0;
+  g_buf[0] = KEY_UP;
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_function == 1);
+  fail_unless (g_action == ACTION_DATA_READ_MEMORY);
+  g_action = -1;
+  g_index = 0;
+  g_buf[0] = KEY_NPAGE;
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_function == 1);
+  fail_unless (g_action == ACTION_DATA_READ_MEMORY);
+  g_win_type = 0;
+
   /* Key right */
   g_view = NULL;
   g_group = -1;
@@ -363,6 +542,20 @@ START_TEST (test_input_create)
   fail_unless (g_mi2 == (mi2_interface *) 43);
   fail_unless (g_action == ACTION_STACK_LIST_VARIABLES);
 
+  /* '\r' in the frame window toggles a variable. */
+  g_mi2 = 0;
+  g_param = -1;
+  g_action = -1;
+  GLOB_RETURN = 3;
+  g_win_type = WIN_FRAME;
+  g_index = 0;
+  g_index_max = 1;
+  g_buf[0] = '\r';
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_param == 3);
+  fail_unless (g_action == ACTION_VAR_TOGGLE);
+
   /* '\r' Wrong window type when view_get_tag. */
   g_function = -2;
   g_param = -1;
@@ -399,6 +592,19 @@ START_TEST (test_input_create)
   fail_unless (g_got_tag == -1);
   fail_unless (g_action == -1);
 
+  /* '\r' In responses window expands or truncates a record. */
+  g_function = -2;
+  g_action = -1;
+  GLOB_RETURN = 0;
+  g_win_type = WIN_RESPONSES;
+  g_index = 0;
+  g_index_max = 1;
+  g_buf[0] = '\r';
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_function == 10);
+  fail_unless (g_action == -1);
+
   /* '\r' In thread window. */
   g_function = -2;
   g_param = -1;
@@ -430,57 +636,92 @@ START_TEST (test_input_create)
   fail_unless (g_action == 0);
   fail_unless (g_mi2 == (mi2_interface *) 43);
 
-  /* Test F4 - start */
+  /* Test F5 - browse start */
   g_string = strdup ("Something");
   g_param = -1;
   g_mi2 = 0;
   GLOB_RETURN = 0;
   g_index = 0;
   g_index_max = 1;
-  g_buf[0] = KEY_F (4);
+  g_buf[0] = KEY_F (5);
   ret = input_get_input (input);
   fail_unless (ret == 0);
   fail_unless (g_function == 7);
   fail_unless (g_action == 0);
 
-  /* Test F4 - bad */
+  /* Test F5 - browse bad */
   g_string = strdup ("Something");
   g_param = -1;
   g_mi2 = 0;
   GLOB_RETURN = -1;
   g_index = 0;
   g_index_max = 1;
-  g_buf[0] = KEY_F (4);
+  g_buf[0] = KEY_F (5);
   ret = input_get_input (input);
   fail_unless (ret == 0);
   fail_unless (g_function == 8);
   fail_unless (g_action == 0);
 
-  /* Test F4 - really bad */
+  /* Test F5 - browse really bad */
   g_string = strdup ("Something");
   g_param = -1;
   g_mi2 = 0;
   GLOB_RETURN = -2;
   g_index = 0;
   g_index_max = 1;
-  g_buf[0] = KEY_F (4);
+  g_buf[0] = KEY_F (5);
   ret = input_get_input (input);
   fail_unless (ret == 0);
   fail_unless (g_function == 6);
 
-  /* Test F5 - symfiles */
+  /* Test F4 - source files */
   g_param = -1;
   g_mi2 = 0;
   GLOB_RETURN = 0;
   g_index = 0;
   g_index_max = 1;
-  g_buf[0] = KEY_F (5);
+  g_buf[0] = KEY_F (4);
   ret = input_get_input (input);
   fail_unless (ret == 0);
   fail_unless (g_function == 1);
   fail_unless (g_action == ACTION_FILE_LIST_EXEC_SORCES);
   fail_unless (g_mi2 == (mi2_interface *) 43);
 
+  /* Test F4 - source files bad */
+  g_param = -1;
+  g_mi2 = 0;
+  GLOB_RETURN = -1;
+  g_index = 0;
+  g_index_max = 1;
+  g_buf[0] = KEY_F (4);
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_function == 6);
+  fail_unless (g_action == ACTION_FILE_LIST_EXEC_SORCES);
+
+  /* Test 'g' - functions */
+  g_param = -1;
+  g_mi2 = 0;
+  GLOB_RETURN = 0;
+  g_index = 0;
+  g_index_max = 1;
+  g_buf[0] = 'g';
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_function == 1);
+  fail_unless (g_action == ACTION_SYMBOL_INFO_FUNCTIONS);
+  fail_unless (g_mi2 == (mi2_interface *) 43);
+
+  /* Test 'g' - functions bad */
+  GLOB_RETURN = -1;
+  g_index = 0;
+  g_index_max = 1;
+  g_buf[0] = 'g';
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_function == 6);
+  fail_unless (g_action == ACTION_SYMBOL_INFO_FUNCTIONS);
+
   /* Test 'd' */
   g_param = -1;
   g_diss = 0;
@@ -496,6 +737,59 @@ START_TEST (test_input_create)
   fail_unless (g_action == ACTION_DATA_DISASSEMBLE);
   fail_unless (g_mi2 == (mi2_interface *) 43);
 
+  /* Test '/' typing a pattern */
+  GLOB_RETURN = 0;
+  g_searches = 0;
+  g_typed = "fo";
+  g_input = "foo";
+  g_index = 0;
+  g_index_max = 1;
+  g_buf[0] = '/';
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_searches == 2);
+  fail_unless (strcmp (g_search, "foo") == 0);
+  fail_unless (g_search_dir == 1);
+  fail_unless (g_search_skip == 0);
+
+  /* Test '?' with the same pattern, goes to the next match */
+  g_searches = 0;
+  g_typed = NULL;
+  g_function = 0;
+  GLOB_RETURN = -1;
+  g_index = 0;
+  g_index_max = 1;
+  g_buf[0] = '?';
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_searches == 1);
+  fail_unless (strcmp (g_search, "foo") == 0);
+  fail_unless (g_search_dir == -1);
+  fail_unless (g_search_skip == 1);
+  fail_unless (g_function == 6);
+
+  /* Test '/' canceled */
+  g_searches = 0;
+  g_input = NULL;
+  GLOB_RETURN = 0;
+  g_index = 0;
+  g_index_max = 1;
+  g_buf[0] = '/';
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_searches == 1);
+  fail_unless (strcmp (g_search, "(null)") == 0);
+
+  /* Test 'x' */
+  g_action = -1;
+  g_index = 0;
+  g_index_max = 1;
+  g_buf[0] = 'x';
+  ret = input_get_input (input);
+  fail_unless (ret == 0);
+  fail_unless (g_function == 1);
+  fail_unless (g_action == ACTION_DATA_MEMORY);
+
   g_index = 0;
   g_index_max = 1;
   g_buf[0] = 255;
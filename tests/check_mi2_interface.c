@@ -5,6 +5,7 @@
 #include <unistd.h>
 
 #include "../src/mi2_interface.h"
+#include "../src/mi2_parser.h"
 #include "../src/win_form.h"
 
 #define LONG_FILE_NAME "1                                                     "\
@@ -40,6 +41,19 @@ int g_form_run;
 int g_thread;
 char *g_regs;
 char *g_file;
+int g_stack_depth;
+int g_stack_total;
+int g_var_action;
+char *g_var_name;
+int g_var_requests = 0;
+int g_streaming = 0;
+int g_ass_request = 0;
+int g_mem_refresh = 0;
+uint64_t g_mem_locate = 0;
+int g_mem_view = -1;
+int g_mem_pages = 0;
+int g_find_file = -1;
+int g_find_symbol = -1;
 breakpoint *GLOB_BP;
 
 /* Overloading dependence to mi2_parser functions. */
@@ -156,6 +170,41 @@ mi2_parser_set_frame (mi2_parser * parser, int frame)
 {
 }
 
+int
+mi2_parser_var_toggle (mi2_parser * parser, int id, const char **var_name)
+{
+  *var_name = g_var_name;
+  return g_var_action;
+}
+
+int
+mi2_parser_next_var_request (mi2_parser * parser, int *thread_id,
+			     int *frame, char **var_name, char **exp)
+{
+  if (g_var_requests == 0)
+    {
+      return VAR_ACTION_NONE;
+    }
+  *thread_id = 1;
+  *frame = 2;
+  if (g_var_requests-- == 2)
+    {
+      *var_name = strdup ("lv7");
+      *exp = strdup ("i");
+      return VAR_ACTION_CREATE;
+    }
+  *var_name = strdup ("lv8");
+  *exp = NULL;
+  return VAR_ACTION_DELETE;
+}
+
+int
+mi2_parser_get_stack_depth (mi2_parser * parser, int *total)
+{
+  *total = g_stack_total;
+  return g_stack_depth;
+}
+
 int
 mi2_parser_parse (mi2_parser * parser, char *line, int *update, char **regs)
 {
@@ -164,6 +213,28 @@ mi2_parser_parse (mi2_parser * parser, char *line, int *update, char **regs)
   return GLOB_RET;
 };
 
+int
+mi2_parser_feed (mi2_parser * parser, const char *buf, int len)
+{
+  int ret;
+
+  if (buf[0] == '^')
+    {
+      g_streaming = 1;
+    }
+  ret = g_streaming;
+  if (memchr (buf, '\n', len) != NULL)
+    {
+      g_streaming = 0;
+    }
+  return ret;
+}
+
+void
+mi2_parser_flush (mi2_parser * parser)
+{
+}
+
 breakpoint *
 mi2_parser_get_bp (mi2_parser * parser, const char *file_name, int line_nr)
 {
@@ -189,6 +260,63 @@ mi2_parser_toggle_disassemble (mi2_parser * parser)
 {
 }
 
+int
+mi2_parser_disassembly_request (mi2_parser * parser)
+{
+  int request = g_ass_request;
+
+  g_ass_request = 0;
+  return request;
+}
+
+void
+mi2_parser_memory_locate (mi2_parser * parser, uint64_t length)
+{
+  g_mem_locate = length;
+}
+
+int
+mi2_parser_memory_refresh (mi2_parser * parser)
+{
+  int request = g_mem_refresh;
+
+  g_mem_refresh = 0;
+  return request;
+}
+
+int
+mi2_parser_memory_pages (mi2_parser * parser, uint64_t address,
+			 uint64_t length, uint64_t * pages, int size)
+{
+  int i;
+
+  for (i = 0; i < g_mem_pages && i < size; i++)
+    {
+      pages[i] = address + i * 0x1000;
+    }
+  return i;
+}
+
+int
+mi2_parser_find_file (mi2_parser * parser)
+{
+  return g_find_file;
+}
+
+int
+mi2_parser_find_symbol (mi2_parser * parser)
+{
+  return g_find_symbol;
+}
+
+int
+view_get_memory_view (view * view, uint64_t * address, uint64_t * length)
+{
+  *address = 0x601000;
+  *length = 0x200;
+  return g_mem_view;
+}
+
 int
 view_get_cursor (view * view, int *win, int *line_nr, const char **file_name)
 {
@@ -293,6 +421,70 @@ START_TEST (test_mi2_interface_do_action)
   fail_unless (ret == 0);
   fail_unless (g_found[0] == 1);
 
+  /* Variable objects. */
+  g_var_action = VAR_ACTION_NONE;
+  g_safe_write = 0;
+  ret = mi2_do_action (mi2, ACTION_VAR_TOGGLE, 5);
+  fail_unless (ret == 0);
+  fail_unless (g_safe_write == 0);
+  g_var_action = -1;
+  ret = mi2_do_action (mi2, ACTION_VAR_TOGGLE, 5);
+  fail_unless (ret < 0);
+  fail_unless (g_safe_write == 0);
+  g_var_action = VAR_ACTION_CHILDREN;
+  g_var_name = "lv5.a";
+  g_to_find[0] = "-var-list-children --simple-values lv5.a";
+  g_to_find[1] = NULL;
+  g_found[0] = 0;
+  g_safe_write = 0;
+  ret = mi2_do_action (mi2, ACTION_VAR_TOGGLE, 6);
+  fail_unless (ret == 0);
+  fail_unless (g_safe_write == 1);
+  fail_unless (g_found[0] == 1);
+
+  /* A new stack keeps the variable objects. */
+  g_to_find[0] = "-var-delete";
+  g_to_find[1] = NULL;
+  g_found[0] = 0;
+  g_safe_write = 0;
+  ret = mi2_do_action (mi2, ACTION_STACK_LIST_FRAMES, 0);
+  fail_unless (ret == 0);
+  fail_unless (g_found[0] == 0);
+  fail_unless (g_safe_write == 2);
+
+  /* Paged stack. */
+  g_to_find[0] = "-stack-info-depth";
+  g_to_find[1] = "-stack-list-frames --thread 0 0 31";
+  g_to_find[2] = NULL;
+  g_found[0] = 0;
+  g_found[1] = 0;
+  ret = mi2_do_action (mi2, ACTION_STACK_LIST_FRAMES, 0);
+  fail_unless (ret == 0);
+  fail_unless (g_found[0] == 1);
+  fail_unless (g_found[1] == 1);
+
+  g_stack_depth = 32;
+  g_stack_total = 1000;
+  g_safe_write = 0;
+  ret = mi2_do_action (mi2, ACTION_STACK_LIST_MORE_FRAMES, 10);
+  fail_unless (ret == 0);
+  fail_unless (g_safe_write == 0);
+  g_to_find[0] = "-stack-list-frames --thread 0 32 63";
+  g_to_find[1] = NULL;
+  g_found[0] = 0;
+  ret = mi2_do_action (mi2, ACTION_STACK_LIST_MORE_FRAMES, 30);
+  fail_unless (ret == 0);
+  fail_unless (g_found[0] == 1);
+  g_safe_write = 0;
+  ret = mi2_do_action (mi2, ACTION_STACK_LIST_MORE_FRAMES, 31);
+  fail_unless (ret == 0);
+  fail_unless (g_safe_write == 0);
+  g_stack_total = 40;
+  g_safe_write = 0;
+  ret = mi2_do_action (mi2, ACTION_STACK_LIST_MORE_FRAMES, 60);
+  fail_unless (ret == 0);
+  fail_unless (g_safe_write == 0);
+
   g_to_find[0] = "-stack-list-variables";
   g_to_find[1] = NULL;
   g_found[0] = 0;
@@ -316,6 +508,40 @@ START_TEST (test_mi2_interface_do_action)
   fail_unless (ret == 0);
   fail_unless (g_found[0] == 1);
 
+  /* The source files are already known. */
+  g_find_file = 0;
+  g_found[0] = 0;
+  g_safe_write = 0;
+  ret = mi2_do_action (mi2, ACTION_FILE_LIST_EXEC_SORCES, 0);
+  fail_unless (ret == 0);
+  fail_unless (g_found[0] == 0);
+  fail_unless (g_safe_write == 0);
+  g_find_file = -1;
+
+  g_to_find[0] = "-symbol-info-functions";
+  g_to_find[1] = NULL;
+  g_found[0] = 0;
+  ret = mi2_do_action (mi2, ACTION_SYMBOL_INFO_FUNCTIONS, 0);
+  fail_unless (ret == 0);
+  fail_unless (g_found[0] == 1);
+
+  /* The functions are already known. */
+  g_find_symbol = 0;
+  g_found[0] = 0;
+  g_safe_write = 0;
+  ret = mi2_do_action (mi2, ACTION_SYMBOL_INFO_FUNCTIONS, 0);
+  fail_unless (ret == 0);
+  fail_unless (g_found[0] == 0);
+  fail_unless (g_safe_write == 0);
+  g_find_symbol = -1;
+
+  g_to_find[0] = "-inferior-tty-set /dev/pts/7\n";
+  g_to_find[1] = NULL;
+  g_found[0] = 0;
+  ret = mi2_set_inferior_tty (mi2, "/dev/pts/7");
+  fail_unless (ret == 0);
+  fail_unless (g_found[0] == 1);
+
   g_to_find[0] = "-data-disassemble ";
   g_to_find[1] = NULL;
   g_found[0] = 0;
@@ -362,12 +588,45 @@ START_TEST (test_mi2_interface_parse)
   ret = mi2_parse (mi2, buf);
   fail_unless (ret == -1);
 
+  /* Parts of long records. */
+  fail_unless (mi2_feed (mi2, "(gdb)\n", 6) == 0);
+  g_safe_write = 0;
+  g_var_requests = 2;
+  fail_unless (mi2_feed (mi2, "^done,files=[", 13) == 1);
+  fail_unless (g_var_requests == 2);
+  fail_unless (mi2_feed (mi2, "]\n", 2) == 1);
+  /* The requests of the record are sent when it has ended. */
+  fail_unless (g_var_requests == 0);
+  fail_unless (g_safe_write == 2);
+
   g_safe_write = 0;
   g_regs = NULL;
   GLOB_CMD = 1;
   GLOB_RET = 0;
   g_to_find[0] = "-stack-list";
   g_to_find[1] = "-thread-info";
+  g_to_find[2] = "-var-update --all-values *";
+  g_to_find[3] = "-stack-list-variables --thread 0 --frame 0 --no-values";
+  g_to_find[4] = NULL;
+  g_found[0] = 0;
+  g_found[1] = 0;
+  g_found[2] = 0;
+  g_found[3] = 0;
+  sprintf (buf, "FOO");
+  ret = mi2_parse (mi2, buf);
+  fail_unless (ret == 0);
+  fail_unless (g_safe_write == 5);
+  fail_unless (g_found[0] == 1);
+  fail_unless (g_found[1] == 1);
+  fail_unless (g_found[2] == 1);
+  fail_unless (g_found[3] == 1);
+
+  /* Variable objects requested by the parser. */
+  g_safe_write = 0;
+  GLOB_CMD = 0;
+  g_var_requests = 2;
+  g_to_find[0] = "-var-create --thread 1 --frame 2 lv7 * i";
+  g_to_find[1] = "-var-delete lv8";
   g_to_find[2] = NULL;
   g_found[0] = 0;
   g_found[1] = 0;
@@ -377,6 +636,7 @@ START_TEST (test_mi2_interface_parse)
   fail_unless (g_safe_write == 2);
   fail_unless (g_found[0] == 1);
   fail_unless (g_found[1] == 1);
+  fail_unless (g_var_requests == 0);
   if (g_file)
     {
       free (g_file);
@@ -401,6 +661,7 @@ START_TEST (test_mi2_interface_parse)
   g_found[3] = 0;
   g_found[4] = 0;
   g_found[5] = 0;
+  g_ass_request = 1;
   if (g_file)
     {
       free (g_file);
@@ -409,7 +670,7 @@ START_TEST (test_mi2_interface_parse)
   sprintf (buf, "FOO");
   ret = mi2_parse (mi2, buf);
   fail_unless (ret == 0);
-  fail_unless (g_safe_write == 6);
+  fail_unless (g_safe_write == 9);
   fail_unless (g_found[0] == 1);
   fail_unless (g_found[1] == 1);
   fail_unless (g_found[2] == 1);
@@ -1157,6 +1418,7 @@ START_TEST (test_mi2_interface_dis)
 {
   int ret;
   mi2_interface *mi2;
+  char buf[64];
 
   GLOB_PARSER = (mi2_parser *) 1;
   mi2 = mi2_create (99, 0, NULL, NULL);
@@ -1167,15 +1429,34 @@ START_TEST (test_mi2_interface_dis)
   GLOB_LINE = 42;
   GLOB_NAME = "foo.c";
   GLOB_BP = NULL;
-  g_to_find[0] = "-data-disassemble ";	/* NB extra space. */
-  g_to_find[1] = "-data-list-changed-registers";
+  g_to_find[0] = "-data-evaluate-expression $pc";
+  g_to_find[1] = "-data-disassemble ";	/* NB extra space. */
   g_to_find[2] = 0;
   g_safe_write = 0;
   g_found[0] = 0;
+  g_found[1] = 0;
   mi2_toggle_disassemble (mi2);
   fail_unless (g_found[0]);
+  fail_unless (!g_found[1]);
   fail_unless (g_fd == 99);
   fail_unless (g_safe_write == 2);
+
+  /* The function at pc is not cached. */
+  g_ass_request = 1;
+  GLOB_CMD = 0;
+  GLOB_RET = 0;
+  g_regs = NULL;
+  g_safe_write = 0;
+  sprintf (buf, "^done,value=\"0x42\"");
+  ret = mi2_parse (mi2, buf);
+  fail_unless (ret == 0);
+  fail_unless (g_found[1]);
+  fail_unless (g_safe_write == 1);
+  if (g_file)
+    {
+      free (g_file);
+    }
+  g_file = NULL;
   if (g_file)
     {
       free (g_file);
@@ -1186,6 +1467,111 @@ START_TEST (test_mi2_interface_dis)
 }
 END_TEST
 
+/* Test the memory window. */
+START_TEST (test_mi2_interface_memory)
+{
+  int ret;
+  mi2_interface *mi2;
+  char buf[64];
+
+  GLOB_PARSER = (mi2_parser *) 1;
+  mi2 = mi2_create (99, 0, NULL, NULL);
+  fail_unless (mi2 != NULL);
+
+  /* Canceled form. */
+  GLOB_RET = 0;
+  GLOB_FORM_RET = -1;
+  GLOB_FORM_NEW = 0;
+  g_safe_write = 0;
+  g_mem_locate = 0;
+  ret = mi2_do_action (mi2, ACTION_DATA_MEMORY, 0);
+  fail_unless (ret == 0);
+  fail_unless (g_safe_write == 0);
+  fail_unless (g_mem_locate == 0);
+
+  /* No address. */
+  GLOB_FORM_RET = 0;
+  GLOB_FORM_NEW = 1;
+  GLOB_STRING = NULL;
+  ret = mi2_do_action (mi2, ACTION_DATA_MEMORY, 0);
+  fail_unless (ret < 0);
+  fail_unless (g_safe_write == 0);
+
+  /* The address is evaluated by the debugger. */
+  GLOB_STRING = "&buf";
+  g_to_find[0] = "-data-read-memory \"&buf\" x 1 1 1";
+  g_to_find[1] = 0;
+  g_found[0] = 0;
+  ret = mi2_do_action (mi2, ACTION_DATA_MEMORY, 0);
+  fail_unless (ret == 0);
+  fail_unless (g_found[0]);
+  fail_unless (g_safe_write == 1);
+  fail_unless (g_mem_locate == 65536);
+
+  /* Spaces, quotes and backslashes are kept in the expression. */
+  GLOB_STRING = "*(char *) strchr (\"a\\b\", 'b')";
+  g_to_find[0] =
+    "-data-read-memory \"*(char *) strchr (\\\"a\\\\b\\\", 'b')\" x 1 1 1";
+  g_found[0] = 0;
+  ret = mi2_do_action (mi2, ACTION_DATA_MEMORY, 0);
+  fail_unless (ret == 0);
+  fail_unless (g_found[0]);
+  fail_unless (g_safe_write == 2);
+  GLOB_FORM_NEW = 0;
+  GLOB_STRING = NULL;
+
+  /* No memory shown. */
+  g_safe_write = 0;
+  g_mem_view = -1;
+  g_mem_pages = 2;
+  ret = mi2_do_action (mi2, ACTION_DATA_READ_MEMORY, 0);
+  fail_unless (ret == 0);
+  fail_unless (g_safe_write == 0);
+
+  /* One command per page. */
+  g_mem_view = 0;
+  g_to_find[0] = "-data-read-memory-bytes 0x601000 4096";
+  g_to_find[1] = "-data-read-memory-bytes 0x602000 4096";
+  g_to_find[2] = 0;
+  g_found[0] = 0;
+  g_found[1] = 0;
+  ret = mi2_do_action (mi2, ACTION_DATA_READ_MEMORY, 0);
+  fail_unless (ret == 0);
+  fail_unless (g_safe_write == 2);
+  fail_unless (g_found[0] && g_found[1]);
+
+  /* Cached pages are not read. */
+  g_safe_write = 0;
+  g_mem_pages = 0;
+  ret = mi2_do_action (mi2, ACTION_DATA_READ_MEMORY, 0);
+  fail_unless (ret == 0);
+  fail_unless (g_safe_write == 0);
+
+  /* The parser asks for a refresh, e.g. after a stop. */
+  g_mem_pages = 1;
+  g_mem_refresh = 1;
+  g_found[0] = 0;
+  g_regs = NULL;
+  GLOB_CMD = 0;
+  sprintf (buf, "^done");
+  ret = mi2_parse (mi2, buf);
+  fail_unless (ret == 0);
+  fail_unless (g_safe_write == 1);
+  fail_unless (g_found[0]);
+  fail_unless (g_mem_refresh == 0);
+
+  /* Failed to send. */
+  GLOB_RET = -1;
+  ret = mi2_do_action (mi2, ACTION_DATA_READ_MEMORY, 0);
+  fail_unless (ret < 0);
+  GLOB_RET = 0;
+  g_mem_pages = 0;
+  g_mem_view = -1;
+
+  mi2_free (mi2);
+}
+END_TEST
+
 /**
  * @test Test mi2_interface.c functions.
  *
@@ -1197,6 +1583,7 @@ END_TEST
  * - _bp: Test handling of breakpoint commands.
  * - _exec: Test execution commands.
  * - _dis: Test setting disassamble.
+ * - _memory: Test reading the memory window.
  */
   Suite * mi2_interface_suite (void)
 {
@@ -1227,6 +1614,10 @@ END_TEST
   tcase_add_test (tc_mi2_interface_dis, test_mi2_interface_dis);
   suite_add_tcase (s, tc_mi2_interface_dis);
 
+  TCase *tc_mi2_interface_memory = tcase_create ("mi2_interface_memory");
+  tcase_add_test (tc_mi2_interface_memory, test_mi2_interface_memory);
+  suite_add_tcase (s, tc_mi2_interface_memory);
+
   return s;
 
 }
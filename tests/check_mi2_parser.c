@@ -7,6 +7,7 @@
 #include "../src/mi2_parser.h"
 #include "../src/mi2_interface.h"
 #include "../src/objects.h"
+#include "../src/win_form.h"
 
 FILE *OUT_FILE = NULL;
 int VERBOSE_LEVEL = 7;
@@ -18,10 +19,18 @@ frame *g_frames;
 stack *g_stack;
 int g_level;
 int g_ass;
-int g_pc;
+int g_ass_moved;
+uint64_t g_pc;
 char *g_file_name = NULL;
 int g_line = -1;
+char g_prefetched[1024];
 data_registers *g_regs;
+mem_cache *g_mem;
+int g_search;
+int g_search_nr;
+int g_search_ret;
+const char *g_search_pattern = "";
+char g_search_item[256];
 
 int conf_get_bool (configuration * conf, const char *group_name,
 		   const char *name, int *valid);
@@ -32,10 +41,14 @@ void view_update_frame (view * view, stack * stack, int level);
 void view_update_stack (view * view, stack * stack);
 int view_show_file (view * view, const char *file_name, int line,
 		    int mark_stop);
+int view_prefetch_file (view * view, const char *file_name);
 void view_remove_breakpoint (view * view, const char *file_name, int line_nr);
 int view_add_message (view * view, int level, const char *msg, ...);
-void view_update_ass (view * view, assembler * ass, int pc);
+void view_update_ass (view * view, asm_function * func, uint64_t pc);
+void view_move_ass_pc (view * view, asm_function * func, uint64_t old_pc,
+		       uint64_t pc);
 void view_update_registers (view * view, data_registers * regs);
+void view_update_memory (view * view, mem_cache * cache);
 
 int
 conf_get_bool (configuration * conf, const char *group_name,
@@ -76,18 +89,32 @@ view_update_stack (view * view, stack * stack)
 }
 
 void
-view_update_ass (view * view, assembler * ass, int pc)
+view_update_ass (view * view, asm_function * func, uint64_t pc)
 {
   g_pc = pc;
   g_ass++;
 }
 
+void
+view_move_ass_pc (view * view, asm_function * func, uint64_t old_pc,
+		  uint64_t pc)
+{
+  g_pc = pc;
+  g_ass_moved++;
+}
+
 void
 view_update_registers (view * view, data_registers * regs)
 {
   g_regs = regs;
 }
 
+void
+view_update_memory (view * view, mem_cache * cache)
+{
+  g_mem = cache;
+}
+
 int
 view_show_file (view * view, const char *file_name, int line, int mark_stop)
 {
@@ -100,6 +127,14 @@ view_show_file (view * view, const char *file_name, int line, int mark_stop)
   return GLOB_RET;
 }
 
+int
+view_prefetch_file (view * view, const char *file_name)
+{
+  strcat (g_prefetched, file_name);
+  strcat (g_prefetched, ";");
+  return 0;
+}
+
 void
 view_remove_breakpoint (view * view, const char *file_name, int line_nr)
 {
@@ -117,6 +152,19 @@ form_selection (char **list, const char *header)
   return GLOB_RET;
 }
 
+int
+form_search (const char *header, form_match_func match, form_item_func item,
+	     void *data)
+{
+  const char *first;
+
+  g_search++;
+  g_search_nr = match (data, g_search_pattern);
+  first = item (data, 0);
+  snprintf (g_search_item, sizeof (g_search_item), "%s", first ? first : "");
+  return g_search_ret;
+}
+
 START_TEST (test_mi2_parser_create)
 {
   mi2_parser *mi2;
@@ -268,6 +316,7 @@ START_TEST (test_mi2_parser_parse_files)
 
   mi2 = mi2_parser_create ((view *) 1, (configuration *) 21);
   fail_unless (mi2 != NULL);
+  fail_unless (mi2_parser_find_file (mi2) == -1);
 
   /* Test wrong files forms. */
   snprintf (buf, 512, "^done,%s", "files=[ ]");
@@ -276,15 +325,15 @@ START_TEST (test_mi2_parser_parse_files)
 
   snprintf (buf, 512, "^done,%s", "files={some='thing'}");
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
-  fail_unless (ret == 0);
+  fail_unless (ret == -1);
 
   snprintf (buf, 512, "^done,%s", "files={{some='thing'}}");
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
-  fail_unless (ret == 0);
+  fail_unless (ret == -1);
 
   snprintf (buf, 512, "^done,%s", "files={{[ ]}}");
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
-  fail_unless (ret == 0);
+  fail_unless (ret == -1);
 
   /* Ok */
   snprintf (buf, 512, "^done,%s", "files={{file='bar.c',fullname='foo.c'}}");
@@ -306,6 +355,116 @@ START_TEST (test_mi2_parser_parse_files)
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
   fail_unless (ret == 0);
 
+  /* The files are interned, sorted and searched. */
+  g_search = 0;
+  g_search_ret = -1;
+  g_search_pattern = "";
+  snprintf (buf, 512, "^done,%s",
+	    "files=[{file='b.c',fullname='/src/lib/b.c'},{file='a.h'},"
+	    "{file='a.c',fullname='/src/a.c'},"
+	    "{file='b.c',fullname='/src/lib/b.c'}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_search == 1);
+  fail_unless (g_search_nr == 3);
+
+  /* No new request until symbols are loaded. */
+  g_search_ret = 0;
+  g_search_pattern = "lb";
+  fail_unless (mi2_parser_find_file (mi2) == 0);
+  fail_unless (g_search == 2);
+  fail_unless (g_search_nr == 1);
+  fail_unless (strcmp (g_file_name, "/src/lib/b.c") == 0);
+
+  g_search_pattern = "zz";
+  g_search_ret = -1;
+  fail_unless (mi2_parser_find_file (mi2) == 0);
+  fail_unless (g_search_nr == 0);
+
+  snprintf (buf, 512, "%s", "=library-loaded,id=\"/lib/libc.so.6\","
+	    "target-name=\"/lib/libc.so.6\",host-name=\"/lib/libc.so.6\","
+	    "symbols-loaded=\"0\"");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (mi2_parser_find_file (mi2) == 0);
+  snprintf (buf, 512, "%s", "=library-loaded,id=\"/lib/libm.so.6\","
+	    "target-name=\"/lib/libm.so.6\",host-name=\"/lib/libm.so.6\","
+	    "symbols-loaded=\"1\"");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (mi2_parser_find_file (mi2) == -1);
+  g_search_pattern = "";
+
+  mi2_parser_free (mi2);
+}
+END_TEST
+
+START_TEST (test_mi2_parser_parse_symbols)
+{
+  int ret;
+  mi2_parser *mi2;
+  char buf[1024];
+  int cmd;
+  char *regs = NULL;
+
+  mi2 = mi2_parser_create ((view *) 1, (configuration *) 21);
+  fail_unless (mi2 != NULL);
+  fail_unless (mi2_parser_find_symbol (mi2) == -1);
+
+  /* Wrong forms are ignored. */
+  snprintf (buf, sizeof (buf), "^done,%s", "symbols={debug=[{line=\"1\"}]}");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (mi2_parser_find_symbol (mi2) == -1);
+
+  snprintf (buf, sizeof (buf), "^done,%s", "symbols={debug=[{filename="
+	    "\"a.c\",symbols=[{line=\"x\",name=\"main\"}]}]}");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (mi2_parser_find_symbol (mi2) == -1);
+
+  /* Ok, only the functions with debug information are kept. */
+  g_search = 0;
+  g_search_ret = -1;
+  g_search_pattern = "";
+  snprintf (buf, sizeof (buf), "^done,%s",
+	    "symbols={debug=[{filename=\"a.c\",fullname=\"/src/a.c\","
+	    "symbols=[{line=\"20\",name=\"main\",type=\"int (void)\","
+	    "description=\"int main(void);\"},{line=\"10\",name=\"add\","
+	    "type=\"int (int, int)\",description=\"static int add(int, int);\"}"
+	    "]},{filename=\"lib/b.c\",symbols=[{line=\"5\",name=\"b_main\","
+	    "type=\"void (void)\",description=\"void b_main(void);\"}]}],"
+	    "nondebugging=[{address=\"0x0000000000401000\",name=\"_init\"}]}");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_search == 1);
+  fail_unless (g_search_nr == 3);
+  fail_unless (strcmp (g_search_item, "add  a.c:10") == 0);
+
+  /* No new request until symbols are loaded. */
+  g_search_ret = 0;
+  g_search_pattern = "main";
+  fail_unless (mi2_parser_find_symbol (mi2) == 0);
+  fail_unless (g_search == 2);
+  fail_unless (g_search_nr == 2);
+  fail_unless (strcmp (g_search_item, "main  a.c:20") == 0);
+  fail_unless (strcmp (g_file_name, "/src/a.c") == 0);
+  fail_unless (g_line == 20);
+
+  g_search_pattern = "b_";
+  fail_unless (mi2_parser_find_symbol (mi2) == 0);
+  fail_unless (strcmp (g_file_name, "lib/b.c") == 0);
+  fail_unless (g_line == 5);
+
+  snprintf (buf, sizeof (buf), "%s", "=library-loaded,id=\"/lib/libm.so.6\","
+	    "target-name=\"/lib/libm.so.6\",host-name=\"/lib/libm.so.6\","
+	    "symbols-loaded=\"1\"");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (mi2_parser_find_symbol (mi2) == -1);
+  g_search_ret = -1;
+  g_search_pattern = "";
+
   mi2_parser_free (mi2);
 }
 END_TEST
@@ -331,12 +490,12 @@ START_TEST (test_mi2_parser_parse_asm)
 
   snprintf (buf, 512, "^done,%s", "asm_insns=[something='+']");
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
-  fail_unless (ret == 0);
+  fail_unless (ret == -1);
   fail_unless (g_ass == 0);
 
   snprintf (buf, 512, "^done,%s", "asm_insns=[{src_and_asm_line={ }}]");
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
-  fail_unless (ret == 0);
+  fail_unless (ret == -1);
   fail_unless (g_ass == 0);
 
   snprintf (buf, 512, "^done,%s", "asm_insns=[src_and_asm_line={ }]");
@@ -346,37 +505,37 @@ START_TEST (test_mi2_parser_parse_asm)
 
   snprintf (buf, 512, "^done,%s", "asm_insns=[src_and_asm_line={line='K'}]");
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
-  fail_unless (ret == 0);
+  fail_unless (ret == -1);
   fail_unless (g_ass == 0);
 
   snprintf (buf, 512, "^done,%s",
 	    "asm_insns=[src_and_asm_line={some='thing'}]");
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
-  fail_unless (ret == 0);
+  fail_unless (ret == -1);
   fail_unless (g_ass == 0);
 
   snprintf (buf, 512, "^done,%s",
 	    "asm_insns=[src_and_asm_line={line_asm_insn={ }}]");
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
-  fail_unless (ret == 0);
+  fail_unless (ret == -1);
   fail_unless (g_ass == 0);
 
   snprintf (buf, 512, "^done,%s",
 	    "asm_insns=[src_and_asm_line={line_asm_insn={ }}]");
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
-  fail_unless (ret == 0);
+  fail_unless (ret == -1);
   fail_unless (g_ass == 0);
 
   snprintf (buf, 512, "^done,%s",
 	    "asm_insns=[src_and_asm_line={line_asm_insn={some='thing'}}]");
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
-  fail_unless (ret == 0);
+  fail_unless (ret == -1);
   fail_unless (g_ass == 0);
 
   snprintf (buf, 512, "^done,%s",
 	    "asm_insns=[src_and_asm_line={line='5',file='bar.c',line_asm_insn=[{aKKdress='0x1',offset='0x42',func-name='bar',inst='xxx'}]}]");
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
-  fail_unless (ret == 0);
+  fail_unless (ret == -1);
   fail_unless (g_ass == 0);
 
   /* Ok */
@@ -390,6 +549,74 @@ START_TEST (test_mi2_parser_parse_asm)
   fail_unless (ret == 0);
   fail_unless (g_ass == 1);
   fail_unless (g_pc == 0x99);
+  fail_unless (mi2_parser_disassembly_request (mi2) == 0);
+
+  /* The pc in the shown function only moves the marker. */
+  mi2_parser_toggle_disassemble (mi2);
+  g_ass_moved = 0;
+  snprintf (buf, 512, "^done,value='0x1'");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_ass == 1);
+  fail_unless (g_ass_moved == 1);
+  fail_unless (g_pc == 0x1);
+  fail_unless (mi2_parser_disassembly_request (mi2) == 0);
+
+  /* Not cached. */
+  snprintf (buf, 512, "^done,value='0x104'");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_ass == 1);
+  fail_unless (mi2_parser_disassembly_request (mi2) == 1);
+  fail_unless (mi2_parser_disassembly_request (mi2) == 0);
+
+  snprintf (buf, 512, "^done,%s",
+	    "asm_insns=[src_and_asm_line={line='7',file='foo.c',line_asm_insn=[{address='0x104',offset='0x4',func-name='foo',inst='yyy'}]},src_and_asm_line={line='6',file='foo.c',line_asm_insn=[{address='0x100',offset='0x0',func-name='foo',inst='xxx'}]}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_ass == 2);
+  fail_unless (g_pc == 0x104);
+
+  /* Cached but not shown, redraw. */
+  snprintf (buf, 512, "^done,value='0x1'");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_ass == 3);
+  fail_unless (g_ass_moved == 1);
+  fail_unless (mi2_parser_disassembly_request (mi2) == 0);
+
+  /* 64 bit addresses are not truncated. */
+  snprintf (buf, 512, "^done,%s",
+	    "asm_insns=[src_and_asm_line={line='3',file='foo.c',line_asm_insn=[{address='0x7ffff7a52000',offset='0x0',func-name='baz',inst='push'},{address='0x7ffff7a52001',offset='0x1',func-name='baz',inst='ret'}]}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_ass == 4);
+  snprintf (buf, 512, "^done,value='0x7ffff7a52001'");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_ass_moved == 2);
+  fail_unless (g_pc == 0x7ffff7a52001ULL);
+  fail_unless (mi2_parser_disassembly_request (mi2) == 0);
+  snprintf (buf, 512, "^done,value='0xf7a52001'");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (mi2_parser_disassembly_request (mi2) == 1);
+
+  /* The parts of a long record are parsed as they arrive. */
+  snprintf (buf, 512, "^done,%s\n",
+	    "asm_insns=[src_and_asm_line={line='9',file='foo.c',fullname='/src/foo.c',line_asm_insn=[{address='0x200',offset='0x0',func-name='qux',inst='nop'}]}]");
+  fail_unless (mi2_parser_feed (mi2, buf, 30) == 1);
+  fail_unless (g_ass == 4);
+  fail_unless (mi2_parser_feed (mi2, buf + 30, strlen (buf) - 30) == 1);
+  fail_unless (g_ass == 5);
+  fail_unless (mi2_parser_feed (mi2, "^done,value='0x1'\n", 18) == 0);
+
+  /* A broken long record is reported when it ends. */
+  snprintf (buf, 512, "^done,%s\n",
+	    "asm_insns=[src_and_asm_line={line='K'}]");
+  fail_unless (mi2_parser_feed (mi2, buf, 20) == 1);
+  fail_unless (mi2_parser_feed (mi2, buf + 20, strlen (buf) - 20) == -1);
+  fail_unless (g_ass == 5);
 
   mi2_parser_free (mi2);
 }
@@ -400,8 +627,11 @@ START_TEST (test_mi2_parser_parse_regs)
   int ret;
   mi2_parser *mi2;
   char buf[512];
+  char big[8192];
   int cmd;
   char *regs = NULL;
+  data_registers *registers;
+  int i;
 
   mi2 = mi2_parser_create ((view *) 1, (configuration *) 21);
   fail_unless (mi2 != NULL);
@@ -417,11 +647,31 @@ START_TEST (test_mi2_parser_parse_regs)
   fail_unless (ret == 0);
   fail_unless (g_regs != NULL);
   fail_unless (g_regs->len == 3);
+  registers = g_regs;
   fail_unless (strcmp (g_regs->registers[0].reg_name, "a1") == 0);
   fail_unless (strcmp (g_regs->registers[1].reg_name, "a2") == 0);
-  fail_unless (strcmp (g_regs->registers[0].svalue, "0x00") == 0);
-  fail_unless (strcmp (g_regs->registers[1].svalue, "0x00, 0x00, 0x00, 0x00")
-	       == 0);
+  fail_unless (g_regs->registers[0].type == DATA_REG_INT);
+  fail_unless (g_regs->registers[0].u64 == 0);
+  fail_unless (g_regs->registers[1].type == DATA_REG_VECTOR);
+  fail_unless (g_regs->registers[1].nr_lanes == 4);
+
+  /* Wide values, repeated lanes and values that are not numbers. */
+  g_regs = NULL;
+  snprintf (buf, 512, "^done,%s",
+	    "register-values=[{number='0',value='0xffffffffffffff00'},"
+	    "{number='1',value='{v4_int32={0x1, 0x2 <repeats 2 times>, 0x3},"
+	    " v2_int64={0x0, 0x0}}'},{number='2',value='<unavailable>'}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_regs != NULL);
+  fail_unless (g_regs->registers[0].u64 == 0xffffffffffffff00ULL);
+  fail_unless (g_regs->registers[1].nr_lanes == 4);
+  fail_unless (g_regs->registers[1].lanes[0] == 1);
+  fail_unless (g_regs->registers[1].lanes[1] == 2);
+  fail_unless (g_regs->registers[1].lanes[2] == 2);
+  fail_unless (g_regs->registers[1].lanes[3] == 3);
+  fail_unless (g_regs->registers[2].type == DATA_REG_STRING);
+  fail_unless (strcmp (g_regs->registers[2].svalue, "<unavailable>") == 0);
 
   g_regs = NULL;
   snprintf (buf, 512, "^done,%s",
@@ -450,6 +700,178 @@ START_TEST (test_mi2_parser_parse_regs)
   fail_unless (ret == 0);
   fail_unless (regs != NULL);
   fail_unless (strcmp (regs, " 1 2") == 0);
+  fail_unless (!data_registers_is_changed (registers, 0));
+  fail_unless (data_registers_is_changed (registers, 1));
+  fail_unless (data_registers_is_changed (registers, 2));
+
+  /* The request is handed out once. */
+  regs = NULL;
+  ret = mi2_parser_parse (mi2, "^done", &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (regs == NULL);
+
+  /* Unchanged registers are not requested again. */
+  snprintf (buf, 512, "^done,%s", "changed-registers=[]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (regs == NULL);
+
+  /*
+   * Registers that were never fetched are requested, registers without a
+   * name are not.
+   */
+  strcpy (big, "^done,register-names=[");
+  for (i = 0; i < 250; i++)
+    {
+      if (i == 3)
+	{
+	  strcat (big, ",\"\"");
+	}
+      else
+	{
+	  sprintf (big + strlen (big), "%s\"r%d\"", i ? "," : "", i);
+	}
+    }
+  strcat (big, "]");
+  ret = mi2_parser_parse (mi2, big, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (registers->len == 250);
+  fail_unless (registers->registers[3].name_len == 0);
+  snprintf (buf, 512, "^done,%s", "changed-registers=[]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (regs != NULL);
+  fail_unless (strlen (regs) == 9 * 2 + 90 * 3 + 150 * 4);
+  fail_unless (strncmp (regs, " 0 1 2 4 5", 10) == 0);
+
+  strcpy (big, "^done,register-values=[");
+  for (i = 0; i < 100; i++)
+    {
+      sprintf (big + strlen (big), "%s{number='%d',value='0x%x'}",
+	       i ? "," : "", i, i);
+    }
+  strcat (big, "]");
+  ret = mi2_parser_parse (mi2, big, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (registers->registers[99].type == DATA_REG_INT);
+
+  regs = NULL;
+  snprintf (buf, 512, "^done,%s", "changed-registers=[\"5\",\"3\"]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (regs != NULL);
+  fail_unless (strlen (regs) == 2 + 150 * 4);
+  fail_unless (strncmp (regs, " 5 100 101", 10) == 0);
+  fail_unless (!data_registers_is_changed (registers, 1));
+  fail_unless (data_registers_is_changed (registers, 3));
+
+  mi2_parser_free (mi2);
+}
+END_TEST
+
+START_TEST (test_mi2_parser_parse_memory)
+{
+  int ret;
+  mi2_parser *mi2;
+  char buf[512];
+  int cmd;
+  char *regs = NULL;
+  uint64_t pages[8];
+  mem_page *page;
+
+  mi2 = mi2_parser_create ((view *) 1, (configuration *) 21);
+  fail_unless (mi2 != NULL);
+
+  /* No region. */
+  ret = mi2_parser_memory_pages (mi2, 0x601000, 0x100, pages, 8);
+  fail_unless (ret == 0);
+
+  /* An address that was not asked for. */
+  g_mem = NULL;
+  snprintf (buf, 512, "%s", "^done,addr=\"0x601040\",nr-bytes=\"1\","
+	    "total-bytes=\"1\",next-row=\"0x601041\",prev-row=\"0x60103f\","
+	    "next-page=\"0x601041\",prev-page=\"0x60103f\","
+	    "memory=[{addr=\"0x601040\",data=[\"0x41\"]}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_mem == NULL);
+  fail_unless (mi2_parser_memory_refresh (mi2) == 0);
+
+  /* A new region. */
+  mi2_parser_memory_locate (mi2, 0x3000);
+  snprintf (buf, 512, "%s", "^done,addr=\"0x601040\",nr-bytes=\"1\","
+	    "total-bytes=\"1\",next-row=\"0x601041\",prev-row=\"0x60103f\","
+	    "next-page=\"0x601041\",prev-page=\"0x60103f\","
+	    "memory=[{addr=\"0x601040\",data=[\"0x41\"]}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_mem != NULL);
+  fail_unless (g_mem->start == 0x601040);
+  fail_unless (g_mem->length == 0x3000);
+  fail_unless (mi2_parser_memory_refresh (mi2) == 1);
+  fail_unless (mi2_parser_memory_refresh (mi2) == 0);
+
+  /* The shown page and the prefetched pages within the region. */
+  ret = mi2_parser_memory_pages (mi2, 0x601040, 0x200, pages, 8);
+  fail_unless (ret == 4);
+  fail_unless (pages[0] == 0x601000);
+  fail_unless (pages[1] == 0x602000);
+  fail_unless (pages[2] == 0x603000);
+  fail_unless (pages[3] == 0x604000);
+  ret = mi2_parser_memory_pages (mi2, 0x601040, 0x200, pages, 8);
+  fail_unless (ret == 0);
+
+  /* Read memory. */
+  g_mem = NULL;
+  snprintf (buf, 512, "%s", "^done,memory=[{begin=\"0x601040\","
+	    "offset=\"0x0\",end=\"0x601042\",contents=\"41ff\"},"
+	    "{begin=\"0x603000\",offset=\"0x10\",end=\"0x603011\","
+	    "contents=\"07\"}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_mem != NULL);
+  page = mem_cache_find (g_mem, 0x601041);
+  fail_unless (page != NULL);
+  fail_unless (page->state == MEM_PAGE_READ);
+  fail_unless (page->data[0x40] == 0x41 && page->data[0x41] == 0xff);
+  fail_unless (MEM_PAGE_VALID (page, 0x41));
+  fail_unless (!MEM_PAGE_VALID (page, 0x42));
+  page = mem_cache_find (g_mem, 0x603010);
+  fail_unless (page->state == MEM_PAGE_READ);
+  fail_unless (page->data[0x10] == 0x07);
+  fail_unless (mem_cache_find (g_mem, 0x602000)->state == MEM_PAGE_PENDING);
+
+  /* Bad blocks. */
+  snprintf (buf, 512, "%s", "^done,memory=[{begin=\"0x601040\","
+	    "offset=\"0x0\",end=\"0x601042\",contents=\"4g\"}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret < 0);
+  snprintf (buf, 512, "%s", "^done,memory=[{begin=\"0x601040\"}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret < 0);
+
+  /* Changed memory is read again. */
+  snprintf (buf, 512, "%s", "=memory-changed,thread-group=\"i1\","
+	    "addr=\"0x603ff0\",len=\"0x20\"");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (mi2_parser_memory_refresh (mi2) == 1);
+  fail_unless (mem_cache_find (g_mem, 0x601000)->state == MEM_PAGE_READ);
+  fail_unless (mem_cache_find (g_mem, 0x603000)->state == MEM_PAGE_STALE);
+  fail_unless (mem_cache_find (g_mem, 0x604000)->state == MEM_PAGE_STALE);
+  ret = mi2_parser_memory_pages (mi2, 0x603000, 0x100, pages, 8);
+  fail_unless (ret == 2);
+  fail_unless (pages[0] == 0x603000);
+  fail_unless (pages[1] == 0x604000);
+
+  /* A stop makes all pages stale, the bytes are kept. */
+  snprintf (buf, 512, "%s", "*stopped,stopped-threads=\"all\"");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (mi2_parser_memory_refresh (mi2) == 1);
+  page = mem_cache_find (g_mem, 0x601040);
+  fail_unless (page->state == MEM_PAGE_STALE);
+  fail_unless (page->data[0x40] == 0x41);
+  fail_unless (MEM_PAGE_VALID (page, 0x40));
 
   mi2_parser_free (mi2);
 }
@@ -648,6 +1070,7 @@ START_TEST (test_mi2_parser_parse_stack)
   char buf[512];
   int cmd;
   char *regs = NULL;
+  int total;
 
   mi2 = mi2_parser_create ((view *) 1, (configuration *) 21);
   fail_unless (mi2 != NULL);
@@ -704,7 +1127,7 @@ START_TEST (test_mi2_parser_parse_stack)
   snprintf (buf, 512, "%s",
 	    "^done,stack=[frame={level='0',addr='42',func='bar',file='foo.c',"
 	    "fullname='bar/foo.c',line='99'},"
-	    "frame={level='1',addr='43',func='bar2',file='foo2.c',"
+	    "frame={level='1',addr='0x7ffff7a52043',func='bar2',file='foo2.c',"
 	    "fullname='bar2/foo2.c',line='100'}]");
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
   fail_unless (ret == 0);
@@ -720,11 +1143,46 @@ START_TEST (test_mi2_parser_parse_stack)
   fail_unless (g_stack->stack[1].args == NULL);
   fail_unless (g_stack->stack[1].variables == NULL);
   fail_unless (g_stack->stack[1].line == 100);
-  fail_unless (g_stack->stack[1].addr == 43);
+  fail_unless (g_stack->stack[1].addr == 0x7ffff7a52043ULL);
   fail_unless (strcmp (g_stack->stack[1].func, "bar2") == 0);
   fail_unless (strcmp (g_stack->stack[1].file, "foo2.c") == 0);
   fail_unless (strcmp (g_stack->stack[1].fullname, "bar2/foo2.c") == 0);
 
+  /* Paged stack, depth first and then the frames page by page. */
+  snprintf (buf, 512, "%s", "^done,depth='K'");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret < 0);
+  snprintf (buf, 512, "%s", "^done,depth='3'");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  ret = mi2_parser_get_stack_depth (mi2, &total);
+  fail_unless (ret == 0);
+  fail_unless (total == 3);
+  snprintf (buf, 512, "%s",
+	    "^done,stack=[frame={level='0',addr='42',func='bar',file='foo.c',"
+	    "fullname='bar/foo.c',line='99'}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_stack->depth == 1);
+  fail_unless (g_stack->appended == 0);
+  g_prefetched[0] = '\0';
+  snprintf (buf, 512, "%s",
+	    "^done,stack=[frame={level='1',addr='43',func='bar2',file='foo2.c',"
+	    "fullname='bar2/foo2.c',line='100'},"
+	    "frame={level='2',addr='44',func='main',file='main.c',"
+	    "fullname='bar2/main.c',line='10'}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_stack->depth == 3);
+  fail_unless (g_stack->appended == 1);
+  fail_unless (strcmp (g_stack->stack[0].func, "bar") == 0);
+  fail_unless (strcmp (g_stack->stack[2].func, "main") == 0);
+  fail_unless (strcmp (g_prefetched, "bar/foo.c;bar2/foo2.c;bar2/main.c;")
+	       == 0, "%s", g_prefetched);
+  ret = mi2_parser_get_stack_depth (mi2, &total);
+  fail_unless (ret == 3);
+  fail_unless (total == 3);
+
   /* Test mi2_parser_set_frame */
   g_level = -1;
   mi2_parser_set_frame (mi2, 1);
@@ -1148,6 +1606,7 @@ END_TEST
 START_TEST (test_mi2_parser_parse_library)
 {
   int ret;
+  int i;
   mi2_parser *mi2;
   char buf[512];
   int cmd;
@@ -1184,6 +1643,8 @@ START_TEST (test_mi2_parser_parse_library)
 	    "target-name='line',symbols-loaded='1'");
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
   fail_unless (ret == 0);
+  fail_unless (g_libraries == NULL);
+  mi2_parser_flush (mi2);
   fail_unless (g_libraries != NULL);
   fail_unless (g_libraries->next == NULL);
   fail_unless (strcmp (g_libraries->id, "book") == 0);
@@ -1199,6 +1660,8 @@ START_TEST (test_mi2_parser_parse_library)
 	    "target-name='line',symbols-loaded='1'");
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
   fail_unless (ret == 0);
+  fail_unless (g_libraries == NULL);
+  mi2_parser_flush (mi2);
   fail_unless (g_libraries != NULL);
   fail_unless (g_libraries->next == NULL);
   fail_unless (strcmp (g_libraries->id, "book") == 0);
@@ -1206,6 +1669,29 @@ START_TEST (test_mi2_parser_parse_library)
   fail_unless (strcmp (g_libraries->host_name, "page") == 0);
   fail_unless (g_libraries->symbols_loaded == 1);
 
+
+  /* A burst of events updates the view once, when flushed. */
+  g_libraries = NULL;
+  for (i = 0; i < 10; i++)
+    {
+      snprintf (buf, 512, "=library-loaded,id='book%d',host-name='page',"
+		"target-name='line',symbols-loaded='0'", i);
+      ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+      fail_unless (ret == 0);
+      snprintf (buf, 512, "=library-unloaded,id='book%d',host-name='page',"
+		"target-name='line'", i);
+      ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+      fail_unless (ret == 0);
+    }
+  fail_unless (g_libraries == NULL);
+  mi2_parser_flush (mi2);
+  fail_unless (g_libraries != NULL);
+  fail_unless (g_libraries->next == NULL);
+  fail_unless (strcmp (g_libraries->id, "book") == 0);
+  g_libraries = NULL;
+  mi2_parser_flush (mi2);
+  fail_unless (g_libraries == NULL);
+
   mi2_parser_free (mi2);
 }
 END_TEST
@@ -1553,7 +2039,7 @@ START_TEST (test_mi2_get_location)
   snprintf (buf, 512, "%s",
 	    "^done,stack=[frame={level='0',addr='42',func='bar',file='foo.c',"
 	    "fullname='bar/foo.c',line='99'},"
-	    "frame={level='1',addr='43',func='bar2',file='foo2.c',"
+	    "frame={level='1',addr='0x7ffff7a52043',func='bar2',file='foo2.c',"
 	    "fullname='bar2/foo2.c',line='100'}]");
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
   fail_unless (ret == 0);
@@ -1567,7 +2053,7 @@ START_TEST (test_mi2_get_location)
   snprintf (buf, 512, "%s",
 	    "^done,stack=[frame={level='0',addr='42',func='bar',file='foo.c',"
 	    "line='99'},"
-	    "frame={level='1',addr='43',func='bar2',file='foo2.c',"
+	    "frame={level='1',addr='0x7ffff7a52043',func='bar2',file='foo2.c',"
 	    "fullname='bar2/foo2.c',line='100'}]");
   ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
   fail_unless (ret == 0);
@@ -1579,6 +2065,220 @@ START_TEST (test_mi2_get_location)
 }
 END_TEST
 
+START_TEST (test_mi2_parser_var_objects)
+{
+  int ret;
+  mi2_parser *mi2;
+  char buf[512];
+  int cmd;
+  char *regs = NULL;
+  const char *var_name = NULL;
+  char *request_name;
+  char *request_exp;
+  int thread;
+  int frame;
+  variable *p;
+  variable *i;
+  variable *child;
+  int id;
+
+  mi2 = mi2_parser_create ((view *) 1, (configuration *) 21);
+  fail_unless (mi2 != NULL);
+
+  /* No frame selected. */
+  ret = mi2_parser_var_toggle (mi2, 0, &var_name);
+  fail_unless (ret < 0);
+  ret = mi2_parser_next_var_request (mi2, &thread, &frame, &request_name,
+				     &request_exp);
+  fail_unless (ret == VAR_ACTION_NONE);
+
+  snprintf (buf, 512, "%s",
+	    "^done,stack=[frame={level='0',addr='42',func='bar',file='foo.c',"
+	    "fullname='bar/foo.c',line='99'}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  mi2_parser_set_frame (mi2, 0);
+
+  /* Only the names are listed, the variable objects are requested. */
+  snprintf (buf, 512, "%s",
+	    "^done,variables=[{name='p',arg='1'},{name='i'}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  p = g_stack->stack[0].args;
+  i = g_stack->stack[0].variables;
+  fail_unless (p != NULL);
+  fail_unless (i != NULL);
+  fail_unless (p->value == NULL);
+  fail_unless (p->type == NULL);
+  id = p->id;
+  snprintf (buf, 32, "lv%d", id);
+  fail_unless (strcmp (p->var_name, buf) == 0);
+  ret = mi2_parser_next_var_request (mi2, &thread, &frame, &request_name,
+				     &request_exp);
+  fail_unless (ret == VAR_ACTION_CREATE);
+  fail_unless (frame == 0);
+  fail_unless (strcmp (request_name, p->var_name) == 0);
+  fail_unless (strcmp (request_exp, "p") == 0);
+  free (request_name);
+  free (request_exp);
+  ret = mi2_parser_next_var_request (mi2, &thread, &frame, &request_name,
+				     &request_exp);
+  fail_unless (ret == VAR_ACTION_CREATE);
+  fail_unless (strcmp (request_name, i->var_name) == 0);
+  fail_unless (strcmp (request_exp, "i") == 0);
+  free (request_name);
+  free (request_exp);
+  ret = mi2_parser_next_var_request (mi2, &thread, &frame, &request_name,
+				     &request_exp);
+  fail_unless (ret == VAR_ACTION_NONE);
+
+  /* The frame is drawn once when flushed. */
+  g_level = -1;
+  snprintf (buf, 512, "^done,name='lv%d',numchild='2',value='{...}',"
+	    "type='struct P',thread-id='1',has_more='0'", id);
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  snprintf (buf, 512, "^done,name='%s',numchild='0',value='1',"
+	    "type='int',thread-id='1',has_more='0'", i->var_name);
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_level == -1);
+  mi2_parser_flush (mi2);
+  fail_unless (g_level == 0);
+  fail_unless (p->numchild == 2);
+  fail_unless (strcmp (p->value, "{...}") == 0);
+  fail_unless (strcmp (p->type, "struct P") == 0);
+  fail_unless (strcmp (i->value, "1") == 0);
+
+  /* Not expanded yet, the children must be listed. */
+  ret = mi2_parser_var_toggle (mi2, id, &var_name);
+  fail_unless (ret == VAR_ACTION_CHILDREN);
+  fail_unless (var_name == p->var_name);
+
+  snprintf (buf, 512, "^done,numchild='2',children=["
+	    "child={name='lv%d.a',exp='a',numchild='0',value='1',"
+	    "type='int',thread-id='1'},"
+	    "child={name='lv%d.q',exp='q',numchild='1',type='struct Q',"
+	    "thread-id='1'}],has_more='0'", id, id);
+  g_level = -1;
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_level == 0);
+  fail_unless (p->expanded);
+  child = p->children;
+  fail_unless (child != NULL);
+  fail_unless (strcmp (child->name, "a") == 0);
+  fail_unless (strcmp (child->value, "1") == 0);
+  fail_unless (child->numchild == 0);
+  child = child->next;
+  fail_unless (child != NULL);
+  fail_unless (strcmp (child->name, "q") == 0);
+  fail_unless (child->value == NULL);
+  fail_unless (child->numchild == 1);
+  fail_unless (child->next == NULL);
+
+  /* Collapse and expand without asking gdb. */
+  ret = mi2_parser_var_toggle (mi2, id, &var_name);
+  fail_unless (ret == VAR_ACTION_NONE);
+  fail_unless (!p->expanded);
+  ret = mi2_parser_var_toggle (mi2, id, &var_name);
+  fail_unless (ret == VAR_ACTION_NONE);
+  fail_unless (p->expanded);
+
+  /* Leafs cannot be expanded, nested children are fetched lazily. */
+  ret = mi2_parser_var_toggle (mi2, p->children->id, &var_name);
+  fail_unless (ret == VAR_ACTION_NONE);
+  ret = mi2_parser_var_toggle (mi2, child->id, &var_name);
+  fail_unless (ret == VAR_ACTION_CHILDREN);
+  fail_unless (strcmp (var_name, child->var_name) == 0);
+
+  /* Only the changed variables are updated and marked. */
+  snprintf (buf, 512, "^done,changelist=[{name='%s',value='2',"
+	    "in_scope='true',type_changed='false',has_more='0'}]",
+	    i->var_name);
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (strcmp (i->value, "2") == 0);
+  fail_unless (i->changed);
+  fail_unless (!p->changed);
+  fail_unless (strcmp (p->value, "{...}") == 0);
+  snprintf (buf, 512, "%s", "^done,changelist=[]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (!i->changed);
+
+  /* Listed again, the kept variables keep their variable objects. */
+  snprintf (buf, 512, "%s",
+	    "^done,variables=[{name='p',arg='1'},{name='j'}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_stack->stack[0].args == p);
+  fail_unless (p->children != NULL);
+  fail_unless (strcmp (g_stack->stack[0].variables->name, "j") == 0);
+  ret = mi2_parser_next_var_request (mi2, &thread, &frame, &request_name,
+				     &request_exp);
+  fail_unless (ret == VAR_ACTION_DELETE);
+  fail_unless (request_exp == NULL);
+  free (request_name);
+  ret = mi2_parser_next_var_request (mi2, &thread, &frame, &request_name,
+				     &request_exp);
+  fail_unless (ret == VAR_ACTION_CREATE);
+  fail_unless (strcmp (request_exp, "j") == 0);
+  free (request_name);
+  free (request_exp);
+
+  /* The type of a child changed. */
+  snprintf (buf, 512, "^done,changelist=[{name='lv%d.q',in_scope='true',"
+	    "type_changed='true',new_type='struct R',new_num_children='3',"
+	    "has_more='0'}]", id);
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (strcmp (child->type, "struct R") == 0);
+  fail_unless (child->numchild == 3);
+  fail_unless (child->children == NULL);
+
+  /* Children of a stale object are ignored. */
+  snprintf (buf, 512, "%s", "^done,numchild='1',children=["
+	    "child={name='lv9999.a',exp='a',numchild='0',type='int'}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+
+  /* Bad child. */
+  snprintf (buf, 512, "%s", "^done,numchild='1',children=["
+	    "child={exp='a',numchild='0',type='int'}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret < 0);
+
+  /* Bad changelist. */
+  snprintf (buf, 512, "%s", "^done,changelist=[{value='1'}]");
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret < 0);
+
+  /* The frame is gone, the scope is dropped. */
+  snprintf (buf, 512, "^done,changelist=[{name='lv%d',in_scope='false',"
+	    "has_more='0'}]", id);
+  ret = mi2_parser_parse (mi2, buf, &cmd, &regs);
+  fail_unless (ret == 0);
+  fail_unless (g_stack->stack[0].args == NULL);
+  fail_unless (g_stack->stack[0].variables == NULL);
+  ret = mi2_parser_next_var_request (mi2, &thread, &frame, &request_name,
+				     &request_exp);
+  fail_unless (ret == VAR_ACTION_DELETE);
+  snprintf (buf, 32, "lv%d", id);
+  fail_unless (strcmp (request_name, buf) == 0);
+  free (request_name);
+  ret = mi2_parser_next_var_request (mi2, &thread, &frame, &request_name,
+				     &request_exp);
+  fail_unless (ret == VAR_ACTION_DELETE);
+  free (request_name);
+  ret = mi2_parser_next_var_request (mi2, &thread, &frame, &request_name,
+				     &request_exp);
+  fail_unless (ret == VAR_ACTION_NONE);
+
+  mi2_parser_free (mi2);
+}
+END_TEST
+
 /**
  * @test Test mi2_parser.c functions.
  *
@@ -1606,6 +2306,8 @@ END_TEST
  * - wp: Watchpoints.
  * - Set/get thread.
  * - Get location.
+ * - Variable objects.
+ * - Memory pages.
  */
   Suite * mi2_parser_suite (void)
 {
@@ -1628,6 +2330,12 @@ END_TEST
   tcase_add_test (tc_mi2_parser_parse_files, test_mi2_parser_parse_files);
   suite_add_tcase (s, tc_mi2_parser_parse_files);
 
+  TCase *tc_mi2_parser_parse_symbols =
+    tcase_create ("mi2_parser_parse_symbols");
+  tcase_add_test (tc_mi2_parser_parse_symbols,
+		  test_mi2_parser_parse_symbols);
+  suite_add_tcase (s, tc_mi2_parser_parse_symbols);
+
   TCase *tc_mi2_parser_parse_asm = tcase_create ("mi2_parser_parse_asm");
   tcase_add_test (tc_mi2_parser_parse_asm, test_mi2_parser_parse_asm);
   suite_add_tcase (s, tc_mi2_parser_parse_asm);
@@ -1636,6 +2344,11 @@ END_TEST
   tcase_add_test (tc_mi2_parser_parse_regs, test_mi2_parser_parse_regs);
   suite_add_tcase (s, tc_mi2_parser_parse_regs);
 
+  TCase *tc_mi2_parser_parse_memory =
+    tcase_create ("mi2_parser_parse_memory");
+  tcase_add_test (tc_mi2_parser_parse_memory, test_mi2_parser_parse_memory);
+  suite_add_tcase (s, tc_mi2_parser_parse_memory);
+
   TCase *tc_mi2_parser_parse_bkpt = tcase_create ("mi2_parser_parse_bkpt");
   tcase_add_test (tc_mi2_parser_parse_bkpt, test_mi2_parser_parse_bkpt);
   suite_add_tcase (s, tc_mi2_parser_parse_bkpt);
@@ -1710,6 +2423,10 @@ END_TEST
   TCase *tc_mi2_parser_get_location = tcase_create ("mi2_get_location");
   tcase_add_test (tc_mi2_parser_get_location, test_mi2_get_location);
   suite_add_tcase (s, tc_mi2_parser_get_location);
+
+  TCase *tc_mi2_parser_var_objects = tcase_create ("mi2_var_objects");
+  tcase_add_test (tc_mi2_parser_var_objects, test_mi2_parser_var_objects);
+  suite_add_tcase (s, tc_mi2_parser_var_objects);
   return s;
 }
 
@@ -0,0 +1,220 @@
+#include <check.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../src/mi2_stream.h"
+
+FILE *OUT_FILE = NULL;
+int VERBOSE_LEVEL = 7;
+
+char g_events[4096];
+int g_fail_at = -1;
+int g_nr_events = 0;
+
+static int
+event (const char *fmt, const char *a, const char *b)
+{
+  char buf[2048];
+
+  snprintf (buf, sizeof (buf), fmt, a ? a : "-", b ? b : "-");
+  strcat (g_events, buf);
+  return g_nr_events++ == g_fail_at ? -1 : 0;
+}
+
+static int
+start (void *data, const char *name, int type)
+{
+  return event ("S %s %s;", name, type == '{' ? "{" : "[");
+}
+
+static int
+end (void *data, int type)
+{
+  return event ("E %s%s;", type == '{' ? "{" : "[", "");
+}
+
+static int
+value (void *data, const char *name, const char *value)
+{
+  return event ("V %s %s;", name, value);
+}
+
+static void
+done (void *data, int error)
+{
+  event ("D %s%s;", error ? "1" : "0", "");
+}
+
+static const mi2_stream_handler handler = { start, end, value, done };
+
+static void
+reset (void)
+{
+  g_events[0] = '\0';
+  g_nr_events = 0;
+  g_fail_at = -1;
+}
+
+START_TEST (test_mi2_stream_events)
+{
+  mi2_stream *stream;
+  const char *record =
+    "^done,files=[{file=\"a.c\",fullname=\"/x/a.c\"},{file='b\\\"c'}]\r\n";
+  const char *expected =
+    "S files [;S - {;V file a.c;V fullname /x/a.c;E {;S - {;V file b\"c;"
+    "E {;E [;D 0;";
+  char big[1024];
+  int ret;
+  int i;
+
+  stream = mi2_stream_create ();
+  fail_unless (stream != NULL);
+  ret = mi2_stream_register (stream, "^done", "files", &handler, NULL);
+  fail_unless (ret == 0);
+  ret = mi2_stream_register (stream, "^done",
+			     "a_name_that_is_longer_than_the_names_of_the"
+			     "_results_from_the_debugger", &handler, NULL);
+  fail_unless (ret == -1);
+
+  /* All at once. */
+  reset ();
+  ret = mi2_stream_feed (stream, record, strlen (record));
+  fail_unless (ret == 1);
+  fail_unless (strcmp (g_events, expected) == 0, "%s", g_events);
+
+  /* Byte by byte. */
+  reset ();
+  for (i = 0; record[i] != '\0'; i++)
+    {
+      ret = mi2_stream_feed (stream, record + i, 1);
+      fail_unless (ret == (i >= 12), "ret %d i %d", ret, i);
+    }
+  fail_unless (strcmp (g_events, expected) == 0, "%s", g_events);
+
+  /* Records without handlers are skipped. */
+  reset ();
+  ret = mi2_stream_feed (stream, "^done,value=\"1\"\n", 16);
+  fail_unless (ret == 0);
+  ret = mi2_stream_feed (stream, "*stopped,files=[]\n^done\n", 24);
+  fail_unless (ret == 0);
+  ret = mi2_stream_feed (stream, "^done,files=[]\n^done", 20);
+  fail_unless (ret == 0);
+  fail_unless (strcmp (g_events, "S files [;E [;D 0;") == 0, "%s",
+	       g_events);
+  ret = mi2_stream_feed (stream, ",files=[", 8);
+  fail_unless (ret == 1);
+  ret = mi2_stream_feed (stream, "]\n", 2);
+  fail_unless (ret == 1);
+
+  /* Long strings. */
+  reset ();
+  memset (big, 'x', sizeof (big));
+  ret = mi2_stream_feed (stream, "^done,files=[{file=\"", 20);
+  ret = mi2_stream_feed (stream, big, sizeof (big));
+  ret = mi2_stream_feed (stream, "\"}]\n", 4);
+  fail_unless (ret == 1);
+  fail_unless (strlen (g_events) == sizeof (big) + strlen ("S files [;S - {;"
+							   "V file ;E {;E [;"
+							   "D 0;"));
+
+  mi2_stream_free (stream);
+}
+END_TEST
+
+START_TEST (test_mi2_stream_errors)
+{
+  mi2_stream *stream;
+  char deep[128];
+  int ret;
+
+  stream = mi2_stream_create ();
+  ret = mi2_stream_register (stream, "^done", "files", &handler, NULL);
+  fail_unless (ret == 0);
+
+  /* Not matching. */
+  reset ();
+  ret = mi2_stream_feed (stream, "^done,files=[{file='a']}]\n", 26);
+  fail_unless (ret == 1);
+  fail_unless (strcmp (g_events, "S files [;S - {;V file a;D 1;") == 0,
+	       "%s", g_events);
+
+  /* Not complete. */
+  reset ();
+  ret = mi2_stream_feed (stream, "^done,files=[{file='a'\n", 23);
+  fail_unless (ret == 1);
+  fail_unless (strcmp (g_events, "S files [;S - {;V file a;D 1;") == 0,
+	       "%s", g_events);
+
+  /* Strange characters. */
+  reset ();
+  ret = mi2_stream_feed (stream, "^done,files=[file=x]\n", 21);
+  fail_unless (strcmp (g_events, "S files [;D 1;") == 0, "%s", g_events);
+  reset ();
+  ret = mi2_stream_feed (stream, "^done,files=[#]\n", 16);
+  fail_unless (strcmp (g_events, "S files [;D 1;") == 0, "%s", g_events);
+
+  /* The handler stops the events. */
+  reset ();
+  g_fail_at = 1;
+  ret = mi2_stream_feed (stream, "^done,files=[{file='a'},{}]\n", 28);
+  fail_unless (ret == 1);
+  fail_unless (strcmp (g_events, "S files [;S - {;D 1;") == 0, "%s",
+	       g_events);
+
+  /* Nested too deep. */
+  reset ();
+  memset (deep, '[', sizeof (deep));
+  ret = mi2_stream_feed (stream, "^done,files=", 12);
+  ret = mi2_stream_feed (stream, deep, sizeof (deep));
+  ret = mi2_stream_feed (stream, "\n", 1);
+  fail_unless (ret == 1);
+  fail_unless (strstr (g_events, "D 1;") != NULL);
+
+  /* Still working. */
+  reset ();
+  ret = mi2_stream_feed (stream, "^done,files=[]\n", 15);
+  fail_unless (ret == 1);
+  fail_unless (strcmp (g_events, "S files [;E [;D 0;") == 0, "%s",
+	       g_events);
+
+  mi2_stream_free (stream);
+  mi2_stream_free (NULL);
+}
+END_TEST
+
+/**
+ * @test Test mi2_stream.c functions.
+ *
+ * - _events: The events of a record fed at once or byte by byte.
+ * - _errors: Broken records.
+ */
+  Suite * mi2_stream_suite (void)
+{
+  Suite *s = suite_create ("mi2_stream");
+
+  TCase *tc_events = tcase_create ("events");
+  tcase_add_test (tc_events, test_mi2_stream_events);
+  suite_add_tcase (s, tc_events);
+
+  TCase *tc_errors = tcase_create ("errors");
+  tcase_add_test (tc_errors, test_mi2_stream_errors);
+  suite_add_tcase (s, tc_errors);
+
+  return s;
+}
+
+int
+main (void)
+{
+  int number_failed;
+
+  OUT_FILE = stdout;
+  Suite *s = mi2_stream_suite ();
+  SRunner *sr = srunner_create (s);
+
+  srunner_run_all (sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed (sr);
+  srunner_free (sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -258,6 +258,29 @@ START_TEST (test_misc_unescape)
   fail_unless (strcmp (text, "AC") == 0, "failed: '%s'", text);
   free (text);
 
+  /* Runs between the escapes and the skipped characters. */
+  text = strdup ("\"  0x7ffff7dd1000 /lib/ld.so\\n\r\v\\t end\\\\\"\r\n");
+  ret = unescape (text, "\r\n\v");
+  fail_unless (ret == 0);
+  fail_unless (strcmp (text, "  0x7ffff7dd1000 /lib/ld.so\t end\\") == 0,
+	       "failed: '%s'", text);
+  free (text);
+
+  /* Nothing is unescaped after a quote, until a single quote. */
+  text = strdup ("a\\tb\"c\\td'e\\'f' \\tg");
+  ret = unescape (text, "");
+  fail_unless (ret == 0);
+  fail_unless (strcmp (text, "a\tb\"c\\td'e'f' \tg") == 0,
+	       "failed: '%s'", text);
+  free (text);
+
+  /* A long skip set. */
+  text = strdup ("Hello \\x41 world");
+  ret = unescape (text, "abcdefghijklmnopqrstuvwxyz0123456789");
+  fail_unless (ret == 0);
+  fail_unless (strcmp (text, "H A ") == 0, "failed: '%s'", text);
+  free (text);
+
   /* Errors */
   text = strdup ("ABC\\P");
   ret = unescape (text, "");
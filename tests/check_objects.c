@@ -222,25 +222,30 @@ START_TEST (test_library)
   char buf_target[64];
   char buf_host[64];
   int ret;
-  library *l = NULL;
+  library_table *lt;
   library *pl;
 
-  ret = library_add (&l, NULL, NULL, NULL, 0);
+  lt = library_table_create ();
+  fail_unless (lt != NULL);
+  fail_unless (lt->first == NULL);
+  fail_unless (lt->count == 0);
+
+  ret = library_add (lt, NULL, NULL, NULL, 0);
   fail_unless (ret < 0);
-  fail_unless (l == NULL);
-  ret = library_add (&l, "id", "target", "host", 5);
+  fail_unless (lt->first == NULL);
+  ret = library_add (lt, "id", "target", "host", 5);
   fail_unless (ret < 0);
-  fail_unless (l == NULL);
+  fail_unless (lt->first == NULL);
 
   for (i = 0; i < 20; i++)
     {
       sprintf (buf_id, "id_%d", i);
       sprintf (buf_target, "target_%d", i);
       sprintf (buf_host, "host_%d", i);
-      ret = library_add (&l, buf_id, buf_target, buf_host, i % 2);
+      ret = library_add (lt, buf_id, buf_target, buf_host, i % 2);
       fail_unless (ret == 0);
       count = i;
-      pl = l;
+      pl = lt->first;
       while (pl)
 	{
 	  sprintf (buf_id, "id_%d", count);
@@ -254,30 +259,71 @@ START_TEST (test_library)
 	}
       fail_unless (count == -1);
     }
-  ret = library_add (&l, "id", NULL, NULL, 1);
+  fail_unless (lt->count == 20);
+  fail_unless (lt->count * 4 <= lt->size * 3);
+
+  ret = library_add (lt, "id", NULL, NULL, 1);
   fail_unless (ret == 0);
-  fail_unless (strcmp (l->id, "id") == 0);
-  fail_unless (strcmp (l->target_name, "") == 0);
-  fail_unless (strcmp (l->host_name, "") == 0);
-  ret = library_add (&l, "id", "target", NULL, 1);
+  fail_unless (strcmp (lt->first->id, "id") == 0);
+  fail_unless (strcmp (lt->first->target_name, "") == 0);
+  fail_unless (strcmp (lt->first->host_name, "") == 0);
+  ret = library_add (lt, "id", "target", NULL, 1);
   fail_unless (ret == 0);
-  fail_unless (strcmp (l->id, "id") == 0);
-  fail_unless (strcmp (l->target_name, "target") == 0);
-  fail_unless (strcmp (l->host_name, "") == 0);
-  ret = library_add (&l, "id", NULL, "host", 1);
+  fail_unless (strcmp (lt->first->id, "id") == 0);
+  fail_unless (strcmp (lt->first->target_name, "target") == 0);
+  fail_unless (strcmp (lt->first->host_name, "") == 0);
+  ret = library_add (lt, "id", NULL, "host", 1);
   fail_unless (ret == 0);
-  fail_unless (strcmp (l->id, "id") == 0);
-  fail_unless (strcmp (l->target_name, "") == 0);
-  fail_unless (strcmp (l->host_name, "host") == 0);
+  fail_unless (strcmp (lt->first->id, "id") == 0);
+  fail_unless (strcmp (lt->first->target_name, "") == 0);
+  fail_unless (strcmp (lt->first->host_name, "host") == 0);
+  fail_unless (lt->count == 23);
 
   /* remove */
-  library_remove (&l, "cccc", NULL, NULL);
-  library_remove (&l, "id", NULL, NULL);
-  library_remove (&l, "id", NULL, "host");
+  library_remove (lt, "cccc", NULL, NULL);
+  fail_unless (lt->count == 23);
+  library_remove (lt, "id", NULL, NULL);
+  fail_unless (lt->count == 22);
+  library_remove (lt, "id", NULL, "host");
+  fail_unless (lt->count == 21);
+  fail_unless (strcmp (lt->first->id, "id") == 0);
+  fail_unless (strcmp (lt->first->target_name, "target") == 0);
+  library_remove (lt, "id_0", "target_0", "host_0");
+  library_remove (lt, "id_19", "target_19", "host_19");
+  library_remove (lt, "id_10", "target_10", "host_10");
+  fail_unless (lt->count == 18);
+  count = 0;
+  for (pl = lt->first; pl != NULL; pl = pl->next)
+    {
+      fail_unless (pl->next == NULL || pl->next->prev == pl);
+      fail_unless (strcmp (pl->id, "id_0") != 0);
+      fail_unless (strcmp (pl->id, "id_19") != 0);
+      fail_unless (strcmp (pl->id, "id_10") != 0);
+      count++;
+    }
+  fail_unless (count == 18);
 
-  library_remove_all (&l);
-  fail_unless (l == 0);
+  /* Load and unload in a loop, tombstones must not fill the table. */
+  for (i = 0; i < 1000; i++)
+    {
+      sprintf (buf_id, "plugin_%d", i % 7);
+      ret = library_add (lt, buf_id, "t", "h", 1);
+      fail_unless (ret == 0);
+      library_remove (lt, buf_id, "t", "h");
+      fail_unless (lt->count == 18);
+      fail_unless (lt->count + lt->tombstones < lt->size);
+    }
+  library_remove (lt, "id_5", "target_5", "host_5");
+  fail_unless (lt->count == 17);
+
+  library_remove_all (lt);
+  fail_unless (lt->first == NULL);
+  fail_unless (lt->count == 0);
+  fail_unless (lt->tombstones == 0);
 
+  ret = library_add (lt, "id", NULL, NULL, 1);
+  fail_unless (ret == 0);
+  library_table_free (lt);
 }
 END_TEST
 
@@ -292,7 +338,12 @@ START_TEST (test_stack)
   char val[64];
   stack *stack;
   frame *f;
+  frame fresh;
   variable *v;
+  variable *removed;
+  variable *vars;
+  scope *sc;
+  scope *s;
   int i;
   int j;
 
@@ -346,12 +397,14 @@ START_TEST (test_stack)
   fail_unless (stack->core == -1);
   fail_unless (stack->max_depth == 10);
 
-  /* Errors. */
+  /* Only the name is listed. */
   f = stack_get_frame (stack, 0);
   ret = frame_insert_variable (f, "name", NULL, NULL, 1, 0);
-  fail_unless (ret < 0);
+  fail_unless (ret == 0);
   fail_unless (f->args == NULL);
-  fail_unless (f->variables == NULL);
+  fail_unless (f->variables != NULL);
+  fail_unless (f->variables->type == NULL);
+  fail_unless (f->variables->value == NULL);
 
   /* OK  - variables */
   ret = frame_insert_variable (f, "name", "int", "10", 1, 0);
@@ -421,6 +474,108 @@ START_TEST (test_stack)
   fail_unless (strcmp (f->args->next->next->type, "int3") == 0);
   fail_unless (strcmp (f->args->next->next->value, "103") == 0);
 
+  /* Variable objects */
+  v = variable_find (f->args, f->args->next->id);
+  fail_unless (v == f->args->next);
+  fail_unless (variable_find (f->args, -1) == NULL);
+  fail_unless (variable_find_object (f->args, "lv1") == NULL);
+  v->var_name = strdup ("lv1");
+  fail_unless (variable_find_object (f->args, "lv1") == v);
+  fail_unless (variable_add_child (v, "a", "lv1.a", "int", "1", 0) != NULL);
+  fail_unless (variable_add_child (v, "b", "lv1.b", "struct B", NULL, 1) !=
+	       NULL);
+  fail_unless (strcmp (v->children->name, "a") == 0);
+  fail_unless (strcmp (v->children->next->var_name, "lv1.b") == 0);
+  fail_unless (v->children->next->value == NULL);
+  fail_unless (v->children->next->numchild == 1);
+  fail_unless (v->children->id != v->children->next->id);
+  fail_unless (variable_find (f->args, v->children->next->id) ==
+	       v->children->next);
+  fail_unless (variable_find_object (f->args, "lv1.b") == v->children->next);
+  fail_unless (variable_find_parent (f->args, "lv1.a") == v);
+  fail_unless (variable_find_parent (f->args, "lv1.b.c") ==
+	       v->children->next);
+  fail_unless (variable_find_parent (f->args, "lv10.a") == NULL);
+
+  /* Scopes */
+  sc = NULL;
+  s = scope_get (&sc, 1, 3, "main");
+  fail_unless (s != NULL);
+  fail_unless (sc == s);
+  fail_unless (scope_get (&sc, 1, 3, "main") == s);
+  fail_unless (scope_get (&sc, 2, 3, "main") != s);
+  fail_unless (scope_get (&sc, 1, 2, NULL) != s);
+  fail_unless (scope_get (&sc, 1, 2, NULL) == sc);
+
+  /* Move the arguments to the scope, the frame only refers to them. */
+  s->args = f->args;
+  s->variables = f->variables;
+  f->scope = s;
+  stack_clean_frame (stack, 0);
+  fail_unless (f->args == NULL);
+  fail_unless (f->scope == NULL);
+  fail_unless (s->args->next == v);
+
+  /* Merge, keep name2 and its children, add new, remove the rest. */
+  memset (&fresh, 0, sizeof (fresh));
+  frame_insert_variable (&fresh, "name2", NULL, "5", 0, 1);
+  frame_insert_variable (&fresh, "new", NULL, NULL, 0, 1);
+  removed = NULL;
+  variable_merge_list (&s->args, fresh.args, &removed);
+  fail_unless (s->args != NULL);
+  fail_unless (strcmp (s->args->name, "name2") == 0);
+  fail_unless (strcmp (s->args->value, "5") == 0);
+  fail_unless (strcmp (s->args->type, "int2") == 0);
+  fail_unless (strcmp (s->args->next->name, "new") == 0);
+  fail_unless (s->args->next->next == NULL);
+  fail_unless (removed != NULL);
+  fail_unless (removed->next != NULL);
+  fail_unless (removed->next->next == NULL);
+  variable_delete_list (removed);
+
+  /* Merge in order, a skipped variable is removed. */
+  memset (&fresh, 0, sizeof (fresh));
+  frame_insert_variable (&fresh, "a", NULL, "1", 0, 1);
+  frame_insert_variable (&fresh, "b", NULL, "2", 0, 1);
+  frame_insert_variable (&fresh, "c", NULL, "3", 0, 1);
+  vars = NULL;
+  removed = NULL;
+  variable_merge_list (&vars, fresh.args, &removed);
+  fail_unless (removed == NULL);
+  v = vars->next->next;
+  memset (&fresh, 0, sizeof (fresh));
+  frame_insert_variable (&fresh, "a", NULL, NULL, 0, 1);
+  frame_insert_variable (&fresh, "c", NULL, "4", 0, 1);
+  frame_insert_variable (&fresh, "d", NULL, NULL, 0, 1);
+  variable_merge_list (&vars, fresh.args, &removed);
+  fail_unless (strcmp (vars->name, "a") == 0);
+  fail_unless (strcmp (vars->value, "1") == 0);
+  fail_unless (vars->next == v);
+  fail_unless (strcmp (v->value, "4") == 0);
+  fail_unless (strcmp (v->next->name, "d") == 0);
+  fail_unless (v->next->next == NULL);
+  fail_unless (removed != NULL);
+  fail_unless (strcmp (removed->name, "b") == 0);
+  fail_unless (removed->next == NULL);
+  variable_delete_list (removed);
+  variable_delete_list (vars);
+
+  /* Changed marks */
+  s->args->changed = 1;
+  s->args->next->changed = 1;
+  variable_clear_changed (s->args);
+  fail_unless (!s->args->changed);
+  fail_unless (!s->args->next->changed);
+
+  scope_remove (&sc, s);
+  fail_unless (sc != NULL);
+  fail_unless (sc->next != NULL);
+  fail_unless (sc->next->next == NULL);
+  while (sc != NULL)
+    {
+      scope_remove (&sc, sc);
+    }
+
   stack_free (stack);
 
   /* Test updating variables */
@@ -473,56 +628,114 @@ END_TEST
 START_TEST (test_asm)
 {
   int ret;
-
+  int i;
+  char name[32];
   assembler *ass;
+  asm_function *func;
+  asm_function *bar;
+  asm_line *line;
 
   ass = ass_create ();
   fail_unless (ass != NULL);
+  fail_unless (ass_find (ass, 0x10) == NULL);
 
-  ret = ass_add_line (ass, "foo.c", "bar", 10, 0x10, 0x00, "hello");
-  fail_unless (ret == 1);
-  ret = ass_add_line (ass, "foo.c", "bar", 10, 0x11, 0x01, "world");
+  /* The lines come in source line order. */
+  bar = asm_function_create ("foo.c");
+  ret = asm_function_add_line (bar, "bar", 11, 0x12, 0x02, "world");
   fail_unless (ret == 0);
-  ret = ass_add_line (ass, "foo.c", "bar", 11, 0x12, 0x02, NULL);
+  ret = asm_function_add_line (bar, NULL, 12, -1, -1, NULL);
   fail_unless (ret == 0);
-  ret = ass_add_line (ass, "foo.c", "foo", 5, 0x05, 0x00, "again");
-  fail_unless (ret == 1);
-  ret = ass_add_line (ass, "foo.c", NULL, -1, -1, -1, NULL);
+  ret = asm_function_add_line (bar, "bar", 10, 0x10, 0x00, "hello");
   fail_unless (ret == 0);
-  ret = ass_add_line (ass, "foo.c", "foo", 1, 0x07, 0x02, "back");
+  ret = asm_function_add_line (bar, "bar", 10, 0x18, 0x08, "again");
   fail_unless (ret == 0);
-  ret = ass_add_line (ass, "foo.c", "foo", 1, 0x06, 0x01, "back");
+  ret = asm_function_add_line (bar, "bar", 10, 0x18, 0x08, "again");
   fail_unless (ret == 0);
+  asm_function_done (bar);
+
+  fail_unless (bar->address == 0x10);
+  fail_unless (bar->end == 0x18);
+  fail_unless (strcmp (bar->function, "bar") == 0);
+  fail_unless (bar->nr_lines == 3);
+  fail_unless (bar->nr_src_lines == 3);
+  fail_unless (bar->src_lines[0] == 10);
+  fail_unless (bar->src_lines[2] == 12);
+  /* Sorted on address, placed below its source line in the window. */
+  fail_unless (bar->lines[0].address == 0x10 && bar->lines[0].row == 2);
+  fail_unless (bar->lines[1].address == 0x12 && bar->lines[1].row == 5);
+  fail_unless (bar->lines[2].address == 0x18 && bar->lines[2].row == 3);
+
+  line = asm_function_find_line (bar, 0x12);
+  fail_unless (line != NULL && strcmp (line->inst, "world") == 0);
+  fail_unless (asm_function_find_line (bar, 0x11) == NULL);
+
+  fail_unless (ass_insert (ass, bar) == bar);
+  fail_unless (ass_find (ass, 0x10) == bar);
+  fail_unless (ass_find (ass, 0x18) == bar);
+  fail_unless (ass_find (ass, 0x19) == NULL);
+  fail_unless (ass_find (ass, 0x0F) == NULL);
+
+  /* Overlapping functions are replaced. */
+  func = asm_function_create ("foo.c");
+  asm_function_add_line (func, "bar", 10, 0x10, 0x00, "hello");
+  asm_function_done (func);
+  ass_insert (ass, func);
+  fail_unless (ass->nr_functions == 1);
+  fail_unless (ass_find (ass, 0x10) == func);
+  fail_unless (ass_find (ass, 0x18) == NULL);
+
+  /* Least recently used is dropped when full. */
+  for (i = 1; i < 40; i++)
+    {
+      snprintf (name, 32, "f%d", i);
+      func = asm_function_create ("foo.c");
+      asm_function_add_line (func, name, 1, 0x100 * i, 0, "nop");
+      asm_function_add_line (func, name, 1, 0x100 * i + 4, 4, "ret");
+      asm_function_done (func);
+      ass_insert (ass, func);
+      fail_unless (ass_find (ass, 0x10) != NULL);
+    }
+  fail_unless (ass_find (ass, 0x100) == NULL);
+  func = ass_find (ass, 0x100 * 39 + 2);
+  fail_unless (func != NULL && strcmp (func->function, "f39") == 0);
+  for (i = 1; i < ass->nr_functions; i++)
+    {
+      fail_unless (ass->functions[i - 1]->address
+		   < ass->functions[i]->address);
+    }
 
-  ret =
-    ass_add_line (ass, "foo_long.c", "foo_long", 10, 0x06, 0x00, "back_long");
-  fail_unless (ret == 1);
-  ret =
-    ass_add_line (ass, "foo_long.c", "foo_long", 11, 0x07, 0x01, "back_long");
-  fail_unless (ret == 0);
-  ret =
-    ass_add_line (ass, "foo_long.c", "foo_long", 12, 0x08, 0x02, "back_long");
-  fail_unless (ret == 0);
-  ret =
-    ass_add_line (ass, "foo_long.c", "foo_long", 12, 0x08, 0x02, "back_long");
-  fail_unless (ret == 0);
-  ret =
-    ass_add_line (ass, "foo_long.c", "foo_long", 12, 0x09, 0x03, "back_long");
-  fail_unless (ret == 0);
-  ret =
-    ass_add_line (ass, "foo_long.c", "foo_long", 12, 0x0A, 0x04, "back_long");
-  fail_unless (ret == 0);
+  ass_reset (ass);
+  fail_unless (ass_find (ass, 0x10) == NULL);
 
+  /* 64 bit addresses, binary search of the pc. */
+  func = asm_function_create ("foo.c");
+  for (i = 99; i >= 0; i--)
+    {
+      asm_function_add_line (func, "big", 100 + i % 7,
+			     0x7ffff7a52000ULL + 3 * i, 3 * i, "nop");
+    }
+  asm_function_done (func);
+  fail_unless (func->address == 0x7ffff7a52000ULL);
+  fail_unless (func->end == 0x7ffff7a52000ULL + 3 * 99);
+  for (i = 0; i < 100; i++)
+    {
+      line = asm_function_find_line (func, 0x7ffff7a52000ULL + 3 * i);
+      fail_unless (line != NULL && line->offset == 3 * i);
+      fail_unless (asm_function_find_line (func,
+					   0x7ffff7a52001ULL + 3 * i) == NULL);
+    }
+  ass_insert (ass, func);
+  fail_unless (ass_find (ass, 0x7ffff7a52010ULL) == func);
+  fail_unless (ass_find (ass, 0xf7a52010ULL) == NULL);
   ass_reset (ass);
 
-  ret =
-    ass_add_line (ass, "foo_long.c", "foo_long", 10, 0x06, 0x00,
-		  "back_longer");
-  fail_unless (ret == 1);
-  ret =
-    ass_add_line (ass, "foo_long.c", "foo_long", 11, 0x08, 0x02,
-		  "back_longer");
-  fail_unless (ret == 0);
+  /* Only source lines. */
+  func = asm_function_create ("foo.c");
+  asm_function_add_line (func, NULL, 3, -1, -1, NULL);
+  asm_function_done (func);
+  fail_unless (func->nr_lines == 0);
+  fail_unless (func->address == ASM_NO_ADDRESS);
+  asm_function_free (func);
 
   ass_free (ass);
 }
@@ -533,6 +746,9 @@ START_TEST (test_reg)
   int ret;
   char buf[32];
   int i;
+  uint64_t lanes[2];
+  uint64_t long_lanes[64];
+  const char *str;
 
   data_registers *reg;
 
@@ -563,11 +779,364 @@ START_TEST (test_reg)
   ret = data_registers_set_value (reg, 100, 99);
   fail_unless (ret == 0);
   fail_unless (reg->registers[100].u64 == 99);
+  fail_unless (reg->registers[100].type == DATA_REG_INT);
+  ret = data_registers_format (reg, 100, buf, 32);
+  fail_unless (ret == 4 && strcmp (buf, "0x63") == 0);
+
+  /* Vector lanes. */
+  lanes[0] = 1;
+  lanes[1] = 0xffffffffffffffffULL;
+  ret = data_registers_set_lanes (reg, 101, lanes, 2);
+  fail_unless (ret == 0);
+  fail_unless (reg->registers[101].type == DATA_REG_VECTOR);
+  fail_unless (reg->registers[101].lanes[1] == 0xffffffffffffffffULL);
+  ret = data_registers_format (reg, 101, buf, 32);
+  fail_unless (strcmp (buf, "0x1, 0xffffffffffffffff") == 0);
+  fail_unless (ret == strlen (buf));
+  ret = data_registers_format (reg, 101, buf, 8);
+  fail_unless (ret == 7 && strcmp (buf, "0x1, 0x") == 0);
+  ret = data_registers_set_lanes (reg, 190, lanes, 2);
+  fail_unless (ret < 0);
+  ret = data_registers_format (reg, 102, buf, 32);
+  fail_unless (ret == 0 && buf[0] == '\0');
+
+  /* Cached formatted values. */
+  str = data_registers_get_str (reg, 100, &ret);
+  fail_unless (ret == 4 && strcmp (str, "0x63") == 0);
+  fail_unless (data_registers_get_str (reg, 100, NULL) == str);
+  fail_unless (reg->registers[100].flen == 4);
+  data_registers_set_value (reg, 100, 99);
+  fail_unless (reg->registers[100].flen == 4);
+  data_registers_set_value (reg, 100, 0x100);
+  fail_unless (reg->registers[100].flen < 0);
+  str = data_registers_get_str (reg, 100, &ret);
+  fail_unless (ret == 5 && strcmp (str, "0x100") == 0);
+  data_registers_set_str_value (reg, 100, "0x100");
+  fail_unless (reg->registers[100].flen < 0);
+  data_registers_get_str (reg, 100, NULL);
+  data_registers_set_str_value (reg, 100, "0x100");
+  fail_unless (reg->registers[100].flen == 5);
+  data_registers_get_str (reg, 101, NULL);
+  data_registers_set_lanes (reg, 101, lanes, 2);
+  fail_unless (reg->registers[101].flen == strlen ("0x1, 0xffffffffffffffff"));
+  data_registers_set_lanes (reg, 101, lanes, 1);
+  str = data_registers_get_str (reg, 101, &ret);
+  fail_unless (ret == 3 && strcmp (str, "0x1") == 0);
+  for (i = 0; i < 64; i++)
+    {
+      long_lanes[i] = 0xffffffffffffffffULL;
+    }
+  data_registers_set_lanes (reg, 101, long_lanes, 64);
+  str = data_registers_get_str (reg, 101, &ret);
+  fail_unless (ret == 64 * 18 + 63 * 2 && ret == strlen (str));
+  str = data_registers_get_str (reg, 102, &ret);
+  fail_unless (ret == 0 && str[0] == '\0');
+  fail_unless (data_registers_get_str (reg, 1000, &ret) == NULL);
+
+  /* Changed registers. */
+  data_registers_add (reg, 300, "far");
+  fail_unless (reg->size > 300);
+  fail_unless (data_registers_set_changed (reg, 3) == 0);
+  fail_unless (data_registers_set_changed (reg, 300) == 0);
+  fail_unless (data_registers_set_changed (reg, 1000) < 0);
+  fail_unless (data_registers_is_changed (reg, 3));
+  fail_unless (data_registers_is_changed (reg, 300));
+  fail_unless (!data_registers_is_changed (reg, 4));
+  fail_unless (!data_registers_is_changed (reg, 1000));
+  data_registers_clear_changed (reg);
+  fail_unless (!data_registers_is_changed (reg, 3));
+  fail_unless (!data_registers_is_changed (reg, 300));
 
   data_registers_free (reg);
 }
 END_TEST
 
+/**
+ * @test Test memory cache functions.
+ */
+START_TEST (test_mem)
+{
+  mem_cache *cache;
+  mem_page *page;
+  uint64_t address;
+  int i;
+
+  cache = mem_cache_create ();
+  fail_unless (cache->nr_pages == 0);
+  fail_unless (mem_cache_find (cache, 0x1000) == NULL);
+
+  /* Request pages. */
+  fail_unless (mem_cache_request (cache, 0x2010) == 1);
+  fail_unless (mem_cache_request (cache, 0x2fff) == 0);
+  fail_unless (mem_cache_request (cache, 0x1000) == 1);
+  fail_unless (cache->nr_pages == 2);
+  fail_unless (cache->pages[0]->address == 0x1000);
+  fail_unless (cache->pages[1]->address == 0x2000);
+  page = mem_cache_find (cache, 0x2abc);
+  fail_unless (page != NULL && page->address == 0x2000);
+  fail_unless (page->state == MEM_PAGE_PENDING);
+  fail_unless (mem_cache_find (cache, 0x3000) == NULL);
+
+  /* Store bytes, crossing a page boundary and a missing page. */
+  fail_unless (mem_cache_set_bytes (cache, 0x1ffe, "0a0B") == 2);
+  fail_unless (mem_cache_set_bytes (cache, 0x2ffe, "ff01fe") == 2);
+  page = mem_cache_find (cache, 0x1000);
+  fail_unless (page->state == MEM_PAGE_READ);
+  fail_unless (MEM_PAGE_VALID (page, 0xffe));
+  fail_unless (MEM_PAGE_VALID (page, 0xfff));
+  fail_unless (!MEM_PAGE_VALID (page, 0));
+  fail_unless (page->data[0xffe] == 0x0a && page->data[0xfff] == 0x0b);
+  page = mem_cache_find (cache, 0x2000);
+  fail_unless (page->state == MEM_PAGE_READ);
+  fail_unless (page->data[0xfff] == 0x01);
+  fail_unless (MEM_PAGE_VALID (page, 0xffe));
+  fail_unless (!MEM_PAGE_VALID (page, 0xffd));
+  fail_unless (mem_cache_set_bytes (cache, 0x1000, "0x") == -1);
+  fail_unless (mem_cache_set_bytes (cache, 0x1000, "") == 0);
+
+  /* Invalidate. */
+  mem_cache_invalidate (cache, 0x2fff, 0);
+  fail_unless (mem_cache_find (cache, 0x2000)->state == MEM_PAGE_READ);
+  mem_cache_invalidate (cache, 0x2fff, 2);
+  fail_unless (mem_cache_find (cache, 0x1000)->state == MEM_PAGE_READ);
+  page = mem_cache_find (cache, 0x2000);
+  fail_unless (page->state == MEM_PAGE_STALE);
+  fail_unless (MEM_PAGE_VALID (page, 0xffe) && page->data[0xffe] == 0xff);
+  fail_unless (mem_cache_request (cache, 0x2000) == 1);
+  fail_unless (page->state == MEM_PAGE_PENDING);
+  fail_unless (mem_cache_request (cache, 0x2000) == 0);
+  fail_unless (mem_cache_set_bytes (cache, 0x2000, "11") == 1);
+  fail_unless (page->state == MEM_PAGE_READ);
+  fail_unless (!MEM_PAGE_VALID (page, 0xffe));
+  mem_cache_invalidate (cache, 0, UINT64_MAX);
+  fail_unless (mem_cache_find (cache, 0x1000)->state == MEM_PAGE_STALE);
+  fail_unless (mem_cache_find (cache, 0x2000)->state == MEM_PAGE_STALE);
+
+  /* Evict the least recently used page. */
+  mem_cache_reset (cache);
+  fail_unless (cache->nr_pages == 0);
+  i = 0;
+  address = 0;
+  while (i < 2048)
+    {
+      fail_unless (mem_cache_request (cache, address) == 1);
+      address += MEM_PAGE_SIZE;
+      i++;
+    }
+  fail_unless (cache->nr_pages == 2048);
+  fail_unless (mem_cache_find (cache, 0) != NULL);
+  fail_unless (mem_cache_request (cache, address) == 1);
+  fail_unless (cache->nr_pages == 2048);
+  fail_unless (mem_cache_find (cache, 0) != NULL);
+  fail_unless (mem_cache_find (cache, MEM_PAGE_SIZE) == NULL);
+  fail_unless (mem_cache_find (cache, address) != NULL);
+
+  /* Region. */
+  mem_cache_set_region (cache, 0x1000, 0x100);
+  fail_unless (cache->start == 0x1000 && cache->length == 0x100);
+  mem_cache_set_region (cache, UINT64_MAX - 0x10, 0x100);
+  fail_unless (cache->length == 0x10);
+
+  mem_cache_free (cache);
+}
+END_TEST
+
+/**
+ * @test Test source file index functions.
+ */
+START_TEST (test_files)
+{
+  file_index *index;
+  const char *a;
+  char buf[64];
+  int i;
+
+  index = file_index_create ();
+  fail_unless (file_index_match (index, "") == 0);
+  fail_unless (file_index_get_match (index, 0) == NULL);
+
+  /* Names are interned. */
+  a = file_index_add (index, "/src/view.c");
+  fail_unless (strcmp (a, "/src/view.c") == 0);
+  fail_unless (file_index_add (index, "/src/view.c") == a);
+  file_index_add (index, "/src/win_handler.c");
+  file_index_add (index, "/src/view.h");
+  file_index_add (index, "/usr/include/stdio.h");
+  file_index_add (index, "/src/input.c");
+  fail_unless (file_index_add (index, "/src/view.h") != a);
+  fail_unless (index->nr_names == 5);
+
+  /* Sorted. */
+  file_index_sort (index);
+  fail_unless (file_index_match (index, "") == 5);
+  fail_unless (strcmp (file_index_get_match (index, 0), "/src/input.c") == 0);
+  fail_unless (strcmp (file_index_get_match (index, 4),
+		       "/usr/include/stdio.h") == 0);
+  fail_unless (file_index_get_match (index, 5) == NULL);
+  fail_unless (file_index_get_match (index, -1) == NULL);
+
+  /* Fuzzy, incremental and case insensitive. */
+  fail_unless (file_index_match (index, "v") == 2);
+  fail_unless (file_index_match (index, "vh") == 1);
+  fail_unless (strcmp (file_index_get_match (index, 0), "/src/view.h") == 0);
+  fail_unless (file_index_match (index, "vhx") == 0);
+  fail_unless (file_index_match (index, "V") == 2);
+  fail_unless (file_index_match (index, "src") == 5);
+  fail_unless (file_index_match (index, "wha") == 1);
+  fail_unless (strcmp (file_index_get_match (index, 0),
+		       "/src/win_handler.c") == 0);
+  /* File names before directories. */
+  fail_unless (file_index_match (index, "in") == 3);
+  fail_unless (strcmp (file_index_get_match (index, 0), "/src/input.c") == 0);
+
+  /* Adding a name restarts the matching. */
+  file_index_add (index, "/src/vh.c");
+  file_index_sort (index);
+  fail_unless (file_index_match (index, "vh") == 2);
+  fail_unless (strcmp (file_index_get_match (index, 0), "/src/vh.c") == 0);
+
+  /* Many names. */
+  file_index_reset (index);
+  fail_unless (index->nr_names == 0);
+  for (i = 0; i < 1000; i++)
+    {
+      snprintf (buf, 64, "/src/file_%d.c", i % 500);
+      file_index_add (index, buf);
+    }
+  fail_unless (index->nr_names == 500);
+  file_index_sort (index);
+  fail_unless (file_index_match (index, "file_49") > 11);
+  fail_unless (strcmp (file_index_get_match (index, 0),
+		       "/src/file_49.c") == 0);
+
+  file_index_free (index);
+}
+END_TEST
+
+/**
+ * @test Test symbol index functions.
+ */
+START_TEST (test_symbols)
+{
+  symbol_index *index;
+  const char *file;
+  const char *a;
+  char buf[64];
+  int line;
+  int i;
+
+  index = symbol_index_create ();
+  symbol_index_sort (index);
+  fail_unless (symbol_index_match (index, "") == 0);
+  fail_unless (symbol_index_get_match (index, 0, &file, &line) == NULL);
+
+  symbol_index_add (index, "view_show_file", "/src/view.c", 100);
+  symbol_index_add (index, "view_create", "/src/view.c", 20);
+  symbol_index_add (index, "win_show", "/src/win_handler.c", 30);
+  symbol_index_add (index, "show", "/src/main.c", 5);
+  symbol_index_add (index, "Fshow", "/src/main.c", 10);
+  symbol_index_add (index, "view_create", "/src/view.c", 20);
+  fail_unless (index->nr_symbols == 6);
+  fail_unless (index->files->nr_names == 3);
+
+  /* Sorted without duplicates. */
+  symbol_index_sort (index);
+  fail_unless (index->nr_symbols == 5);
+  fail_unless (symbol_index_match (index, "") == 5);
+  a = symbol_index_get_match (index, 0, &file, &line);
+  fail_unless (strcmp (a, "Fshow") == 0);
+  fail_unless (strcmp (file, "/src/main.c") == 0);
+  fail_unless (line == 10);
+  fail_unless (symbol_index_get_match (index, 5, &file, &line) == NULL);
+  fail_unless (symbol_index_get_match (index, -1, &file, &line) == NULL);
+
+  /* Exact name, start of name, start of word and then the rest. */
+  fail_unless (symbol_index_match (index, "sh") == 4);
+  fail_unless (symbol_index_match (index, "show") == 4);
+  fail_unless (strcmp (symbol_index_get_match (index, 0, &file, &line),
+		       "show") == 0);
+  fail_unless (strcmp (symbol_index_get_match (index, 1, &file, &line),
+		       "view_show_file") == 0);
+  fail_unless (strcmp (symbol_index_get_match (index, 2, &file, &line),
+		       "win_show") == 0);
+  fail_unless (strcmp (symbol_index_get_match (index, 3, &file, &line),
+		       "Fshow") == 0);
+  fail_unless (symbol_index_match (index, "SHOW_") == 1);
+  fail_unless (strcmp (symbol_index_get_match (index, 0, &file, &line),
+		       "view_show_file") == 0);
+  fail_unless (line == 100);
+  fail_unless (symbol_index_match (index, "V") == 2);
+  fail_unless (symbol_index_match (index, "view_cr") == 1);
+  fail_unless (symbol_index_match (index, "xyz") == 0);
+
+  /* Many symbols. */
+  symbol_index_reset (index);
+  fail_unless (index->nr_symbols == 0);
+  for (i = 0; i < 100000; i++)
+    {
+      snprintf (buf, 64, "function_%d", i);
+      symbol_index_add (index, buf, i % 2 ? "/a.c" : "/b.c", i);
+    }
+  symbol_index_sort (index);
+  fail_unless (symbol_index_match (index, "tion_1234") == 11);
+  fail_unless (strcmp (symbol_index_get_match (index, 0, &file, &line),
+		       "function_1234") == 0);
+  fail_unless (line == 1234);
+  fail_unless (strcmp (file, "/b.c") == 0);
+  fail_unless (symbol_index_match (index, "function_99999") == 1);
+  fail_unless (symbol_index_match (index, "f") == 100000);
+
+  symbol_index_free (index);
+}
+END_TEST
+
+START_TEST (test_records)
+{
+  record_log *log;
+  const char *text;
+  char *big;
+  int len;
+  int i;
+
+  log = record_log_create ();
+  fail_unless (record_log_get (log, 0, &len) == NULL);
+  fail_unless (record_log_add (log, "^done") == 0);
+  fail_unless (record_log_add (log, "") == 1);
+
+  /* A record larger than a block of the arena. */
+  big = (char *) malloc (200000);
+  memset (big, 'x', 199999);
+  big[199999] = '\0';
+  fail_unless (record_log_add (log, big) == 2);
+  free (big);
+  for (i = 3; i < 5000; i++)
+    {
+      fail_unless (record_log_add (log, "*running,thread-id=\"all\"") == i);
+    }
+
+  text = record_log_get (log, 0, &len);
+  fail_unless (text != NULL && strcmp (text, "^done") == 0 && len == 5);
+  text = record_log_get (log, 1, &len);
+  fail_unless (text != NULL && *text == '\0' && len == 0);
+  text = record_log_get (log, 2, &len);
+  fail_unless (text != NULL && len == 199999 && text[199998] == 'x');
+  text = record_log_get (log, 4999, &len);
+  fail_unless (text != NULL && strcmp (text, "*running,thread-id=\"all\"") == 0);
+  fail_unless (record_log_get (log, 5000, &len) == NULL);
+  fail_unless (record_log_get (log, -1, &len) == NULL);
+
+  /* Records are truncated until they are expanded. */
+  fail_unless (record_log_toggle (log, 2) == 1);
+  fail_unless (record_log_toggle (log, 1) == 1);
+  fail_unless (record_log_toggle (log, 2) == 0);
+  fail_unless (record_log_toggle (log, 1) == 0);
+  fail_unless (record_log_toggle (log, 5000) == -1);
+  fail_unless (record_log_toggle (log, -1) == -1);
+
+  record_log_free (log);
+}
+END_TEST
+
 /**
  * @test Test objects.c functions.
  *
@@ -580,6 +1149,10 @@ END_TEST
  * - _stack: Test stack, frame and variables is ok.
  * - _asm: Test asm objects.
  * - _reg: Test register functions.
+ * - _mem: Test memory cache.
+ * - _files: Test source file index.
+ * - _symbols: Test symbol index.
+ * - _records: Test record log.
  */
   Suite * objects_suite (void)
 {
@@ -609,6 +1182,22 @@ END_TEST
   tcase_add_test (tc_reg, test_reg);
   suite_add_tcase (s, tc_reg);
 
+  TCase *tc_mem = tcase_create ("mem");
+  tcase_add_test (tc_mem, test_mem);
+  suite_add_tcase (s, tc_mem);
+
+  TCase *tc_files = tcase_create ("files");
+  tcase_add_test (tc_files, test_files);
+  suite_add_tcase (s, tc_files);
+
+  TCase *tc_symbols = tcase_create ("symbols");
+  tcase_add_test (tc_symbols, test_symbols);
+  suite_add_tcase (s, tc_symbols);
+
+  TCase *tc_records = tcase_create ("records");
+  tcase_add_test (tc_records, test_records);
+  suite_add_tcase (s, tc_records);
+
   return s;
 }
 
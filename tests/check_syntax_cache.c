@@ -0,0 +1,133 @@
+#include <check.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/syntax_cache.h"
+
+FILE *OUT_FILE = NULL;
+int VERBOSE_LEVEL = 7;
+
+id_table g_ids[3];
+
+const id_table *
+get_ids (void *data, int line)
+{
+  return &g_ids[line];
+}
+
+START_TEST (test_syntax_cache)
+{
+  char dir[] = "/tmp/check_syntax_cacheXXXXXX";
+  char file_name[64];
+  char cmd[64];
+  syntax_cache *cache;
+  const id_entry *ids;
+  id_entry many[40];
+  uint64_t syntax;
+  FILE *file;
+  int len;
+  int ret;
+  int i;
+
+  fail_unless (mkdtemp (dir) != NULL);
+  setenv ("XDG_CACHE_HOME", dir, 1);
+  snprintf (file_name, sizeof (file_name), "%s/a.c", dir);
+  file = fopen (file_name, "w");
+  fail_unless (file != NULL);
+  fprintf (file, "int a;\n\nint b; /* a long line */\n");
+  fclose (file);
+  syntax = syntax_cache_hash ("{id='1',match='int'}");
+  fail_unless (syntax != syntax_cache_hash ("{id='2',match='int'}"));
+
+  /* Not cached yet. */
+  fail_unless (syntax_cache_open (file_name, syntax) == NULL);
+
+  memset (g_ids, 0, sizeof (g_ids));
+  for (i = 0; i < 3; i++)
+    {
+      g_ids[i].size = DEF_IDT_LEN;
+    }
+  for (i = 0; i < 40; i++)
+    {
+      many[i].id = i % 3;
+      many[i].index = i;
+      many[i].len = 1;
+    }
+  fail_unless (id_table_set (&g_ids[0], many, 1) == 0);
+  fail_unless (id_table_set (&g_ids[2], many, 40) == 0);
+  fail_unless (g_ids[2].size >= 40);
+  fail_unless (id_table_get (&g_ids[2], 39)->index == 39);
+  fail_unless (id_table_get (&g_ids[2], 3)->index == 3);
+
+  ret = syntax_cache_store (file_name, syntax, 3, get_ids, NULL);
+  fail_unless (ret == 0);
+
+  /* Cached. */
+  cache = syntax_cache_open (file_name, syntax);
+  fail_unless (cache != NULL);
+  fail_unless (syntax_cache_nr_of_lines (cache) == 3);
+  ids = syntax_cache_get_line (cache, 0, &len);
+  fail_unless (ids != NULL && len == 1);
+  fail_unless (ids[0].id == 0 && ids[0].index == 0 && ids[0].len == 1);
+  ids = syntax_cache_get_line (cache, 1, &len);
+  fail_unless (ids != NULL && len == 0);
+  ids = syntax_cache_get_line (cache, 2, &len);
+  fail_unless (ids != NULL && len == 40);
+  fail_unless (ids[39].id == 0 && ids[39].index == 39);
+  fail_unless (syntax_cache_get_line (cache, 3, &len) == NULL);
+  fail_unless (syntax_cache_get_line (cache, -1, &len) == NULL);
+  syntax_cache_close (cache);
+
+  /* Other definitions. */
+  fail_unless (syntax_cache_open (file_name, syntax + 1) == NULL);
+
+  /* The file is changed. */
+  file = fopen (file_name, "a");
+  fail_unless (file != NULL);
+  fprintf (file, "int c;\n");
+  fclose (file);
+  fail_unless (syntax_cache_open (file_name, syntax) == NULL);
+
+  /* Another file. */
+  snprintf (file_name, sizeof (file_name), "%s/b.c", dir);
+  fail_unless (syntax_cache_open (file_name, syntax) == NULL);
+
+  free (g_ids[2].extra_id);
+  snprintf (cmd, sizeof (cmd), "rm -rf %s", dir);
+  ret = system (cmd);
+  unsetenv ("XDG_CACHE_HOME");
+}
+END_TEST
+
+/**
+ * @test Test syntax_cache.c functions.
+ *
+ * - _syntax_cache: Store and open the cache of a file.
+ */
+  Suite * syntax_cache_suite (void)
+{
+  Suite *s = suite_create ("syntax_cache");
+
+  TCase *tc_syntax_cache = tcase_create ("syntax_cache");
+  tcase_add_test (tc_syntax_cache, test_syntax_cache);
+  suite_add_tcase (s, tc_syntax_cache);
+
+  return s;
+}
+
+int
+main (void)
+{
+  int number_failed;
+
+  OUT_FILE = stdout;
+  Suite *s = syntax_cache_suite ();
+  SRunner *sr = srunner_create (s);
+
+  srunner_run_all (sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed (sr);
+  srunner_free (sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -66,6 +66,31 @@ START_TEST (test_text_line)
   fail_unless (len == 2);
   fail_unless (strcmp (p, "  ") == 0);
 
+  /* Replace lines, the buffer grows when needed. */
+  text_clear (text);
+  ret = text_add_line (text, "a");
+  fail_unless (ret == 1);
+  ret = text_set_line (text, 0, "a much longer line");
+  fail_unless (ret == 18);
+  p = text_get_line (text, 0, &len);
+  fail_unless (len == 18);
+  fail_unless (strcmp (p, "a much longer line") == 0);
+  ret = text_set_line (text, 0, "b");
+  fail_unless (ret == 1);
+  p = text_get_line (text, 0, &len);
+  fail_unless (len == 1 && strcmp (p, "b") == 0);
+  ret = text_set_line (text, 1, "b");
+  fail_unless (ret < 0);
+  ret = text_set_line (text, 0, "\001");
+  fail_unless (ret < 0);
+
+  /* Reused line buffers must fit the new line. */
+  text_clear (text);
+  ret = text_add_line (text, "a very long line that does not fit");
+  fail_unless (ret == 1);
+  p = text_get_line (text, 0, &len);
+  fail_unless (strcmp (p, "a very long line that does not fit") == 0);
+
   text_free (text);
 }
 END_TEST
@@ -132,6 +157,74 @@ START_TEST (test_text_load)
 }
 END_TEST
 
+START_TEST (test_text_search)
+{
+  text *text;
+  text_pattern *p;
+  const char *str = "abcabdabcabe";
+  int count;
+  int len;
+  int nr;
+
+  /* Find in strings. */
+  p = text_pattern_create ("abe");
+  fail_unless (strcmp (text_pattern_get (p, &len), "abe") == 0);
+  fail_unless (len == 3);
+  fail_unless (text_pattern_find (p, str, strlen (str)) == str + 9);
+  fail_unless (text_pattern_find (p, str, 11) == NULL);
+  fail_unless (text_pattern_find (p, str, 2) == NULL);
+  text_pattern_free (p);
+  p = text_pattern_create ("d");
+  fail_unless (text_pattern_find (p, str, strlen (str)) == str + 5);
+  fail_unless (text_pattern_find (p, str, 5) == NULL);
+  text_pattern_free (p);
+  p = text_pattern_create ("abcabdabcabe");
+  fail_unless (text_pattern_find (p, str, strlen (str)) == str);
+  text_pattern_free (p);
+
+  /* Find lines. */
+  text = text_create ();
+  text_add_line (text, "int main (void)");
+  text_add_line (text, "{");
+  text_add_line (text, "  int i = main;");
+  text_add_line (text, "}");
+  p = text_pattern_create ("main");
+  fail_unless (text_find (text, p, 0, 1) == 0);
+  fail_unless (text_find (text, p, 1, 1) == 2);
+  fail_unless (text_find (text, p, 3, 1) == -1);
+  fail_unless (text_find (text, p, 3, -1) == 2);
+  fail_unless (text_find (text, p, 1, -1) == 0);
+  fail_unless (text_find (text, p, 10, 1) == -1);
+
+  /* Count a part at the time. */
+  text_add_line (text, "main main mainmain");
+  count = 0;
+  nr = text_count (text, p, 0, 2, &count);
+  fail_unless (nr == 2);
+  fail_unless (count == 1);
+  nr = text_count (text, p, nr, 2, &count);
+  fail_unless (nr == 4);
+  fail_unless (count == 2);
+  nr = text_count (text, p, nr, 2, &count);
+  fail_unless (nr == 5);
+  fail_unless (count == 6);
+  nr = text_count (text, p, nr, 2, &count);
+  fail_unless (nr == 5);
+  fail_unless (count == 6);
+  text_pattern_free (p);
+
+  /* Matches do not overlap. */
+  text_add_line (text, "aaaa");
+  p = text_pattern_create ("aa");
+  count = 0;
+  fail_unless (text_count (text, p, 5, 1, &count) == 6);
+  fail_unless (count == 2);
+  text_pattern_free (p);
+
+  text_free (text);
+}
+END_TEST
+
 /**
  * @test Test text.x functions.
  *
@@ -139,6 +232,7 @@ END_TEST
  * - _create: Test creation.
  * - _line: Test adding lines to text.
  * - _load: Test loading files.
+ * - _search: Test searching.
  */
   Suite * text_suite (void)
 {
@@ -156,6 +250,10 @@ END_TEST
   tcase_add_test (tc_text_load, test_text_load);
   suite_add_tcase (s, tc_text_load);
 
+  TCase *tc_text_search = tcase_create ("text_search");
+  tcase_add_test (tc_text_search, test_text_search);
+  suite_add_tcase (s, tc_text_search);
+
   return s;
 }
 
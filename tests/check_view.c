@@ -4,6 +4,8 @@
 #include <string.h>
 #include <unistd.h>
 #include <ncurses.h>
+#include <panel.h>
+#include <sys/select.h>
 
 #include "../src/view.h"
 #include "../src/objects.h"
@@ -42,6 +44,46 @@ conf_get_string (configuration * conf, const char *group_name,
   return strcmp (name, "colors") == 0 ? GLOB_PAIR : GLOB_COLOR_STR;
 }
 
+/* Wait for the file loaded in the background, at most 5 seconds. */
+static int
+wait_loaded (view * view)
+{
+  fd_set rfds;
+  struct timeval timeout = { 5, 0 };
+  int fd = view_loader_fd (view);
+
+  if (fd < 0)
+    {
+      return 1;
+    }
+  FD_ZERO (&rfds);
+  FD_SET (fd, &rfds);
+  if (select (fd + 1, &rfds, NULL, NULL, &timeout) != 1)
+    {
+      return -2;
+    }
+  return view_file_loaded (view);
+}
+
+/* Find the row on the screen with @a text, the row is copied to @a row. */
+static int
+find_row (const char *text, char *row, int size)
+{
+  int i;
+
+  update_panels ();
+  doupdate ();
+  for (i = 0; i < LINES; i++)
+    {
+      mvwinnstr (curscr, i, 0, row, size - 1);
+      if (strstr (row, text) != NULL)
+	{
+	  return i;
+	}
+    }
+  return -1;
+}
+
 START_TEST (test_view_create)
 {
   view *view;
@@ -293,6 +335,10 @@ END_TEST
 START_TEST (test_view_misc)
 {
   view *view;
+  char buf[64];
+  char big[4096];
+  char row[512];
+  char *mark;
   int ret;
   int i;
 
@@ -306,10 +352,72 @@ START_TEST (test_view_misc)
   ret = view_add_line (view, 0, "kk", 1);
   fail_unless (ret == 0);
 
+  strcpy (buf, "line 1\r\nline 2\rline 3\n\001line\t4");
+  ret = view_add_lines (view, WIN_TARGET, buf);
+  fail_unless (ret == 0);
+  ret = view_add_lines (view, 999, buf);
+  fail_unless (ret < 0);
+
+  /* A record wider than the window is truncated until it is expanded. */
+  ret = view_add_record (view, "^done");
+  fail_unless (ret == 0);
+  memset (big, 'x', sizeof (big) - 1);
+  big[sizeof (big) - 1] = '\0';
+  memcpy (big, "^done,asm_insns=\t", 17);
+  ret = view_add_record (view, big);
+  fail_unless (ret == 0);
+  ret = view_set_focus (view, WIN_RESPONSES);
+  fail_unless (ret == 0);
+  ret = view_go_to_line (view, WIN_RESPONSES, 1);
+  fail_unless (ret == 0);
+  fail_unless (find_row ("^done,asm_insns=", row, sizeof (row)) >= 0);
+  fail_unless (strstr (row, " [4095 bytes]") != NULL);
+  ret = view_toggle_record (view);
+  fail_unless (ret == 0);
+  fail_unless (find_row ("^done,asm_insns=", row, sizeof (row)) >= 0);
+  fail_unless (strstr (row, "bytes]") == NULL);
+  ret = view_toggle_record (view);
+  fail_unless (ret == 0);
+  fail_unless (find_row ("^done,asm_insns=", row, sizeof (row)) >= 0);
+  fail_unless (strstr (row, " [4095 bytes]") != NULL);
+
+  /* A truncated record is truncated again at the new width. */
+  resizeterm (LINES, COLS + 20);
+  view_resize (view);
+  fail_unless (find_row ("^done,asm_insns=", row, sizeof (row)) >= 0);
+  mark = strstr (row, " [4095 bytes]");
+  fail_unless (mark != NULL && mark - row + 13 == COLS);
+
+  /* The row of a truncated record is expanded after a resize. */
+  ret = view_toggle_record (view);
+  fail_unless (ret == 0);
+  fail_unless (find_row ("^done,asm_insns=", row, sizeof (row)) >= 0);
+  fail_unless (strstr (row, "bytes]") == NULL);
+  ret = view_toggle_record (view);
+  fail_unless (ret == 0);
+  fail_unless (find_row ("^done,asm_insns=", row, sizeof (row)) >= 0);
+  fail_unless (strstr (row, " [4095 bytes]") != NULL);
+  resizeterm (LINES, COLS - 20);
+  view_resize (view);
+
   ret = view_show_file (view, "", 15, 1);
   fail_unless (ret == 0);
+  ret = view_file_loaded (view);
+  fail_unless (ret == 0);
+  ret = view_show_file (view, CONFDIR "text_WRONG.txt", 15, 1);
+  fail_unless (ret == 0);
+  ret = wait_loaded (view);
+  fail_unless (ret == -1 || view_loader_fd (view) < 0);
+  ret = view_show_file (view, CONFDIR "text_test_long.txt", 15, 1);
+  fail_unless (ret == 0);
+  ret = view_show_file (view, "", 15, 1);
+  fail_unless (ret == 0);
+  ret = wait_loaded (view);
+  fail_unless (ret == 0 || view_loader_fd (view) < 0);
   ret = view_show_file (view, CONFDIR "text_test.txt", 15, 1);
   fail_unless (ret == 0);
+  ret = wait_loaded (view);
+  fail_unless (ret == 1);
   ret = view_show_file (view, CONFDIR "text_test.txt", 13, 1);
   fail_unless (ret == 0);
 
@@ -354,6 +462,21 @@ START_TEST (test_view_misc)
       fail_unless (ret == 0);
     }
 
+  /* The windows are laid out again and keep their groups. */
+  resizeterm (LINES / 2, COLS + 20);
+  ret = view_resize (view);
+  fail_unless (ret == 0);
+  resizeterm (LINES * 2, COLS - 20);
+  ret = view_resize (view);
+  fail_unless (ret == 0);
+  ret = view_go_to_line (view, WIN_MAIN, 15);
+  fail_unless (ret == 0);
+  for (i = 0; i < 15; i++)
+    {
+      ret = view_next_window (view, 1, 2);
+      fail_unless (ret == 0);
+    }
+
   ret = view_set_status (view, 0, "Hello");
   fail_unless (ret == 0);
 
@@ -362,6 +485,20 @@ START_TEST (test_view_misc)
   ret = view_add_message (view, 0, "Hel\x01o");
   fail_unless (ret < 0);
 
+  /* A put off screen update is done when idle. */
+  for (i = 0; i < 100; i++)
+    {
+      ret = view_add_message (view, 0, "Hello");
+      fail_unless (ret == 0);
+    }
+  for (i = 0; i < 100 && view_refresh_time (view) >= 0; i++)
+    {
+      fail_unless (view_refresh_time (view) <= 250000);
+      usleep (view_refresh_time (view));
+      view_idle (view);
+    }
+  fail_unless (view_refresh_time (view) == -1);
+
   view_cleanup (view);
 }
 END_TEST
@@ -416,7 +553,7 @@ START_TEST (test_view_objects_library)
   int ret;
   int i;
   int j;
-  library *l = NULL;
+  library_table *l;
 
   GLOB_STR = NULL;
 
@@ -425,22 +562,23 @@ START_TEST (test_view_objects_library)
   fail_unless (ret == 0);
 
   /* Test with no library. */
-  view_update_libraries (view, l);
+  l = library_table_create ();
+  view_update_libraries (view, l->first);
 
   /* Set up with a couple of libraries. */
-  ret = library_add (&l, "BOOK1", "TARG", "HOST", 1);
+  ret = library_add (l, "BOOK1", "TARG", "HOST", 1);
   fail_unless (ret == 0);
-  ret = library_add (&l, "BOOK2", "TARG", "HOST", 0);
+  ret = library_add (l, "BOOK2", "TARG", "HOST", 0);
   fail_unless (ret == 0);
-  ret = library_add (&l, "BOOK2", "TARG", NULL, 0);
+  ret = library_add (l, "BOOK2", "TARG", NULL, 0);
   fail_unless (ret == 0);
-  ret = library_add (&l, "BOOK2", NULL, "HOST", 0);
+  ret = library_add (l, "BOOK2", NULL, "HOST", 0);
   fail_unless (ret == 0);
-  ret = library_add (&l, "BOOK2", NULL, NULL, 0);
+  ret = library_add (l, "BOOK2", NULL, NULL, 0);
   fail_unless (ret == 0);
-  view_update_libraries (view, l);
+  view_update_libraries (view, l->first);
 
-  library_remove_all (&l);
+  library_table_free (l);
   view_cleanup (view);
 }
 END_TEST
@@ -460,6 +598,8 @@ START_TEST (test_view_objects_breakpoint)
   fail_unless (ret == 0);
   ret = view_show_file (view, CONFDIR "text_test.txt", 15, 1);
   fail_unless (ret == 0);
+  ret = wait_loaded (view);
+  fail_unless (ret == 1);
 
   bpt = bp_table_create ();
   fail_unless (bpt != NULL);
@@ -538,6 +678,7 @@ START_TEST (test_view_objects_stack)
   view *view;
   int ret;
   int i;
+  char row[256];
   frame *f = NULL;
   stack *stack = NULL;
 
@@ -592,6 +733,29 @@ START_TEST (test_view_objects_stack)
   view_update_frame (view, stack, 2);
   stack->depth = 3;
   view_update_stack (view, stack);
+
+  /* The frames of the next page are added, the shown frames are kept. */
+  f = stack_get_frame (stack, 0);
+  free (f->func);
+  f->func = strdup ("changed");
+  for (i = 3; i < 5; i++)
+    {
+      f = stack_get_frame (stack, i);
+      fail_unless (f != NULL);
+      f->addr = i;
+      f->line = i;
+      f->file = strdup ("file");
+      f->fullname = NULL;
+      f->func = strdup ("page");
+    }
+  stack->depth = 5;
+  stack->appended = 1;
+  view_update_stack (view, stack);
+  fail_unless (find_row ("#0  file:10 func()", row, sizeof (row)) >= 0);
+  fail_unless (find_row ("changed", row, sizeof (row)) < 0);
+  ret = view_go_to_line (view, WIN_STACK, 4);
+  fail_unless (ret == 0);
+  fail_unless (find_row ("#4  file:4 page()", row, sizeof (row)) >= 0);
   stack_free (stack);
 
   view_cleanup (view);
@@ -603,21 +767,24 @@ START_TEST (test_view_objects_dis)
   view *view;
   int ret;
   int i;
-  assembler *ass;
+  asm_function *func;
 
   /* Setup the view. */
   GLOB_STR = NULL;
   ret = view_setup (&view, (configuration *) 42);
   fail_unless (ret == 0);
 
-  ass = ass_create ();
-  ass_add_line (ass, "123", "123", 10, 0x10, 0, "123");
-  ass_add_line (ass, "123", "123", 10, 0x11, 1, "1234");
-  ass_add_line (ass, "123", "123", 11, 0x12, 2, "1234");
+  func = asm_function_create ("123");
+  asm_function_add_line (func, "123", 10, 0x10, 0, "123");
+  asm_function_add_line (func, "123", 10, 0x11, 1, "1234");
+  asm_function_add_line (func, "123", 11, 0x12, 2, "1234");
+  asm_function_done (func);
 
-  view_update_ass (view, ass, 0x11);
+  view_update_ass (view, func, 0x11);
+  view_move_ass_pc (view, func, 0x11, 0x12);
+  view_move_ass_pc (view, func, 0x12, 0x42);
 
-  ass_free (ass);
+  asm_function_free (func);
   view_cleanup (view);
 }
 END_TEST
@@ -643,11 +810,121 @@ START_TEST (test_view_objects_reg)
 
   view_update_registers (view, reg);
 
+  /* Only the changed rows are redrawn. */
+  data_registers_set_value (reg, 2, 0x42);
+  data_registers_set_changed (reg, 2);
+  view_update_registers (view, reg);
+  data_registers_clear_changed (reg);
+  view_update_registers (view, reg);
+
+  /* A wider value rebuilds the view. */
+  data_registers_set_str_value (reg, 1, "a much wider value");
+  data_registers_set_changed (reg, 1);
+  view_update_registers (view, reg);
+
   data_registers_free (reg);
   view_cleanup (view);
 }
 END_TEST
 
+START_TEST (test_view_objects_mem)
+{
+  view *view;
+  int ret;
+  mem_cache *cache;
+  uint64_t address;
+  uint64_t length;
+  uint64_t row;
+  char row_text[512];
+  char *p;
+  int i;
+
+  /* Setup the view. */
+  GLOB_STR = NULL;
+  ret = view_setup (&view, (configuration *) 42);
+  fail_unless (ret == 0);
+
+  ret = view_get_memory_view (view, &address, &length);
+  fail_unless (ret < 0);
+
+  /* A 1 MiB region, only a part of the first page is read. */
+  cache = mem_cache_create ();
+  mem_cache_set_region (cache, 0x601040, 0x100000);
+  mem_cache_request (cache, 0x601040);
+  mem_cache_set_bytes (cache, 0x601040, "41ff00");
+  view_update_memory (view, cache);
+  ret = view_get_memory_view (view, &address, &length);
+  fail_unless (ret == 0);
+  fail_unless (address == 0x601040);
+  fail_unless (length > 0 && length < 0x100000);
+
+  /* Scroll a row and a page. */
+  ret = view_set_focus (view, WIN_MEMORY);
+  fail_unless (ret == 0);
+  ret = view_scroll_down (view);
+  fail_unless (ret < 0);
+  ret = view_scroll_up (view);
+  fail_unless (ret == 0);
+  view_get_memory_view (view, &row, &length);
+  row -= 0x601040;
+  fail_unless (row == 4 || row == 8 || row == 16);
+  ret = view_scroll_page (view, 1);
+  fail_unless (ret == 0);
+  view_get_memory_view (view, &address, &length);
+  fail_unless (address == 0x601040 + row + length);
+  ret = view_scroll_page (view, -1);
+  fail_unless (ret == 0);
+  ret = view_scroll_page (view, -1);
+  fail_unless (ret == 0);
+  view_get_memory_view (view, &address, &length);
+  fail_unless (address == 0x601040);
+
+  /* Stop at the end of the region. */
+  ret = 0;
+  while (ret == 0)
+    {
+      ret = view_scroll_page (view, 1);
+    }
+  view_get_memory_view (view, &address, &length);
+  fail_unless (address + length == 0x701040);
+
+  /* A new region moves to its start, a short region is not filled. */
+  mem_cache_set_region (cache, 0x601000, 0x10);
+  view_update_memory (view, cache);
+  view_get_memory_view (view, &address, &length);
+  fail_unless (address == 0x601000);
+  fail_unless (length == 0x10);
+  ret = view_scroll_up (view);
+  fail_unless (ret < 0);
+
+  /* A full row of 16 bytes. */
+  resizeterm (LINES, 250);
+  ret = view_resize (view);
+  fail_unless (ret == 0);
+  mem_cache_set_region (cache, 0x602000, 0x10);
+  mem_cache_request (cache, 0x602000);
+  mem_cache_set_bytes (cache, 0x602000, "4142434445464748494a4b4c4d4e4f50");
+  view_update_memory (view, cache);
+  ret = view_set_focus (view, WIN_MEMORY);
+  fail_unless (ret == 0);
+  update_panels ();
+  doupdate ();
+  row_text[0] = '\0';
+  for (i = 0; i < LINES && strstr (row_text, "0000000000602000") == NULL; i++)
+    {
+      mvwinnstr (curscr, i, 0, row_text, sizeof (row_text) - 1);
+    }
+  p = strstr (row_text, "0000000000602000");
+  fail_unless (p != NULL);
+  fail_unless (strncmp (p, "0000000000602000: 41 42 43 44 45 46 47 48 49 4a "
+			"4b 4c 4d 4e 4f 50  ABCDEFGHIJKLMNOP", 83) == 0,
+	       "%s", p);
+
+  mem_cache_free (cache);
+  view_cleanup (view);
+}
+END_TEST
+
 START_TEST (test_view_goto)
 {
   view *view;
@@ -692,6 +969,59 @@ START_TEST (test_view_goto)
 }
 END_TEST
 
+START_TEST (test_view_search)
+{
+  view *view;
+  int ret;
+  int i;
+  char buf[64];
+  int type;
+
+  GLOB_STR = NULL;
+  ret = view_setup (&view, (configuration *) 42);
+  fail_unless (ret == 0);
+
+  for (i = 0; i < 10000; i++)
+    {
+      sprintf (buf, "Line nr %d", i);
+      ret = view_add_line (view, WIN_MAIN, buf, i);
+      fail_unless (ret == 0);
+    }
+  ret = view_set_focus (view, WIN_MAIN);
+  fail_unless (ret == 0);
+
+  /* Nothing to count. */
+  fail_unless (view_idle (view) == 0);
+
+  ret = view_search (view, "nr 42", 1, 0);
+  fail_unless (ret == 0);
+  type = -1;
+  fail_unless (view_get_tag (view, &type) == 42);
+  ret = view_search (view, "nr 42", 1, 1);
+  fail_unless (ret == 0);
+  type = -1;
+  fail_unless (view_get_tag (view, &type) == 420);
+  ret = view_search (view, "nr 42", -1, 1);
+  fail_unless (ret == 0);
+  type = -1;
+  fail_unless (view_get_tag (view, &type) == 42);
+
+  /* The matches are counted a part at the time. */
+  fail_unless (view_idle (view) == 1);
+  fail_unless (view_idle (view) == 1);
+  fail_unless (view_idle (view) == 1);
+  fail_unless (view_idle (view) == 0);
+
+  ret = view_search (view, "nr 10000", 1, 1);
+  fail_unless (ret < 0);
+  ret = view_search (view, NULL, 1, 1);
+  fail_unless (ret == 0);
+  fail_unless (view_idle (view) == 0);
+
+  view_cleanup (view);
+}
+END_TEST
+
 START_TEST (test_view_move)
 {
   view *view;
@@ -724,7 +1054,7 @@ START_TEST (test_view_move)
       for (i = 0; i < 80; i++)
 	{
 	  ret = view_move_cursor (view, i);
-	  fail_unless (ret == (j >= 1 && j <= 5 ? -1 : 0), "ret %d i %d j %d",
+	  fail_unless (ret == (j >= 1 && j <= 4 ? -1 : 0), "ret %d i %d j %d",
 		       ret, i, j);
 	}
     }
@@ -799,6 +1129,8 @@ START_TEST (test_view_curpos)
   /* Set up the main window (has cursor pos). */
   ret = view_show_file (view, CONFDIR "text_test.txt", 15, 1);
   fail_unless (ret == 0);
+  ret = wait_loaded (view);
+  fail_unless (ret == 1);
 
   /* Set up the target window (has no cursor pos). */
   for (i = 0; i < 10; i++)
@@ -854,6 +1186,25 @@ START_TEST (test_view_curpos)
   fail_unless (win == WIN_MAIN);
   fail_unless (strcmp (CONFDIR "text_test.txt", name) == 0);
 
+  /* A prefetched file is handed over by the loader. */
+  ret = view_prefetch_file (view, CONFDIR "text_test.txt");
+  fail_unless (ret == 0);
+  ret = view_prefetch_file (view, CONFDIR "text_test_long.txt");
+  fail_unless (ret == 0);
+  ret = view_show_file (view, CONFDIR "text_test_long.txt", 3, 0);
+  fail_unless (ret == 0);
+  i = 0;
+  do
+    {
+      ret = wait_loaded (view);
+    }
+  while (ret == 0 && ++i < 10);
+  fail_unless (ret == 1);
+  ret = view_get_cursor (view, &win, &line, &name);
+  fail_unless (ret == 0);
+  fail_unless (strcmp (CONFDIR "text_test_long.txt", name) == 0);
+  fail_unless (line == 2);
+
   view_cleanup (view);
 }
 END_TEST
@@ -870,10 +1221,11 @@ END_TEST
  * - Misc: Test showFile, scrolling, outputs, changing outputs and
  *         setting statuses.
  * - viewUpdate*: Test updating thread-, library-, stack-, frame-,
- *   breakpoints-window, disassembler, registers.
+ *   breakpoints-window, disassembler, registers, memory.
  * - view_goto,view_move: Test goto specific lines and moving cursor.
  * - view_get_tag: Test to retrieve tags.
  * - view_curpos: Test to retrieve cursor pos.
+ * - view_search: Test searching the current window.
  */
   Suite * view_suite (void)
 {
@@ -921,11 +1273,21 @@ END_TEST
   tcase_add_test (tc_view_objects_reg, test_view_objects_reg);
   suite_add_tcase (s, tc_view_objects_reg);
 
+  TCase *tc_view_objects_mem = tcase_create ("view_objects_mem");
+  tcase_add_checked_fixture (tc_view_objects_mem, NULL, teardown);
+  tcase_add_test (tc_view_objects_mem, test_view_objects_mem);
+  suite_add_tcase (s, tc_view_objects_mem);
+
   TCase *tc_view_goto = tcase_create ("view_goto");
   tcase_add_checked_fixture (tc_view_goto, NULL, teardown);
   tcase_add_test (tc_view_goto, test_view_goto);
   suite_add_tcase (s, tc_view_goto);
 
+  TCase *tc_view_search = tcase_create ("view_search");
+  tcase_add_checked_fixture (tc_view_search, NULL, teardown);
+  tcase_add_test (tc_view_search, test_view_search);
+  suite_add_tcase (s, tc_view_search);
+
   TCase *tc_view_move = tcase_create ("view_move");
   tcase_add_checked_fixture (tc_view_move, NULL, teardown);
   tcase_add_test (tc_view_move, test_view_move);
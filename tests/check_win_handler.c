@@ -3,10 +3,14 @@
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
 #include <ncurses.h>
+#include <panel.h>
 #include <term.h>
 
 #include "../src/win_handler.h"
+#include "../src/syntax_cache.h"
 
 FILE *OUT_FILE = NULL;
 int VERBOSE_LEVEL = 7;
@@ -68,6 +72,15 @@ START_TEST (test_win_handler_text)
   ret = win_add_line (w, "line\001 1", 1, 1);
   fail_unless (ret < 0);
 
+  ret = win_set_line (w, 1, "line 2");
+  fail_unless (ret == 0);
+  fail_unless (strcmp (win_get_line (w, 1), "line 2") == 0);
+  ret = win_set_line (w, 1, "a line wrapping the window line................"
+		      "...............................................");
+  fail_unless (ret == 0);
+  ret = win_set_line (w, 99, "line 2");
+  fail_unless (ret < 0);
+
   ret = win_load_file (w, CONFDIR "text_test_bad.txt");
   fail_unless (ret < 0);
 
@@ -198,6 +211,91 @@ START_TEST (test_win_handler_mark)
 }
 END_TEST
 
+START_TEST (test_win_handler_resize)
+{
+  Win *w;
+  int ret;
+  int i;
+  int rows;
+  char buf[64];
+  win_properties props = { 0, 0 };
+
+  /* Lines taking up 1, 2 and 3 rows. */
+  w = win_create (0, 0, 10, 20, &props);
+  fail_unless (w != NULL);
+  rows = 0;
+  for (i = 0; i < 99; i++)
+    {
+      memset (buf, 'a', sizeof (buf));
+      buf[(i % 3) * 20 + 5] = '\0';
+      rows += i % 3 + 1;
+      ret = win_add_line (w, buf, i == 98, i);
+      fail_unless (ret == 0);
+    }
+
+  /* The window shows the last 9 rows. */
+  ret = win_scroll (w, -(rows - 9));
+  fail_unless (ret == 0);
+  ret = win_scroll (w, -1);
+  fail_unless (ret < 0);
+  ret = win_scroll (w, rows - 9);
+  fail_unless (ret == 0);
+  ret = win_scroll (w, 1);
+  fail_unless (ret < 0);
+  ret = win_scroll (w, -(rows + 9));
+  fail_unless (ret < 0);
+  ret = win_scroll (w, 60);
+  fail_unless (ret == 0);
+
+  /* A line on fewer rows, the window is redrawn from line 30. */
+  ret = win_set_line (w, 1, "a");
+  fail_unless (ret == 0);
+  rows--;
+  ret = win_add_line (w, "a", 0, 99);
+  fail_unless (ret == 0);
+  rows++;
+  ret = win_scroll (w, rows - 9 - 59);
+  fail_unless (ret == 0);
+  ret = win_scroll (w, 1);
+  fail_unless (ret < 0);
+
+  /* Wider, the lines take up 1, 1 and 2 rows. */
+  ret = win_resize (w, 2, 0, 8, 30);
+  fail_unless (ret == 0);
+  win_get_size (w, &i, &ret);
+  fail_unless (i == 7 && ret == 30, "%dx%d", i, ret);
+  rows = 33 * 4 + 1;
+  ret = win_scroll (w, -(rows - 7));
+  fail_unless (ret == 0);
+  ret = win_scroll (w, -1);
+  fail_unless (ret < 0);
+  ret = win_resize (w, 0, 0, 1, 1);
+  fail_unless (ret == 0);
+  ret = win_resize (w, 0, 0, 10, 20);
+  fail_unless (ret == 0);
+
+  win_clear (w);
+  ret = win_resize (w, 0, 0, 10, 40);
+  fail_unless (ret == 0);
+  win_free (w);
+
+  /* A window with a cursor keeps the cursor in sight. */
+  props.properties = WIN_PROP_CURSOR | WIN_PROP_BORDER;
+  w = win_create (0, 0, 40, 80, &props);
+  fail_unless (w != NULL);
+  ret = win_load_file (w, CONFDIR "text_test_long.txt");
+  fail_unless (ret == 0);
+  ret = win_go_to_line (w, 20);
+  fail_unless (ret == 0);
+  ret = win_resize (w, 0, 0, 10, 40);
+  fail_unless (ret == 0);
+  fail_unless (win_get_cursor (w) == 20);
+  ret = win_move_cursor (w, 1);
+  fail_unless (ret == 0);
+  win_free (w);
+}
+END_TEST
+
 START_TEST (test_win_handler_move_cursor)
 {
   Win *w;
@@ -346,13 +444,53 @@ START_TEST (test_win_handler_get_line)
 }
 END_TEST
 
+/**
+ * @brief Get the only cache file in a cache home.
+ *
+ * @param dir The cache home.
+ * @param path Set to the path of the cache file.
+ * @param size The size of @a path.
+ *
+ * @return 0 if there is exactly one cache file, else -1.
+ */
+static int
+cache_file (const char *dir, char *path, int size)
+{
+  DIR *d;
+  struct dirent *ent;
+  int n = 0;
+
+  snprintf (path, size, "%s/lvdbg", dir);
+  d = opendir (path);
+  if (d == NULL)
+    {
+      return -1;
+    }
+  while ((ent = readdir (d)) != NULL)
+    {
+      if (ent->d_name[0] != '.')
+	{
+	  snprintf (path, size, "%s/lvdbg/%s", dir, ent->d_name);
+	  n++;
+	}
+    }
+  closedir (d);
+
+  return n == 1 ? 0 : -1;
+}
+
 START_TEST (test_win_handler_syntax)
 {
   Win *w;
   int ret;
   int i;
   char buf[64];
+  char dir[] = "/tmp/check_win_handlerXXXXXX";
+  char path[256];
   const char *line;
+  syntax_cache *cache;
+  struct stat st;
+  ino_t ino = 0;
   win_attribute attr[] = { {1, 0x01}, {2, 0x02}, {3, 0x03} };
   char *scan =
     strdup
@@ -371,7 +509,264 @@ START_TEST (test_win_handler_syntax)
       fail_unless (ret == 0);
     }
   win_go_to_line (w, 5);
+  win_free (w);
+
+  /* A scanned file is cached and loaded from the cache the next time. */
+  fail_unless (mkdtemp (dir) != NULL);
+  setenv ("XDG_CACHE_HOME", dir, 1);
+  fail_unless (syntax_cache_open (CONFDIR "text_test.txt",
+				  syntax_cache_hash (scan)) == NULL);
+  for (i = 0; i < 2; i++)
+    {
+      w = win_create (0, 0, 40, 80, &props);
+      fail_unless (w != NULL);
+      ret = win_load_file (w, CONFDIR "text_test.txt");
+      fail_unless (ret == 0);
+      line = win_get_line (w, 3);
+      fail_unless (line != NULL);
+      win_free (w);
+
+      cache = syntax_cache_open (CONFDIR "text_test.txt",
+				 syntax_cache_hash (scan));
+      fail_unless (cache != NULL);
+      fail_unless (syntax_cache_nr_of_lines (cache) == 120);
+      syntax_cache_close (cache);
+
+      /* A store replaces the cache file, a cache hit leaves it. */
+      fail_unless (cache_file (dir, path, sizeof (path)) == 0);
+      fail_unless (stat (path, &st) == 0);
+      if (i == 0)
+	{
+	  ino = st.st_ino;
+	}
+      fail_unless (st.st_ino == ino);
+    }
+  fail_unless (unlink (path) == 0);
+  snprintf (path, sizeof (path), "%s/lvdbg", dir);
+  fail_unless (rmdir (path) == 0);
+  fail_unless (rmdir (dir) == 0);
+  unsetenv ("XDG_CACHE_HOME");
+  free (scan);
+}
+END_TEST
+
+START_TEST (test_win_handler_wrap)
+{
+  Win *w;
+  FILE *f;
+  int ret;
+  int i;
+  char file[] = "/tmp/check_win_handler_wrap.txt";
+  const char *line;
+  win_attribute attr[] = { {1, 0x01}, {2, 0x02} };
+  char *scan = strdup ("{id='0',type='1',match='int'},"
+		       "{id='1',match='[[:digit:]]*'}");
+  win_properties props =
+    { 0, WIN_PROP_CURSOR | WIN_PROP_SYNTAX, attr, 2, scan };
+
+  f = fopen (file, "w");
+  fail_unless (f != NULL);
+  fprintf (f, "0123456789012345678901234567890123456789 int 42\n");
+  for (i = 1; i < 30; i++)
+    {
+      fprintf (f, "Line int %d\n", i);
+    }
+  fclose (f);
+
+  w = win_create (0, 0, 10, 20, &props);
+  fail_unless (w != NULL);
+  ret = win_load_file (w, file);
+  fail_unless (ret == 0);
+  line = win_get_line (w, 0);
+  ret = win_scroll_columns (w, 1);
+  fail_unless (ret < 0);	/* The lines are wrapped. */
+
+  /* Every line takes up one row. */
+  ret = win_set_wrap (w, 0);
+  fail_unless (ret == 0);
+  fail_unless (win_get_wrap (w) == 0);
+  ret = win_scroll (w, 21);
+  fail_unless (ret == 0);
+  ret = win_scroll (w, 1);
+  fail_unless (ret < 0);
+  ret = win_scroll (w, -21);
+  fail_unless (ret == 0);
+
+  /* Only the shown columns are drawn, up to the end of the longest line. */
+  ret = win_scroll_columns (w, 30);
+  fail_unless (ret == 0);
+  ret = win_scroll_columns (w, 1);
+  fail_unless (ret < 0);
+  update_panels ();
+  doupdate ();
+  for (i = 0; i < 20; i++)
+    {
+      fail_unless ((mvwinch (curscr, 0, i) & A_CHARTEXT) == line[27 + i],
+		   "column %d", i);
+    }
+  ret = win_scroll_columns (w, -100);
+  fail_unless (ret == 0);
+  update_panels ();
+  doupdate ();
+  for (i = 0; i < 20; i++)
+    {
+      fail_unless ((mvwinch (curscr, 0, i) & A_CHARTEXT) == line[i],
+		   "column %d", i);
+    }
+
+  ret = win_resize (w, 0, 0, 10, 30);
+  fail_unless (ret == 0);
+  ret = win_set_wrap (w, 1);
+  fail_unless (ret == 0);
+  fail_unless (win_get_wrap (w) == 1);
+  ret = win_set_wrap (w, 1);
+  fail_unless (ret == 0);
+  win_free (w);
+
+  unlink (file);
   free (scan);
+}
+END_TEST
+
+START_TEST (test_win_handler_hidden)
+{
+  Win *a;
+  Win *b;
+  int ret;
+  int i;
+  char buf[64];
+  chtype screen[16];
+  win_properties props = { 0, 0 };
+
+  a = win_create (0, 0, 10, 20, &props);
+  fail_unless (a != NULL);
+  b = win_create (0, 0, 10, 20, &props);
+  fail_unless (b != NULL);
+
+  /* b is covered by a and is only drawn when it is on top again. */
+  win_to_top (a);
+  ret = win_add_line (a, "a line", 1, 0);
+  fail_unless (ret == 0);
+  for (i = 0; i < 30; i++)
+    {
+      snprintf (buf, sizeof (buf), "b line %d", i);
+      ret = win_add_line (b, buf, 1, i);
+      fail_unless (ret == 0);
+    }
+  ret = win_set_line (b, 28, "changed");
+  fail_unless (ret == 0);
+  update_panels ();
+  doupdate ();
+  mvwinchnstr (curscr, 8, 0, screen, 6);
+  for (i = 0; i < 6; i++)
+    {
+      fail_unless ((screen[i] & A_CHARTEXT) == "a line"[i]);
+    }
+
+  win_to_top (b);
+  update_panels ();
+  doupdate ();
+  mvwinchnstr (curscr, 7, 0, screen, 7);
+  for (i = 0; i < 7; i++)
+    {
+      fail_unless ((screen[i] & A_CHARTEXT) == "changed"[i]);
+    }
+  mvwinchnstr (curscr, 8, 0, screen, 7);
+  for (i = 0; i < 7; i++)
+    {
+      fail_unless ((screen[i] & A_CHARTEXT) == "b line "[i]);
+    }
+
+  /* Lines added while b is covered are shown after a resize. */
+  win_to_top (a);
+  for (i = 30; i < 40; i++)
+    {
+      snprintf (buf, sizeof (buf), "b line %d", i);
+      ret = win_add_line (b, buf, 1, i);
+      fail_unless (ret == 0);
+    }
+  ret = win_resize (b, 0, 0, 12, 20);
+  fail_unless (ret == 0);
+  win_to_top (b);
+  update_panels ();
+  doupdate ();
+  mvwinchnstr (curscr, 10, 0, screen, 9);
+  for (i = 0; i < 9; i++)
+    {
+      fail_unless ((screen[i] & A_CHARTEXT) == "b line 39"[i]);
+    }
+
+  /* a is uncovered when b is freed. */
+  win_clear (a);
+  ret = win_add_line (a, "again", 1, 0);
+  fail_unless (ret == 0);
+  win_free (b);
+  update_panels ();
+  doupdate ();
+  mvwinchnstr (curscr, 8, 0, screen, 5);
+  for (i = 0; i < 5; i++)
+    {
+      fail_unless ((screen[i] & A_CHARTEXT) == "again"[i]);
+    }
+  win_free (a);
+}
+END_TEST
+
+START_TEST (test_win_handler_search)
+{
+  Win *w;
+  int ret;
+  int i;
+  char buf[64];
+  win_properties props = { 0, WIN_PROP_CURSOR };
+
+  w = win_create (0, 0, 10, 40, &props);
+  fail_unless (w != NULL);
+  for (i = 0; i < 100; i++)
+    {
+      snprintf (buf, 64, "line %d%s", i, i % 10 == 3 ? " found" : "");
+      ret = win_add_line (w, buf, 0, i);
+      fail_unless (ret == 0);
+    }
+
+  /* No pattern. */
+  fail_unless (win_search (w, 1, 1) == -1);
+  fail_unless (win_count_matches (w, 10) == 0);
+
+  /* Search forward and backward, wrapping around. */
+  win_set_search (w, "found");
+  fail_unless (win_search (w, 1, 0) == 3);
+  fail_unless (win_get_tag (w) == 3);
+  fail_unless (win_search (w, 1, 0) == 3);
+  fail_unless (win_search (w, 1, 1) == 13);
+  fail_unless (win_search (w, -1, 1) == 3);
+  fail_unless (win_search (w, -1, 1) == 93);
+  fail_unless (win_search (w, 1, 1) == 3);
+
+  /* Count a part at the time. */
+  fail_unless (win_count_matches (w, 50) == 1);
+  fail_unless (win_count_matches (w, 50) == 1);
+  fail_unless (win_count_matches (w, 50) == 0);
+  ret = win_add_line (w, "found found", 0, 100);
+  fail_unless (ret == 0);
+  fail_unless (win_count_matches (w, 50) == 1);
+  fail_unless (win_count_matches (w, 50) == 0);
+  ret = win_set_line (w, 3, "line 3");
+  fail_unless (ret == 0);
+  fail_unless (win_count_matches (w, 200) == 1);
+  fail_unless (win_count_matches (w, 200) == 0);
+
+  /* Not found. */
+  win_set_search (w, "missing");
+  fail_unless (win_search (w, 1, 1) == -1);
+  win_set_search (w, "");
+  fail_unless (win_search (w, 1, 1) == -1);
+  win_set_search (w, NULL);
+  win_set_search (w, "line 5");
+  fail_unless (win_search (w, -1, 1) == 59);
+  win_clear (w);
+  fail_unless (win_search (w, 1, 1) == -1);
+  fail_unless (win_count_matches (w, 50) == 0);
 
   win_free (w);
 }
@@ -390,12 +785,16 @@ END_TEST
  * - _scroll: Test scrolling, go to lines, bring window to top. Test moving
  *            window, by win_move().
  * - _mark: Test marking in window.
+ * - _resize: Scrolling many rows of wrapped lines, and resizing.
  * - _move_cursor: Test moving cursor. Test moving/scroll if
  *   window has no cursor.
  * - _tag: Test setting/getting tags.
  * - _get_curpos: Test getting cursor pos and filename.
  * - get_line: Get the text line.
  * - _syntax: Highlighting and scanner.
+ * - _search: Searching and counting matches.
+ * - _wrap: Cut lines scrolled sideways.
+ * - _hidden: Covered windows are drawn when they are shown.
  */
   Suite * win_handler_suite (void)
 {
@@ -421,6 +820,11 @@ END_TEST
   tcase_add_test (tc_win_handler_mark, test_win_handler_mark);
   suite_add_tcase (s, tc_win_handler_mark);
 
+  TCase *tc_win_handler_resize = tcase_create ("win_handler_resize");
+  tcase_add_checked_fixture (tc_win_handler_resize, setup, teardown);
+  tcase_add_test (tc_win_handler_resize, test_win_handler_resize);
+  suite_add_tcase (s, tc_win_handler_resize);
+
   TCase *tc_win_handler_move_cursor =
     tcase_create ("win_handler_move_cursor");
   tcase_add_checked_fixture (tc_win_handler_move_cursor, setup, teardown);
@@ -447,6 +851,21 @@ END_TEST
   tcase_add_test (tc_win_handler_syntax, test_win_handler_syntax);
   suite_add_tcase (s, tc_win_handler_syntax);
 
+  TCase *tc_win_handler_search = tcase_create ("win_handler_search");
+  tcase_add_checked_fixture (tc_win_handler_search, setup, teardown);
+  tcase_add_test (tc_win_handler_search, test_win_handler_search);
+  suite_add_tcase (s, tc_win_handler_search);
+
+  TCase *tc_win_handler_wrap = tcase_create ("win_handler_wrap");
+  tcase_add_checked_fixture (tc_win_handler_wrap, setup, teardown);
+  tcase_add_test (tc_win_handler_wrap, test_win_handler_wrap);
+  suite_add_tcase (s, tc_win_handler_wrap);
+
+  TCase *tc_win_handler_hidden = tcase_create ("win_handler_hidden");
+  tcase_add_checked_fixture (tc_win_handler_hidden, setup, teardown);
+  tcase_add_test (tc_win_handler_hidden, test_win_handler_hidden);
+  suite_add_tcase (s, tc_win_handler_hidden);
+
   return s;
 }
 